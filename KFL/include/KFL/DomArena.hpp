@@ -0,0 +1,66 @@
+/**
+ * @file DomArena.hpp
+ * @author Minmin Gong
+ *
+ * @section DESCRIPTION
+ *
+ * This source file is part of KFL, a subproject of KlayGE
+ * For the latest info, see http://www.klayge.org
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * You may alternatively use this source under the terms of
+ * the KlayGE Proprietary License (KPL). You can obtained such a license
+ * from http://www.klayge.org/licensing/.
+ */
+
+#ifndef _KFL_DOMARENA_HPP
+#define _KFL_DOMARENA_HPP
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+
+namespace KlayGE
+{
+	// Monotonic storage of a loaded XML or JSON document. Everything is released at once with the arena.
+	class DomArena final : boost::noncopyable
+	{
+	public:
+		DomArena() noexcept;
+		~DomArena() noexcept;
+
+		void* Allocate(size_t size, size_t alignment);
+		char* AllocateString(size_t size);
+
+		// Backs the operator new/delete of DOM objects. A small header records whether an object comes from an arena,
+		// so deleting it only runs the destructor and leaves the memory to its arena.
+		static void* AllocateObject(size_t size, DomArena* arena);
+		static void DeallocateObject(void* p) noexcept;
+
+	private:
+		std::vector<std::unique_ptr<uint8_t[]>> blocks_;
+		uint8_t* curr_;
+		size_t remaining_;
+	};
+}
+
+#endif		// _KFL_DOMARENA_HPP
@@ -38,6 +38,8 @@
 
 #include <boost/noncopyable.hpp>
 
+#include <KFL/DomArena.hpp>
+
 namespace KlayGE
 {
 	enum class JsonValueType
@@ -69,7 +71,11 @@ namespace KlayGE
 		std::unique_ptr<JsonValue> AllocValueObject(std::vector<std::pair<std::string, std::unique_ptr<JsonValue>>> values);
 
 	private:
+		// Loaded documents keep their source text and values here. Declared before root_ to outlive the tree.
+		DomArena arena_;
 		std::unique_ptr<JsonValue> root_;
+
+		friend std::unique_ptr<JsonDocument> LoadJson(ResIdentifier& source);
 	};
 
 	class JsonValue : boost::noncopyable
@@ -77,6 +83,11 @@ namespace KlayGE
 	public:
 		virtual ~JsonValue() noexcept;
 
+		static void* operator new(size_t size);
+		static void* operator new(size_t size, DomArena& arena);
+		static void operator delete(void* p) noexcept;
+		static void operator delete(void* p, DomArena& arena) noexcept;
+
 		virtual JsonValueType Type() const noexcept = 0;
 
 		virtual std::unique_ptr<JsonValue> Clone() = 0;
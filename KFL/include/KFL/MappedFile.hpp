@@ -0,0 +1,74 @@
+/**
+ * @file MappedFile.hpp
+ * @author Minmin Gong
+ *
+ * @section DESCRIPTION
+ *
+ * This source file is part of KFL, a subproject of KlayGE
+ * For the latest info, see http://www.klayge.org
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * You may alternatively use this source under the terms of
+ * the KlayGE Proprietary License (KPL). You can obtained such a license
+ * from http://www.klayge.org/licensing/.
+ */
+
+#ifndef _KFL_MAPPEDFILE_HPP
+#define _KFL_MAPPEDFILE_HPP
+
+#pragma once
+
+#include <KFL/CXX20/span.hpp>
+
+#include <string>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+
+namespace KlayGE
+{
+	// Read-only memory mapping of a whole file. Small files are copied into memory instead, mapping them saves nothing.
+	//  A mapped file can't be truncated while the mapping is alive. Windows refuses it with ERROR_USER_MAPPED_FILE, and on
+	//  POSIX reading the mapping afterwards raises SIGBUS. Release the mapping before rewriting the file.
+	class MappedFile final : boost::noncopyable
+	{
+	public:
+		MappedFile() noexcept;
+		~MappedFile() noexcept;
+
+		// Returns false if the file can't be mapped, for example when it's empty
+		bool Map(std::string const & file_name);
+		void Unmap() noexcept;
+
+		std::span<uint8_t const> Data() const noexcept
+		{
+			return std::span<uint8_t const>(data_, size_);
+		}
+
+	private:
+		uint8_t const * data_;
+		size_t size_;
+		std::vector<uint8_t> copy_;
+#ifdef KLAYGE_PLATFORM_WINDOWS
+		void* file_;
+		void* mapping_;
+#endif
+	};
+}
+
+#endif		// _KFL_MAPPEDFILE_HPP
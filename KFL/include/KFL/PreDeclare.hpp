@@ -41,6 +41,8 @@ namespace KlayGE
 	typedef std::shared_ptr<ResIdentifier> ResIdentifierPtr;
 	class DllLoader;
 
+	class DomArena;
+
 	class XMLDocument;
 	class XMLNode;
 	class XMLAttribute;
@@ -49,6 +51,7 @@ namespace KlayGE
 	class JsonValue;
 
 	class ThreadPool;
+	class JobSystem;
 
 	class half;
 	template <typename T, int N>
@@ -0,0 +1,115 @@
+/**
+ * @file RadixSort.hpp
+ * @author Minmin Gong
+ *
+ * @section DESCRIPTION
+ *
+ * This source file is part of KFL, a subproject of KlayGE
+ * For the latest info, see http://www.klayge.org
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * You may alternatively use this source under the terms of
+ * the KlayGE Proprietary License (KPL). You can obtained such a license
+ * from http://www.klayge.org/licensing/.
+ */
+
+#ifndef _KFL_RADIXSORT_HPP
+#define _KFL_RADIXSORT_HPP
+
+#pragma once
+
+#include <KFL/PreDeclare.hpp>
+#include <KFL/CXX20/bit.hpp>
+
+#include <algorithm>
+#include <type_traits>
+
+namespace KlayGE
+{
+	// Maps a float to an uint32_t with the same order, so it can be radix sorted
+	inline uint32_t FloatToSortableKey(float f) noexcept
+	{
+		uint32_t const bits = std::bit_cast<uint32_t>(f);
+		return bits ^ ((bits & 0x80000000U) ? 0xFFFFFFFFU : 0x80000000U);
+	}
+
+	// Stable LSD radix sort of num (key, value) pairs in ascending key order, 8 bits per pass. tmp_keys and tmp_values
+	// are scratch buffers of num elements. Passes where all the keys have the same byte are skipped.
+	template <typename Key, typename Value>
+	void RadixSort(Key* keys, Value* values, size_t num, Key* tmp_keys, Value* tmp_values)
+	{
+		static_assert(std::is_unsigned_v<Key>);
+
+		uint32_t constexpr NUM_PASSES = sizeof(Key);
+
+		if (num == 0)
+		{
+			return;
+		}
+
+		size_t histograms[NUM_PASSES][256] = {};
+		for (size_t i = 0; i < num; ++ i)
+		{
+			Key const key = keys[i];
+			for (uint32_t pass = 0; pass < NUM_PASSES; ++ pass)
+			{
+				++ histograms[pass][(key >> (pass * 8)) & 0xFF];
+			}
+		}
+
+		Key* src_keys = keys;
+		Value* src_values = values;
+		Key* dst_keys = tmp_keys;
+		Value* dst_values = tmp_values;
+		for (uint32_t pass = 0; pass < NUM_PASSES; ++ pass)
+		{
+			size_t* histogram = histograms[pass];
+			uint32_t const shift = pass * 8;
+			if (histogram[(src_keys[0] >> shift) & 0xFF] == num)
+			{
+				continue;
+			}
+
+			size_t offset = 0;
+			for (uint32_t i = 0; i < 256; ++ i)
+			{
+				size_t const count = histogram[i];
+				histogram[i] = offset;
+				offset += count;
+			}
+
+			for (size_t i = 0; i < num; ++ i)
+			{
+				size_t const dst = histogram[(src_keys[i] >> shift) & 0xFF] ++;
+				dst_keys[dst] = src_keys[i];
+				dst_values[dst] = src_values[i];
+			}
+
+			std::swap(src_keys, dst_keys);
+			std::swap(src_values, dst_values);
+		}
+
+		if (src_keys != keys)
+		{
+			std::copy(src_keys, src_keys + num, keys);
+			std::copy(src_values, src_values + num, values);
+		}
+	}
+}
+
+#endif		// _KFL_RADIXSORT_HPP
@@ -34,6 +34,9 @@
 #pragma once
 
 #include <KFL/PreDeclare.hpp>
+#include <KFL/CustomizedStreamBuf.hpp>
+#include <KFL/CXX20/span.hpp>
+#include <KFL/SmartPtrHelper.hpp>
 #include <istream>
 #include <string>
 #include <string_view>
@@ -54,6 +57,15 @@ namespace KlayGE
 			: res_name_(std::move(name)), timestamp_(timestamp), istream_(is), streambuf_(streambuf)
 		{
 		}
+		// Wraps a contiguous block of memory, such as a mapped file or a decoded buffer. data_owner keeps it alive.
+		ResIdentifier(std::string_view name, uint64_t timestamp,
+				std::span<uint8_t const> data, std::shared_ptr<void const> const & data_owner)
+			: res_name_(std::move(name)), timestamp_(timestamp),
+				streambuf_(MakeSharedPtr<MemInputStreamBuf>(data.data(), static_cast<std::streamsize>(data.size()))),
+				data_(data), data_owner_(data_owner)
+		{
+			istream_ = MakeSharedPtr<std::istream>(streambuf_.get());
+		}
 
 		void ResName(std::string_view name)
 		{
@@ -113,11 +125,21 @@ namespace KlayGE
 			return *istream_;
 		}
 
+		// The whole resource as read-only memory, independent of the stream position. Empty if the resource is only
+		//  available as a stream.
+		std::span<uint8_t const> Data() const
+		{
+			return data_;
+		}
+
 	private:
 		std::string res_name_;
 		uint64_t timestamp_;
 		std::shared_ptr<std::istream> istream_;
 		std::shared_ptr<std::streambuf> streambuf_;
+
+		std::span<uint8_t const> data_;
+		std::shared_ptr<void const> data_owner_;
 	};
 }
 
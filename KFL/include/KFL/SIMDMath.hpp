@@ -34,6 +34,7 @@
 #pragma once
 
 #include <KFL/PreDeclare.hpp>
+#include <KFL/Math.hpp>
 
 #if defined(KLAYGE_SSE_SUPPORT)
 	#define SIMD_MATH_SSE
@@ -251,6 +252,13 @@ namespace KlayGE
 		// From Game Programming Gems 5, Section 2.6.
 		void ObliqueClipping(SIMDMatrixF4& proj, SIMDVectorF4 const & clip_plane);
 
+		// Bound
+		///////////////////////////////////////////////////////////////////////////////
+		// Tests num AABBs, packed as structure of arrays, against a frustum. Each result is the same as Frustum::Intersect's.
+		// The arrays must be 16-byte aligned and num must be a multiple of 4.
+		void IntersectAABBsFrustum(float const * min_x, float const * min_y, float const * min_z,
+			float const * max_x, float const * max_y, float const * max_z, uint32_t num,
+			Frustum const & frustum, BoundOverlap* results);
 
 		// Color
 		///////////////////////////////////////////////////////////////////////////////
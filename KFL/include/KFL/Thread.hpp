@@ -33,7 +33,12 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
 #include <functional>
 #ifdef KLAYGE_COMPILER_MSVC
 #pragma warning(push)
@@ -43,8 +48,11 @@
 #ifdef KLAYGE_COMPILER_MSVC
 #pragma warning(pop)
 #endif
+#include <memory>
 #include <mutex>
+#include <new>
 #include <thread>
+#include <type_traits>
 #include <vector>
 
 #include <boost/noncopyable.hpp>
@@ -188,6 +196,229 @@ namespace KlayGE
 	private:
 		std::shared_ptr<CommonData> data_;
 	};
+
+	// A fixed-size work-stealing job system. ThreadPool hands a whole thread to each task, which is fine for long-running
+	//  loops (loading thread, audio streaming), but too heavy for the thousands of small jobs a frame can produce.
+	//  JobSystem keeps one worker per hardware thread. Each worker owns a queue, pops its own jobs in LIFO order and steals
+	//  from the others in FIFO order when idle. Threads that wait on a counter execute jobs instead of blocking.
+	class JobSystem final : boost::noncopyable
+	{
+	public:
+		// A move-only functor with small buffer storage. Callables that fit in the buffer don't allocate.
+		class Job final
+		{
+			static constexpr size_t InlineSize = 48;
+
+			struct Ops
+			{
+				void (*invoke)(void* storage);
+				void (*move)(void* dst, void* src) noexcept;
+				void (*destroy)(void* storage) noexcept;
+			};
+
+		public:
+			Job() noexcept = default;
+
+			template <typename Func, typename = std::enable_if_t<!std::is_same_v<std::decay_t<Func>, Job>>>
+			Job(Func&& func)
+			{
+				using func_t = std::decay_t<Func>;
+				if constexpr ((sizeof(func_t) <= InlineSize) && (alignof(func_t) <= alignof(std::max_align_t))
+					&& std::is_nothrow_move_constructible_v<func_t>)
+				{
+					static Ops const ops = {
+						[](void* storage) { (*static_cast<func_t*>(storage))(); },
+						[](void* dst, void* src) noexcept {
+							new (dst) func_t(std::move(*static_cast<func_t*>(src)));
+							static_cast<func_t*>(src)->~func_t();
+						},
+						[](void* storage) noexcept { static_cast<func_t*>(storage)->~func_t(); }
+					};
+					new (storage_) func_t(std::forward<Func>(func));
+					ops_ = &ops;
+				}
+				else
+				{
+					static Ops const ops = {
+						[](void* storage) { (**static_cast<func_t**>(storage))(); },
+						[](void* dst, void* src) noexcept { *static_cast<func_t**>(dst) = *static_cast<func_t**>(src); },
+						[](void* storage) noexcept { delete *static_cast<func_t**>(storage); }
+					};
+					*reinterpret_cast<func_t**>(storage_) = new func_t(std::forward<Func>(func));
+					ops_ = &ops;
+				}
+			}
+
+			Job(Job&& rhs) noexcept;
+			Job& operator=(Job&& rhs) noexcept;
+			~Job();
+
+			explicit operator bool() const noexcept
+			{
+				return ops_ != nullptr;
+			}
+
+			void operator()();
+
+		private:
+			void Reset() noexcept;
+
+		private:
+			alignas(std::max_align_t) unsigned char storage_[InlineSize];
+			Ops const* ops_ = nullptr;
+		};
+
+		// Counts unfinished jobs. Scheduling a job with a counter increments it and finishing the job decrements it.
+		//  Continuations attached to a counter are scheduled as soon as it drops to zero.
+		class Counter final : boost::noncopyable
+		{
+			friend class JobSystem;
+
+		public:
+			bool Done() const noexcept
+			{
+				return (count_.load(std::memory_order_acquire) == 0) && (finishing_.load(std::memory_order_acquire) == 0);
+			}
+
+		private:
+			std::atomic<uint32_t> count_{0};
+			std::atomic<uint32_t> finishing_{0};
+
+			std::mutex continuation_mutex_;
+			std::vector<std::pair<Job, Counter*>> continuations_;
+		};
+
+	public:
+		// num_workers == 0 means one worker per hardware thread, minus the calling thread which helps in Wait().
+		explicit JobSystem(uint32_t num_workers = 0);
+		~JobSystem();
+
+		uint32_t NumWorkers() const noexcept
+		{
+			return static_cast<uint32_t>(workers_.size());
+		}
+
+		// An exception thrown by the job propagates out of the Wait() that runs it, or ends the program on a worker thread
+		void Schedule(Job job, Counter* counter = nullptr);
+		// Schedules job after all jobs counted by dependency are finished.
+		void Continue(Counter& dependency, Job job, Counter* counter = nullptr);
+		// Executes pending jobs on the calling thread until counter reaches zero.
+		void Wait(Counter& counter);
+
+		// Splits [begin, end) into ranges of at most grain_size elements and calls func(range_begin, range_end) on each of
+		//  them in parallel. Returns when all ranges are done. grain_size == 0 picks a size that gives each worker a few
+		//  ranges to balance the load. If func throws, the rest of the ranges still run, and the first exception is
+		//  rethrown here after all of them are done.
+		template <typename Func>
+		void ParallelFor(uint32_t begin, uint32_t end, uint32_t grain_size, Func const& func)
+		{
+			if (begin >= end)
+			{
+				return;
+			}
+
+			uint32_t const count = end - begin;
+			if (grain_size == 0)
+			{
+				uint32_t const num_ranges = (this->NumWorkers() + 1) * 4;
+				grain_size = std::max((count + num_ranges - 1) / num_ranges, 1U);
+			}
+
+			if (count <= grain_size)
+			{
+				func(begin, end);
+				return;
+			}
+
+			// Scheduled jobs refer to this frame, so nothing may leave it before the counter is done
+			std::mutex exception_mutex;
+			std::exception_ptr exception;
+			auto const store_exception = [&exception_mutex, &exception]() noexcept {
+				std::lock_guard<std::mutex> lock(exception_mutex);
+				if (!exception)
+				{
+					exception = std::current_exception();
+				}
+			};
+			auto const run_range = [&func, &store_exception](uint32_t range_begin, uint32_t range_end) noexcept {
+				try
+				{
+					func(range_begin, range_end);
+				}
+				catch (...)
+				{
+					store_exception();
+				}
+			};
+
+			Counter counter;
+			try
+			{
+				for (uint32_t range_begin = begin + grain_size; range_begin < end; range_begin += grain_size)
+				{
+					uint32_t const range_end = std::min(range_begin + grain_size, end);
+					this->Schedule([&run_range, range_begin, range_end] { run_range(range_begin, range_end); }, &counter);
+				}
+			}
+			catch (...)
+			{
+				store_exception();
+			}
+			run_range(begin, std::min(begin + grain_size, end));
+
+			// Wait() can run unrelated jobs on this thread, and they may throw
+			for (;;)
+			{
+				try
+				{
+					this->Wait(counter);
+					break;
+				}
+				catch (...)
+				{
+					store_exception();
+				}
+			}
+
+			if (exception)
+			{
+				std::rethrow_exception(exception);
+			}
+		}
+
+	private:
+		struct QueuedJob
+		{
+			Job job;
+			Counter* counter;
+		};
+
+		// Padded to keep queues of different workers in different cache lines
+		struct alignas(64) WorkQueue
+		{
+			std::mutex mutex;
+			std::deque<QueuedJob> jobs;
+		};
+
+		uint32_t CurrentQueueIndex() const noexcept;
+		void Push(uint32_t queue_index, QueuedJob&& job);
+		bool Pop(uint32_t queue_index, QueuedJob& job);
+		bool Steal(uint32_t thief_index, QueuedJob& job);
+		bool RunOneJob(uint32_t queue_index);
+		void FinishJob(Counter* counter);
+		void WorkerFunc(uint32_t index);
+
+	private:
+		// One queue per worker, plus the last one shared by all non-worker threads
+		std::unique_ptr<WorkQueue[]> queues_;
+		std::vector<std::thread> workers_;
+
+		std::atomic<uint32_t> num_pending_jobs_{0};
+		std::atomic<uint32_t> num_sleeping_workers_{0};
+		std::mutex sleep_mutex_;
+		std::condition_variable sleep_cond_;
+		bool quit_ = false;
+	};
 }
 
 #endif		// KFL_THREAD_HPP
@@ -38,6 +38,8 @@
 
 #include <boost/noncopyable.hpp>
 
+#include <KFL/DomArena.hpp>
+
 namespace KlayGE
 {
 	enum class XMLNodeType
@@ -70,7 +72,11 @@ namespace KlayGE
 		std::unique_ptr<XMLAttribute> AllocAttribString(std::string_view name, std::string_view value);
 
 	private:
+		// Loaded documents keep their source text, nodes, and attributes here. Declared before root_ to outlive the tree.
+		DomArena arena_;
 		std::unique_ptr<XMLNode> root_;
+
+		friend std::unique_ptr<XMLDocument> LoadXml(ResIdentifier& source);
 	};
 
 	class XMLNode final : boost::noncopyable
@@ -78,6 +84,11 @@ namespace KlayGE
 	public:
 		explicit XMLNode(XMLNodeType type);
 
+		static void* operator new(size_t size);
+		static void* operator new(size_t size, DomArena& arena);
+		static void operator delete(void* p) noexcept;
+		static void operator delete(void* p, DomArena& arena) noexcept;
+
 		std::string_view Name() const;
 		void Name(std::string_view name);
 
@@ -148,16 +159,26 @@ namespace KlayGE
 		XMLNode* parent_{};
 
 		XMLNodeType type_;
-		std::string name_;
-		std::string value_;
+		// Loaded nodes reference the source text in the document's arena. Setting a name or value moves it to the storage.
+		std::string_view name_;
+		std::string_view value_;
+		std::string name_storage_;
+		std::string value_storage_;
 
 		std::vector<std::unique_ptr<XMLNode>> children_;
 		std::vector<std::unique_ptr<XMLAttribute>> attrs_;
+
+		friend std::unique_ptr<XMLDocument> LoadXml(ResIdentifier& source);
 	};
 
 	class XMLAttribute final : boost::noncopyable
 	{
 	public:
+		static void* operator new(size_t size);
+		static void* operator new(size_t size, DomArena& arena);
+		static void operator delete(void* p) noexcept;
+		static void operator delete(void* p, DomArena& arena) noexcept;
+
 		std::string_view Name() const;
 		void Name(std::string_view name);
 
@@ -187,8 +208,12 @@ namespace KlayGE
 	private:
 		XMLNode* parent_{};
 
-		std::string name_;
-		std::string value_;
+		std::string_view name_;
+		std::string_view value_;
+		std::string name_storage_;
+		std::string value_storage_;
+
+		friend std::unique_ptr<XMLDocument> LoadXml(ResIdentifier& source);
 	};
 
 	std::unique_ptr<XMLDocument> LoadXml(ResIdentifier& source);
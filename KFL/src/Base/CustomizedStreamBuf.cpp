@@ -106,46 +106,34 @@ namespace KlayGE
 		BOOST_ASSERT(which == std::ios_base::in);
 		KFL_UNUSED(which);
 
+		off_type pos;
 		switch (way)
 		{
 		case std::ios_base::beg:
-			if (off <= end_ - begin_)
-			{
-				current_ = begin_ + off;
-			}
-			else
-			{
-				off = -1;
-			}
+			pos = off;
 			break;
 
 		case std::ios_base::end:
-			if (end_ - off >= begin_)
-			{
-				current_ = end_ - off;
-				off = current_ - begin_;
-			}
-			else
-			{
-				off = -1;
-			}
+			pos = (end_ - begin_) + off;
 			break;
 
 		case std::ios_base::cur:
 		default:
-			if (current_ + off <= end_)
-			{
-				current_ += off;
-				off = current_ - begin_;
-			}
-			else
-			{
-				off = -1;
-			}
+			pos = (current_ - begin_) + off;
 			break;
 		}
 
-		return off;
+		// Seeking to the end itself is valid, reads from there hit EOF
+		if ((pos >= 0) && (pos <= end_ - begin_))
+		{
+			current_ = begin_ + pos;
+		}
+		else
+		{
+			pos = -1;
+		}
+
+		return pos;
 	}
 
 	MemInputStreamBuf::pos_type MemInputStreamBuf::seekpos(pos_type sp, std::ios_base::openmode which)
@@ -153,9 +141,10 @@ namespace KlayGE
 		BOOST_ASSERT(which == std::ios_base::in);
 		KFL_UNUSED(which);
 
-		if (sp < end_ - begin_)
+		off_type const pos = sp;
+		if ((pos >= 0) && (pos <= end_ - begin_))
 		{
-			current_ = begin_ + static_cast<int>(sp);
+			current_ = begin_ + pos;
 		}
 		else
 		{
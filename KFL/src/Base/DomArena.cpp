@@ -0,0 +1,113 @@
+/**
+ * @file DomArena.cpp
+ * @author Minmin Gong
+ *
+ * @section DESCRIPTION
+ *
+ * This source file is part of KFL, a subproject of KlayGE
+ * For the latest info, see http://www.klayge.org
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * You may alternatively use this source under the terms of
+ * the KlayGE Proprietary License (KPL). You can obtained such a license
+ * from http://www.klayge.org/licensing/.
+ */
+
+#include <KFL/KFL.hpp>
+
+#include <algorithm>
+#include <new>
+
+#include <KFL/DomArena.hpp>
+
+namespace
+{
+	size_t constexpr BLOCK_SIZE = 64 * 1024;
+	size_t constexpr OBJECT_HEADER_SIZE = alignof(std::max_align_t);
+	static_assert(OBJECT_HEADER_SIZE >= sizeof(void*));
+}
+
+namespace KlayGE
+{
+	DomArena::DomArena() noexcept
+		: curr_(nullptr), remaining_(0)
+	{
+	}
+
+	DomArena::~DomArena() noexcept = default;
+
+	void* DomArena::Allocate(size_t size, size_t alignment)
+	{
+		size_t const padding = (alignment - reinterpret_cast<uintptr_t>(curr_) % alignment) % alignment;
+		if (padding + size > remaining_)
+		{
+			size_t const block_size = std::max(BLOCK_SIZE, size + alignment);
+			// Not value initialized, every byte handed out gets written by the caller
+			std::unique_ptr<uint8_t[]> block(new uint8_t[block_size]);
+			uint8_t* p = block.get();
+			if (block_size > BLOCK_SIZE)
+			{
+				// Large allocations, such as the source text, get a block of their own so the current one keeps being used
+				blocks_.insert(blocks_.begin(), std::move(block));
+				return p + (alignment - reinterpret_cast<uintptr_t>(p) % alignment) % alignment;
+			}
+
+			blocks_.push_back(std::move(block));
+			curr_ = p;
+			remaining_ = block_size;
+			return this->Allocate(size, alignment);
+		}
+
+		void* ret = curr_ + padding;
+		curr_ += padding + size;
+		remaining_ -= padding + size;
+		return ret;
+	}
+
+	char* DomArena::AllocateString(size_t size)
+	{
+		return static_cast<char*>(this->Allocate(size, 1));
+	}
+
+	void* DomArena::AllocateObject(size_t size, DomArena* arena)
+	{
+		uint8_t* p;
+		if (arena != nullptr)
+		{
+			p = static_cast<uint8_t*>(arena->Allocate(OBJECT_HEADER_SIZE + size, OBJECT_HEADER_SIZE));
+		}
+		else
+		{
+			p = static_cast<uint8_t*>(::operator new(OBJECT_HEADER_SIZE + size));
+		}
+		*reinterpret_cast<DomArena**>(p) = arena;
+		return p + OBJECT_HEADER_SIZE;
+	}
+
+	void DomArena::DeallocateObject(void* p) noexcept
+	{
+		if (p != nullptr)
+		{
+			uint8_t* header = static_cast<uint8_t*>(p) - OBJECT_HEADER_SIZE;
+			if (*reinterpret_cast<DomArena**>(header) == nullptr)
+			{
+				::operator delete(header);
+			}
+		}
+	}
+}
@@ -35,6 +35,7 @@
 #include <KFL/StringUtil.hpp>
 #include <KFL/Util.hpp>
 
+#include <cstring>
 #include <string>
 
 #if defined(KLAYGE_COMPILER_MSVC)
@@ -206,7 +207,7 @@ namespace
 		std::unique_ptr<JsonValue> Clone() override
 		{
 			auto ret = MakeUniquePtr<JsonValueString>();
-			ret->value_ = value_;
+			ret->Value(value_);
 			return ret;
 		}
 
@@ -217,13 +218,21 @@ namespace
 
 		void Value(std::string_view value) override
 		{
-			value_ = std::string(std::move(value));
+			storage_ = std::string(std::move(value));
+			value_ = storage_;
 		}
 
 		using JsonValue::Value;
 
+		// Loaded strings reference the source text in the document's arena
+		void ValueInPlace(std::string_view value)
+		{
+			value_ = value;
+		}
+
 	private:
-		std::string value_;
+		std::string_view value_;
+		std::string storage_;
 	};
 
 	class JsonValueArray final : public JsonValue
@@ -408,82 +417,98 @@ namespace
 		std::vector<std::pair<std::string, std::unique_ptr<JsonValue>>> values_;
 	};
 
-	std::unique_ptr<JsonValue> CreateJsonValueFromRapidJsonValue(JsonDocument& doc, rapidjson::Value& value)
+	template <typename T>
+	std::unique_ptr<T> MakeArenaJsonValue(DomArena& arena)
+	{
+		return std::unique_ptr<T>(new (arena) T);
+	}
+
+	std::unique_ptr<JsonValue> CreateJsonValueFromRapidJsonValue(DomArena& arena, rapidjson::Value& value)
 	{
 		if (value.IsNull())
 		{
-			return MakeUniquePtr<JsonValueNull>();
+			return MakeArenaJsonValue<JsonValueNull>(arena);
 		}
 		else if (value.IsFalse())
 		{
-			auto ret = MakeUniquePtr<JsonValueBool>();
+			auto ret = MakeArenaJsonValue<JsonValueBool>(arena);
 			ret->Value(false);
 			return ret;
 		}
 		else if (value.IsTrue())
 		{
-			auto ret = MakeUniquePtr<JsonValueBool>();
+			auto ret = MakeArenaJsonValue<JsonValueBool>(arena);
 			ret->Value(true);
 			return ret;
 		}
 		else if (value.IsBool())
 		{
-			auto ret = MakeUniquePtr<JsonValueBool>();
+			auto ret = MakeArenaJsonValue<JsonValueBool>(arena);
 			ret->Value(value.GetBool());
 			return ret;
 		}
 		else if (value.IsInt())
 		{
-			auto ret = MakeUniquePtr<JsonValueInt>();
+			auto ret = MakeArenaJsonValue<JsonValueInt>(arena);
 			ret->Value(value.GetInt());
 			return ret;
 		}
 		else if (value.IsUint())
 		{
-			auto ret = MakeUniquePtr<JsonValueUInt>();
+			auto ret = MakeArenaJsonValue<JsonValueUInt>(arena);
 			ret->Value(value.GetUint());
 			return ret;
 		}
 		else if (value.IsInt64())
 		{
-			auto ret = MakeUniquePtr<JsonValueInt>();
+			auto ret = MakeArenaJsonValue<JsonValueInt>(arena);
 			ret->Value(static_cast<int32_t>(value.GetInt64()));
 			return ret;
 		}
 		else if (value.IsUint64())
 		{
-			auto ret = MakeUniquePtr<JsonValueInt>();
+			auto ret = MakeArenaJsonValue<JsonValueUInt>(arena);
 			ret->Value(static_cast<uint32_t>(value.GetUint64()));
 			return ret;
 		}
 		else if (value.IsDouble())
 		{
-			auto ret = MakeUniquePtr<JsonValueFloat>();
+			auto ret = MakeArenaJsonValue<JsonValueFloat>(arena);
 			ret->Value(static_cast<float>(value.GetDouble()));
 			return ret;
 		}
 		else if (value.IsString())
 		{
-			auto ret = MakeUniquePtr<JsonValueString>();
-			ret->Value(std::string(value.GetString()));
+			auto ret = MakeArenaJsonValue<JsonValueString>(arena);
+			ret->ValueInPlace(std::string_view(value.GetString(), value.GetStringLength()));
 			return ret;
 		}
 		else if (value.IsArray())
 		{
-			auto ret = MakeUniquePtr<JsonValueArray>();
+			std::vector<std::unique_ptr<JsonValue>> values;
+			values.reserve(value.Size());
 			for (auto iter = value.Begin(); iter != value.End(); ++iter)
 			{
-				ret->AppendValue(CreateJsonValueFromRapidJsonValue(doc, *iter));
+				values.emplace_back(CreateJsonValueFromRapidJsonValue(arena, *iter));
 			}
+
+			auto ret = MakeArenaJsonValue<JsonValueArray>(arena);
+			ret->Value(std::move(values));
 			return ret;
 		}
 		else if (value.IsObject())
 		{
-			auto ret = MakeUniquePtr<JsonValueObject>();
+			// Member names stay std::string, ValueObject() hands them out that way
+			std::vector<std::pair<std::string, std::unique_ptr<JsonValue>>> values;
+			values.reserve(value.MemberCount());
 			for (auto iter = value.MemberBegin(); iter != value.MemberEnd(); ++iter)
 			{
-				ret->AppendValue(iter->name.GetString(), CreateJsonValueFromRapidJsonValue(doc, iter->value));
+				values.emplace_back(std::string(iter->name.GetString(), iter->name.GetStringLength()),
+					CreateJsonValueFromRapidJsonValue(arena, iter->value));
 			}
+
+			auto ret = MakeArenaJsonValue<JsonValueObject>(arena);
+			ret->Value(std::move(values));
 			return ret;
 		}
 		else
@@ -760,6 +785,27 @@ namespace KlayGE
 
 	JsonValue::~JsonValue() noexcept = default;
 
+	void* JsonValue::operator new(size_t size)
+	{
+		return DomArena::AllocateObject(size, nullptr);
+	}
+
+	void* JsonValue::operator new(size_t size, DomArena& arena)
+	{
+		return DomArena::AllocateObject(size, &arena);
+	}
+
+	void JsonValue::operator delete(void* p) noexcept
+	{
+		DomArena::DeallocateObject(p);
+	}
+
+	void JsonValue::operator delete(void* p, DomArena& arena) noexcept
+	{
+		KFL_UNUSED(arena);
+		DomArena::DeallocateObject(p);
+	}
+
 	JsonValue* JsonValue::Member(std::string_view name) const
 	{
 		KFL_UNUSED(name);
@@ -913,19 +959,35 @@ namespace KlayGE
 
 	std::unique_ptr<JsonDocument> LoadJson(ResIdentifier& source)
 	{
-		source.seekg(0, std::ios_base::end);
-		size_t const len = static_cast<size_t>(source.tellg());
-		source.seekg(0, std::ios_base::beg);
-		auto xml_src = MakeUniquePtr<char[]>(len + 1);
-		source.read(&xml_src[0], len);
-		xml_src[len] = 0;
+		auto ret = MakeUniquePtr<JsonDocument>();
+		DomArena& arena = ret->arena_;
+
+		// Parses in situ over a null-terminated copy in the document's arena. Loaded strings point into it instead of being
+		// copied into rapidjson's pool and then again into the DOM.
+		auto const data = source.Data();
+		size_t len;
+		char* json_src;
+		if (!data.empty())
+		{
+			len = data.size();
+			json_src = arena.AllocateString(len + 1);
+			std::memcpy(json_src, data.data(), len);
+		}
+		else
+		{
+			source.seekg(0, std::ios_base::end);
+			len = static_cast<size_t>(source.tellg());
+			source.seekg(0, std::ios_base::beg);
+			json_src = arena.AllocateString(len + 1);
+			source.read(json_src, len);
+		}
+		json_src[len] = 0;
 
 		rapidjson::Document doc;
-		doc.Parse(xml_src.get());
+		doc.ParseInsitu(json_src);
 		Verify(!doc.HasParseError());
 
-		auto ret = MakeUniquePtr<JsonDocument>();
-		ret->RootValue(CreateJsonValueFromRapidJsonValue(*ret, doc));
+		ret->RootValue(CreateJsonValueFromRapidJsonValue(arena, doc));
 
 		return ret;
 	}
@@ -0,0 +1,212 @@
+/**
+ * @file MappedFile.cpp
+ * @author Minmin Gong
+ *
+ * @section DESCRIPTION
+ *
+ * This source file is part of KFL, a subproject of KlayGE
+ * For the latest info, see http://www.klayge.org
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * You may alternatively use this source under the terms of
+ * the KlayGE Proprietary License (KPL). You can obtained such a license
+ * from http://www.klayge.org/licensing/.
+ */
+
+#include <KFL/KFL.hpp>
+#include <KFL/ErrorHandling.hpp>
+
+#ifdef KLAYGE_PLATFORM_WINDOWS
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <KFL/MappedFile.hpp>
+
+namespace
+{
+	// Below this, reading the file costs less than setting up the mapping and taking its page faults
+	size_t constexpr MIN_MAPPED_SIZE = 64 * 1024;
+}
+
+namespace KlayGE
+{
+	MappedFile::MappedFile() noexcept
+		: data_(nullptr), size_(0)
+#ifdef KLAYGE_PLATFORM_WINDOWS
+			, file_(nullptr), mapping_(nullptr)
+#endif
+	{
+	}
+
+	MappedFile::~MappedFile() noexcept
+	{
+		this->Unmap();
+	}
+
+	bool MappedFile::Map(std::string const & file_name)
+	{
+		this->Unmap();
+
+#ifdef KLAYGE_PLATFORM_WINDOWS
+#ifdef KLAYGE_PLATFORM_WINDOWS_DESKTOP
+		// Like a std::ifstream, this doesn't stop other handles from writing, renaming, or deleting the file. Truncating it
+		//  still fails with ERROR_USER_MAPPED_FILE while the mapping is alive.
+		HANDLE file = ::CreateFileA(file_name.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+			nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+		file_ = file;
+
+		LARGE_INTEGER file_size;
+		if (!::GetFileSizeEx(file, &file_size) || (file_size.QuadPart == 0))
+		{
+			this->Unmap();
+			return false;
+		}
+
+		if (static_cast<uint64_t>(file_size.QuadPart) < MIN_MAPPED_SIZE)
+		{
+			copy_.resize(static_cast<size_t>(file_size.QuadPart));
+			DWORD bytes_read;
+			bool const succeeded = ::ReadFile(file, copy_.data(), static_cast<DWORD>(copy_.size()), &bytes_read, nullptr)
+				&& (bytes_read == copy_.size());
+			::CloseHandle(file);
+			file_ = nullptr;
+			if (!succeeded)
+			{
+				this->Unmap();
+				return false;
+			}
+
+			data_ = copy_.data();
+			size_ = copy_.size();
+			return true;
+		}
+
+		mapping_ = ::CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping_ == nullptr)
+		{
+			this->Unmap();
+			return false;
+		}
+
+		data_ = static_cast<uint8_t const *>(::MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+		if (data_ == nullptr)
+		{
+			this->Unmap();
+			return false;
+		}
+		size_ = static_cast<size_t>(file_size.QuadPart);
+
+		return true;
+#else
+		// Store apps go through the stream path
+		KFL_UNUSED(file_name);
+		return false;
+#endif
+#else
+		int const fd = ::open(file_name.c_str(), O_RDONLY);
+		if (fd < 0)
+		{
+			return false;
+		}
+
+		struct stat st;
+		if ((::fstat(fd, &st) != 0) || (st.st_size <= 0))
+		{
+			::close(fd);
+			return false;
+		}
+
+		if (static_cast<size_t>(st.st_size) < MIN_MAPPED_SIZE)
+		{
+			copy_.resize(static_cast<size_t>(st.st_size));
+			size_t offset = 0;
+			while (offset < copy_.size())
+			{
+				ssize_t const bytes_read = ::read(fd, copy_.data() + offset, copy_.size() - offset);
+				if (bytes_read <= 0)
+				{
+					break;
+				}
+				offset += static_cast<size_t>(bytes_read);
+			}
+			::close(fd);
+			if (offset != copy_.size())
+			{
+				this->Unmap();
+				return false;
+			}
+
+			data_ = copy_.data();
+			size_ = copy_.size();
+			return true;
+		}
+
+		void* p = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+		// The mapping stays valid after the descriptor is closed
+		::close(fd);
+		if (p == MAP_FAILED)
+		{
+			return false;
+		}
+
+		data_ = static_cast<uint8_t const *>(p);
+		size_ = static_cast<size_t>(st.st_size);
+		return true;
+#endif
+	}
+
+	void MappedFile::Unmap() noexcept
+	{
+		bool const mapped = copy_.empty() && (data_ != nullptr);
+		std::vector<uint8_t>().swap(copy_);
+
+#ifdef KLAYGE_PLATFORM_WINDOWS
+		if (mapped)
+		{
+			::UnmapViewOfFile(data_);
+		}
+		if (mapping_ != nullptr)
+		{
+			::CloseHandle(mapping_);
+		}
+		if (file_ != nullptr)
+		{
+			::CloseHandle(file_);
+		}
+		file_ = nullptr;
+		mapping_ = nullptr;
+#else
+		if (mapped)
+		{
+			::munmap(const_cast<uint8_t*>(data_), size_);
+		}
+#endif
+
+		data_ = nullptr;
+		size_ = 0;
+	}
+}
@@ -32,6 +32,7 @@
 
 #include <boost/assert.hpp>
 
+#include <KFL/CpuInfo.hpp>
 #include <KFL/Thread.hpp>
 
 namespace KlayGE
@@ -191,4 +192,279 @@ namespace KlayGE
 
 		data_->AddWaitingThreads(num_min_cached_threads);
 	}
+
+	JobSystem::Job::Job(Job&& rhs) noexcept
+		: ops_(rhs.ops_)
+	{
+		if (ops_ != nullptr)
+		{
+			ops_->move(storage_, rhs.storage_);
+			rhs.ops_ = nullptr;
+		}
+	}
+
+	JobSystem::Job& JobSystem::Job::operator=(Job&& rhs) noexcept
+	{
+		if (this != &rhs)
+		{
+			this->Reset();
+			ops_ = rhs.ops_;
+			if (ops_ != nullptr)
+			{
+				ops_->move(storage_, rhs.storage_);
+				rhs.ops_ = nullptr;
+			}
+		}
+		return *this;
+	}
+
+	JobSystem::Job::~Job()
+	{
+		this->Reset();
+	}
+
+	void JobSystem::Job::operator()()
+	{
+		BOOST_ASSERT(ops_ != nullptr);
+		ops_->invoke(storage_);
+	}
+
+	void JobSystem::Job::Reset() noexcept
+	{
+		if (ops_ != nullptr)
+		{
+			ops_->destroy(storage_);
+			ops_ = nullptr;
+		}
+	}
+
+
+	namespace
+	{
+		thread_local JobSystem const* tls_job_system = nullptr;
+		thread_local uint32_t tls_worker_index = 0;
+	}
+
+	JobSystem::JobSystem(uint32_t num_workers)
+	{
+		if (num_workers == 0)
+		{
+			CpuInfo cpu;
+			num_workers = std::max(cpu.NumHWThreads(), 2U) - 1;
+		}
+
+		queues_ = MakeUniquePtr<WorkQueue[]>(num_workers + 1);
+		workers_.reserve(num_workers);
+		for (uint32_t i = 0; i < num_workers; ++ i)
+		{
+			workers_.emplace_back([this, i] { this->WorkerFunc(i); });
+		}
+	}
+
+	JobSystem::~JobSystem()
+	{
+		{
+			std::lock_guard<std::mutex> lock(sleep_mutex_);
+			quit_ = true;
+		}
+		sleep_cond_.notify_all();
+
+		for (auto& worker : workers_)
+		{
+			worker.join();
+		}
+	}
+
+	void JobSystem::Schedule(Job job, Counter* counter)
+	{
+		if (counter != nullptr)
+		{
+			counter->count_.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		this->Push(this->CurrentQueueIndex(), QueuedJob{std::move(job), counter});
+	}
+
+	void JobSystem::Continue(Counter& dependency, Job job, Counter* counter)
+	{
+		if (counter != nullptr)
+		{
+			counter->count_.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(dependency.continuation_mutex_);
+			if (dependency.count_.load(std::memory_order_acquire) != 0)
+			{
+				dependency.continuations_.emplace_back(std::move(job), counter);
+				return;
+			}
+		}
+
+		this->Push(this->CurrentQueueIndex(), QueuedJob{std::move(job), counter});
+	}
+
+	void JobSystem::Wait(Counter& counter)
+	{
+		uint32_t const queue_index = this->CurrentQueueIndex();
+		while (!counter.Done())
+		{
+			if (!this->RunOneJob(queue_index))
+			{
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	uint32_t JobSystem::CurrentQueueIndex() const noexcept
+	{
+		return (tls_job_system == this) ? tls_worker_index : this->NumWorkers();
+	}
+
+	void JobSystem::Push(uint32_t queue_index, QueuedJob&& job)
+	{
+		// Pairs with the increment of num_sleeping_workers_ in WorkerFunc. Either the worker sees the new job, or we see
+		//  the sleeping worker and wake it up.
+		num_pending_jobs_.fetch_add(1);
+		{
+			auto& queue = queues_[queue_index];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			queue.jobs.push_back(std::move(job));
+		}
+
+		if (num_sleeping_workers_.load() > 0)
+		{
+			{
+				std::lock_guard<std::mutex> lock(sleep_mutex_);
+			}
+			sleep_cond_.notify_one();
+		}
+	}
+
+	bool JobSystem::Pop(uint32_t queue_index, QueuedJob& job)
+	{
+		auto& queue = queues_[queue_index];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (queue.jobs.empty())
+		{
+			return false;
+		}
+
+		job = std::move(queue.jobs.back());
+		queue.jobs.pop_back();
+		return true;
+	}
+
+	bool JobSystem::Steal(uint32_t thief_index, QueuedJob& job)
+	{
+		uint32_t const num_queues = this->NumWorkers() + 1;
+		for (uint32_t i = 1; i < num_queues; ++ i)
+		{
+			auto& queue = queues_[(thief_index + i) % num_queues];
+			std::unique_lock<std::mutex> lock(queue.mutex, std::try_to_lock);
+			if (lock.owns_lock() && !queue.jobs.empty())
+			{
+				job = std::move(queue.jobs.front());
+				queue.jobs.pop_front();
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	bool JobSystem::RunOneJob(uint32_t queue_index)
+	{
+		if (num_pending_jobs_.load(std::memory_order_relaxed) == 0)
+		{
+			return false;
+		}
+
+		QueuedJob job;
+		if (this->Pop(queue_index, job) || this->Steal(queue_index, job))
+		{
+			num_pending_jobs_.fetch_sub(1, std::memory_order_relaxed);
+
+			// The counter must drop even if the job throws, or its waiter never returns
+			try
+			{
+				job.job();
+			}
+			catch (...)
+			{
+				this->FinishJob(job.counter);
+				throw;
+			}
+			this->FinishJob(job.counter);
+			return true;
+		}
+
+		return false;
+	}
+
+	void JobSystem::FinishJob(Counter* counter)
+	{
+		if (counter == nullptr)
+		{
+			return;
+		}
+
+		// finishing_ keeps Done() false until the continuations are drained, so the waiter can't destroy the counter
+		//  while it's still in use here.
+		counter->finishing_.fetch_add(1, std::memory_order_acq_rel);
+		if (counter->count_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		{
+			std::vector<std::pair<Job, Counter*>> continuations;
+			{
+				std::lock_guard<std::mutex> lock(counter->continuation_mutex_);
+				continuations.swap(counter->continuations_);
+			}
+			counter->finishing_.fetch_sub(1, std::memory_order_acq_rel);
+
+			uint32_t const queue_index = this->CurrentQueueIndex();
+			for (auto& continuation : continuations)
+			{
+				this->Push(queue_index, QueuedJob{std::move(continuation.first), continuation.second});
+			}
+		}
+		else
+		{
+			counter->finishing_.fetch_sub(1, std::memory_order_acq_rel);
+		}
+	}
+
+	void JobSystem::WorkerFunc(uint32_t index)
+	{
+		tls_job_system = this;
+		tls_worker_index = index;
+
+		uint32_t const SpinCount = 64;
+
+		for (;;)
+		{
+			bool found = false;
+			for (uint32_t spin = 0; spin < SpinCount; ++ spin)
+			{
+				if (this->RunOneJob(index))
+				{
+					found = true;
+					break;
+				}
+				std::this_thread::yield();
+			}
+
+			if (!found)
+			{
+				std::unique_lock<std::mutex> lock(sleep_mutex_);
+				num_sleeping_workers_.fetch_add(1);
+				sleep_cond_.wait(lock, [this] { return quit_ || (num_pending_jobs_.load() > 0); });
+				num_sleeping_workers_.fetch_sub(1);
+
+				if (quit_)
+				{
+					return;
+				}
+			}
+		}
+	}
 }
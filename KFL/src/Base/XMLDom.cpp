@@ -34,6 +34,7 @@
 #include <KFL/StringUtil.hpp>
 #include <KFL/Util.hpp>
 
+#include <cstring>
 #include <iterator>
 #include <string>
 #ifdef KLAYGE_CXX17_LIBRARY_CHARCONV_SUPPORT
@@ -73,12 +74,6 @@ using namespace KlayGE;
 
 namespace
 {
-	std::unique_ptr<XMLAttribute> CreateXmlAttribFromRapidXmlAttrib(XMLDocument& doc, rapidxml::xml_attribute<char> const& attrib)
-	{
-		return doc.AllocAttribString(
-			std::string_view(attrib.name(), attrib.name_size()), std::string_view(attrib.value(), attrib.value_size()));
-	}
-
 	rapidxml::xml_attribute<char>* CreateRapidXmlAttribFromXmlAttrib(rapidxml::xml_document<char>& doc, XMLAttribute const& attrib)
 	{
 		auto* ret = doc.allocate_attribute();
@@ -91,10 +86,10 @@ namespace
 		return ret;
 	}
 
-	std::unique_ptr<XMLNode> CreateXmlNodeFromRapidXmlNode(XMLDocument& doc, rapidxml::xml_node<char> const& node)
+	XMLNodeType XmlNodeTypeFromRapidXmlNodeType(rapidxml::node_type rapidxml_type)
 	{
 		XMLNodeType type;
-		switch (node.type())
+		switch (rapidxml_type)
 		{
 		case rapidxml::node_document:
 			type = XMLNodeType::Document;
@@ -130,19 +125,7 @@ namespace
 			break;
 		}
 
-		auto ret = doc.AllocNode(type, std::string_view(node.name(), node.name_size()));
-		ret->Value(std::string_view(node.value(), node.value_size()));
-
-		for (auto* child = node.first_node(); child; child = child->next_sibling())
-		{
-			ret->AppendNode(CreateXmlNodeFromRapidXmlNode(doc, *child));
-		}
-		for (auto* attr = node.first_attribute(); attr; attr = attr->next_attribute())
-		{
-			ret->AppendAttrib(CreateXmlAttribFromRapidXmlAttrib(doc, *attr));
-		}
-
-		return ret;
+		return type;
 	}
 
 	rapidxml::xml_node<char>* CreateRapidXmlNodeFromXmlNode(rapidxml::xml_document<char>& doc, XMLNode const& node)
@@ -203,7 +186,7 @@ namespace
 		return ret;
 	}
 
-	bool TryConvertStringToValue(std::string const& value_str, int32_t& val)
+	bool TryConvertStringToValue(std::string_view value_str, int32_t& val)
 	{
 #ifdef KLAYGE_CXX17_LIBRARY_CHARCONV_SUPPORT
 		char const* str = value_str.data();
@@ -212,7 +195,7 @@ namespace
 #else
 		try
 		{
-			val = std::stol(value_str);
+			val = std::stol(std::string(value_str));
 			return true;
 		}
 		catch (...)
@@ -222,7 +205,7 @@ namespace
 #endif
 	}
 
-	bool TryConvertStringToValue(std::string const& value_str, uint32_t& val)
+	bool TryConvertStringToValue(std::string_view value_str, uint32_t& val)
 	{
 #ifdef KLAYGE_CXX17_LIBRARY_CHARCONV_SUPPORT
 		char const* str = value_str.data();
@@ -231,7 +214,7 @@ namespace
 #else
 		try
 		{
-			val = std::stoul(value_str);
+			val = std::stoul(std::string(value_str));
 			return true;
 		}
 		catch (...)
@@ -241,7 +224,7 @@ namespace
 #endif
 	}
 
-	bool TryConvertStringToValue(std::string const& value_str, float& val)
+	bool TryConvertStringToValue(std::string_view value_str, float& val)
 	{
 #ifdef KLAYGE_CXX17_LIBRARY_CHARCONV_SUPPORT
 		char const* str = value_str.data();
@@ -250,7 +233,7 @@ namespace
 #else
 		try
 		{
-			val = std::stof(value_str);
+			val = std::stof(std::string(value_str));
 			return true;
 		}
 		catch (...)
@@ -260,9 +243,9 @@ namespace
 #endif
 	}
 
-	bool TryConvertStringToValue(std::string const& value_str, bool& val)
+	bool TryConvertStringToValue(std::string_view value_str, bool& val)
 	{
-		std::string lower_value_str = value_str;
+		std::string lower_value_str(value_str);
 		StringUtil::ToLower(lower_value_str);
 		if ((lower_value_str == "true") || (lower_value_str == "1"))
 		{
@@ -361,6 +344,27 @@ namespace KlayGE
 	{
 	}
 
+	void* XMLNode::operator new(size_t size)
+	{
+		return DomArena::AllocateObject(size, nullptr);
+	}
+
+	void* XMLNode::operator new(size_t size, DomArena& arena)
+	{
+		return DomArena::AllocateObject(size, &arena);
+	}
+
+	void XMLNode::operator delete(void* p) noexcept
+	{
+		DomArena::DeallocateObject(p);
+	}
+
+	void XMLNode::operator delete(void* p, DomArena& arena) noexcept
+	{
+		KFL_UNUSED(arena);
+		DomArena::DeallocateObject(p);
+	}
+
 	std::string_view XMLNode::Name() const
 	{
 		return name_;
@@ -368,7 +372,8 @@ namespace KlayGE
 
 	void XMLNode::Name(std::string_view name)
 	{
-		name_ = std::move(name);
+		name_storage_ = std::string(std::move(name));
+		name_ = name_storage_;
 	}
 
 	XMLNodeType XMLNode::Type() const
@@ -809,25 +814,50 @@ namespace KlayGE
 
 	void XMLNode::Value(int32_t value)
 	{
-		value_ = std::to_string(value);
+		value_storage_ = std::to_string(value);
+		value_ = value_storage_;
 	}
 
 	void XMLNode::Value(uint32_t value)
 	{
-		value_ = std::to_string(value);
+		value_storage_ = std::to_string(value);
+		value_ = value_storage_;
 	}
 
 	void XMLNode::Value(float value)
 	{
-		value_ = std::to_string(value);
+		value_storage_ = std::to_string(value);
+		value_ = value_storage_;
 	}
 
 	void XMLNode::Value(std::string_view value)
 	{
-		value_ = std::move(value);
+		value_storage_ = std::string(std::move(value));
+		value_ = value_storage_;
 	}
 
 
+	void* XMLAttribute::operator new(size_t size)
+	{
+		return DomArena::AllocateObject(size, nullptr);
+	}
+
+	void* XMLAttribute::operator new(size_t size, DomArena& arena)
+	{
+		return DomArena::AllocateObject(size, &arena);
+	}
+
+	void XMLAttribute::operator delete(void* p) noexcept
+	{
+		DomArena::DeallocateObject(p);
+	}
+
+	void XMLAttribute::operator delete(void* p, DomArena& arena) noexcept
+	{
+		KFL_UNUSED(arena);
+		DomArena::DeallocateObject(p);
+	}
+
 	std::string_view XMLAttribute::Name() const
 	{
 		return name_;
@@ -835,7 +865,8 @@ namespace KlayGE
 
 	void XMLAttribute::Name(std::string_view name)
 	{
-		name_ = std::move(name);
+		name_storage_ = std::string(std::move(name));
+		name_ = name_storage_;
 	}
 
 	XMLNode* XMLAttribute::Parent() const
@@ -918,38 +949,101 @@ namespace KlayGE
 
 	void XMLAttribute::Value(int32_t value)
 	{
-		value_ = std::to_string(value);
+		value_storage_ = std::to_string(value);
+		value_ = value_storage_;
 	}
 
 	void XMLAttribute::Value(uint32_t value)
 	{
-		value_ = std::to_string(value);
+		value_storage_ = std::to_string(value);
+		value_ = value_storage_;
 	}
 
 	void XMLAttribute::Value(float value)
 	{
-		value_ = std::to_string(value);
+		value_storage_ = std::to_string(value);
+		value_ = value_storage_;
 	}
 
 	void XMLAttribute::Value(std::string_view value)
 	{
-		value_ = std::move(value);
+		value_storage_ = std::string(std::move(value));
+		value_ = value_storage_;
 	}
 
 	std::unique_ptr<XMLDocument> LoadXml(ResIdentifier& source)
 	{
-		source.seekg(0, std::ios_base::end);
-		size_t const len = static_cast<size_t>(source.tellg());
-		source.seekg(0, std::ios_base::beg);
-		auto xml_src = MakeUniquePtr<char[]>(len + 1);
-		source.read(&xml_src[0], len);
+		auto ret = MakeUniquePtr<XMLDocument>();
+		DomArena& arena = ret->arena_;
+
+		// rapidxml parses in situ, so it needs a writable, null-terminated copy. The copy lives in the document's arena, and
+		// names and values of the loaded nodes point into it.
+		auto const data = source.Data();
+		size_t len;
+		char* xml_src;
+		if (!data.empty())
+		{
+			len = data.size();
+			xml_src = arena.AllocateString(len + 1);
+			std::memcpy(xml_src, data.data(), len);
+		}
+		else
+		{
+			source.seekg(0, std::ios_base::end);
+			len = static_cast<size_t>(source.tellg());
+			source.seekg(0, std::ios_base::beg);
+			xml_src = arena.AllocateString(len + 1);
+			source.read(xml_src, len);
+		}
 		xml_src[len] = 0;
 
 		rapidxml::xml_document<char> doc;
-		doc.parse<0>(xml_src.get());
+		doc.parse<0>(xml_src);
 
-		auto ret = MakeUniquePtr<XMLDocument>();
-		ret->RootNode(CreateXmlNodeFromRapidXmlNode(*ret, *doc.first_node()));
+		auto alloc_node = [&arena](rapidxml::xml_node<char> const& node) {
+			std::unique_ptr<XMLNode> new_node(new (arena) XMLNode(XmlNodeTypeFromRapidXmlNodeType(node.type())));
+			new_node->name_ = std::string_view(node.name(), node.name_size());
+			new_node->value_ = std::string_view(node.value(), node.value_size());
+			return new_node;
+		};
+
+		auto const* root = doc.first_node();
+		ret->RootNode(alloc_node(*root));
+
+		std::vector<std::pair<rapidxml::xml_node<char> const*, XMLNode*>> pending_nodes;
+		pending_nodes.emplace_back(root, ret->RootNode());
+		while (!pending_nodes.empty())
+		{
+			auto const [node, xml_node] = pending_nodes.back();
+			pending_nodes.pop_back();
+
+			uint32_t num_children = 0;
+			for (auto* child = node->first_node(); child; child = child->next_sibling())
+			{
+				++ num_children;
+			}
+			uint32_t num_attrs = 0;
+			for (auto* attr = node->first_attribute(); attr; attr = attr->next_attribute())
+			{
+				++ num_attrs;
+			}
+			xml_node->children_.reserve(num_children);
+			xml_node->attrs_.reserve(num_attrs);
+
+			for (auto* child = node->first_node(); child; child = child->next_sibling())
+			{
+				auto xml_child = alloc_node(*child);
+				pending_nodes.emplace_back(child, xml_child.get());
+				xml_node->AppendNode(std::move(xml_child));
+			}
+			for (auto* attr = node->first_attribute(); attr; attr = attr->next_attribute())
+			{
+				std::unique_ptr<XMLAttribute> xml_attr(new (arena) XMLAttribute);
+				xml_attr->name_ = std::string_view(attr->name(), attr->name_size());
+				xml_attr->value_ = std::string_view(attr->value(), attr->value_size());
+				xml_node->AppendAttrib(std::move(xml_attr));
+			}
+		}
 
 		return ret;
 	}
@@ -34,6 +34,9 @@
 #ifdef SIMD_MATH_SSE
 	#include <emmintrin.h>
 #endif
+#ifdef KLAYGE_AVX_SUPPORT
+	#include <immintrin.h>
+#endif
 
 namespace KlayGE
 {
@@ -2155,6 +2158,117 @@ namespace KlayGE
 			proj.Col(2, clip_plane * SetVector(c));
 		}
 
+		// Bound
+		///////////////////////////////////////////////////////////////////////////////
+		void IntersectAABBsFrustum(float const * min_x, float const * min_y, float const * min_z,
+			float const * max_x, float const * max_y, float const * max_z, uint32_t num,
+			Frustum const & frustum, BoundOverlap* results)
+		{
+			BOOST_ASSERT((num & 3) == 0);
+
+			// For each plane, v0 is the corner farthest along the normal and v1 is diagonally opposed to it.
+			// The sign of the normal is the same for all boxes, so the corners are picked per plane instead of per box.
+			std::array<float const *, 6> v0[3];
+			std::array<float const *, 6> v1[3];
+			for (int p = 0; p < 6; ++ p)
+			{
+				Plane const & plane = frustum.FrustumPlane(p);
+				v0[0][p] = (plane.a() < 0) ? min_x : max_x;
+				v0[1][p] = (plane.b() < 0) ? min_y : max_y;
+				v0[2][p] = (plane.c() < 0) ? min_z : max_z;
+				v1[0][p] = (plane.a() < 0) ? max_x : min_x;
+				v1[1][p] = (plane.b() < 0) ? max_y : min_y;
+				v1[2][p] = (plane.c() < 0) ? max_z : min_z;
+			}
+
+			static BoundOverlap const overlaps[] = { BoundOverlap::Yes, BoundOverlap::Partial, BoundOverlap::No, BoundOverlap::No };
+
+			uint32_t i = 0;
+#if defined(KLAYGE_AVX_SUPPORT)
+			{
+				__m256 const zero = _mm256_setzero_ps();
+				for (; i + 8 <= num; i += 8)
+				{
+					__m256 outside = zero;
+					__m256 intersect = zero;
+					for (int p = 0; p < 6; ++ p)
+					{
+						Plane const & plane = frustum.FrustumPlane(p);
+						__m256 const a = _mm256_set1_ps(plane.a());
+						__m256 const b = _mm256_set1_ps(plane.b());
+						__m256 const c = _mm256_set1_ps(plane.c());
+						__m256 const d = _mm256_set1_ps(plane.d());
+
+						__m256 const dot0 = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(
+							_mm256_mul_ps(a, _mm256_loadu_ps(v0[0][p] + i)), _mm256_mul_ps(b, _mm256_loadu_ps(v0[1][p] + i))),
+							_mm256_mul_ps(c, _mm256_loadu_ps(v0[2][p] + i))), d);
+						__m256 const dot1 = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(
+							_mm256_mul_ps(a, _mm256_loadu_ps(v1[0][p] + i)), _mm256_mul_ps(b, _mm256_loadu_ps(v1[1][p] + i))),
+							_mm256_mul_ps(c, _mm256_loadu_ps(v1[2][p] + i))), d);
+
+						outside = _mm256_or_ps(outside, _mm256_cmp_ps(dot0, zero, _CMP_LT_OQ));
+						intersect = _mm256_or_ps(intersect, _mm256_cmp_ps(dot1, zero, _CMP_LT_OQ));
+					}
+
+					int const outside_mask = _mm256_movemask_ps(outside);
+					int const intersect_mask = _mm256_movemask_ps(intersect);
+					for (uint32_t j = 0; j < 8; ++ j)
+					{
+						results[i + j] = overlaps[(((outside_mask >> j) & 1) << 1) | ((intersect_mask >> j) & 1)];
+					}
+				}
+			}
+#endif
+#if defined(SIMD_MATH_SSE)
+			{
+				__m128 const zero = _mm_setzero_ps();
+				for (; i < num; i += 4)
+				{
+					__m128 outside = zero;
+					__m128 intersect = zero;
+					for (int p = 0; p < 6; ++ p)
+					{
+						Plane const & plane = frustum.FrustumPlane(p);
+						__m128 const a = _mm_set1_ps(plane.a());
+						__m128 const b = _mm_set1_ps(plane.b());
+						__m128 const c = _mm_set1_ps(plane.c());
+						__m128 const d = _mm_set1_ps(plane.d());
+
+						__m128 const dot0 = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+							_mm_mul_ps(a, _mm_load_ps(v0[0][p] + i)), _mm_mul_ps(b, _mm_load_ps(v0[1][p] + i))),
+							_mm_mul_ps(c, _mm_load_ps(v0[2][p] + i))), d);
+						__m128 const dot1 = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+							_mm_mul_ps(a, _mm_load_ps(v1[0][p] + i)), _mm_mul_ps(b, _mm_load_ps(v1[1][p] + i))),
+							_mm_mul_ps(c, _mm_load_ps(v1[2][p] + i))), d);
+
+						outside = _mm_or_ps(outside, _mm_cmplt_ps(dot0, zero));
+						intersect = _mm_or_ps(intersect, _mm_cmplt_ps(dot1, zero));
+					}
+
+					int const outside_mask = _mm_movemask_ps(outside);
+					int const intersect_mask = _mm_movemask_ps(intersect);
+					for (uint32_t j = 0; j < 4; ++ j)
+					{
+						results[i + j] = overlaps[(((outside_mask >> j) & 1) << 1) | ((intersect_mask >> j) & 1)];
+					}
+				}
+			}
+#else
+			for (; i < num; ++ i)
+			{
+				bool outside = false;
+				bool intersect = false;
+				for (int p = 0; p < 6; ++ p)
+				{
+					Plane const & plane = frustum.FrustumPlane(p);
+					outside |= (plane.a() * v0[0][p][i] + plane.b() * v0[1][p][i] + plane.c() * v0[2][p][i] + plane.d() < 0);
+					intersect |= (plane.a() * v1[0][p][i] + plane.b() * v1[1][p][i] + plane.c() * v1[2][p][i] + plane.d() < 0);
+				}
+				results[i] = overlaps[(outside ? 2 : 0) | (intersect ? 1 : 0)];
+			}
+#endif
+		}
+
 		// Color
 		///////////////////////////////////////////////////////////////////////////////
 		SIMDVectorF4 NegativeColor(SIMDVectorF4 const & rhs)
@@ -0,0 +1,100 @@
+/**
+ * @file AnimationEvaluator.hpp
+ * @author Minmin Gong
+ *
+ * @section DESCRIPTION
+ *
+ * This source file is part of KlayGE
+ * For the latest info, see http://www.klayge.org
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * You may alternatively use this source under the terms of
+ * the KlayGE Proprietary License (KPL). You can obtained such a license
+ * from http://www.klayge.org/licensing/.
+ */
+
+#ifndef KLAYGE_CORE_ANIMATION_EVALUATOR_HPP
+#define KLAYGE_CORE_ANIMATION_EVALUATOR_HPP
+
+#pragma once
+
+#include <KlayGE/PreDeclare.hpp>
+#include <KFL/CXX20/span.hpp>
+#include <KFL/Quaternion.hpp>
+
+#include <vector>
+
+namespace KlayGE
+{
+	// Evaluates the key frames of a skeleton and chains every joint to its parent, with the same result as KeyFrameSet::Frame
+	//  followed by the parent composition of SkinnedModel. The skeleton is kept as flat parent index arrays. Every track has a
+	//  cursor to the key frame segment it sampled last, along with the screw parameters of that segment, so a frame costs one
+	//  sincos and a few dual quaternion products per joint. The interpolation runs on 4 tracks at a time in SoA layout.
+	class KLAYGE_CORE_API AnimationEvaluator final : boost::noncopyable
+	{
+	public:
+		AnimationEvaluator();
+
+		// parents[i] is the index of the parent joint of joint i, or -1 for a root. Parents have to come before their children.
+		void Bind(std::vector<int32_t> parents, std::shared_ptr<std::vector<KeyFrameSet>> const & key_frame_sets);
+
+		uint32_t NumJoints() const
+		{
+			return static_cast<uint32_t>(parents_.size());
+		}
+
+		void Evaluate(float frame);
+
+		std::span<Quaternion const> BindReals() const
+		{
+			return bind_reals_;
+		}
+		std::span<Quaternion const> BindDuals() const
+		{
+			return bind_duals_;
+		}
+		std::span<float const> BindScales() const
+		{
+			return bind_scales_;
+		}
+
+	private:
+		void UpdateSegment(uint32_t track, float frame);
+		void InterpolateTracks();
+		void ComposeJoints();
+		void ComposeMirroredJoint(uint32_t joint, Quaternion const & key_real, Quaternion const & key_dual, float key_scale);
+
+	private:
+		std::vector<int32_t> parents_;
+		std::shared_ptr<std::vector<KeyFrameSet>> key_frame_sets_;
+
+		uint32_t num_padded_tracks_;
+		std::vector<uint32_t> cursors_;
+		// Channels of every track are stored channel by channel, num_padded_tracks_ apart
+		std::vector<float> segments_;
+		std::vector<float> locals_;
+		// Joint indices grouped by depth, each group padded with -1 to whole batches
+		std::vector<int32_t> compose_order_;
+
+		std::vector<Quaternion> bind_reals_;
+		std::vector<Quaternion> bind_duals_;
+		std::vector<float> bind_scales_;
+	};
+} // namespace KlayGE
+
+#endif // KLAYGE_CORE_ANIMATION_EVALUATOR_HPP
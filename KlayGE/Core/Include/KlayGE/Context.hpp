@@ -174,6 +174,10 @@ namespace KlayGE
 		{
 			return *gtp_instance_;
 		}
+		JobSystem& JobSystemInstance()
+		{
+			return *job_system_instance_;
+		}
 
 	private:
 		void DestroyAll();
@@ -216,6 +220,7 @@ namespace KlayGE
 #endif
 
 		std::unique_ptr<ThreadPool> gtp_instance_;
+		std::unique_ptr<JobSystem> job_system_instance_;
 	};
 }
 
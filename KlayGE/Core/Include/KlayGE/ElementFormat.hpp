@@ -673,6 +673,8 @@ namespace KlayGE
 
 	KLAYGE_CORE_API void ConvertToABGR32F(ElementFormat fmt, void const * input, uint32_t num_elems, Color* output);
 	KLAYGE_CORE_API void ConvertFromABGR32F(ElementFormat fmt, Color const * input, uint32_t num_elems, void* output);
+	// Converts between two uncompressed formats. Common pairs skip the ABGR32F intermediate.
+	KLAYGE_CORE_API void ConvertFormat(ElementFormat dst_fmt, void* output, ElementFormat src_fmt, void const * input, uint32_t num_elems);
 
 
 	enum ElementAccessHint
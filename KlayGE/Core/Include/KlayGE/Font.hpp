@@ -84,9 +84,13 @@ namespace KlayGE
 			std::wstring_view text, float font_size, uint32_t align);
 		void RenderText(float4x4 const & mvp, Color const & clr, std::wstring_view text, float font_size);
 
+	private:
+		void AttachOverlayNode();
+
 	private:
 		std::shared_ptr<FontRenderable> font_renderable_;
 		uint32_t fsn_attrib_;
+		SceneNodePtr overlay_node_;
 	};
 
 	KLAYGE_CORE_API FontPtr SyncLoadFont(std::string_view font_name, uint32_t flags = 0);
@@ -342,11 +342,13 @@ namespace KlayGE
 		void AssignJoints(ForwardIterator first, ForwardIterator last)
 		{
 			joints_.assign(first, last);
+			animation_evaluator_.reset();
 			this->UpdateBinds();
 		}
 		void AttachKeyFrameSets(std::shared_ptr<std::vector<KeyFrameSet>> const & kf)
 		{
 			key_frame_sets_ = kf;
+			animation_evaluator_.reset();
 		}
 		std::shared_ptr<std::vector<KeyFrameSet>> const & GetKeyFrameSets() const
 		{
@@ -396,6 +398,7 @@ namespace KlayGE
 		std::vector<float4> bind_duals_;
 
 		std::shared_ptr<std::vector<KeyFrameSet>> key_frame_sets_;
+		AnimationEvaluatorPtr animation_evaluator_;
 		float last_frame_;
 
 		uint32_t num_frames_;
@@ -35,7 +35,10 @@
 
 #include <KlayGE/PreDeclare.hpp>
 
+#include <string>
 #include <string_view>
+#include <unordered_map>
+#include <vector>
 
 struct IInArchive;
 
@@ -55,8 +58,15 @@ namespace KlayGE
 			return archive_is_.get();
 		}
 
+		// Paths of all the extractable files in the archive, '/' separated, in archive order
+		std::vector<std::string> const& FilePaths() const
+		{
+			return file_paths_;
+		}
+
 	private:
-		uint32_t Find(std::string_view extract_file_path);
+		void BuildDirectory();
+		uint32_t Find(std::string_view extract_file_path) const;
 
 	private:
 		ResIdentifierPtr archive_is_;
@@ -65,6 +75,10 @@ namespace KlayGE
 		std::string password_;
 
 		uint32_t num_items_;
+
+		std::vector<std::string> file_paths_;
+		// Lower-cased path to item index. Items that can't be extracted map to 0xFFFFFFFF.
+		std::unordered_map<std::string, uint32_t> directory_;
 	};
 }
 
@@ -55,6 +55,28 @@ namespace KlayGE
 		float init_life;
 	};
 
+	// Particles in structure-of-arrays layout, so the updaters can go through a whole range of them at once
+	struct KLAYGE_CORE_API ParticleArrays
+	{
+		std::vector<float> pos_x;
+		std::vector<float> pos_y;
+		std::vector<float> pos_z;
+		std::vector<float> vel_x;
+		std::vector<float> vel_y;
+		std::vector<float> vel_z;
+		std::vector<float> life;
+		std::vector<float> spin;
+		std::vector<float> size;
+		std::vector<float> alpha;
+		std::vector<float> init_life;
+
+		void Resize(uint32_t num);
+
+		Particle Get(uint32_t index) const;
+		void Set(uint32_t index, Particle const & par);
+		void Move(uint32_t from, uint32_t to);
+	};
+
 	class KLAYGE_CORE_API ParticleEmitter : boost::noncopyable
 	{
 	public:
@@ -211,7 +233,8 @@ namespace KlayGE
 		virtual std::string const & Type() const = 0;
 		virtual ParticleUpdaterPtr Clone() = 0;
 
-		virtual void Update(Particle& par, float elapse_time) = 0;
+		// Updates the particles in [begin, end). It's called from several threads at the same time on different ranges.
+		virtual void Update(ParticleArrays& particles, uint32_t begin, uint32_t end, float elapse_time) = 0;
 		virtual void SnapParams() = 0;
 
 	protected:
@@ -289,19 +312,20 @@ namespace KlayGE
 
 		uint32_t NumParticles() const
 		{
-			return static_cast<uint32_t>(particles_.size());
+			return max_num_particles_;
 		}
 		uint32_t NumActiveParticles() const;
 		uint32_t GetActiveParticleIndex(uint32_t i) const;
-		Particle const & GetParticle(uint32_t i) const
+		// Active particles are kept at the front of the arrays, in no particular order
+		Particle GetParticle(uint32_t i) const
 		{
-			BOOST_ASSERT(i < particles_.size());
-			return particles_[i];
+			BOOST_ASSERT(i < max_num_particles_);
+			return particles_.Get(i);
 		}
-		Particle& GetParticle(uint32_t i)
+		void SetParticle(uint32_t i, Particle const & par)
 		{
-			BOOST_ASSERT(i < particles_.size());
-			return particles_[i];
+			BOOST_ASSERT(i < max_num_particles_);
+			particles_.Set(i, par);
 		}
 		void ClearParticles();
 
@@ -339,10 +363,21 @@ namespace KlayGE
 		std::vector<ParticleEmitterPtr> emitters_;
 		std::vector<ParticleUpdaterPtr> updaters_;
 
-		std::vector<Particle> particles_;
-		std::vector<std::pair<uint32_t, float>> actived_particles_;
+		ParticleArrays particles_;
+		uint32_t max_num_particles_;
+		uint32_t num_particles_ = 0;
+
+		// Indices of the active particles in drawing order, and their instance data laid out as the vertex buffer wants
+		std::vector<uint32_t> actived_particles_;
+		std::vector<float4> particle_instances_;
 		mutable std::mutex actived_particles_mutex_;
 
+		std::vector<uint32_t> sort_keys_;
+		std::vector<uint32_t> sort_tmp_keys_;
+		std::vector<uint32_t> sort_tmp_indices_;
+		std::vector<float3> range_min_bbs_;
+		std::vector<float3> range_max_bbs_;
+
 		float gravity_;
 		float3 force_;
 		float media_density_;
@@ -417,7 +452,7 @@ namespace KlayGE
 			return opacity_over_life_;
 		}
 
-		void Update(Particle& par, float elapse_time) override;
+		void Update(ParticleArrays& particles, uint32_t begin, uint32_t end, float elapse_time) override;
 		void SnapParams() override;
 
 	private:
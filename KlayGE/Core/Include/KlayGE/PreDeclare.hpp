@@ -49,6 +49,8 @@ namespace KlayGE
 	using SceneComponentPtr = std::shared_ptr<SceneComponent>;
 	class SceneNode;
 	using SceneNodePtr = std::shared_ptr<SceneNode>;
+	class PosBoundWSStore;
+	using PosBoundWSStorePtr = std::shared_ptr<PosBoundWSStore>;
 	class SceneObjectLightSourceProxy;
 	using SceneObjectLightSourceProxyPtr = std::shared_ptr<SceneObjectLightSourceProxy>;
 	class SceneObjectCameraProxy;
@@ -178,6 +180,9 @@ namespace KlayGE
 	typedef std::shared_ptr<SkinnedModel> SkinnedModelPtr;
 	class SkinnedMesh;
 	typedef std::shared_ptr<SkinnedMesh> SkinnedMeshPtr;
+	struct KeyFrameSet;
+	class AnimationEvaluator;
+	typedef std::shared_ptr<AnimationEvaluator> AnimationEvaluatorPtr;
 	class RenderableLightSourceProxy;
 	typedef std::shared_ptr<RenderableLightSourceProxy> RenderableLightSourceProxyPtr;
 	class RenderableCameraProxy;
@@ -478,8 +478,13 @@ namespace KlayGE
 		}
 		RenderEffectParameter* ParameterBySemantic(std::string_view semantic) noexcept;
 		RenderEffectParameter const* ParameterBySemantic(std::string_view semantic) const noexcept;
+		RenderEffectParameter* ParameterBySemantic(size_t semantic_hash) noexcept;
+		RenderEffectParameter const* ParameterBySemantic(size_t semantic_hash) const noexcept;
 		RenderEffectParameter* ParameterByName(std::string_view name) noexcept;
 		RenderEffectParameter const* ParameterByName(std::string_view name) const noexcept;
+		// Takes a precomputed hash, usually CT_HASH("name"), to skip hashing the string at runtime
+		RenderEffectParameter* ParameterByName(size_t name_hash) noexcept;
+		RenderEffectParameter const* ParameterByName(size_t name_hash) const noexcept;
 		RenderEffectParameter* ParameterByIndex(uint32_t n) noexcept;
 		RenderEffectParameter const* ParameterByIndex(uint32_t n) const noexcept;
 
@@ -506,6 +511,7 @@ namespace KlayGE
 			return static_cast<uint32_t>(immutable_->techniques.size());
 		}
 		RenderTechnique* TechniqueByName(std::string_view name) const noexcept;
+		RenderTechnique* TechniqueByName(size_t name_hash) const noexcept;
 		RenderTechnique* TechniqueByIndex(uint32_t n) const noexcept;
 
 		uint32_t NumShaderFragments() const noexcept
@@ -553,6 +559,10 @@ namespace KlayGE
 		void Load(XMLNode const& root);
 #endif
 
+		void BuildLookupIndices();
+		uint32_t ParameterIndexByName(size_t name_hash) const noexcept;
+		uint32_t ParameterIndexBySemantic(size_t semantic_hash) const noexcept;
+
 	private:
 		struct Immutable final : boost::noncopyable
 		{
@@ -578,6 +588,11 @@ namespace KlayGE
 			std::vector<ShaderDesc> shader_descs;
 
 			std::vector<RenderShaderGraphNode> shader_graph_nodes;
+
+			// (hash, index) pairs sorted by hash. Shared by all clones, since they keep the same parameter order.
+			std::vector<std::pair<size_t, uint32_t>> param_name_index;
+			std::vector<std::pair<size_t, uint32_t>> param_semantic_index;
+			std::vector<std::pair<size_t, uint32_t>> tech_name_index;
 		};
 
 		std::shared_ptr<Immutable> immutable_;
@@ -208,6 +208,20 @@ namespace KlayGE
 			return instances_[index];
 		}
 
+		// Scene-node instances without instance format are drawn in batches, with their transforms packed into the camera slots
+		void AutoInstancing(bool auto_instancing)
+		{
+			auto_instancing_ = auto_instancing;
+		}
+		bool AutoInstancing() const
+		{
+			return auto_instancing_;
+		}
+		uint32_t NumDrawsSaved() const
+		{
+			return num_draws_saved_;
+		}
+
 		virtual void ModelMatrix(float4x4 const & mat);
 		virtual void InverseModelMatrix(float4x4 const& mat);
 		virtual void PrevModelMatrix(float4x4 const& mat);
@@ -299,6 +313,9 @@ namespace KlayGE
 		virtual RenderTechnique* PassTech(PassType type) const;
 		virtual void UpdateTechniques();
 
+		RenderTechnique* AutoInstancingTech() const;
+		void RenderAutoInstances(RenderEffect const & effect, RenderTechnique const & tech, RenderLayout const & layout);
+
 	protected:
 		std::wstring name_;
 
@@ -308,6 +325,11 @@ namespace KlayGE
 		std::vector<SceneNode const *> instances_;
 		SceneNode const * curr_node_ = nullptr;
 
+		bool auto_instancing_ = false;
+		uint32_t num_draws_saved_ = 0;
+		SceneNode const * const * batch_nodes_ = nullptr;
+		uint32_t num_batch_nodes_ = 0;
+
 		RenderEffectPtr effect_;
 		RenderTechnique* technique_ = nullptr;
 
@@ -34,8 +34,14 @@
 #pragma once
 
 #include <KlayGE/PreDeclare.hpp>
+#include <array>
+#include <atomic>
+#include <deque>
 #include <istream>
+#include <list>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include <KFL/ResIdentifier.hpp>
@@ -47,6 +53,16 @@ struct AAsset;
 
 namespace KlayGE
 {
+	enum class ResLoadingPriority : uint32_t
+	{
+		Visible = 0,	// Needed by something on screen right now
+		Normal,
+		Prefetch,		// Speculative loading, the first to be cancelled
+
+		NumPriorities,
+	};
+	uint32_t constexpr NumResLoadingPriorities = static_cast<uint32_t>(ResLoadingPriority::NumPriorities);
+
 	class KLAYGE_CORE_API ResLoadingDesc : boost::noncopyable
 	{
 	public:
@@ -66,10 +82,27 @@ namespace KlayGE
 		virtual bool HasSubThreadStage() const = 0;
 
 		virtual bool Match(ResLoadingDesc const & rhs) const = 0;
+		// Two descs that Match() must have the same hash
+		virtual uint64_t Hash() const = 0;
 		virtual void CopyDataFrom(ResLoadingDesc const & rhs) = 0;
 		virtual std::shared_ptr<void> CloneResourceFrom(std::shared_ptr<void> const & resource) = 0;
 
 		virtual std::shared_ptr<void> Resource() const = 0;
+
+		// Bytes the loaded resource occupies in the resident cache. 0 means it's never kept resident.
+		virtual uint64_t ResidentSize() const
+		{
+			return 0;
+		}
+	};
+
+	struct ResCacheStatistics
+	{
+		uint64_t hits = 0;
+		uint64_t misses = 0;
+		uint64_t evictions = 0;
+		uint64_t resident_evictions = 0;
+		uint32_t num_loaded = 0;
 	};
 
 	class KLAYGE_CORE_API ResLoader final : boost::noncopyable
@@ -97,11 +130,22 @@ namespace KlayGE
 
 		ResIdentifierPtr Open(std::string_view name);
 		std::string Locate(std::string_view name);
+
+		// Locate and Open answer existence checks from directory snapshots. The snapshots are dropped on Mount and Unmount, and
+		//  kept up to date with inotify on Linux, where missing directories are cached too. On other platforms a lookup that
+		//  misses everywhere is verified against the file system. NumAvoidedStats() only counts the answers that aren't verified.
+		void InvalidateLookupCache();
+		uint64_t NumAvoidedStats() const
+		{
+			return num_avoided_stats_;
+		}
 		uint64_t Timestamp(std::string_view name);
 		std::string AbsPath(std::string_view path);
 
 		std::shared_ptr<void> SyncQuery(ResLoadingDescPtr const & res_desc);
-		std::shared_ptr<void> ASyncQuery(ResLoadingDescPtr const & res_desc);
+		std::shared_ptr<void> ASyncQuery(ResLoadingDescPtr const & res_desc,
+			ResLoadingPriority priority = ResLoadingPriority::Normal);
+		// Also cancels the sub thread stage of res if it's still in the queue
 		void Unload(std::shared_ptr<void> const & res);
 
 		template <typename T>
@@ -111,9 +155,10 @@ namespace KlayGE
 		}
 
 		template <typename T>
-		std::shared_ptr<T> ASyncQueryT(ResLoadingDescPtr const & res_desc)
+		std::shared_ptr<T> ASyncQueryT(ResLoadingDescPtr const & res_desc,
+			ResLoadingPriority priority = ResLoadingPriority::Normal)
 		{
-			return std::static_pointer_cast<T>(this->ASyncQuery(res_desc));
+			return std::static_pointer_cast<T>(this->ASyncQuery(res_desc, priority));
 		}
 
 		template <typename T>
@@ -129,7 +174,57 @@ namespace KlayGE
 			return static_cast<uint32_t>(loading_res_.size());
 		}
 
+		uint32_t NumLoadingThreads() const
+		{
+			return static_cast<uint32_t>(loading_threads_.size());
+		}
+
+		ResCacheStatistics CacheStatistics() const;
+		void ResetCacheStatistics();
+
+		// Keeps up to budget bytes of the most recently unloaded resources of a ResLoadingDesc::Type() alive after all the
+		// users drop them. 0, the default, means no resident cache for that type.
+		void ResidentBudget(uint64_t type, uint64_t budget);
+		uint64_t ResidentBudget(uint64_t type) const;
+		// Only resources no one else holds are resident. Both pick up the resources dropped since the last Update().
+		uint64_t ResidentBytes(uint64_t type);
+		uint32_t NumResidentResources(uint64_t type);
+		void ClearResidentResources();
+
 	private:
+		enum LoadingStatus
+		{
+			LS_Loading,
+			LS_Complete,
+			LS_CanBeRemoved
+		};
+
+		struct LoadingResource
+		{
+			ResLoadingDescPtr res_desc;
+			std::shared_ptr<std::atomic<LoadingStatus>> status;
+			// Main thread stages run in the order of the queries, so a desc always comes before the ones cloned from it
+			uint64_t order;
+		};
+
+		struct ResidentResource
+		{
+			std::shared_ptr<void> res;
+			uint64_t type;
+			uint64_t size;
+		};
+
+		struct ResidentCategory
+		{
+			uint64_t budget = 0;
+			// Of the resources in lru only
+			uint64_t bytes = 0;
+			// Loaded resources that are still in use. They wait here until the cache holds the last reference.
+			std::list<ResidentResource> referenced;
+			// Resources no one else holds, the most recently unloaded in the front
+			std::list<ResidentResource> lru;
+		};
+
 		std::string RealPath(std::string_view path);
 		std::string RealPath(std::string_view path,
 			std::string& package_path, std::string& password, std::string& path_in_package);
@@ -138,10 +233,25 @@ namespace KlayGE
 
 		void AddLoadedResource(ResLoadingDescPtr const & res_desc, std::shared_ptr<void> const & res);
 		std::shared_ptr<void> FindMatchLoadedResource(ResLoadingDescPtr const & res_desc);
+		std::shared_ptr<std::atomic<LoadingStatus>> FindMatchLoadingResource(ResLoadingDescPtr const & res_desc);
 		void RemoveUnrefResources();
 
+		void AddResidentResource(ResLoadingDescPtr const & res_desc, std::shared_ptr<void> const & res);
+		void ReuseResidentResource(void const * res);
+		void CollectUnrefResidentResources(std::vector<std::shared_ptr<void>>& evicted);
+		void TrimResidentResources(ResidentCategory& category, std::vector<std::shared_ptr<void>>& evicted);
+
+		void EnqueueLoadingResource(ResLoadingDescPtr const & res_desc, std::shared_ptr<std::atomic<LoadingStatus>> const & status,
+			ResLoadingPriority priority);
+		void PromoteLoadingResource(std::shared_ptr<std::atomic<LoadingStatus>> const & status, ResLoadingPriority priority);
+		void CancelLoadingResource(std::shared_ptr<void> const & res);
 		void LoadingThreadFunc();
 
+		void RefreshLookupCache();
+		bool LookupCacheWatched() const;
+		bool CachedExists(std::string const & res_name, bool& from_snapshot);
+		void UpdateLookupCache(std::string const & res_name, bool exists);
+
 #if defined(KLAYGE_PLATFORM_ANDROID)
 		AAsset* LocateFileAndroid(std::string_view name);
 #elif defined(KLAYGE_PLATFORM_IOS)
@@ -153,30 +263,48 @@ namespace KlayGE
 	private:
 		static std::unique_ptr<ResLoader> res_loader_instance_;
 
-		enum LoadingStatus
-		{
-			LS_Loading,
-			LS_Complete,
-			LS_CanBeRemoved
-		};
-
 		std::string exe_path_;
 		std::string local_path_;
 		std::vector<std::tuple<uint64_t, uint32_t, std::string, PackagePtr>> paths_;
 		std::mutex paths_mutex_;
 
-		std::mutex loaded_mutex_;
-		std::mutex loading_mutex_;
-		std::vector<std::pair<ResLoadingDescPtr, std::weak_ptr<void>>> loaded_res_;
-		std::vector<std::pair<ResLoadingDescPtr, std::shared_ptr<volatile LoadingStatus>>> loading_res_;
+		// Directory to the names of its entries. Guarded by paths_mutex_.
+		std::unordered_map<std::string, std::unordered_set<std::string>> lookup_cache_;
+		std::atomic<uint64_t> num_avoided_stats_{0};
+#if defined(KLAYGE_PLATFORM_LINUX)
+		int lookup_watch_fd_ = -1;
+		// inotify hands out the same watch for every spelling of a directory, each of which is cached on its own. A missing
+		//  directory is cached under the watch of its nearest existing parent.
+		std::unordered_multimap<int, std::string> lookup_watches_;
+#endif
 
-		bool non_empty_loading_res_queue_ = false;
+		mutable std::mutex loaded_mutex_;
+		std::mutex loading_mutex_;
+		// Both keyed by ResLoadingDesc::Hash(). Matching descs always land in the same bucket.
+		std::unordered_multimap<uint64_t, std::pair<ResLoadingDescPtr, std::weak_ptr<void>>> loaded_res_;
+		std::unordered_multimap<uint64_t, LoadingResource> loading_res_;
+		uint64_t loading_res_order_ = 0;
+		// Number of ASyncQuery callers waiting on each loading status. Stateless queries share one entry in loading_res_.
+		std::unordered_map<std::atomic<LoadingStatus> const *, uint32_t> loading_queries_;
+		// From a loaded resource to the hash of its desc, for Unload()
+		std::unordered_multimap<void const *, uint64_t> loaded_res_hashes_;
+		// Expired entries are swept when loaded_res_ grows past this size, so the cost is amortized over the insertions
+		size_t loaded_res_sweep_size_ = 64;
+		ResCacheStatistics cache_stat_;
+
+		// Strong references that keep the resources in loaded_res_ alive. Guarded by loaded_mutex_ too.
+		std::unordered_map<uint64_t, ResidentCategory> resident_categories_;
+		// Points into the lru list of the resource's category if the flag is true, or into its referenced list
+		std::unordered_map<void const *, std::pair<std::list<ResidentResource>::iterator, bool>> resident_res_index_;
+
+		// One FIFO per priority, served from the highest priority down by all loading threads
 		std::condition_variable loading_res_queue_cv_;
 		std::mutex loading_res_queue_mutex_;
-		std::vector<std::pair<ResLoadingDescPtr, std::shared_ptr<volatile LoadingStatus>>> loading_res_queue_;
+		std::array<std::deque<std::pair<ResLoadingDescPtr, std::shared_ptr<std::atomic<LoadingStatus>>>>, NumResLoadingPriorities>
+			loading_res_queue_;
 
-		std::future<void> loading_thread_;
-		volatile bool quit_{false};
+		std::vector<std::future<void>> loading_threads_;
+		bool quit_{false};
 	};
 }
 
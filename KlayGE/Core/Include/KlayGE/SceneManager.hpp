@@ -45,7 +45,12 @@ namespace KlayGE
 
 		void SmallObjectThreshold(float area);
 		void SceneUpdateElapse(float elapse);
+		// Culls the nodes on the JobSystem when there are enough of them. On by default.
+		void ParallelCulling(bool parallel);
+		bool ParallelCulling() const;
 		virtual void ClipScene();
+		// Updates the bounds and the visible marks of the scene nodes for the cameras of the current viewport, without rendering
+		void CullScene();
 
 		uint32_t NumFrameCameras() const;
 		Camera* GetFrameCamera(uint32_t index);
@@ -94,6 +99,7 @@ namespace KlayGE
 		uint32_t NumPrimitivesRendered() const;
 		uint32_t NumVerticesRendered() const;
 		uint32_t NumDrawCalls() const;
+		uint32_t NumDrawCallsSaved() const;
 		uint32_t NumDispatchCalls() const;
 
 		virtual void OnSceneChanged() = 0;
@@ -112,11 +118,15 @@ namespace KlayGE
 		void UpdateThreadFunc();
 
 		BoundOverlap VisibleTestFromParent(SceneNode const & node, uint32_t camera_index);
+		void ClipNode(SceneNode& node, Viewport const & viewport);
 
 	protected:
 		std::vector<CameraPtr> frame_cameras_;
 		std::vector<Frustum const*> camera_frustums_;
 		std::vector<float4x4> camera_view_projs_;
+		// Snapshots of the cameras, so the culling doesn't go through the lazily evaluated camera matrices
+		std::vector<float3> camera_eye_poses_;
+		std::vector<float3> camera_forward_vecs_;
 		std::vector<LightSourcePtr> frame_lights_;
 		SceneNode scene_root_;
 		SceneNode overlay_root_;
@@ -130,13 +140,39 @@ namespace KlayGE
 		std::vector<SceneNode*> all_scene_nodes_;
 		std::vector<SceneNode*> all_overlay_nodes_;
 
+		bool parallel_culling_ = true;
+		// World space bounds of the scene nodes, and the frustum test results of them for each camera. Managers that cull
+		//  through their own trees reset it, so that the nodes aren't synced to it every frame.
+		PosBoundWSStorePtr pos_bounds_ws_;
+		std::vector<std::vector<BoundOverlap>> pos_bound_overlaps_;
+		// all_scene_nodes_ grouped by depth. A level can only be culled after its parent level.
+		std::vector<std::vector<SceneNode*>> culling_levels_;
+
 	private:
 		void FlushScene();
+		void MarkUncullableNodes(uint32_t num_cameras);
+		void SnapshotCameras(Viewport const & viewport);
+		void SortRenderQueue(Viewport const & viewport);
 
 	private:
 		uint32_t urt_;
 
-		std::vector<std::pair<RenderTechnique const *, std::vector<Renderable*>>> render_queue_;
+		std::vector<Renderable*> render_queue_;
+
+		// Scratch data of sorting the render queue, kept to avoid allocations every frame
+		std::vector<RenderTechnique const *> queue_techs_;
+		std::unordered_map<RenderTechnique const *, uint32_t> queue_tech_ids_;
+		std::unordered_map<RenderMaterial const *, uint32_t> queue_mtl_ids_;
+		std::unordered_map<RenderLayout const *, uint32_t> queue_layout_ids_;
+		std::vector<uint32_t> queue_tech_indices_;
+		std::vector<uint32_t> queue_tech_ranks_;
+		std::vector<uint32_t> queue_tech_orders_;
+		std::vector<uint32_t> queue_state_ids_;
+		std::vector<uint64_t> queue_keys_;
+		std::vector<uint64_t> queue_tmp_keys_;
+		std::vector<uint32_t> queue_indices_;
+		std::vector<uint32_t> queue_tmp_indices_;
+		std::vector<Renderable*> sorted_render_queue_;
 
 		uint32_t num_objects_rendered_;
 		uint32_t num_renderables_rendered_;
@@ -144,6 +180,9 @@ namespace KlayGE
 		uint32_t num_vertices_rendered_;
 		uint32_t num_draw_calls_;
 		uint32_t num_dispatch_calls_;
+		// Draw calls merged by auto instancing
+		uint32_t num_draw_calls_saved_ = 0;
+		uint32_t num_frame_draw_calls_saved_ = 0;
 
 		std::mutex update_mutex_;
 		std::optional<std::future<void>> update_thread_;
@@ -34,6 +34,7 @@
 #pragma once
 
 #include <KlayGE/PreDeclare.hpp>
+#include <KFL/AlignedAllocator.hpp>
 #include <KlayGE/Renderable.hpp>
 #include <KlayGE/RenderEngine.hpp>
 #include <KlayGE/RenderLayout.hpp>
@@ -42,6 +43,33 @@
 
 namespace KlayGE
 {
+	// World space AABBs of scene nodes, packed as structure of arrays so that culling streams through them with SIMD.
+	// Kept in sync by SceneNode::UpdatePosBoundSubtree. Only the scene manager writes it, under its update lock.
+	class KLAYGE_CORE_API PosBoundWSStore final : boost::noncopyable
+	{
+	public:
+		uint32_t Allocate();
+		// Can be called from any thread
+		void Free(uint32_t index);
+		void Update(uint32_t index, AABBox const & aabb);
+
+		// Padded to a multiple of 4
+		uint32_t Size() const
+		{
+			return static_cast<uint32_t>(coords_[0].size());
+		}
+
+		// results must have Size() elements. The ones of free slots are meaningless.
+		void Intersect(Frustum const & frustum, BoundOverlap* results) const;
+
+	private:
+		// Min x, y, z, then max x, y, z
+		std::array<std::vector<float, aligned_allocator<float, 16>>, 6> coords_;
+
+		std::mutex free_slots_mutex_;
+		std::vector<uint32_t> free_slots_;
+	};
+
 	class KLAYGE_CORE_API SceneNode final : boost::noncopyable, public std::enable_shared_from_this<SceneNode>
 	{
 	public:
@@ -151,7 +179,15 @@ namespace KlayGE
 		AABBox const& PosBoundOS() const;
 		AABBox const& PosBoundWS() const;
 		void UpdateTransforms();
+		// Safe on loading threads. The changed bounds reach the store on the next call that passes it.
 		void UpdatePosBoundSubtree();
+		// Also writes the bounds into store
+		void UpdatePosBoundSubtree(PosBoundWSStorePtr const & store);
+		// Index of the bounds in store, or ~0U if the node isn't synced to it
+		uint32_t PosBoundWSIndex(PosBoundWSStore const & store) const
+		{
+			return (pos_bound_store_ == &store) ? pos_bound_index_ : ~0U;
+		}
 		bool Updated() const;
 		void FillVisibleMark(BoundOverlap vm);
 		void VisibleMark(uint32_t camera_index, BoundOverlap vm);
@@ -222,6 +258,10 @@ namespace KlayGE
 		std::unique_ptr<AABBox> pos_aabb_os_;
 		std::unique_ptr<AABBox> pos_aabb_ws_;
 		bool pos_aabb_dirty_ = true;
+		PosBoundWSStore const * pos_bound_store_ = nullptr;
+		std::weak_ptr<PosBoundWSStore> pos_bound_store_weak_;
+		uint32_t pos_bound_index_ = ~0U;
+		bool pos_bound_store_dirty_ = false;
 		std::array<BoundOverlap, RenderEngine::PredefinedCameraCBuffer::max_num_cameras> visible_marks_;
 
 		UpdateEvent sub_thread_update_event_;
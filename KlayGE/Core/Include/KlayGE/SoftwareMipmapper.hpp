@@ -0,0 +1,81 @@
+/**
+ * @file SoftwareMipmapper.hpp
+ * @author Minmin Gong
+ *
+ * @section DESCRIPTION
+ *
+ * This source file is part of KlayGE
+ * For the latest info, see http://www.klayge.org
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * You may alternatively use this source under the terms of
+ * the KlayGE Proprietary License (KPL). You can obtained such a license
+ * from http://www.klayge.org/licensing/.
+ */
+
+#ifndef KLAYGE_CORE_SOFTWARE_MIPMAPPER_HPP
+#define KLAYGE_CORE_SOFTWARE_MIPMAPPER_HPP
+
+#pragma once
+
+#include <KlayGE/PreDeclare.hpp>
+
+namespace KlayGE
+{
+	enum class MipmapFilter
+	{
+		Box,
+		Kaiser,
+		Lanczos
+	};
+
+	// Builds mip chains of CPU-accessible textures on the job system. Filtering happens in linear float space, so sRGB formats
+	//  are downsampled gamma-correctly. Slices, cube faces and rows of a level are processed in parallel.
+	class KLAYGE_CORE_API SoftwareMipmapper final : boost::noncopyable
+	{
+	public:
+		explicit SoftwareMipmapper(MipmapFilter filter = MipmapFilter::Box);
+
+		void Filter(MipmapFilter filter)
+		{
+			filter_ = filter;
+		}
+		MipmapFilter Filter() const
+		{
+			return filter_;
+		}
+
+		// Rescales alpha of each level so the fraction of texels above alpha_ref matches level 0. Keeps alpha-tested foliage from
+		//  thinning out in the distance.
+		void PreserveAlphaCoverage(bool preserve, float alpha_ref = 0.5f)
+		{
+			preserve_alpha_coverage_ = preserve;
+			alpha_ref_ = alpha_ref;
+		}
+
+		// Supports uncompressed 1D, 2D and cube textures (including arrays). Level 0 is the source of all the other levels.
+		void BuildSubLevels(Texture& texture) const;
+
+	private:
+		MipmapFilter filter_;
+		bool preserve_alpha_coverage_ = false;
+		float alpha_ref_ = 0.5f;
+	};
+} // namespace KlayGE
+
+#endif // KLAYGE_CORE_SOFTWARE_MIPMAPPER_HPP
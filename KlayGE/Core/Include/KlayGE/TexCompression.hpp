@@ -77,6 +77,11 @@ namespace KlayGE
 		virtual void EncodeTex(TexturePtr const & out_tex, TexturePtr const & in_tex, TexCompressionMethod method);
 		virtual void DecodeTex(TexturePtr const & out_tex, TexturePtr const & in_tex);
 
+	protected:
+		// EncodeMem encodes block rows in parallel. Codecs that keep per-block states in members while encoding
+		// return a new instance here for each job. Others return nullptr to share this one.
+		virtual std::unique_ptr<TexCompression> MakeJobCodec() const;
+
 	protected:
 		ElementFormat compression_format_;
 	};
@@ -143,6 +143,9 @@ namespace KlayGE
 
 		static int GetModifier(int cw, int selector);
 
+	protected:
+		std::unique_ptr<TexCompression> MakeJobCodec() const override;
+
 	private:
 		struct ETC1SolutionCoordinates
 		{
@@ -218,6 +221,9 @@ namespace KlayGE
 		void DecodeETCHModeInternal(ARGBColor32* argb, ETC2HModeBlock const & etc2, bool alpha);
 		void DecodeETCPlanarModeInternal(ARGBColor32* argb, ETC2PlanarModeBlock const & etc2);
 
+	protected:
+		std::unique_ptr<TexCompression> MakeJobCodec() const override;
+
 	private:
 		std::unique_ptr<TexCompressionETC1> etc1_codec_;
 	};
@@ -230,6 +236,9 @@ namespace KlayGE
 		virtual void EncodeBlock(void* output, void const * input, TexCompressionMethod method) override;
 		virtual void DecodeBlock(void* output, void const * input) override;
 
+	protected:
+		std::unique_ptr<TexCompression> MakeJobCodec() const override;
+
 	private:
 		std::unique_ptr<TexCompressionETC1> etc1_codec_;
 		std::unique_ptr<TexCompressionETC2RGB8> etc2_rgb8_codec_;
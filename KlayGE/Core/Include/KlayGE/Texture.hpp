@@ -363,6 +363,9 @@ namespace KlayGE
 			return data_block_;
 		}
 
+	protected:
+		bool HwBuildMipSubLevels(TextureFilter filter) override;
+
 	private:
 		bool ref_only_;
 
@@ -348,6 +348,8 @@ namespace KlayGE
 		IRect bounding_box_;		// Rectangle defining the active region of the control
 	};
 
+	class UIRectRenderable;
+
 	class KLAYGE_CORE_API UIManager final : boost::noncopyable, public std::enable_shared_from_this<UIManager>
 	{
 	public:
@@ -427,6 +429,7 @@ namespace KlayGE
 	private:
 		void Init();
 		void InputHandler(InputEngine const & sender, InputAction const & action);
+		UIRectRenderable& RectRenderable(TexturePtr const & texture);
 
 	private:
 		static std::unique_ptr<UIManager> ui_mgr_instance_;
@@ -441,7 +444,8 @@ namespace KlayGE
 
 		std::array<std::vector<IRect >, UICT_Num_Control_Types> elem_texture_rcs_;
 
-		std::map<TexturePtr, RenderablePtr> rects_;
+		// Batched quads and their overlay scene node of each texture, kept across frames
+		std::map<TexturePtr, std::pair<std::shared_ptr<UIRectRenderable>, SceneNodePtr>> rects_;
 
 		struct string_cache
 		{
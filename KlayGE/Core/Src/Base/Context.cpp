@@ -107,6 +107,7 @@ namespace KlayGE
 #endif
 
 		gtp_instance_ = MakeUniquePtr<ThreadPool>(1, 16);
+		job_system_instance_ = MakeUniquePtr<JobSystem>();
 	}
 
 	Context::~Context()
@@ -135,6 +136,7 @@ namespace KlayGE
 
 		app_ = nullptr;
 
+		job_system_instance_.reset();
 		gtp_instance_.reset();
 	}
 
@@ -288,7 +290,7 @@ namespace KlayGE
 		static char const * available_sfs_array[] = { "NullShow" };
 		static char const * available_scfs_array[] = { "Python" };
 #endif
-		static char const * available_sms_array[] = { "OCTree" };
+		static char const * available_sms_array[] = { "OCTree", "BVH" };
 
 		uint32_t width = 800;
 		uint32_t height = 600;
@@ -29,11 +29,16 @@
  */
 
 #include <KlayGE/KlayGE.hpp>
+#include <KFL/CpuInfo.hpp>
 #include <KFL/Hash.hpp>
+#include <KFL/MappedFile.hpp>
+#include <KFL/StringUtil.hpp>
 #include <KFL/Util.hpp>
 #include <KlayGE/Package.hpp>
 #include <KFL/CXX17/filesystem.hpp>
 
+#include <algorithm>
+#include <iterator>
 #if defined KLAYGE_PLATFORM_LINUX
 #include <cstring>
 #endif
@@ -57,6 +62,9 @@ namespace uwp
 
 #include <KFL/ErrorHandling.hpp>
 #elif defined KLAYGE_PLATFORM_LINUX
+#include <cerrno>
+#include <sys/inotify.h>
+#include <unistd.h>
 #elif defined KLAYGE_PLATFORM_ANDROID
 #include <android_native_app_glue.h>
 #include <android/asset_manager.h>
@@ -73,6 +81,17 @@ namespace
 {
 	std::mutex singleton_mutex;
 
+	// Splits a resource name into the key of its directory snapshot and the name of the entry in it
+	void SplitLookupName(std::string const & res_name, std::string& dir, std::string& file_name)
+	{
+		size_t const slash = res_name.rfind('/');
+		dir = (slash == std::string::npos) ? std::string() : res_name.substr(0, slash);
+		file_name = (slash == std::string::npos) ? res_name : res_name.substr(slash + 1);
+#if defined KLAYGE_PLATFORM_WINDOWS
+		KlayGE::StringUtil::ToLower(file_name);
+#endif
+	}
+
 #ifdef KLAYGE_PLATFORM_ANDROID
 	class AAssetStreamBuf : public KlayGE::MemInputStreamBuf
 	{
@@ -103,6 +122,10 @@ namespace KlayGE
 
 	ResLoader::ResLoader()
 	{
+#if defined(KLAYGE_PLATFORM_LINUX)
+		lookup_watch_fd_ = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+
 #if defined KLAYGE_PLATFORM_WINDOWS
 #if defined KLAYGE_PLATFORM_WINDOWS_DESKTOP
 		char buf[MAX_PATH];
@@ -203,20 +226,36 @@ namespace KlayGE
 #endif
 #endif
 
-		loading_thread_ = Context::Instance().ThreadPoolInstance().QueueThread([this] { this->LoadingThreadFunc(); });
+		// Sub thread stages are mostly I/O and decompression. Half of the hardware threads keeps them busy without starving
+		//  the main and render threads.
+		CpuInfo cpu;
+		uint32_t const num_loading_threads = std::clamp(cpu.NumHWThreads() / 2, 1U, 4U);
+		for (uint32_t i = 0; i < num_loading_threads; ++ i)
+		{
+			loading_threads_.emplace_back(
+				Context::Instance().ThreadPoolInstance().QueueThread([this] { this->LoadingThreadFunc(); }));
+		}
 	}
 
 	ResLoader::~ResLoader()
 	{
-		quit_ = true;
+		{
+			std::lock_guard<std::mutex> lock(loading_res_queue_mutex_);
+			quit_ = true;
+		}
+		loading_res_queue_cv_.notify_all();
 
+		for (auto& thread : loading_threads_)
 		{
-			std::unique_lock<std::mutex> lock(loading_res_queue_mutex_, std::try_to_lock);
-			non_empty_loading_res_queue_ = true;
-			loading_res_queue_cv_.notify_one();
+			thread.wait();
 		}
 
-		loading_thread_.wait();
+#if defined(KLAYGE_PLATFORM_LINUX)
+		if (lookup_watch_fd_ >= 0)
+		{
+			::close(lookup_watch_fd_);
+		}
+#endif
 	}
 
 	ResLoader& ResLoader::Instance()
@@ -484,6 +523,7 @@ namespace KlayGE
 				}
 
 				paths_.emplace_back(virtual_path_hash, static_cast<uint32_t>(virtual_path_str.size()), real_path, std::move(package));
+				lookup_cache_.clear();
 			}
 		}
 	}
@@ -507,12 +547,169 @@ namespace KlayGE
 				if ((std::get<0>(*iter) == virtual_path_hash) && (std::get<2>(*iter) == real_path))
 				{
 					paths_.erase(iter);
+					lookup_cache_.clear();
 					break;
 				}
 			}
 		}
 	}
 
+	void ResLoader::InvalidateLookupCache()
+	{
+		std::lock_guard<std::mutex> lock(paths_mutex_);
+		lookup_cache_.clear();
+	}
+
+	void ResLoader::RefreshLookupCache()
+	{
+#if defined(KLAYGE_PLATFORM_LINUX)
+		if (lookup_watch_fd_ < 0)
+		{
+			return;
+		}
+
+		alignas(inotify_event) char buff[4096];
+		for (;;)
+		{
+			ssize_t const len = ::read(lookup_watch_fd_, buff, sizeof(buff));
+			if (len <= 0)
+			{
+				break;
+			}
+
+			for (char const * p = buff; p < buff + len;)
+			{
+				auto const * event = reinterpret_cast<inotify_event const *>(p);
+				if (event->mask & IN_Q_OVERFLOW)
+				{
+					lookup_cache_.clear();
+				}
+				else
+				{
+					auto const range = lookup_watches_.equal_range(event->wd);
+					for (auto iter = range.first; iter != range.second; ++ iter)
+					{
+						lookup_cache_.erase(iter->second);
+					}
+					if (event->mask & IN_IGNORED)
+					{
+						lookup_watches_.erase(range.first, range.second);
+					}
+				}
+
+				p += sizeof(inotify_event) + event->len;
+			}
+		}
+#endif
+	}
+
+	bool ResLoader::LookupCacheWatched() const
+	{
+#if defined(KLAYGE_PLATFORM_LINUX)
+		return lookup_watch_fd_ >= 0;
+#else
+		return false;
+#endif
+	}
+
+	bool ResLoader::CachedExists(std::string const & res_name, bool& from_snapshot)
+	{
+		from_snapshot = false;
+
+		std::string dir;
+		std::string file_name;
+		SplitLookupName(res_name, dir, file_name);
+		if (file_name.empty())
+		{
+			std::error_code ec;
+			return FILESYSTEM_NS::exists(FILESYSTEM_NS::path(res_name), ec);
+		}
+
+		auto iter = lookup_cache_.find(dir);
+		if (iter != lookup_cache_.end())
+		{
+			from_snapshot = true;
+		}
+		else
+		{
+			FILESYSTEM_NS::path const dir_path(dir.empty() ? std::string(".") : dir);
+
+#if defined(KLAYGE_PLATFORM_LINUX)
+			if (lookup_watch_fd_ >= 0)
+			{
+				// All the watches use the same mask, adding one again on a watched directory would replace it
+				uint32_t const watch_mask = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF;
+				int wd = ::inotify_add_watch(lookup_watch_fd_, dir_path.c_str(), watch_mask);
+				if ((wd < 0) && ((ENOENT == errno) || (ENOTDIR == errno)))
+				{
+					// A missing directory is cached as an empty one, until anything changes in its nearest existing parent
+					FILESYSTEM_NS::path parent_path = dir_path;
+					do
+					{
+						parent_path = parent_path.parent_path();
+						wd = ::inotify_add_watch(lookup_watch_fd_, parent_path.empty() ? "." : parent_path.c_str(), watch_mask);
+					} while ((wd < 0) && ((ENOENT == errno) || (ENOTDIR == errno)) && !parent_path.empty()
+						&& (parent_path != parent_path.root_path()));
+
+					std::error_code ec;
+					if ((wd >= 0) && FILESYSTEM_NS::exists(dir_path, ec))
+					{
+						// Created before the parent was watched
+						wd = -1;
+					}
+				}
+				if (wd < 0)
+				{
+					// Can't be watched
+					std::error_code ec;
+					return FILESYSTEM_NS::exists(FILESYSTEM_NS::path(res_name), ec);
+				}
+				auto const range = lookup_watches_.equal_range(wd);
+				if (std::find_if(range.first, range.second, [&dir](auto const & watch) { return watch.second == dir; }) == range.second)
+				{
+					lookup_watches_.emplace(wd, dir);
+				}
+			}
+#endif
+
+			std::unordered_set<std::string> entries;
+			std::error_code ec;
+			for (FILESYSTEM_NS::directory_iterator entry_iter(dir_path, ec), end; !ec && (entry_iter != end); entry_iter.increment(ec))
+			{
+				std::string entry_name = entry_iter->path().filename().string();
+#if defined KLAYGE_PLATFORM_WINDOWS
+				StringUtil::ToLower(entry_name);
+#endif
+				entries.emplace(std::move(entry_name));
+			}
+
+			iter = lookup_cache_.emplace(std::move(dir), std::move(entries)).first;
+		}
+
+		return iter->second.find(file_name) != iter->second.end();
+	}
+
+	// Corrects a snapshot that disagrees with the file system on one entry, keeping the rest of the cache
+	void ResLoader::UpdateLookupCache(std::string const & res_name, bool exists)
+	{
+		std::string dir;
+		std::string file_name;
+		SplitLookupName(res_name, dir, file_name);
+
+		auto const iter = lookup_cache_.find(dir);
+		if (iter != lookup_cache_.end())
+		{
+			if (exists)
+			{
+				iter->second.emplace(std::move(file_name));
+			}
+			else
+			{
+				iter->second.erase(file_name);
+			}
+		}
+	}
+
 	std::string ResLoader::Locate(std::string_view name)
 	{
 		if (name.empty())
@@ -532,42 +729,81 @@ namespace KlayGE
 #else
 		{
 			std::lock_guard<std::mutex> lock(paths_mutex_);
-			for (auto const & path : paths_)
+			this->RefreshLookupCache();
+
+			// Unwatched snapshots can miss files created after they were taken. A lookup that misses everywhere is verified by a
+			//  second pass that goes to the file system. Packages don't change, they are only searched in the first pass.
+			bool const watched = this->LookupCacheWatched();
+			uint32_t const num_passes = watched ? 1 : 2;
+			uint64_t num_snapshot_answers = 0;
+			for (uint32_t pass = 0; pass < num_passes; ++ pass)
 			{
-				if ((std::get<1>(path) != 0) || (HashRange(name.begin(), name.begin() + std::get<1>(path)) == std::get<0>(path)))
+				for (auto const & path : paths_)
 				{
-					std::string res_name(std::get<2>(path) + std::string(name.substr(std::get<1>(path))));
+					if ((std::get<1>(path) != 0) || (HashRange(name.begin(), name.begin() + std::get<1>(path)) == std::get<0>(path)))
+					{
+						std::string res_name(std::get<2>(path) + std::string(name.substr(std::get<1>(path))));
 #if defined KLAYGE_PLATFORM_WINDOWS
-					std::replace(res_name.begin(), res_name.end(), '\\', '/');
+						std::replace(res_name.begin(), res_name.end(), '\\', '/');
 #endif
 
-					std::error_code ec;
-					if (FILESYSTEM_NS::exists(FILESYSTEM_NS::path(res_name), ec))
-					{
-						return res_name;
-					}
-					else
-					{
-						std::string package_path;
-						std::string password;
-						std::string path_in_package;
-						this->DecomposePackageName(res_name, package_path, password, path_in_package);
-						auto const & package = std::get<3>(path);
-						if (!package_path.empty() && package && (package_path == package->ArchiveStream()->ResName()))
+						bool exists;
+						if (pass == 0)
 						{
-							if (package->Locate(path_in_package))
+							bool from_snapshot;
+							exists = this->CachedExists(res_name, from_snapshot);
+							if (from_snapshot)
 							{
-								return res_name;
+								++ num_snapshot_answers;
+							}
+						}
+						else
+						{
+							std::error_code ec;
+							exists = FILESYSTEM_NS::exists(FILESYSTEM_NS::path(res_name), ec);
+						}
+
+						if (exists)
+						{
+							if (pass == 0)
+							{
+								num_avoided_stats_ += num_snapshot_answers;
+							}
+							else
+							{
+								this->UpdateLookupCache(res_name, true);
+							}
+							return res_name;
+						}
+						else if (pass == 0)
+						{
+							std::string package_path;
+							std::string password;
+							std::string path_in_package;
+							this->DecomposePackageName(res_name, package_path, password, path_in_package);
+							auto const & package = std::get<3>(path);
+							if (!package_path.empty() && package && (package_path == package->ArchiveStream()->ResName()))
+							{
+								if (package->Locate(path_in_package))
+								{
+									num_avoided_stats_ += num_snapshot_answers;
+									return res_name;
+								}
 							}
 						}
 					}
-				}
 
-				if ((std::get<1>(path) == 0) && FILESYSTEM_NS::path(name.begin(), name.end()).is_absolute())
-				{
-					break;
+					if ((std::get<1>(path) == 0) && FILESYSTEM_NS::path(name.begin(), name.end()).is_absolute())
+					{
+						break;
+					}
 				}
 			}
+
+			if (watched)
+			{
+				num_avoided_stats_ += num_snapshot_answers;
+			}
 		}
 #if defined KLAYGE_PLATFORM_WINDOWS_STORE
 		std::string const & res_name = this->LocateFileWinRT(name);
@@ -608,46 +844,97 @@ namespace KlayGE
 #else
 		{
 			std::lock_guard<std::mutex> lock(paths_mutex_);
-			for (auto const & path : paths_)
+			this->RefreshLookupCache();
+
+			bool const watched = this->LookupCacheWatched();
+			uint32_t const num_passes = watched ? 1 : 2;
+			uint64_t num_snapshot_answers = 0;
+			for (uint32_t pass = 0; pass < num_passes; ++ pass)
 			{
-				if ((std::get<1>(path) != 0) || (HashRange(name.begin(), name.begin() + std::get<1>(path)) == std::get<0>(path)))
+				for (auto const & path : paths_)
 				{
-					std::string res_name(std::get<2>(path) + std::string(name.substr(std::get<1>(path))));
+					if ((std::get<1>(path) != 0) || (HashRange(name.begin(), name.begin() + std::get<1>(path)) == std::get<0>(path)))
+					{
+						std::string res_name(std::get<2>(path) + std::string(name.substr(std::get<1>(path))));
 #if defined KLAYGE_PLATFORM_WINDOWS
-					std::replace(res_name.begin(), res_name.end(), '\\', '/');
+						std::replace(res_name.begin(), res_name.end(), '\\', '/');
 #endif
 
-					FILESYSTEM_NS::path res_path(res_name);
-					std::error_code ec;
-					if (FILESYSTEM_NS::exists(res_path, ec))
-					{
-						uint64_t const timestamp = FILESYSTEM_NS::last_write_time(res_path).time_since_epoch().count();
-						return MakeSharedPtr<ResIdentifier>(
-							name, timestamp, MakeSharedPtr<std::ifstream>(res_name.c_str(), std::ios_base::binary));
-					}
-					else
-					{
-						std::string package_path;
-						std::string password;
-						std::string path_in_package;
-						this->DecomposePackageName(res_name, package_path, password, path_in_package);
-						auto const & package = std::get<3>(path);
-						if (!package_path.empty() && package && (package_path == package->ArchiveStream()->ResName()))
+						FILESYSTEM_NS::path res_path(res_name);
+						bool exists;
+						if (pass == 0)
 						{
-							auto res = package->Extract(path_in_package, name);
-							if (res)
+							bool from_snapshot;
+							exists = this->CachedExists(res_name, from_snapshot);
+							if (from_snapshot && !exists)
 							{
-								return res;
+								// A hit is stat-ed below anyway
+								++ num_snapshot_answers;
+							}
+						}
+						else
+						{
+							std::error_code ec;
+							exists = FILESYSTEM_NS::exists(res_path, ec);
+						}
+
+						if (exists)
+						{
+							// Also catches files removed after the snapshot was taken
+							std::error_code ec;
+							auto const last_write_time = FILESYSTEM_NS::last_write_time(res_path, ec);
+							if ((pass != 0) || ec)
+							{
+								this->UpdateLookupCache(res_name, !ec);
+							}
+							if (!ec)
+							{
+								if (pass == 0)
+								{
+									num_avoided_stats_ += num_snapshot_answers;
+								}
+
+								uint64_t const timestamp = last_write_time.time_since_epoch().count();
+
+								auto mapped_file = MakeSharedPtr<MappedFile>();
+								if (mapped_file->Map(res_name))
+								{
+									return MakeSharedPtr<ResIdentifier>(name, timestamp, mapped_file->Data(), mapped_file);
+								}
+								return MakeSharedPtr<ResIdentifier>(
+									name, timestamp, MakeSharedPtr<std::ifstream>(res_name.c_str(), std::ios_base::binary));
+							}
+						}
+						else if (pass == 0)
+						{
+							std::string package_path;
+							std::string password;
+							std::string path_in_package;
+							this->DecomposePackageName(res_name, package_path, password, path_in_package);
+							auto const & package = std::get<3>(path);
+							if (!package_path.empty() && package && (package_path == package->ArchiveStream()->ResName()))
+							{
+								auto res = package->Extract(path_in_package, name);
+								if (res)
+								{
+									num_avoided_stats_ += num_snapshot_answers;
+									return res;
+								}
 							}
 						}
 					}
-				}
 
-				if ((std::get<1>(path) == 0) && FILESYSTEM_NS::path(name.begin(), name.end()).is_absolute())
-				{
-					break;
+					if ((std::get<1>(path) == 0) && FILESYSTEM_NS::path(name.begin(), name.end()).is_absolute())
+					{
+						break;
+					}
 				}
 			}
+
+			if (watched)
+			{
+				num_avoided_stats_ += num_snapshot_answers;
+			}
 		}
 #if defined(KLAYGE_PLATFORM_WINDOWS_STORE)
 		std::string const & res_name = this->LocateFileWinRT(name);
@@ -698,24 +985,8 @@ namespace KlayGE
 		}
 		else
 		{
-			std::shared_ptr<volatile LoadingStatus> async_is_done;
-			bool found = false;
-			{
-				std::lock_guard<std::mutex> lock(loading_mutex_);
-
-				for (auto const & lrq : loading_res_)
-				{
-					if (lrq.first->Match(*res_desc))
-					{
-						res_desc->CopyDataFrom(*lrq.first);
-						async_is_done = lrq.second;
-						found = true;
-						break;
-					}
-				}
-			}
-
-			if (found)
+			auto async_is_done = this->FindMatchLoadingResource(res_desc);
+			if (async_is_done)
 			{
 				*async_is_done = LS_Complete;
 			}
@@ -732,12 +1003,13 @@ namespace KlayGE
 			res_desc->MainThreadStage();
 			res = res_desc->Resource();
 			this->AddLoadedResource(res_desc, res);
+			this->AddResidentResource(res_desc, res);
 		}
 
 		return res;
 	}
 
-	std::shared_ptr<void> ResLoader::ASyncQuery(ResLoadingDescPtr const & res_desc)
+	std::shared_ptr<void> ResLoader::ASyncQuery(ResLoadingDescPtr const & res_desc, ResLoadingPriority priority)
 	{
 		this->RemoveUnrefResources();
 
@@ -760,32 +1032,22 @@ namespace KlayGE
 		}
 		else
 		{
-			std::shared_ptr<volatile LoadingStatus> async_is_done;
-			bool found = false;
+			auto async_is_done = this->FindMatchLoadingResource(res_desc);
+			if (async_is_done)
 			{
-				std::lock_guard<std::mutex> lock(loading_mutex_);
+				res = res_desc->Resource();
 
-				for (auto const & lrq : loading_res_)
 				{
-					if (lrq.first->Match(*res_desc))
+					std::lock_guard<std::mutex> lock(loading_mutex_);
+					if (!res_desc->StateLess())
 					{
-						res_desc->CopyDataFrom(*lrq.first);
-						async_is_done = lrq.second;
-						found = true;
-						break;
+						loading_res_.emplace(res_desc->Hash(), LoadingResource{res_desc, async_is_done, loading_res_order_});
+						++ loading_res_order_;
 					}
+					++ loading_queries_[async_is_done.get()];
 				}
-			}
 
-			if (found)
-			{
-				res = res_desc->Resource();
-
-				if (!res_desc->StateLess())
-				{
-					std::lock_guard<std::mutex> lock(loading_mutex_);
-					loading_res_.emplace_back(res_desc, async_is_done);
-				}
+				this->PromoteLoadingResource(async_is_done, priority);
 			}
 			else
 			{
@@ -793,24 +1055,22 @@ namespace KlayGE
 				{
 					res = res_desc->CreateResource();
 
-					async_is_done = MakeSharedPtr<LoadingStatus>(LS_Loading);
+					async_is_done = MakeSharedPtr<std::atomic<LoadingStatus>>(LS_Loading);
 
 					{
 						std::lock_guard<std::mutex> lock(loading_mutex_);
-						loading_res_.emplace_back(res_desc, async_is_done);
-					}
-					{
-						std::unique_lock<std::mutex> lock(loading_res_queue_mutex_, std::try_to_lock);
-						loading_res_queue_.emplace_back(res_desc, async_is_done);
-						non_empty_loading_res_queue_ = true;
-						loading_res_queue_cv_.notify_one();
+						loading_res_.emplace(res_desc->Hash(), LoadingResource{res_desc, async_is_done, loading_res_order_});
+						++ loading_res_order_;
+						loading_queries_[async_is_done.get()] = 1;
 					}
+					this->EnqueueLoadingResource(res_desc, async_is_done, priority);
 				}
 				else
 				{
 					res_desc->MainThreadStage();
 					res = res_desc->Resource();
 					this->AddLoadedResource(res_desc, res);
+					this->AddResidentResource(res_desc, res);
 				}
 			}
 		}
@@ -819,84 +1079,383 @@ namespace KlayGE
 
 	void ResLoader::Unload(std::shared_ptr<void> const & res)
 	{
-		std::lock_guard<std::mutex> lock(loaded_mutex_);
-
-		for (auto iter = loaded_res_.begin(); iter != loaded_res_.end(); ++ iter)
 		{
-			if (res == iter->second.lock())
+			std::lock_guard<std::mutex> lock(loaded_mutex_);
+
+			auto const hash_range = loaded_res_hashes_.equal_range(res.get());
+			for (auto hash_iter = hash_range.first; hash_iter != hash_range.second; ++ hash_iter)
 			{
-				loaded_res_.erase(iter);
-				break;
+				bool found = false;
+				auto const range = loaded_res_.equal_range(hash_iter->second);
+				for (auto iter = range.first; iter != range.second; ++ iter)
+				{
+					if (res == iter->second.second.lock())
+					{
+						loaded_res_.erase(iter);
+						++ cache_stat_.evictions;
+						found = true;
+						break;
+					}
+				}
+
+				if (found)
+				{
+					loaded_res_hashes_.erase(hash_iter);
+					break;
+				}
+			}
+
+			auto const resident_iter = resident_res_index_.find(res.get());
+			if (resident_iter != resident_res_index_.end())
+			{
+				auto const rr_iter = resident_iter->second.first;
+				auto& category = resident_categories_[rr_iter->type];
+				if (resident_iter->second.second)
+				{
+					category.bytes -= rr_iter->size;
+					category.lru.erase(rr_iter);
+				}
+				else
+				{
+					category.referenced.erase(rr_iter);
+				}
+				resident_res_index_.erase(resident_iter);
 			}
 		}
+
+		this->CancelLoadingResource(res);
 	}
 
 	void ResLoader::AddLoadedResource(ResLoadingDescPtr const & res_desc, std::shared_ptr<void> const & res)
 	{
+		uint64_t const hash = res_desc->Hash();
+
 		std::lock_guard<std::mutex> lock(loaded_mutex_);
 
 		bool found = false;
-		for (auto& c_desc : loaded_res_)
+		auto const range = loaded_res_.equal_range(hash);
+		for (auto iter = range.first; iter != range.second; ++ iter)
 		{
-			if (c_desc.first == res_desc)
+			if (iter->second.first == res_desc)
 			{
-				c_desc.second = std::weak_ptr<void>(res);
+				iter->second.second = std::weak_ptr<void>(res);
 				found = true;
 				break;
 			}
 		}
 		if (!found)
 		{
-			loaded_res_.emplace_back(res_desc, std::weak_ptr<void>(res));
+			loaded_res_.emplace(hash, std::make_pair(res_desc, std::weak_ptr<void>(res)));
 		}
+		// Stale entries of a replaced resource are dropped by the next sweep
+		loaded_res_hashes_.emplace(res.get(), hash);
 	}
 
 	std::shared_ptr<void> ResLoader::FindMatchLoadedResource(ResLoadingDescPtr const & res_desc)
 	{
+		uint64_t const hash = res_desc->Hash();
+
 		std::lock_guard<std::mutex> lock(loaded_mutex_);
 
 		std::shared_ptr<void> loaded_res;
-		for (auto const & lr : loaded_res_)
+		auto const range = loaded_res_.equal_range(hash);
+		for (auto iter = range.first; iter != range.second;)
 		{
-			if (lr.first->Match(*res_desc))
+			if (iter->second.first->Match(*res_desc))
 			{
-				loaded_res = lr.second.lock();
-				break;
+				loaded_res = iter->second.second.lock();
+				if (loaded_res)
+				{
+					break;
+				}
+
+				// The resource is dead, evict it while we are here
+				iter = loaded_res_.erase(iter);
+				++ cache_stat_.evictions;
+			}
+			else
+			{
+				++ iter;
 			}
 		}
+
+		if (loaded_res)
+		{
+			this->ReuseResidentResource(loaded_res.get());
+			++ cache_stat_.hits;
+		}
+		else
+		{
+			++ cache_stat_.misses;
+		}
+
 		return loaded_res;
 	}
 
+	std::shared_ptr<std::atomic<ResLoader::LoadingStatus>> ResLoader::FindMatchLoadingResource(ResLoadingDescPtr const & res_desc)
+	{
+		std::shared_ptr<std::atomic<LoadingStatus>> status;
+
+		std::lock_guard<std::mutex> lock(loading_mutex_);
+
+		auto const range = loading_res_.equal_range(res_desc->Hash());
+		for (auto iter = range.first; iter != range.second; ++ iter)
+		{
+			// A cancelled load can't be joined, it's only waiting for Update() to drop it
+			if ((*iter->second.status != LS_CanBeRemoved) && iter->second.res_desc->Match(*res_desc))
+			{
+				res_desc->CopyDataFrom(*iter->second.res_desc);
+				status = iter->second.status;
+				break;
+			}
+		}
+
+		return status;
+	}
+
 	void ResLoader::RemoveUnrefResources()
 	{
 		std::lock_guard<std::mutex> lock(loaded_mutex_);
 
+		if (loaded_res_.size() + loaded_res_hashes_.size() < loaded_res_sweep_size_ * 2)
+		{
+			return;
+		}
+
 		for (auto iter = loaded_res_.begin(); iter != loaded_res_.end();)
 		{
-			if (iter->second.lock())
+			if (iter->second.second.expired())
 			{
-				++ iter;
+				iter = loaded_res_.erase(iter);
+				++ cache_stat_.evictions;
 			}
 			else
 			{
-				iter = loaded_res_.erase(iter);
+				++ iter;
 			}
 		}
+
+		loaded_res_hashes_.clear();
+		for (auto const & lr : loaded_res_)
+		{
+			auto res = lr.second.second.lock();
+			if (res)
+			{
+				loaded_res_hashes_.emplace(res.get(), lr.first);
+			}
+		}
+
+		loaded_res_sweep_size_ = std::max<size_t>(loaded_res_.size() * 2, 64);
+	}
+
+	ResCacheStatistics ResLoader::CacheStatistics() const
+	{
+		std::lock_guard<std::mutex> lock(loaded_mutex_);
+
+		ResCacheStatistics stat = cache_stat_;
+		stat.num_loaded = static_cast<uint32_t>(loaded_res_.size());
+		return stat;
+	}
+
+	void ResLoader::ResetCacheStatistics()
+	{
+		std::lock_guard<std::mutex> lock(loaded_mutex_);
+		cache_stat_ = ResCacheStatistics();
+	}
+
+	void ResLoader::ResidentBudget(uint64_t type, uint64_t budget)
+	{
+		// Evicted resources are destructed after the lock is released
+		std::vector<std::shared_ptr<void>> evicted;
+		{
+			std::lock_guard<std::mutex> lock(loaded_mutex_);
+
+			this->CollectUnrefResidentResources(evicted);
+
+			auto& category = resident_categories_[type];
+			category.budget = budget;
+			if (0 == budget)
+			{
+				for (auto& rr : category.referenced)
+				{
+					resident_res_index_.erase(rr.res.get());
+				}
+				category.referenced.clear();
+			}
+			this->TrimResidentResources(category, evicted);
+		}
+	}
+
+	uint64_t ResLoader::ResidentBudget(uint64_t type) const
+	{
+		std::lock_guard<std::mutex> lock(loaded_mutex_);
+
+		auto const iter = resident_categories_.find(type);
+		return (iter != resident_categories_.end()) ? iter->second.budget : 0;
+	}
+
+	uint64_t ResLoader::ResidentBytes(uint64_t type)
+	{
+		std::vector<std::shared_ptr<void>> evicted;
+		{
+			std::lock_guard<std::mutex> lock(loaded_mutex_);
+
+			this->CollectUnrefResidentResources(evicted);
+
+			auto const iter = resident_categories_.find(type);
+			return (iter != resident_categories_.end()) ? iter->second.bytes : 0;
+		}
+	}
+
+	uint32_t ResLoader::NumResidentResources(uint64_t type)
+	{
+		std::vector<std::shared_ptr<void>> evicted;
+		{
+			std::lock_guard<std::mutex> lock(loaded_mutex_);
+
+			this->CollectUnrefResidentResources(evicted);
+
+			auto const iter = resident_categories_.find(type);
+			return (iter != resident_categories_.end()) ? static_cast<uint32_t>(iter->second.lru.size()) : 0;
+		}
+	}
+
+	void ResLoader::ClearResidentResources()
+	{
+		std::vector<std::shared_ptr<void>> evicted;
+		{
+			std::lock_guard<std::mutex> lock(loaded_mutex_);
+
+			this->CollectUnrefResidentResources(evicted);
+
+			for (auto& category : resident_categories_)
+			{
+				for (auto& rr : category.second.lru)
+				{
+					resident_res_index_.erase(rr.res.get());
+					evicted.push_back(std::move(rr.res));
+				}
+				cache_stat_.resident_evictions += category.second.lru.size();
+				category.second.lru.clear();
+				category.second.bytes = 0;
+			}
+		}
+	}
+
+	void ResLoader::AddResidentResource(ResLoadingDescPtr const & res_desc, std::shared_ptr<void> const & res)
+	{
+		if (!res)
+		{
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(loaded_mutex_);
+
+		auto const cat_iter = resident_categories_.find(res_desc->Type());
+		if ((cat_iter == resident_categories_.end()) || (0 == cat_iter->second.budget))
+		{
+			return;
+		}
+
+		if (resident_res_index_.find(res.get()) != resident_res_index_.end())
+		{
+			this->ReuseResidentResource(res.get());
+			return;
+		}
+
+		uint64_t const size = res_desc->ResidentSize();
+		auto& category = cat_iter->second;
+		if ((0 == size) || (size > category.budget))
+		{
+			return;
+		}
+
+		// Not budgeted until the users drop it
+		category.referenced.push_front(ResidentResource{res, res_desc->Type(), size});
+		resident_res_index_.emplace(res.get(), std::make_pair(category.referenced.begin(), false));
+	}
+
+	void ResLoader::ReuseResidentResource(void const * res)
+	{
+		auto const iter = resident_res_index_.find(res);
+		if ((iter != resident_res_index_.end()) && iter->second.second)
+		{
+			auto const rr_iter = iter->second.first;
+			auto& category = resident_categories_[rr_iter->type];
+			category.bytes -= rr_iter->size;
+			category.referenced.splice(category.referenced.begin(), category.lru, rr_iter);
+			iter->second.second = false;
+		}
+	}
+
+	void ResLoader::CollectUnrefResidentResources(std::vector<std::shared_ptr<void>>& evicted)
+	{
+		// New references to a resource are only made under loaded_mutex_, so a use count of 1 can't go up behind our back
+		for (auto& category : resident_categories_)
+		{
+			auto& cat = category.second;
+			bool added = false;
+			for (auto iter = cat.referenced.begin(); iter != cat.referenced.end();)
+			{
+				auto const next = std::next(iter);
+				if (iter->res.use_count() == 1)
+				{
+					cat.bytes += iter->size;
+					cat.lru.splice(cat.lru.begin(), cat.referenced, iter);
+					resident_res_index_[iter->res.get()].second = true;
+					added = true;
+				}
+				iter = next;
+			}
+
+			if (added)
+			{
+				this->TrimResidentResources(cat, evicted);
+			}
+		}
+	}
+
+	void ResLoader::TrimResidentResources(ResidentCategory& category, std::vector<std::shared_ptr<void>>& evicted)
+	{
+		while (category.bytes > category.budget)
+		{
+			auto& rr = category.lru.back();
+			resident_res_index_.erase(rr.res.get());
+			category.bytes -= rr.size;
+			evicted.push_back(std::move(rr.res));
+			category.lru.pop_back();
+			++ cache_stat_.resident_evictions;
+		}
 	}
 
 	void ResLoader::Update()
 	{
-		std::vector<std::pair<ResLoadingDescPtr, std::shared_ptr<volatile LoadingStatus>>> tmp_loading_res;
+		{
+			std::vector<std::shared_ptr<void>> evicted;
+			{
+				std::lock_guard<std::mutex> lock(loaded_mutex_);
+				this->CollectUnrefResidentResources(evicted);
+			}
+		}
+
+		std::vector<LoadingResource> tmp_loading_res;
 		{
 			std::lock_guard<std::mutex> lock(loading_mutex_);
-			tmp_loading_res = loading_res_;
+			tmp_loading_res.reserve(loading_res_.size());
+			for (auto const & lr : loading_res_)
+			{
+				tmp_loading_res.push_back(lr.second);
+			}
 		}
+		// The multimap doesn't keep the query order of equal keys
+		std::sort(tmp_loading_res.begin(), tmp_loading_res.end(),
+			[](LoadingResource const & lhs, LoadingResource const & rhs) { return lhs.order < rhs.order; });
 
 		for (auto& lrq : tmp_loading_res)
 		{
-			if (LS_Complete == *lrq.second)
+			if (LS_Complete == *lrq.status)
 			{
-				ResLoadingDescPtr const & res_desc = lrq.first;
+				ResLoadingDescPtr const & res_desc = lrq.res_desc;
 
 				std::shared_ptr<void> res;
 				std::shared_ptr<void> loaded_res = this->FindMatchLoadedResource(res_desc);
@@ -916,14 +1475,15 @@ namespace KlayGE
 					res_desc->MainThreadStage();
 					res = res_desc->Resource();
 					this->AddLoadedResource(res_desc, res);
+					this->AddResidentResource(res_desc, res);
 				}
 			}
 		}
 		for (auto& lrq : tmp_loading_res)
 		{
-			if (LS_Complete == *lrq.second)
+			if (LS_Complete == *lrq.status)
 			{
-				*lrq.second = LS_CanBeRemoved;
+				*lrq.status = LS_CanBeRemoved;
 			}
 		}
 
@@ -931,8 +1491,9 @@ namespace KlayGE
 			std::lock_guard<std::mutex> lock(loading_mutex_);
 			for (auto iter = loading_res_.begin(); iter != loading_res_.end();)
 			{
-				if (LS_CanBeRemoved == *(iter->second))
+				if (LS_CanBeRemoved == *(iter->second.status))
 				{
+					loading_queries_.erase(iter->second.status.get());
 					iter = loading_res_.erase(iter);
 				}
 				else
@@ -943,30 +1504,115 @@ namespace KlayGE
 		}
 	}
 
-	void ResLoader::LoadingThreadFunc()
+	void ResLoader::EnqueueLoadingResource(ResLoadingDescPtr const & res_desc,
+		std::shared_ptr<std::atomic<LoadingStatus>> const & status, ResLoadingPriority priority)
 	{
-		while (!quit_)
 		{
-			std::vector<std::pair<ResLoadingDescPtr, std::shared_ptr<volatile LoadingStatus>>> loading_res_queue_copy;
+			std::lock_guard<std::mutex> lock(loading_res_queue_mutex_);
+			loading_res_queue_[static_cast<uint32_t>(priority)].emplace_back(res_desc, status);
+		}
+		loading_res_queue_cv_.notify_one();
+	}
+
+	void ResLoader::PromoteLoadingResource(std::shared_ptr<std::atomic<LoadingStatus>> const & status, ResLoadingPriority priority)
+	{
+		std::lock_guard<std::mutex> lock(loading_res_queue_mutex_);
 
+		for (uint32_t i = static_cast<uint32_t>(priority) + 1; i < NumResLoadingPriorities; ++ i)
+		{
+			auto& queue = loading_res_queue_[i];
+			auto iter = std::find_if(queue.begin(), queue.end(), [&status](auto const & res_pair) { return res_pair.second == status; });
+			if (iter != queue.end())
 			{
-				std::unique_lock<std::mutex> lock(loading_res_queue_mutex_);
-				loading_res_queue_cv_.wait(lock, [this] { return non_empty_loading_res_queue_; });
+				loading_res_queue_[static_cast<uint32_t>(priority)].push_back(std::move(*iter));
+				queue.erase(iter);
+				break;
+			}
+		}
+	}
 
-				loading_res_queue_copy.swap(loading_res_queue_);
-				non_empty_loading_res_queue_ = false;
+	void ResLoader::CancelLoadingResource(std::shared_ptr<void> const & res)
+	{
+		if (!res)
+		{
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(loading_mutex_);
+
+		for (auto const & lr : loading_res_)
+		{
+			if (lr.second.res_desc->Resource() != res)
+			{
+				continue;
 			}
 
-			for (auto& res_pair : loading_res_queue_copy)
+			auto const & status = lr.second.status;
+			auto const query_iter = loading_queries_.find(status.get());
+			if (query_iter != loading_queries_.end())
 			{
-				if (LS_Loading == *res_pair.second)
+				BOOST_ASSERT(query_iter->second > 0);
+				-- query_iter->second;
+				if (query_iter->second > 0)
 				{
-					res_pair.first->SubThreadStage();
-					*res_pair.second = LS_Complete;
+					// Other queries are still waiting for it
+					return;
 				}
 			}
 
-			Sleep(10);
+			std::lock_guard<std::mutex> queue_lock(loading_res_queue_mutex_);
+			for (auto& queue : loading_res_queue_)
+			{
+				auto const iter =
+					std::find_if(queue.begin(), queue.end(), [&status](auto const & res_pair) { return res_pair.second == status; });
+				if (iter != queue.end())
+				{
+					// The sub thread stage never runs. Update() drops every entry of it without the main thread stage.
+					LoadingStatus expected = LS_Loading;
+					status->compare_exchange_strong(expected, LS_CanBeRemoved);
+					queue.erase(iter);
+					break;
+				}
+			}
+			return;
+		}
+	}
+
+	void ResLoader::LoadingThreadFunc()
+	{
+		for (;;)
+		{
+			std::pair<ResLoadingDescPtr, std::shared_ptr<std::atomic<LoadingStatus>>> res_pair;
+
+			{
+				std::unique_lock<std::mutex> lock(loading_res_queue_mutex_);
+				loading_res_queue_cv_.wait(lock, [this] {
+					return quit_ || std::any_of(loading_res_queue_.begin(), loading_res_queue_.end(),
+										[](auto const & queue) { return !queue.empty(); });
+				});
+				if (quit_)
+				{
+					break;
+				}
+
+				for (auto& queue : loading_res_queue_)
+				{
+					if (!queue.empty())
+					{
+						res_pair = std::move(queue.front());
+						queue.pop_front();
+						break;
+					}
+				}
+			}
+
+			if (LS_Loading == *res_pair.second)
+			{
+				res_pair.first->SubThreadStage();
+
+				LoadingStatus expected = LS_Loading;
+				res_pair.second->compare_exchange_strong(expected, LS_Complete);
+			}
 		}
 	}
 
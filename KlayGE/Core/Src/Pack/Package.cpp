@@ -31,6 +31,7 @@
 #include <KlayGE/KlayGE.hpp>
 #define INITGUID
 #include <KFL/com_ptr.hpp>
+#include <KFL/CustomizedStreamBuf.hpp>
 #include <KFL/ErrorHandling.hpp>
 #include <KFL/ResIdentifier.hpp>
 #include <KFL/StringUtil.hpp>
@@ -44,8 +45,9 @@
 #include <KFL/DllLoader.hpp>
 
 #include <algorithm>
-#include <sstream>
+#include <ostream>
 #include <string>
+#include <vector>
 
 #include <boost/assert.hpp>
 
@@ -175,6 +177,8 @@ namespace KlayGE
 		TIFHR(archive->GetNumberOfItems(&num_items_));
 
 		archive_ = std::shared_ptr<IInArchive>(archive.detach(), std::mem_fn(&IInArchive::Release));
+
+		this->BuildDirectory();
 	}
 
 	bool Package::Locate(std::string_view extract_file_path)
@@ -188,12 +192,24 @@ namespace KlayGE
 		uint32_t real_index = this->Find(extract_file_path);
 		if (real_index != 0xFFFFFFFF)
 		{
-			auto decoded_file = MakeSharedPtr<std::stringstream>();
-			com_ptr<IOutStream> out_stream(new OutStream(decoded_file), false);
-			com_ptr<IArchiveExtractCallback> ecb(new ArchiveExtractCallback(password_, out_stream.get()), false);
-			TIFHR(archive_->Extract(&real_index, 1, false, ecb.get()));
-
 			PROPVARIANT prop;
+			prop.vt = VT_EMPTY;
+			TIFHR(archive_->GetProperty(real_index, kpidSize, &prop));
+
+			// Decodes into one contiguous buffer, so loaders can parse the resource in place
+			auto decoded = MakeSharedPtr<std::vector<char>>();
+			if (prop.vt == VT_UI8)
+			{
+				decoded->reserve(static_cast<size_t>(prop.uhVal.QuadPart));
+			}
+			VectorOutputStreamBuf decoded_buff(*decoded);
+			auto decoded_file = MakeSharedPtr<std::ostream>(&decoded_buff);
+			{
+				com_ptr<IOutStream> out_stream(new OutStream(decoded_file), false);
+				com_ptr<IArchiveExtractCallback> ecb(new ArchiveExtractCallback(password_, out_stream.get()), false);
+				TIFHR(archive_->Extract(&real_index, 1, false, ecb.get()));
+			}
+
 			prop.vt = VT_EMPTY;
 			TIFHR(archive_->GetProperty(real_index, kpidMTime, &prop));
 			uint64_t mtime;
@@ -208,41 +224,35 @@ namespace KlayGE
 				mtime = archive_is_->Timestamp();
 			}
 
-			return MakeSharedPtr<ResIdentifier>(res_name, mtime, decoded_file);
+			auto const data = MakeSpan(reinterpret_cast<uint8_t const *>(decoded->data()), decoded->size());
+			return MakeSharedPtr<ResIdentifier>(res_name, mtime, data, decoded);
 		}
 		return ResIdentifierPtr();
 	}
 
-	uint32_t Package::Find(std::string_view extract_file_path)
+	void Package::BuildDirectory()
 	{
-		uint32_t real_index = 0xFFFFFFFF;
-
 		for (uint32_t i = 0; i < num_items_; ++ i)
 		{
 			bool is_folder = true;
 			TIFHR(IsArchiveItemFolder(archive_.get(), i, is_folder));
-			if (!is_folder)
+			if (is_folder)
 			{
-				std::string file_path;
-				TIFHR(GetArchiveItemPath(archive_.get(), i, file_path));
-				std::replace(file_path.begin(), file_path.end(), '\\', '/');
-				if (!StringUtil::CaseInsensitiveLexicographicalCompare(extract_file_path, file_path) &&
-					!StringUtil::CaseInsensitiveLexicographicalCompare(file_path, extract_file_path))
-				{
-					real_index = i;
-					break;
-				}
+				continue;
 			}
-		}
-		if (real_index != 0xFFFFFFFF)
-		{
+
+			std::string file_path;
+			TIFHR(GetArchiveItemPath(archive_.get(), i, file_path));
+			std::replace(file_path.begin(), file_path.end(), '\\', '/');
+
+			uint32_t real_index = i;
 			PROPVARIANT prop;
 			prop.vt = VT_EMPTY;
-			TIFHR(archive_->GetProperty(real_index, kpidIsAnti, &prop));
+			TIFHR(archive_->GetProperty(i, kpidIsAnti, &prop));
 			if ((VT_BOOL == prop.vt) && (VARIANT_FALSE == prop.boolVal))
 			{
 				prop.vt = VT_EMPTY;
-				TIFHR(archive_->GetProperty(real_index, kpidPosition, &prop));
+				TIFHR(archive_->GetProperty(i, kpidPosition, &prop));
 				if (prop.vt != VT_EMPTY)
 				{
 					if ((prop.vt != VT_UI8) || (prop.uhVal.QuadPart != 0))
@@ -255,8 +265,27 @@ namespace KlayGE
 			{
 				real_index = 0xFFFFFFFF;
 			}
+
+			std::string key = file_path;
+			StringUtil::ToLower(key);
+			// The first item with a given path wins, as the linear search used to do
+			if (directory_.emplace(std::move(key), real_index).second && (real_index != 0xFFFFFFFF))
+			{
+				file_paths_.push_back(std::move(file_path));
+			}
 		}
+	}
+
+	uint32_t Package::Find(std::string_view extract_file_path) const
+	{
+		std::string key(extract_file_path);
+		StringUtil::ToLower(key);
 
-		return real_index;
+		auto iter = directory_.find(key);
+		if (iter != directory_.end())
+		{
+			return iter->second;
+		}
+		return 0xFFFFFFFF;
 	}
 }
@@ -0,0 +1,558 @@
+/**
+ * @file AnimationEvaluator.cpp
+ * @author Minmin Gong
+ *
+ * @section DESCRIPTION
+ *
+ * This source file is part of KlayGE
+ * For the latest info, see http://www.klayge.org
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * You may alternatively use this source under the terms of
+ * the KlayGE Proprietary License (KPL). You can obtained such a license
+ * from http://www.klayge.org/licensing/.
+ */
+
+#include <KlayGE/KlayGE.hpp>
+
+#include <KFL/Math.hpp>
+#include <KlayGE/Mesh.hpp>
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(KLAYGE_SSE2_SUPPORT)
+	#include <emmintrin.h>
+#endif
+
+#include <KlayGE/AnimationEvaluator.hpp>
+
+namespace
+{
+	using namespace KlayGE;
+
+	// Cached key frame segment of a track
+	enum SegmentChannel
+	{
+		SC_RealX = 0,
+		SC_RealY,
+		SC_RealZ,
+		SC_RealW,
+		SC_DualX,
+		SC_DualY,
+		SC_DualZ,
+		SC_DualW,
+		SC_Angle,
+		SC_Pitch,
+		SC_DirX,
+		SC_DirY,
+		SC_DirZ,
+		SC_MomentX,
+		SC_MomentY,
+		SC_MomentZ,
+		SC_Scale,
+		SC_ScaleDelta,
+		SC_Frame,
+		SC_InvLength,
+		SC_Factor,
+
+		SC_NumChannels
+	};
+
+	// Interpolated key of a track, before it's chained to the parent
+	enum LocalChannel
+	{
+		LC_RealX = 0,
+		LC_RealY,
+		LC_RealZ,
+		LC_RealW,
+		LC_DualX,
+		LC_DualY,
+		LC_DualZ,
+		LC_DualW,
+		LC_Scale,
+
+		LC_NumChannels
+	};
+
+	uint32_t constexpr BATCH_SIZE = 4;
+
+	float constexpr IDENTITY[LC_NumChannels] = {0, 0, 0, 1, 0, 0, 0, 0, 1};
+
+#if defined(KLAYGE_SSE2_SUPPORT)
+	struct Batch
+	{
+		__m128 v;
+
+		static Batch Load(float const * p)
+		{
+			return {_mm_loadu_ps(p)};
+		}
+		static Batch Set(float f)
+		{
+			return {_mm_set1_ps(f)};
+		}
+		void Store(float* p) const
+		{
+			_mm_storeu_ps(p, v);
+		}
+	};
+
+	Batch operator+(Batch const & lhs, Batch const & rhs)
+	{
+		return {_mm_add_ps(lhs.v, rhs.v)};
+	}
+	Batch operator-(Batch const & lhs, Batch const & rhs)
+	{
+		return {_mm_sub_ps(lhs.v, rhs.v)};
+	}
+	Batch operator*(Batch const & lhs, Batch const & rhs)
+	{
+		return {_mm_mul_ps(lhs.v, rhs.v)};
+	}
+#else
+	struct Batch
+	{
+		float v[BATCH_SIZE];
+
+		static Batch Load(float const * p)
+		{
+			return {{p[0], p[1], p[2], p[3]}};
+		}
+		static Batch Set(float f)
+		{
+			return {{f, f, f, f}};
+		}
+		void Store(float* p) const
+		{
+			std::copy(v, v + BATCH_SIZE, p);
+		}
+	};
+
+	template <typename Op>
+	Batch PerLane(Batch const & lhs, Batch const & rhs, Op const & op)
+	{
+		Batch ret;
+		for (uint32_t i = 0; i < BATCH_SIZE; ++ i)
+		{
+			ret.v[i] = op(lhs.v[i], rhs.v[i]);
+		}
+		return ret;
+	}
+
+	Batch operator+(Batch const & lhs, Batch const & rhs)
+	{
+		return PerLane(lhs, rhs, [](float a, float b) { return a + b; });
+	}
+	Batch operator-(Batch const & lhs, Batch const & rhs)
+	{
+		return PerLane(lhs, rhs, [](float a, float b) { return a - b; });
+	}
+	Batch operator*(Batch const & lhs, Batch const & rhs)
+	{
+		return PerLane(lhs, rhs, [](float a, float b) { return a * b; });
+	}
+#endif
+
+	struct BatchQuat
+	{
+		Batch x, y, z, w;
+	};
+
+	// Same as MathLib::mul, on 4 quaternions at a time
+	BatchQuat Mul(BatchQuat const & lhs, BatchQuat const & rhs)
+	{
+		return {lhs.x * rhs.w - lhs.y * rhs.z + lhs.z * rhs.y + lhs.w * rhs.x,
+			lhs.x * rhs.z + lhs.y * rhs.w - lhs.z * rhs.x + lhs.w * rhs.y,
+			lhs.y * rhs.x - lhs.x * rhs.y + lhs.z * rhs.w + lhs.w * rhs.z,
+			lhs.w * rhs.w - lhs.x * rhs.x - lhs.y * rhs.y - lhs.z * rhs.z};
+	}
+
+	// Half screw angles stay in [-pi/2, pi/2], since sclerp's difference rotation is on the same hemisphere and the factor is
+	//  in [-1, 1]. Taylor series up to x^11 and x^12 are accurate to float precision over that range.
+	void SinCos(Batch const & x, Batch& s, Batch& c)
+	{
+		Batch const x2 = x * x;
+
+		s = Batch::Set(-1.0f / 39916800);
+		s = s * x2 + Batch::Set(1.0f / 362880);
+		s = s * x2 + Batch::Set(-1.0f / 5040);
+		s = s * x2 + Batch::Set(1.0f / 120);
+		s = s * x2 + Batch::Set(-1.0f / 6);
+		s = (s * x2 + Batch::Set(1)) * x;
+
+		c = Batch::Set(1.0f / 479001600);
+		c = c * x2 + Batch::Set(-1.0f / 3628800);
+		c = c * x2 + Batch::Set(1.0f / 40320);
+		c = c * x2 + Batch::Set(-1.0f / 720);
+		c = c * x2 + Batch::Set(1.0f / 24);
+		c = c * x2 + Batch::Set(-0.5f);
+		c = c * x2 + Batch::Set(1);
+	}
+} // namespace
+
+namespace KlayGE
+{
+	AnimationEvaluator::AnimationEvaluator() : num_padded_tracks_(0)
+	{
+	}
+
+	void AnimationEvaluator::Bind(std::vector<int32_t> parents, std::shared_ptr<std::vector<KeyFrameSet>> const & key_frame_sets)
+	{
+		BOOST_ASSERT(parents.size() == key_frame_sets->size());
+
+		parents_ = std::move(parents);
+		key_frame_sets_ = key_frame_sets;
+
+		uint32_t const num_joints = this->NumJoints();
+		num_padded_tracks_ = (num_joints + BATCH_SIZE - 1) / BATCH_SIZE * BATCH_SIZE;
+
+		cursors_.assign(num_joints, ~0U);
+		segments_.assign(SC_NumChannels * num_padded_tracks_, 0.0f);
+		locals_.assign(LC_NumChannels * num_padded_tracks_, 0.0f);
+		for (uint32_t i = num_joints; i < num_padded_tracks_; ++ i)
+		{
+			// Padding lanes stay at identity
+			segments_[SC_RealW * num_padded_tracks_ + i] = 1;
+			segments_[SC_Scale * num_padded_tracks_ + i] = 1;
+		}
+
+		bind_reals_.resize(num_joints);
+		bind_duals_.resize(num_joints);
+		bind_scales_.resize(num_joints);
+
+		// Joints of the same depth don't depend on each other, so each depth is composed in batches of its own
+		std::vector<uint32_t> depths(num_joints);
+		uint32_t max_depth = 0;
+		for (uint32_t i = 0; i < num_joints; ++ i)
+		{
+			int32_t const parent = parents_[i];
+			BOOST_ASSERT(parent < static_cast<int32_t>(i));
+			depths[i] = (parent < 0) ? 0 : depths[parent] + 1;
+			max_depth = std::max(max_depth, depths[i]);
+		}
+		compose_order_.clear();
+		for (uint32_t depth = 0; depth <= max_depth; ++ depth)
+		{
+			for (uint32_t i = 0; i < num_joints; ++ i)
+			{
+				if (depths[i] == depth)
+				{
+					compose_order_.push_back(static_cast<int32_t>(i));
+				}
+			}
+			compose_order_.resize((compose_order_.size() + BATCH_SIZE - 1) / BATCH_SIZE * BATCH_SIZE, -1);
+		}
+	}
+
+	void AnimationEvaluator::Evaluate(float frame)
+	{
+		for (uint32_t i = 0; i < this->NumJoints(); ++ i)
+		{
+			this->UpdateSegment(i, frame);
+		}
+		this->InterpolateTracks();
+		this->ComposeJoints();
+	}
+
+	void AnimationEvaluator::UpdateSegment(uint32_t track, float frame)
+	{
+		KeyFrameSet const & kf = (*key_frame_sets_)[track];
+		uint32_t const num_keys = static_cast<uint32_t>(kf.frame_id.size());
+		float* seg = &segments_[track];
+		uint32_t const stride = num_padded_tracks_;
+
+		uint32_t index0;
+		if (num_keys == 1)
+		{
+			index0 = 0;
+		}
+		else
+		{
+			float const period = static_cast<float>(kf.frame_id.back() + 1);
+			frame -= std::floor(frame / period) * period;
+
+			auto in_segment = [&kf, num_keys, frame](uint32_t index) {
+				return (index < num_keys) && (kf.frame_id[index] <= frame)
+					&& ((index + 1 == num_keys) || (frame < kf.frame_id[index + 1]));
+			};
+
+			index0 = cursors_[track];
+			if (!in_segment(index0))
+			{
+				// Playback mostly stays in the segment or moves on to the next one
+				if (in_segment(index0 + 1))
+				{
+					++ index0;
+				}
+				else
+				{
+					auto iter = std::upper_bound(kf.frame_id.begin(), kf.frame_id.end(), frame);
+					index0 = static_cast<uint32_t>(std::max<ptrdiff_t>(iter - kf.frame_id.begin() - 1, 0));
+				}
+			}
+		}
+
+		if (index0 != cursors_[track])
+		{
+			cursors_[track] = index0;
+
+			uint32_t const index1 = (index0 + 1) % num_keys;
+			Quaternion const & real0 = kf.bind_real[index0];
+			Quaternion const & dual0 = kf.bind_dual[index0];
+
+			// The screw motion from key 0 to key 1, as MathLib::sclerp computes it
+			Quaternion real1 = kf.bind_real[index1];
+			Quaternion dual1 = kf.bind_dual[index1];
+			if (MathLib::dot(real0, real1) < 0)
+			{
+				real1 = -real1;
+				dual1 = -dual1;
+			}
+
+			std::pair<Quaternion, Quaternion> dif_dq = MathLib::inverse(real0, dual0);
+			dif_dq.second = MathLib::mul_dual(dif_dq.first, dif_dq.second, real1, dual1);
+			dif_dq.first = MathLib::mul_real(dif_dq.first, real1);
+
+			float angle, pitch;
+			float3 dir, moment;
+			MathLib::udq_to_screw(angle, pitch, dir, moment, dif_dq.first, dif_dq.second);
+
+			seg[SC_RealX * stride] = real0.x();
+			seg[SC_RealY * stride] = real0.y();
+			seg[SC_RealZ * stride] = real0.z();
+			seg[SC_RealW * stride] = real0.w();
+			seg[SC_DualX * stride] = dual0.x();
+			seg[SC_DualY * stride] = dual0.y();
+			seg[SC_DualZ * stride] = dual0.z();
+			seg[SC_DualW * stride] = dual0.w();
+			seg[SC_Angle * stride] = angle;
+			seg[SC_Pitch * stride] = pitch;
+			seg[SC_DirX * stride] = dir.x();
+			seg[SC_DirY * stride] = dir.y();
+			seg[SC_DirZ * stride] = dir.z();
+			seg[SC_MomentX * stride] = moment.x();
+			seg[SC_MomentY * stride] = moment.y();
+			seg[SC_MomentZ * stride] = moment.z();
+			seg[SC_Scale * stride] = kf.bind_scale[index0];
+			seg[SC_ScaleDelta * stride] = kf.bind_scale[index1] - kf.bind_scale[index0];
+
+			float const frame0 = static_cast<float>(kf.frame_id[index0]);
+			float const frame1 = static_cast<float>(kf.frame_id[index1]);
+			seg[SC_Frame * stride] = frame0;
+			seg[SC_InvLength * stride] = (num_keys == 1) ? 0.0f : 1 / (frame1 - frame0);
+		}
+
+		// Before the first key, the first key is held
+		seg[SC_Factor * stride] = std::max(frame - seg[SC_Frame * stride], 0.0f) * seg[SC_InvLength * stride];
+	}
+
+	void AnimationEvaluator::InterpolateTracks()
+	{
+		uint32_t const stride = num_padded_tracks_;
+		for (uint32_t t = 0; t < num_padded_tracks_; t += BATCH_SIZE)
+		{
+			float const * seg = &segments_[t];
+			auto load = [seg, stride](uint32_t channel) { return Batch::Load(seg + channel * stride); };
+
+			// MathLib::udq_from_screw on the scaled screw, followed by the key 0 dual quaternion
+			Batch const factor = load(SC_Factor);
+			Batch const half_angle = load(SC_Angle) * factor * Batch::Set(0.5f);
+			Batch const half_pitch = load(SC_Pitch) * factor * Batch::Set(0.5f);
+			Batch sa, ca;
+			SinCos(half_angle, sa, ca);
+
+			Batch const dir_x = load(SC_DirX);
+			Batch const dir_y = load(SC_DirY);
+			Batch const dir_z = load(SC_DirZ);
+			BatchQuat const dif_real = {dir_x * sa, dir_y * sa, dir_z * sa, ca};
+			Batch const pitch_ca = half_pitch * ca;
+			BatchQuat const dif_dual = {sa * load(SC_MomentX) + pitch_ca * dir_x, sa * load(SC_MomentY) + pitch_ca * dir_y,
+				sa * load(SC_MomentZ) + pitch_ca * dir_z, Batch::Set(0) - half_pitch * sa};
+
+			BatchQuat const real0 = {load(SC_RealX), load(SC_RealY), load(SC_RealZ), load(SC_RealW)};
+			BatchQuat const dual0 = {load(SC_DualX), load(SC_DualY), load(SC_DualZ), load(SC_DualW)};
+			BatchQuat const real = Mul(real0, dif_real);
+			BatchQuat const dual_a = Mul(real0, dif_dual);
+			BatchQuat const dual_b = Mul(dual0, dif_real);
+			Batch const scale = load(SC_Scale) + load(SC_ScaleDelta) * factor;
+
+			float results[LC_NumChannels][BATCH_SIZE];
+			real.x.Store(results[LC_RealX]);
+			real.y.Store(results[LC_RealY]);
+			real.z.Store(results[LC_RealZ]);
+			real.w.Store(results[LC_RealW]);
+			(dual_a.x + dual_b.x).Store(results[LC_DualX]);
+			(dual_a.y + dual_b.y).Store(results[LC_DualY]);
+			(dual_a.z + dual_b.z).Store(results[LC_DualZ]);
+			(dual_a.w + dual_b.w).Store(results[LC_DualW]);
+			scale.Store(results[LC_Scale]);
+
+			// Composition picks joints in hierarchy order, so keys are kept joint by joint
+			for (uint32_t lane = 0; lane < BATCH_SIZE; ++ lane)
+			{
+				float* local = &locals_[(t + lane) * LC_NumChannels];
+				for (uint32_t c = 0; c < LC_NumChannels; ++ c)
+				{
+					local[c] = results[c][lane];
+				}
+			}
+		}
+	}
+
+	void AnimationEvaluator::ComposeJoints()
+	{
+		for (size_t slot = 0; slot < compose_order_.size(); slot += BATCH_SIZE)
+		{
+			// Gathers the keys and the already composed parents. Roots are chained to identity, which leaves them unchanged.
+			float keys[LC_NumChannels][BATCH_SIZE];
+			float parents[LC_NumChannels][BATCH_SIZE];
+			float signs[BATCH_SIZE];
+			for (uint32_t lane = 0; lane < BATCH_SIZE; ++ lane)
+			{
+				int32_t const joint = compose_order_[slot + lane];
+				int32_t const parent = (joint < 0) ? -1 : parents_[joint];
+				float const * local = (joint < 0) ? IDENTITY : &locals_[joint * LC_NumChannels];
+				for (uint32_t c = 0; c < LC_NumChannels; ++ c)
+				{
+					keys[c][lane] = local[c];
+				}
+				if (parent < 0)
+				{
+					for (uint32_t c = 0; c < LC_NumChannels; ++ c)
+					{
+						parents[c][lane] = IDENTITY[c];
+					}
+					signs[lane] = 1;
+				}
+				else
+				{
+					Quaternion const & parent_real = bind_reals_[parent];
+					Quaternion const & parent_dual = bind_duals_[parent];
+					for (uint32_t c = 0; c < 4; ++ c)
+					{
+						parents[LC_RealX + c][lane] = parent_real[c];
+						parents[LC_DualX + c][lane] = parent_dual[c];
+					}
+					parents[LC_Scale][lane] = bind_scales_[parent];
+
+					// Keeps the key on the parent's hemisphere
+					float const dot = keys[LC_RealX][lane] * parent_real.x() + keys[LC_RealY][lane] * parent_real.y()
+						+ keys[LC_RealZ][lane] * parent_real.z() + keys[LC_RealW][lane] * parent_real.w();
+					signs[lane] = (dot < 0) ? -1.0f : 1.0f;
+				}
+			}
+
+			Batch const sign = Batch::Load(signs);
+			BatchQuat const key_real = {Batch::Load(keys[LC_RealX]) * sign, Batch::Load(keys[LC_RealY]) * sign,
+				Batch::Load(keys[LC_RealZ]) * sign, Batch::Load(keys[LC_RealW]) * sign};
+			BatchQuat const key_dual = {Batch::Load(keys[LC_DualX]) * sign, Batch::Load(keys[LC_DualY]) * sign,
+				Batch::Load(keys[LC_DualZ]) * sign, Batch::Load(keys[LC_DualW]) * sign};
+			Batch const key_scale = Batch::Load(keys[LC_Scale]);
+			BatchQuat const parent_real = {Batch::Load(parents[LC_RealX]), Batch::Load(parents[LC_RealY]),
+				Batch::Load(parents[LC_RealZ]), Batch::Load(parents[LC_RealW])};
+			BatchQuat const parent_dual = {Batch::Load(parents[LC_DualX]), Batch::Load(parents[LC_DualY]),
+				Batch::Load(parents[LC_DualZ]), Batch::Load(parents[LC_DualW])};
+			Batch const parent_scale = Batch::Load(parents[LC_Scale]);
+
+			// MathLib::mul_real and mul_dual, with the key translation scaled by the parent
+			BatchQuat const scaled_key_dual = {key_dual.x * parent_scale, key_dual.y * parent_scale, key_dual.z * parent_scale,
+				key_dual.w * parent_scale};
+			BatchQuat const real = Mul(key_real, parent_real);
+			BatchQuat const dual_a = Mul(key_real, parent_dual);
+			BatchQuat const dual_b = Mul(scaled_key_dual, parent_real);
+
+			float results[LC_NumChannels][BATCH_SIZE];
+			real.x.Store(results[LC_RealX]);
+			real.y.Store(results[LC_RealY]);
+			real.z.Store(results[LC_RealZ]);
+			real.w.Store(results[LC_RealW]);
+			(dual_a.x + dual_b.x).Store(results[LC_DualX]);
+			(dual_a.y + dual_b.y).Store(results[LC_DualY]);
+			(dual_a.z + dual_b.z).Store(results[LC_DualZ]);
+			(dual_a.w + dual_b.w).Store(results[LC_DualW]);
+			(key_scale * parent_scale).Store(results[LC_Scale]);
+
+			for (uint32_t lane = 0; lane < BATCH_SIZE; ++ lane)
+			{
+				int32_t const joint = compose_order_[slot + lane];
+				if (joint < 0)
+				{
+					continue;
+				}
+
+				if ((parents_[joint] >= 0)
+					&& (std::signbit(keys[LC_Scale][lane]) || std::signbit(parents[LC_Scale][lane])))
+				{
+					this->ComposeMirroredJoint(joint,
+						Quaternion(keys[LC_RealX][lane], keys[LC_RealY][lane], keys[LC_RealZ][lane], keys[LC_RealW][lane]),
+						Quaternion(keys[LC_DualX][lane], keys[LC_DualY][lane], keys[LC_DualZ][lane], keys[LC_DualW][lane]),
+						keys[LC_Scale][lane]);
+				}
+				else
+				{
+					bind_reals_[joint] = Quaternion(results[LC_RealX][lane], results[LC_RealY][lane], results[LC_RealZ][lane],
+						results[LC_RealW][lane]);
+					bind_duals_[joint] = Quaternion(results[LC_DualX][lane], results[LC_DualY][lane], results[LC_DualZ][lane],
+						results[LC_DualW][lane]);
+					bind_scales_[joint] = results[LC_Scale][lane];
+				}
+			}
+		}
+	}
+
+	// Mirrored joints can't be chained as dual quaternions, go through matrices instead
+	void AnimationEvaluator::ComposeMirroredJoint(uint32_t joint, Quaternion const & key_real, Quaternion const & key_dual,
+		float key_scale)
+	{
+		int32_t const parent = parents_[joint];
+		Quaternion const & parent_real = bind_reals_[parent];
+		Quaternion const & parent_dual = bind_duals_[parent];
+		float const parent_scale = bind_scales_[parent];
+
+		float4x4 tmp_mat = MathLib::scaling(MathLib::abs(key_scale), MathLib::abs(key_scale), key_scale)
+			* MathLib::to_matrix(key_real)
+			* MathLib::translation(MathLib::udq_to_trans(key_real, key_dual))
+			* MathLib::scaling(MathLib::abs(parent_scale), MathLib::abs(parent_scale), parent_scale)
+			* MathLib::to_matrix(parent_real)
+			* MathLib::translation(MathLib::udq_to_trans(parent_real, parent_dual));
+
+		float flip = 1;
+		if (MathLib::dot(MathLib::cross(float3(tmp_mat(0, 0), tmp_mat(0, 1), tmp_mat(0, 2)),
+			float3(tmp_mat(1, 0), tmp_mat(1, 1), tmp_mat(1, 2))),
+			float3(tmp_mat(2, 0), tmp_mat(2, 1), tmp_mat(2, 2))) < 0)
+		{
+			tmp_mat(2, 0) = -tmp_mat(2, 0);
+			tmp_mat(2, 1) = -tmp_mat(2, 1);
+			tmp_mat(2, 2) = -tmp_mat(2, 2);
+
+			flip = -1;
+		}
+
+		float3 scale;
+		Quaternion rot;
+		float3 trans;
+		MathLib::decompose(scale, rot, trans, tmp_mat);
+
+		bind_reals_[joint] = rot;
+		bind_duals_[joint] = MathLib::quat_trans_to_udq(rot, trans);
+		bind_scales_[joint] = flip * scale.x();
+	}
+} // namespace KlayGE
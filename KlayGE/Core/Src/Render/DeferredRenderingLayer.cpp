@@ -31,6 +31,7 @@
 #include <KlayGE/KlayGE.hpp>
 
 #include <KFL/ErrorHandling.hpp>
+#include <KFL/Hash.hpp>
 #include <KFL/Util.hpp>
 #include <KFL/Math.hpp>
 #include <KlayGE/DepthOfField.hpp>
@@ -330,7 +331,7 @@ namespace
 				  MakeSpan<std::string>({"out_tex"}), RenderEffectPtr(), nullptr)
 		{
 			auto effect = ASyncLoadRenderEffect("DeferredRenderingDebug.fxml");
-			this->Technique(effect, effect->TechniqueByName("ShowPosition"));
+			this->Technique(effect, effect->TechniqueByName(CT_HASH("ShowPosition")));
 		}
 
 		void Display(DeferredRenderingLayer::DisplayType display_type)
@@ -341,51 +342,51 @@ namespace
 				break;
 
 			case DeferredRenderingLayer::DT_Position:
-				technique_ = effect_->TechniqueByName("ShowPosition");
+				technique_ = effect_->TechniqueByName(CT_HASH("ShowPosition"));
 				break;
 
 			case DeferredRenderingLayer::DT_Normal:
-				technique_ = effect_->TechniqueByName("ShowNormal");
+				technique_ = effect_->TechniqueByName(CT_HASH("ShowNormal"));
 				break;
 
 			case DeferredRenderingLayer::DT_Depth:
-				technique_ = effect_->TechniqueByName("ShowDepth");
+				technique_ = effect_->TechniqueByName(CT_HASH("ShowDepth"));
 				break;
 
 			case DeferredRenderingLayer::DT_Diffuse:
-				technique_ = effect_->TechniqueByName("ShowDiffuse");
+				technique_ = effect_->TechniqueByName(CT_HASH("ShowDiffuse"));
 				break;
 
 			case DeferredRenderingLayer::DT_Specular:
-				technique_ = effect_->TechniqueByName("ShowSpecular");
+				technique_ = effect_->TechniqueByName(CT_HASH("ShowSpecular"));
 				break;
 
 			case DeferredRenderingLayer::DT_Shininess:
-				technique_ = effect_->TechniqueByName("ShowShininess");
+				technique_ = effect_->TechniqueByName(CT_HASH("ShowShininess"));
 				break;
 
 			case DeferredRenderingLayer::DT_MotionVec:
-				technique_ = effect_->TechniqueByName("ShowMotionVec");
+				technique_ = effect_->TechniqueByName(CT_HASH("ShowMotionVec"));
 				break;
 
 			case DeferredRenderingLayer::DT_Occlusion:
-				technique_ = effect_->TechniqueByName("ShowOcclusion");
+				technique_ = effect_->TechniqueByName(CT_HASH("ShowOcclusion"));
 				break;
 
 			case DeferredRenderingLayer::DT_Edge:
 				break;
 
 			case DeferredRenderingLayer::DT_SSVO:
-				technique_ = effect_->TechniqueByName("ShowSSVO");
+				technique_ = effect_->TechniqueByName(CT_HASH("ShowSSVO"));
 				break;
 
 #if DEFAULT_DEFERRED == TRIDITIONAL_DEFERRED
 			case DeferredRenderingLayer::DT_DiffuseLighting:
-				technique_ = effect_->TechniqueByName("ShowDiffuseLighting");
+				technique_ = effect_->TechniqueByName(CT_HASH("ShowDiffuseLighting"));
 				break;
 
 			case DeferredRenderingLayer::DT_SpecularLighting:
-				technique_ = effect_->TechniqueByName("ShowSpecularLighting");
+				technique_ = effect_->TechniqueByName(CT_HASH("ShowSpecularLighting"));
 				break;
 #endif
 
@@ -399,8 +400,8 @@ namespace
 			PostProcess::OnRenderBegin();
 
 			Camera const & camera = Context::Instance().AppInstance().ActiveCamera();
-			*(effect_->ParameterByName("inv_proj")) = camera.InverseProjMatrix();
-			*(effect_->ParameterByName("depth_near_far_invfar")) = float3(camera.NearPlane(), camera.FarPlane(), 1 / camera.FarPlane());
+			*(effect_->ParameterByName(CT_HASH("inv_proj"))) = camera.InverseProjMatrix();
+			*(effect_->ParameterByName(CT_HASH("depth_near_far_invfar"))) = float3(camera.NearPlane(), camera.FarPlane(), 1 / camera.FarPlane());
 		}
 	};
 }
@@ -570,78 +571,78 @@ namespace KlayGE
 
 		auto dr_effect = dr_effect_.get();
 
-		technique_shadows_[LightSource::LT_Point][0] = dr_effect->TechniqueByName("DeferredShadowingPointR");
-		technique_shadows_[LightSource::LT_Point][1] = dr_effect->TechniqueByName("DeferredShadowingPointG");
-		technique_shadows_[LightSource::LT_Point][2] = dr_effect->TechniqueByName("DeferredShadowingPointB");
-		technique_shadows_[LightSource::LT_Point][3] = dr_effect->TechniqueByName("DeferredShadowingPointA");
-		technique_shadows_[LightSource::LT_Point][4] = dr_effect->TechniqueByName("DeferredShadowingPoint");
-		technique_shadows_[LightSource::LT_Spot][0] = dr_effect->TechniqueByName("DeferredShadowingSpotR");
-		technique_shadows_[LightSource::LT_Spot][1] = dr_effect->TechniqueByName("DeferredShadowingSpotG");
-		technique_shadows_[LightSource::LT_Spot][2] = dr_effect->TechniqueByName("DeferredShadowingSpotB");
-		technique_shadows_[LightSource::LT_Spot][3] = dr_effect->TechniqueByName("DeferredShadowingSpotA");
-		technique_shadows_[LightSource::LT_Spot][4] = dr_effect->TechniqueByName("DeferredShadowingSpot");
-		technique_shadows_[LightSource::LT_Directional][0] = dr_effect->TechniqueByName("DeferredShadowingDirectionalR");
-		technique_shadows_[LightSource::LT_Directional][1] = dr_effect->TechniqueByName("DeferredShadowingDirectionalG");
-		technique_shadows_[LightSource::LT_Directional][2] = dr_effect->TechniqueByName("DeferredShadowingDirectionalB");
-		technique_shadows_[LightSource::LT_Directional][3] = dr_effect->TechniqueByName("DeferredShadowingDirectionalA");
-		technique_shadows_[LightSource::LT_Directional][4] = dr_effect->TechniqueByName("DeferredShadowingDirectional");
-		technique_shadows_[LightSource::LT_SphereArea][0] = dr_effect->TechniqueByName("DeferredShadowingPointR");
-		technique_shadows_[LightSource::LT_SphereArea][1] = dr_effect->TechniqueByName("DeferredShadowingPointG");
-		technique_shadows_[LightSource::LT_SphereArea][2] = dr_effect->TechniqueByName("DeferredShadowingPointB");
-		technique_shadows_[LightSource::LT_SphereArea][3] = dr_effect->TechniqueByName("DeferredShadowingPointA");
-		technique_shadows_[LightSource::LT_SphereArea][4] = dr_effect->TechniqueByName("DeferredShadowingPoint");
-		technique_shadows_[LightSource::LT_TubeArea][0] = dr_effect->TechniqueByName("DeferredShadowingPointR");
-		technique_shadows_[LightSource::LT_TubeArea][1] = dr_effect->TechniqueByName("DeferredShadowingPointG");
-		technique_shadows_[LightSource::LT_TubeArea][2] = dr_effect->TechniqueByName("DeferredShadowingPointB");
-		technique_shadows_[LightSource::LT_TubeArea][3] = dr_effect->TechniqueByName("DeferredShadowingPointA");
-		technique_shadows_[LightSource::LT_TubeArea][4] = dr_effect->TechniqueByName("DeferredShadowingPoint");
+		technique_shadows_[LightSource::LT_Point][0] = dr_effect->TechniqueByName(CT_HASH("DeferredShadowingPointR"));
+		technique_shadows_[LightSource::LT_Point][1] = dr_effect->TechniqueByName(CT_HASH("DeferredShadowingPointG"));
+		technique_shadows_[LightSource::LT_Point][2] = dr_effect->TechniqueByName(CT_HASH("DeferredShadowingPointB"));
+		technique_shadows_[LightSource::LT_Point][3] = dr_effect->TechniqueByName(CT_HASH("DeferredShadowingPointA"));
+		technique_shadows_[LightSource::LT_Point][4] = dr_effect->TechniqueByName(CT_HASH("DeferredShadowingPoint"));
+		technique_shadows_[LightSource::LT_Spot][0] = dr_effect->TechniqueByName(CT_HASH("DeferredShadowingSpotR"));
+		technique_shadows_[LightSource::LT_Spot][1] = dr_effect->TechniqueByName(CT_HASH("DeferredShadowingSpotG"));
+		technique_shadows_[LightSource::LT_Spot][2] = dr_effect->TechniqueByName(CT_HASH("DeferredShadowingSpotB"));
+		technique_shadows_[LightSource::LT_Spot][3] = dr_effect->TechniqueByName(CT_HASH("DeferredShadowingSpotA"));
+		technique_shadows_[LightSource::LT_Spot][4] = dr_effect->TechniqueByName(CT_HASH("DeferredShadowingSpot"));
+		technique_shadows_[LightSource::LT_Directional][0] = dr_effect->TechniqueByName(CT_HASH("DeferredShadowingDirectionalR"));
+		technique_shadows_[LightSource::LT_Directional][1] = dr_effect->TechniqueByName(CT_HASH("DeferredShadowingDirectionalG"));
+		technique_shadows_[LightSource::LT_Directional][2] = dr_effect->TechniqueByName(CT_HASH("DeferredShadowingDirectionalB"));
+		technique_shadows_[LightSource::LT_Directional][3] = dr_effect->TechniqueByName(CT_HASH("DeferredShadowingDirectionalA"));
+		technique_shadows_[LightSource::LT_Directional][4] = dr_effect->TechniqueByName(CT_HASH("DeferredShadowingDirectional"));
+		technique_shadows_[LightSource::LT_SphereArea][0] = dr_effect->TechniqueByName(CT_HASH("DeferredShadowingPointR"));
+		technique_shadows_[LightSource::LT_SphereArea][1] = dr_effect->TechniqueByName(CT_HASH("DeferredShadowingPointG"));
+		technique_shadows_[LightSource::LT_SphereArea][2] = dr_effect->TechniqueByName(CT_HASH("DeferredShadowingPointB"));
+		technique_shadows_[LightSource::LT_SphereArea][3] = dr_effect->TechniqueByName(CT_HASH("DeferredShadowingPointA"));
+		technique_shadows_[LightSource::LT_SphereArea][4] = dr_effect->TechniqueByName(CT_HASH("DeferredShadowingPoint"));
+		technique_shadows_[LightSource::LT_TubeArea][0] = dr_effect->TechniqueByName(CT_HASH("DeferredShadowingPointR"));
+		technique_shadows_[LightSource::LT_TubeArea][1] = dr_effect->TechniqueByName(CT_HASH("DeferredShadowingPointG"));
+		technique_shadows_[LightSource::LT_TubeArea][2] = dr_effect->TechniqueByName(CT_HASH("DeferredShadowingPointB"));
+		technique_shadows_[LightSource::LT_TubeArea][3] = dr_effect->TechniqueByName(CT_HASH("DeferredShadowingPointA"));
+		technique_shadows_[LightSource::LT_TubeArea][4] = dr_effect->TechniqueByName(CT_HASH("DeferredShadowingPoint"));
 #if DEFAULT_DEFERRED == TRIDITIONAL_DEFERRED
-		technique_lights_[LightSource::LT_Ambient] = dr_effect->TechniqueByName("DeferredRenderingAmbient");
-		technique_lights_[LightSource::LT_Directional] = dr_effect->TechniqueByName("DeferredRenderingDirectional");
-		technique_lights_[LightSource::LT_Point] = dr_effect->TechniqueByName("DeferredRenderingPoint");
-		technique_lights_[LightSource::LT_Spot] = dr_effect->TechniqueByName("DeferredRenderingSpot");
-		technique_lights_[LightSource::LT_SphereArea] = dr_effect->TechniqueByName("DeferredRenderingSphereArea");
-		technique_lights_[LightSource::LT_TubeArea] = dr_effect->TechniqueByName("DeferredRenderingTubeArea");
-		technique_light_depth_only_ = dr_effect->TechniqueByName("DeferredRenderingLightDepthOnly");
-		technique_light_stencil_ = dr_effect->TechniqueByName("DeferredRenderingLightStencil");
+		technique_lights_[LightSource::LT_Ambient] = dr_effect->TechniqueByName(CT_HASH("DeferredRenderingAmbient"));
+		technique_lights_[LightSource::LT_Directional] = dr_effect->TechniqueByName(CT_HASH("DeferredRenderingDirectional"));
+		technique_lights_[LightSource::LT_Point] = dr_effect->TechniqueByName(CT_HASH("DeferredRenderingPoint"));
+		technique_lights_[LightSource::LT_Spot] = dr_effect->TechniqueByName(CT_HASH("DeferredRenderingSpot"));
+		technique_lights_[LightSource::LT_SphereArea] = dr_effect->TechniqueByName(CT_HASH("DeferredRenderingSphereArea"));
+		technique_lights_[LightSource::LT_TubeArea] = dr_effect->TechniqueByName(CT_HASH("DeferredRenderingTubeArea"));
+		technique_light_depth_only_ = dr_effect->TechniqueByName(CT_HASH("DeferredRenderingLightDepthOnly"));
+		technique_light_stencil_ = dr_effect->TechniqueByName(CT_HASH("DeferredRenderingLightStencil"));
 #endif
-		technique_no_lighting_ = dr_effect->TechniqueByName("NoLightingTech");
-		technique_shading_ = dr_effect->TechniqueByName("ShadingTech");
-		technique_merge_shading_[0] = dr_effect->TechniqueByName("MergeShadingAlphaBlendTech");
-		technique_merge_shading_[1] = dr_effect->TechniqueByName("MergeShadingAlphaBlendMSTech");
-		technique_merge_depth_[0] = dr_effect->TechniqueByName("MergeDepthAlphaBlendTech");
-		technique_merge_depth_[1] = dr_effect->TechniqueByName("MergeDepthAlphaBlendMSTech");
-		technique_copy_shading_depth_ = dr_effect->TechniqueByName("CopyShadingDepthTech");
+		technique_no_lighting_ = dr_effect->TechniqueByName(CT_HASH("NoLightingTech"));
+		technique_shading_ = dr_effect->TechniqueByName(CT_HASH("ShadingTech"));
+		technique_merge_shading_[0] = dr_effect->TechniqueByName(CT_HASH("MergeShadingAlphaBlendTech"));
+		technique_merge_shading_[1] = dr_effect->TechniqueByName(CT_HASH("MergeShadingAlphaBlendMSTech"));
+		technique_merge_depth_[0] = dr_effect->TechniqueByName(CT_HASH("MergeDepthAlphaBlendTech"));
+		technique_merge_depth_[1] = dr_effect->TechniqueByName(CT_HASH("MergeDepthAlphaBlendMSTech"));
+		technique_copy_shading_depth_ = dr_effect->TechniqueByName(CT_HASH("CopyShadingDepthTech"));
 #if DEFAULT_DEFERRED == LIGHT_INDEXED_DEFERRED
 		if (cs_cldr_)
 		{
-			technique_cldr_shadowing_unified_[0] = dr_effect->TechniqueByName("ClusteredDRShadowingUnified");
-			technique_cldr_shadowing_unified_[1] = dr_effect->TechniqueByName("ClusteredDRShadowingUnifiedMS");
-			technique_cldr_light_intersection_unified_ = dr_effect->TechniqueByName("ClusteredDRLightIntersection");
+			technique_cldr_shadowing_unified_[0] = dr_effect->TechniqueByName(CT_HASH("ClusteredDRShadowingUnified"));
+			technique_cldr_shadowing_unified_[1] = dr_effect->TechniqueByName(CT_HASH("ClusteredDRShadowingUnifiedMS"));
+			technique_cldr_light_intersection_unified_ = dr_effect->TechniqueByName(CT_HASH("ClusteredDRLightIntersection"));
 			technique_cldr_unified_[0] = dr_effect->TechniqueByName(typed_uav_ ? "ClusteredDRUnified" : "ClusteredDRUnifiedNoTypedUAV");
 			technique_cldr_unified_[1] = dr_effect->TechniqueByName(typed_uav_ ? "ClusteredDRUnifiedMS" : "ClusteredDRUnifiedNoTypedUAVMS");
 
-			technique_depth_to_tiled_min_max_[0] = dr_effect->TechniqueByName("DepthToTiledMinMax");
-			technique_depth_to_tiled_min_max_[1] = dr_effect->TechniqueByName("DepthToTiledMinMaxMS");
-			technique_resolve_g_buffers_ = dr_effect->TechniqueByName("ResolveGBuffers");
-			technique_resolve_merged_depth_ = dr_effect->TechniqueByName("ResolveMergedDepth");
-			technique_array_to_multiSample_ = dr_effect->TechniqueByName("ArrayToMultiSample");
+			technique_depth_to_tiled_min_max_[0] = dr_effect->TechniqueByName(CT_HASH("DepthToTiledMinMax"));
+			technique_depth_to_tiled_min_max_[1] = dr_effect->TechniqueByName(CT_HASH("DepthToTiledMinMaxMS"));
+			technique_resolve_g_buffers_ = dr_effect->TechniqueByName(CT_HASH("ResolveGBuffers"));
+			technique_resolve_merged_depth_ = dr_effect->TechniqueByName(CT_HASH("ResolveMergedDepth"));
+			technique_array_to_multiSample_ = dr_effect->TechniqueByName(CT_HASH("ArrayToMultiSample"));
 		}
 		else
 		{
-			technique_draw_light_index_point_ = dr_effect->TechniqueByName("DrawLightIndexPoint");
-			technique_draw_light_index_spot_ = dr_effect->TechniqueByName("DrawLightIndexSpot");
-			technique_lidr_ambient_ = dr_effect->TechniqueByName("LIDRAmbient");
-			technique_lidr_directional_shadow_ = dr_effect->TechniqueByName("LIDRDirectionalShadow");
-			technique_lidr_directional_no_shadow_ = dr_effect->TechniqueByName("LIDRDirectionalNoShadow");
-			technique_lidr_point_shadow_ = dr_effect->TechniqueByName("LIDRPointShadow");
-			technique_lidr_point_no_shadow_ = dr_effect->TechniqueByName("LIDRPointNoShadow");
-			technique_lidr_spot_shadow_ = dr_effect->TechniqueByName("LIDRSpotShadow");
-			technique_lidr_spot_no_shadow_ = dr_effect->TechniqueByName("LIDRSpotNoShadow");
-			technique_lidr_sphere_area_shadow_ = dr_effect->TechniqueByName("LIDRSphereAreaShadow");
-			technique_lidr_sphere_area_no_shadow_ = dr_effect->TechniqueByName("LIDRSphereAreaNoShadow");
-			technique_lidr_tube_area_shadow_ = dr_effect->TechniqueByName("LIDRTubeAreaShadow");
-			technique_lidr_tube_area_no_shadow_ = dr_effect->TechniqueByName("LIDRTubeAreaNoShadow");
+			technique_draw_light_index_point_ = dr_effect->TechniqueByName(CT_HASH("DrawLightIndexPoint"));
+			technique_draw_light_index_spot_ = dr_effect->TechniqueByName(CT_HASH("DrawLightIndexSpot"));
+			technique_lidr_ambient_ = dr_effect->TechniqueByName(CT_HASH("LIDRAmbient"));
+			technique_lidr_directional_shadow_ = dr_effect->TechniqueByName(CT_HASH("LIDRDirectionalShadow"));
+			technique_lidr_directional_no_shadow_ = dr_effect->TechniqueByName(CT_HASH("LIDRDirectionalNoShadow"));
+			technique_lidr_point_shadow_ = dr_effect->TechniqueByName(CT_HASH("LIDRPointShadow"));
+			technique_lidr_point_no_shadow_ = dr_effect->TechniqueByName(CT_HASH("LIDRPointNoShadow"));
+			technique_lidr_spot_shadow_ = dr_effect->TechniqueByName(CT_HASH("LIDRSpotShadow"));
+			technique_lidr_spot_no_shadow_ = dr_effect->TechniqueByName(CT_HASH("LIDRSpotNoShadow"));
+			technique_lidr_sphere_area_shadow_ = dr_effect->TechniqueByName(CT_HASH("LIDRSphereAreaShadow"));
+			technique_lidr_sphere_area_no_shadow_ = dr_effect->TechniqueByName(CT_HASH("LIDRSphereAreaNoShadow"));
+			technique_lidr_tube_area_shadow_ = dr_effect->TechniqueByName(CT_HASH("LIDRTubeAreaShadow"));
+			technique_lidr_tube_area_no_shadow_ = dr_effect->TechniqueByName(CT_HASH("LIDRTubeAreaNoShadow"));
 		}
 #endif
 
@@ -735,8 +736,8 @@ namespace KlayGE
 		auto effect_x = SyncLoadRenderEffect("SSVO.fxml");
 		auto effect_y = effect_x->Clone();
 		ssvo_blur_pp_ = MakeSharedPtr<BlurPostProcess<SeparableBilateralFilterPostProcess>>(3, 1.0f,
-			effect_x, effect_x->TechniqueByName("SSVOBlurX"),
-			effect_y, effect_y->TechniqueByName("SSVOBlurY"));
+			effect_x, effect_x->TechniqueByName(CT_HASH("SSVOBlurX")),
+			effect_y, effect_y->TechniqueByName(CT_HASH("SSVOBlurY")));
 		ssvo_upsample_pp_ = SyncLoadPostProcess("SSVO.ppml", "SSVOUpsample");
 		for (int i = 0; i < 2; ++ i)
 		{
@@ -795,108 +796,108 @@ namespace KlayGE
 		}
 		depth_mipmap_pp_ = SyncLoadPostProcess("Depth.ppml", "DepthMipmapBilinear");
 
-		g_buffer_rt0_tex_param_ = dr_effect->ParameterByName("g_buffer_rt0_tex");
-		g_buffer_rt1_tex_param_ = dr_effect->ParameterByName("g_buffer_rt1_tex");
-		g_buffer_rt2_tex_param_ = dr_effect->ParameterByName("g_buffer_rt2_tex");
-		depth_tex_param_ = dr_effect->ParameterByName("depth_tex");
-		depth_tex_ms_param_ = dr_effect->ParameterByName("depth_tex_ms");
+		g_buffer_rt0_tex_param_ = dr_effect->ParameterByName(CT_HASH("g_buffer_rt0_tex"));
+		g_buffer_rt1_tex_param_ = dr_effect->ParameterByName(CT_HASH("g_buffer_rt1_tex"));
+		g_buffer_rt2_tex_param_ = dr_effect->ParameterByName(CT_HASH("g_buffer_rt2_tex"));
+		depth_tex_param_ = dr_effect->ParameterByName(CT_HASH("depth_tex"));
+		depth_tex_ms_param_ = dr_effect->ParameterByName(CT_HASH("depth_tex_ms"));
 #if DEFAULT_DEFERRED == TRIDITIONAL_DEFERRED
-		lighting_tex_param_ = dr_effect->ParameterByName("lighting_tex");
+		lighting_tex_param_ = dr_effect->ParameterByName(CT_HASH("lighting_tex"));
 #endif
-		shading_tex_param_ = dr_effect->ParameterByName("shading_tex");
-		shading_tex_ms_param_ = dr_effect->ParameterByName("shading_tex_ms");
-		light_attrib_param_ = dr_effect->ParameterByName("light_attrib");
-		light_radius_extend_param_ = dr_effect->ParameterByName("light_radius_extend");
-		light_color_param_ = dr_effect->ParameterByName("light_color");
-		light_falloff_range_param_ = dr_effect->ParameterByName("light_falloff_range");
-		light_view_proj_param_ = dr_effect->ParameterByName("light_view_proj");
-		light_volume_mv_param_ = dr_effect->ParameterByName("light_volume_mv");
-		light_volume_mvp_param_ = dr_effect->ParameterByName("light_volume_mvp");
-		view_to_light_model_param_ = dr_effect->ParameterByName("view_to_light_model");
-		light_pos_es_param_ = dr_effect->ParameterByName("light_pos_es");
-		light_dir_es_param_ = dr_effect->ParameterByName("light_dir_es");
-		projective_map_2d_tex_param_ = dr_effect->ParameterByName("projective_map_2d_tex");
-		projective_map_cube_tex_param_ = dr_effect->ParameterByName("projective_map_cube_tex");
-		filtered_shadow_map_2d_tex_param_ = dr_effect->ParameterByName("filtered_shadow_map_2d_tex");
-		filtered_shadow_map_2d_tex_array_param_ = dr_effect->ParameterByName("filtered_shadow_map_2d_tex_array");
-		filtered_shadow_map_2d_light_index_param_ = dr_effect->ParameterByName("filtered_shadow_map_2d_light_index");
-		filtered_shadow_map_cube_tex_param_ = dr_effect->ParameterByName("filtered_shadow_map_cube_tex");
-		inv_width_height_param_ = dr_effect->ParameterByName("inv_width_height");
-		shadowing_tex_param_ = dr_effect->ParameterByName("shadowing_tex");
-		projective_shadowing_tex_param_ = dr_effect->ParameterByName("projective_shadowing_tex");
-		shadowing_channel_param_ = dr_effect->ParameterByName("shadowing_channel");
-		esm_scale_factor_param_ = dr_effect->ParameterByName("esm_scale_factor");
-		near_q_param_ = dr_effect->ParameterByName("near_q");
-		cascade_intervals_param_ = dr_effect->ParameterByName("cascade_intervals");
-		cascade_scale_bias_param_ = dr_effect->ParameterByName("cascade_scale_bias");
-		num_cascades_param_ = dr_effect->ParameterByName("num_cascades");
-		view_z_to_light_view_param_ = dr_effect->ParameterByName("view_z_to_light_view");
+		shading_tex_param_ = dr_effect->ParameterByName(CT_HASH("shading_tex"));
+		shading_tex_ms_param_ = dr_effect->ParameterByName(CT_HASH("shading_tex_ms"));
+		light_attrib_param_ = dr_effect->ParameterByName(CT_HASH("light_attrib"));
+		light_radius_extend_param_ = dr_effect->ParameterByName(CT_HASH("light_radius_extend"));
+		light_color_param_ = dr_effect->ParameterByName(CT_HASH("light_color"));
+		light_falloff_range_param_ = dr_effect->ParameterByName(CT_HASH("light_falloff_range"));
+		light_view_proj_param_ = dr_effect->ParameterByName(CT_HASH("light_view_proj"));
+		light_volume_mv_param_ = dr_effect->ParameterByName(CT_HASH("light_volume_mv"));
+		light_volume_mvp_param_ = dr_effect->ParameterByName(CT_HASH("light_volume_mvp"));
+		view_to_light_model_param_ = dr_effect->ParameterByName(CT_HASH("view_to_light_model"));
+		light_pos_es_param_ = dr_effect->ParameterByName(CT_HASH("light_pos_es"));
+		light_dir_es_param_ = dr_effect->ParameterByName(CT_HASH("light_dir_es"));
+		projective_map_2d_tex_param_ = dr_effect->ParameterByName(CT_HASH("projective_map_2d_tex"));
+		projective_map_cube_tex_param_ = dr_effect->ParameterByName(CT_HASH("projective_map_cube_tex"));
+		filtered_shadow_map_2d_tex_param_ = dr_effect->ParameterByName(CT_HASH("filtered_shadow_map_2d_tex"));
+		filtered_shadow_map_2d_tex_array_param_ = dr_effect->ParameterByName(CT_HASH("filtered_shadow_map_2d_tex_array"));
+		filtered_shadow_map_2d_light_index_param_ = dr_effect->ParameterByName(CT_HASH("filtered_shadow_map_2d_light_index"));
+		filtered_shadow_map_cube_tex_param_ = dr_effect->ParameterByName(CT_HASH("filtered_shadow_map_cube_tex"));
+		inv_width_height_param_ = dr_effect->ParameterByName(CT_HASH("inv_width_height"));
+		shadowing_tex_param_ = dr_effect->ParameterByName(CT_HASH("shadowing_tex"));
+		projective_shadowing_tex_param_ = dr_effect->ParameterByName(CT_HASH("projective_shadowing_tex"));
+		shadowing_channel_param_ = dr_effect->ParameterByName(CT_HASH("shadowing_channel"));
+		esm_scale_factor_param_ = dr_effect->ParameterByName(CT_HASH("esm_scale_factor"));
+		near_q_param_ = dr_effect->ParameterByName(CT_HASH("near_q"));
+		cascade_intervals_param_ = dr_effect->ParameterByName(CT_HASH("cascade_intervals"));
+		cascade_scale_bias_param_ = dr_effect->ParameterByName(CT_HASH("cascade_scale_bias"));
+		num_cascades_param_ = dr_effect->ParameterByName(CT_HASH("num_cascades"));
+		view_z_to_light_view_param_ = dr_effect->ParameterByName(CT_HASH("view_z_to_light_view"));
 		if (tex_array_support_)
 		{
-			filtered_csm_texs_param_[0] = dr_effect->ParameterByName("filtered_csm_tex_array");
+			filtered_csm_texs_param_[0] = dr_effect->ParameterByName(CT_HASH("filtered_csm_tex_array"));
 		}
 		else
 		{
-			filtered_csm_texs_param_[0] = dr_effect->ParameterByName("filtered_csm_0_tex");
-			filtered_csm_texs_param_[1] = dr_effect->ParameterByName("filtered_csm_1_tex");
-			filtered_csm_texs_param_[2] = dr_effect->ParameterByName("filtered_csm_2_tex");
-			filtered_csm_texs_param_[3] = dr_effect->ParameterByName("filtered_csm_3_tex");
+			filtered_csm_texs_param_[0] = dr_effect->ParameterByName(CT_HASH("filtered_csm_0_tex"));
+			filtered_csm_texs_param_[1] = dr_effect->ParameterByName(CT_HASH("filtered_csm_1_tex"));
+			filtered_csm_texs_param_[2] = dr_effect->ParameterByName(CT_HASH("filtered_csm_2_tex"));
+			filtered_csm_texs_param_[3] = dr_effect->ParameterByName(CT_HASH("filtered_csm_3_tex"));
 		}
-		skylight_diff_spec_mip_param_ = dr_effect->ParameterByName("skylight_diff_spec_mip");
-		inv_view_param_ = dr_effect->ParameterByName("inv_view");
-		skylight_y_cube_tex_param_ = dr_effect->ParameterByName("skylight_y_cube_tex");
-		skylight_c_cube_tex_param_ = dr_effect->ParameterByName("skylight_c_cube_tex");
+		skylight_diff_spec_mip_param_ = dr_effect->ParameterByName(CT_HASH("skylight_diff_spec_mip"));
+		inv_view_param_ = dr_effect->ParameterByName(CT_HASH("inv_view"));
+		skylight_y_cube_tex_param_ = dr_effect->ParameterByName(CT_HASH("skylight_y_cube_tex"));
+		skylight_c_cube_tex_param_ = dr_effect->ParameterByName(CT_HASH("skylight_c_cube_tex"));
 #if DEFAULT_DEFERRED == LIGHT_INDEXED_DEFERRED
-		min_max_depth_tex_param_ = dr_effect->ParameterByName("min_max_depth_tex");
-		lights_color_param_ = dr_effect->ParameterByName("lights_color");
-		lights_pos_es_param_ = dr_effect->ParameterByName("lights_pos_es");
-		lights_dir_es_param_ = dr_effect->ParameterByName("lights_dir_es");
-		lights_falloff_range_param_ = dr_effect->ParameterByName("lights_falloff_range");
-		lights_attrib_param_ = dr_effect->ParameterByName("lights_attrib");
-		lights_radius_extend_param_ = dr_effect->ParameterByName("lights_radius_extend");
-		lights_aabb_min_param_ = dr_effect->ParameterByName("lights_aabb_min");
-		lights_aabb_max_param_ = dr_effect->ParameterByName("lights_aabb_max");
-		tile_scale_param_ = dr_effect->ParameterByName("tile_scale");
-		camera_proj_01_param_ = dr_effect->ParameterByName("camera_proj_01");
+		min_max_depth_tex_param_ = dr_effect->ParameterByName(CT_HASH("min_max_depth_tex"));
+		lights_color_param_ = dr_effect->ParameterByName(CT_HASH("lights_color"));
+		lights_pos_es_param_ = dr_effect->ParameterByName(CT_HASH("lights_pos_es"));
+		lights_dir_es_param_ = dr_effect->ParameterByName(CT_HASH("lights_dir_es"));
+		lights_falloff_range_param_ = dr_effect->ParameterByName(CT_HASH("lights_falloff_range"));
+		lights_attrib_param_ = dr_effect->ParameterByName(CT_HASH("lights_attrib"));
+		lights_radius_extend_param_ = dr_effect->ParameterByName(CT_HASH("lights_radius_extend"));
+		lights_aabb_min_param_ = dr_effect->ParameterByName(CT_HASH("lights_aabb_min"));
+		lights_aabb_max_param_ = dr_effect->ParameterByName(CT_HASH("lights_aabb_max"));
+		tile_scale_param_ = dr_effect->ParameterByName(CT_HASH("tile_scale"));
+		camera_proj_01_param_ = dr_effect->ParameterByName(CT_HASH("camera_proj_01"));
 
 		if (cs_cldr_)
 		{
-			g_buffer_rt0_tex_ms_param_ = dr_effect->ParameterByName("g_buffer_rt0_tex_ms");
-			g_buffer_rt1_tex_ms_param_ = dr_effect->ParameterByName("g_buffer_rt1_tex_ms");
-			g_buffer_rt2_tex_ms_param_ = dr_effect->ParameterByName("g_buffer_rt2_tex_ms");
-			g_buffer_ds_tex_ms_param_ = dr_effect->ParameterByName("g_buffer_ds_tex_ms");
-			g_buffer_depth_tex_ms_param_ = dr_effect->ParameterByName("g_buffer_depth_tex_ms");
-			g_buffer_stencil_tex_param_ = (dr_effect_->ParameterByName("g_buffer_stencil_tex"));
-			g_buffer_stencil_tex_ms_param_ = (dr_effect_->ParameterByName("g_buffer_stencil_tex_ms"));
-			src_2d_tex_array_param_ = dr_effect->ParameterByName("src_2d_tex_array");
-
-			near_q_far_param_ = dr_effect->ParameterByName("near_q_far");
-			width_height_param_ = dr_effect->ParameterByName("width_height");
-			depth_to_tiled_ds_in_tex_param_ = dr_effect->ParameterByName("ds_in_tex");
-			depth_to_tiled_linear_depth_in_tex_ms_param_ = dr_effect->ParameterByName("linear_depth_in_tex_ms");
-			depth_to_tiled_min_max_depth_rw_tex_param_ = dr_effect->ParameterByName("min_max_depth_rw_tex");
-			linear_depth_rw_tex_param_ = dr_effect->ParameterByName("linear_depth_rw_tex");
-			upper_left_param_ = dr_effect->ParameterByName("upper_left");
-			x_dir_param_ = dr_effect->ParameterByName("x_dir");
-			y_dir_param_ = dr_effect->ParameterByName("y_dir");
-			multi_sample_mask_tex_param_ = dr_effect->ParameterByName("multi_sample_mask_tex");
-			shading_in_tex_param_ = dr_effect->ParameterByName("shading_in_tex");
-			shading_in_tex_ms_param_ = dr_effect->ParameterByName("shading_in_tex_ms");
-			shading_rw_tex_param_ = dr_effect->ParameterByName("shading_rw_tex");
-			shading_rw_tex_array_param_ = dr_effect->ParameterByName("shading_rw_tex_array");
-			lights_type_param_ = dr_effect->ParameterByName("lights_type");
-			lights_start_in_tex_param_ = dr_effect->ParameterByName("lights_start_in_tex");
-			lights_start_rw_tex_param_ = dr_effect->ParameterByName("lights_start_rw_tex");
-			intersected_light_indices_in_tex_param_ = dr_effect->ParameterByName("intersected_light_indices_in_tex");
-			intersected_light_indices_rw_tex_param_ = dr_effect->ParameterByName("intersected_light_indices_rw_tex");
-			depth_slices_param_ = dr_effect->ParameterByName("depth_slices");
-			depth_slices_shading_param_ = dr_effect->ParameterByName("depth_slices_shading");
-
-			projective_shadowing_rw_tex_param_ = dr_effect->ParameterByName("projective_shadowing_rw_tex");
-			shadowing_rw_tex_param_ = dr_effect->ParameterByName("shadowing_rw_tex");
-			lights_view_proj_param_ = dr_effect->ParameterByName("lights_view_proj");
-			filtered_shadow_maps_2d_light_index_param_ = dr_effect->ParameterByName("filtered_shadow_maps_2d_light_index");
-			esms_scale_factor_param_ = dr_effect->ParameterByName("esms_scale_factor");
+			g_buffer_rt0_tex_ms_param_ = dr_effect->ParameterByName(CT_HASH("g_buffer_rt0_tex_ms"));
+			g_buffer_rt1_tex_ms_param_ = dr_effect->ParameterByName(CT_HASH("g_buffer_rt1_tex_ms"));
+			g_buffer_rt2_tex_ms_param_ = dr_effect->ParameterByName(CT_HASH("g_buffer_rt2_tex_ms"));
+			g_buffer_ds_tex_ms_param_ = dr_effect->ParameterByName(CT_HASH("g_buffer_ds_tex_ms"));
+			g_buffer_depth_tex_ms_param_ = dr_effect->ParameterByName(CT_HASH("g_buffer_depth_tex_ms"));
+			g_buffer_stencil_tex_param_ = (dr_effect_->ParameterByName(CT_HASH("g_buffer_stencil_tex")));
+			g_buffer_stencil_tex_ms_param_ = (dr_effect_->ParameterByName(CT_HASH("g_buffer_stencil_tex_ms")));
+			src_2d_tex_array_param_ = dr_effect->ParameterByName(CT_HASH("src_2d_tex_array"));
+
+			near_q_far_param_ = dr_effect->ParameterByName(CT_HASH("near_q_far"));
+			width_height_param_ = dr_effect->ParameterByName(CT_HASH("width_height"));
+			depth_to_tiled_ds_in_tex_param_ = dr_effect->ParameterByName(CT_HASH("ds_in_tex"));
+			depth_to_tiled_linear_depth_in_tex_ms_param_ = dr_effect->ParameterByName(CT_HASH("linear_depth_in_tex_ms"));
+			depth_to_tiled_min_max_depth_rw_tex_param_ = dr_effect->ParameterByName(CT_HASH("min_max_depth_rw_tex"));
+			linear_depth_rw_tex_param_ = dr_effect->ParameterByName(CT_HASH("linear_depth_rw_tex"));
+			upper_left_param_ = dr_effect->ParameterByName(CT_HASH("upper_left"));
+			x_dir_param_ = dr_effect->ParameterByName(CT_HASH("x_dir"));
+			y_dir_param_ = dr_effect->ParameterByName(CT_HASH("y_dir"));
+			multi_sample_mask_tex_param_ = dr_effect->ParameterByName(CT_HASH("multi_sample_mask_tex"));
+			shading_in_tex_param_ = dr_effect->ParameterByName(CT_HASH("shading_in_tex"));
+			shading_in_tex_ms_param_ = dr_effect->ParameterByName(CT_HASH("shading_in_tex_ms"));
+			shading_rw_tex_param_ = dr_effect->ParameterByName(CT_HASH("shading_rw_tex"));
+			shading_rw_tex_array_param_ = dr_effect->ParameterByName(CT_HASH("shading_rw_tex_array"));
+			lights_type_param_ = dr_effect->ParameterByName(CT_HASH("lights_type"));
+			lights_start_in_tex_param_ = dr_effect->ParameterByName(CT_HASH("lights_start_in_tex"));
+			lights_start_rw_tex_param_ = dr_effect->ParameterByName(CT_HASH("lights_start_rw_tex"));
+			intersected_light_indices_in_tex_param_ = dr_effect->ParameterByName(CT_HASH("intersected_light_indices_in_tex"));
+			intersected_light_indices_rw_tex_param_ = dr_effect->ParameterByName(CT_HASH("intersected_light_indices_rw_tex"));
+			depth_slices_param_ = dr_effect->ParameterByName(CT_HASH("depth_slices"));
+			depth_slices_shading_param_ = dr_effect->ParameterByName(CT_HASH("depth_slices_shading"));
+
+			projective_shadowing_rw_tex_param_ = dr_effect->ParameterByName(CT_HASH("projective_shadowing_rw_tex"));
+			shadowing_rw_tex_param_ = dr_effect->ParameterByName(CT_HASH("shadowing_rw_tex"));
+			lights_view_proj_param_ = dr_effect->ParameterByName(CT_HASH("lights_view_proj"));
+			filtered_shadow_maps_2d_light_index_param_ = dr_effect->ParameterByName(CT_HASH("filtered_shadow_maps_2d_light_index"));
+			esms_scale_factor_param_ = dr_effect->ParameterByName(CT_HASH("esms_scale_factor"));
 
 			for (int i = 0; i < 2; ++ i)
 			{
@@ -905,7 +906,7 @@ namespace KlayGE
 		}
 		else
 		{
-			light_index_tex_param_ = dr_effect->ParameterByName("light_index_tex");
+			light_index_tex_param_ = dr_effect->ParameterByName(CT_HASH("light_index_tex"));
 		}
 
 		depth_to_min_max_pp_ = SyncLoadPostProcess("Depth.ppml", "DepthToMinMax");
@@ -38,6 +38,258 @@
 #include <KFL/Math.hpp>
 #include <KFL/Half.hpp>
 
+#include <array>
+#include <cstring>
+
+#if defined(KLAYGE_SSE2_SUPPORT)
+	#include <emmintrin.h>
+#endif
+
+namespace
+{
+	using namespace KlayGE;
+
+	static_assert(sizeof(Color) == sizeof(float) * 4);
+
+	std::array<float, 256> const & SRGBToLinearTable()
+	{
+		static std::array<float, 256> const table = []
+			{
+				std::array<float, 256> ret;
+				for (uint32_t i = 0; i < ret.size(); ++ i)
+				{
+					ret[i] = MathLib::srgb_to_linear(i / 255.0f);
+				}
+				return ret;
+			}();
+		return table;
+	}
+
+	// Every texel is 4 bytes in memory order of (r, g, b, a) if !swap_rb, or (b, g, r, a) if swap_rb
+	uint32_t Unorm8x4ToABGR32F(uint8_t const * input, uint32_t num_elems, Color* output, bool swap_rb)
+	{
+		uint32_t i = 0;
+#if defined(KLAYGE_SSE2_SUPPORT)
+		__m128i const zero = _mm_setzero_si128();
+		__m128 const scale = _mm_set1_ps(255.0f);
+		float* dst = &output->r();
+		for (; i + 4 <= num_elems; i += 4, input += 16, dst += 16)
+		{
+			__m128i const v = _mm_loadu_si128(reinterpret_cast<__m128i const *>(input));
+			__m128i const lo = _mm_unpacklo_epi8(v, zero);
+			__m128i const hi = _mm_unpackhi_epi8(v, zero);
+			__m128 clr[] =
+			{
+				_mm_div_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), scale),
+				_mm_div_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), scale),
+				_mm_div_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), scale),
+				_mm_div_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), scale)
+			};
+			for (int j = 0; j < 4; ++ j)
+			{
+				if (swap_rb)
+				{
+					clr[j] = _mm_shuffle_ps(clr[j], clr[j], _MM_SHUFFLE(3, 0, 1, 2));
+				}
+				_mm_storeu_ps(dst + j * 4, clr[j]);
+			}
+		}
+#else
+		KFL_UNUSED(input);
+		KFL_UNUSED(num_elems);
+		KFL_UNUSED(output);
+		KFL_UNUSED(swap_rb);
+#endif
+		return i;
+	}
+
+	uint32_t ABGR32FToUnorm8x4(Color const * input, uint32_t num_elems, uint8_t* output, bool swap_rb)
+	{
+		uint32_t i = 0;
+#if defined(KLAYGE_SSE2_SUPPORT)
+		__m128 const scale = _mm_set1_ps(255.0f);
+		__m128 const half = _mm_set1_ps(0.5f);
+		__m128 const zero = _mm_setzero_ps();
+		float const * src = &input->r();
+		for (; i + 4 <= num_elems; i += 4, src += 16, output += 16)
+		{
+			__m128i texels[4];
+			for (int j = 0; j < 4; ++ j)
+			{
+				__m128 clr = _mm_loadu_ps(src + j * 4);
+				if (swap_rb)
+				{
+					clr = _mm_shuffle_ps(clr, clr, _MM_SHUFFLE(3, 0, 1, 2));
+				}
+
+				// Clamping before the truncation matches the scalar clamp(int(x * 255 + 0.5), 0, 255)
+				clr = _mm_min_ps(_mm_max_ps(_mm_add_ps(_mm_mul_ps(clr, scale), half), zero), scale);
+				texels[j] = _mm_cvttps_epi32(clr);
+			}
+			__m128i const v = _mm_packus_epi16(_mm_packs_epi32(texels[0], texels[1]), _mm_packs_epi32(texels[2], texels[3]));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(output), v);
+		}
+#else
+		KFL_UNUSED(input);
+		KFL_UNUSED(num_elems);
+		KFL_UNUSED(output);
+		KFL_UNUSED(swap_rb);
+#endif
+		return i;
+	}
+
+	uint32_t A2BGR10ToABGR32F(uint8_t const * input, uint32_t num_elems, Color* output)
+	{
+		uint32_t i = 0;
+#if defined(KLAYGE_SSE2_SUPPORT)
+		__m128i const mask = _mm_set1_epi32(0x03FF);
+		__m128 const scale = _mm_set1_ps(1023.0f);
+		__m128 const scale_a = _mm_set1_ps(3.0f);
+		float* dst = &output->r();
+		for (; i + 4 <= num_elems; i += 4, input += 16, dst += 16)
+		{
+			__m128i const v = _mm_loadu_si128(reinterpret_cast<__m128i const *>(input));
+			__m128 r = _mm_div_ps(_mm_cvtepi32_ps(_mm_and_si128(v, mask)), scale);
+			__m128 g = _mm_div_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(v, 10), mask)), scale);
+			__m128 b = _mm_div_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(v, 20), mask)), scale);
+			__m128 a = _mm_div_ps(_mm_cvtepi32_ps(_mm_srli_epi32(v, 30)), scale_a);
+			_MM_TRANSPOSE4_PS(r, g, b, a);
+			_mm_storeu_ps(dst + 0, r);
+			_mm_storeu_ps(dst + 4, g);
+			_mm_storeu_ps(dst + 8, b);
+			_mm_storeu_ps(dst + 12, a);
+		}
+#else
+		KFL_UNUSED(input);
+		KFL_UNUSED(num_elems);
+		KFL_UNUSED(output);
+#endif
+		return i;
+	}
+
+	uint32_t ABGR32FToA2BGR10(Color const * input, uint32_t num_elems, uint8_t* output)
+	{
+		uint32_t i = 0;
+#if defined(KLAYGE_SSE2_SUPPORT)
+		__m128 const scale = _mm_set1_ps(1023.0f);
+		__m128 const scale_a = _mm_set1_ps(3.0f);
+		__m128 const half = _mm_set1_ps(0.5f);
+		__m128 const zero = _mm_setzero_ps();
+		float const * src = &input->r();
+		for (; i + 4 <= num_elems; i += 4, src += 16, output += 16)
+		{
+			__m128 r = _mm_loadu_ps(src + 0);
+			__m128 g = _mm_loadu_ps(src + 4);
+			__m128 b = _mm_loadu_ps(src + 8);
+			__m128 a = _mm_loadu_ps(src + 12);
+			_MM_TRANSPOSE4_PS(r, g, b, a);
+			r = _mm_min_ps(_mm_max_ps(_mm_add_ps(_mm_mul_ps(r, scale), half), zero), scale);
+			g = _mm_min_ps(_mm_max_ps(_mm_add_ps(_mm_mul_ps(g, scale), half), zero), scale);
+			b = _mm_min_ps(_mm_max_ps(_mm_add_ps(_mm_mul_ps(b, scale), half), zero), scale);
+			a = _mm_min_ps(_mm_max_ps(_mm_add_ps(_mm_mul_ps(a, scale_a), half), zero), scale_a);
+			__m128i v = _mm_cvttps_epi32(r);
+			v = _mm_or_si128(v, _mm_slli_epi32(_mm_cvttps_epi32(g), 10));
+			v = _mm_or_si128(v, _mm_slli_epi32(_mm_cvttps_epi32(b), 20));
+			v = _mm_or_si128(v, _mm_slli_epi32(_mm_cvttps_epi32(a), 30));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(output), v);
+		}
+#else
+		KFL_UNUSED(input);
+		KFL_UNUSED(num_elems);
+		KFL_UNUSED(output);
+#endif
+		return i;
+	}
+
+#if defined(KLAYGE_SSE2_SUPPORT)
+	// Converts 4 halfs in the low 16 bits of each lane to floats. The same as half::operator float().
+	__m128 HalfToFloat4(__m128i h)
+	{
+		__m128i const exp_mask = _mm_set1_epi32(0x7C00 << 13);
+		__m128 const denorm_magic = _mm_castsi128_ps(_mm_set1_epi32(113 << 23));
+
+		__m128i o = _mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(0x7FFF)), 13);
+		__m128i const exp = _mm_and_si128(o, exp_mask);
+		o = _mm_add_epi32(o, _mm_set1_epi32((127 - 15) << 23));
+
+		// Inf and NaN
+		__m128i const inf_nan = _mm_cmpeq_epi32(exp, exp_mask);
+		o = _mm_add_epi32(o, _mm_and_si128(inf_nan, _mm_set1_epi32((128 - 16) << 23)));
+
+		// Zero and denormal, renormalized by a float subtraction
+		__m128i const zero_denorm = _mm_cmpeq_epi32(exp, _mm_setzero_si128());
+		__m128i const renorm = _mm_castps_si128(_mm_sub_ps(
+			_mm_castsi128_ps(_mm_add_epi32(o, _mm_set1_epi32(1 << 23))), denorm_magic));
+		o = _mm_or_si128(_mm_and_si128(zero_denorm, renorm), _mm_andnot_si128(zero_denorm, o));
+
+		o = _mm_or_si128(o, _mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(0x8000)), 16));
+		return _mm_castsi128_ps(o);
+	}
+#endif
+
+	// Converts R16F, GR16F, or ABGR16F
+	uint32_t HalfToABGR32F(uint8_t const * input, uint32_t num_elems, uint32_t num_channels, Color* output)
+	{
+		uint32_t i = 0;
+#if defined(KLAYGE_SSE2_SUPPORT)
+		__m128i const zero = _mm_setzero_si128();
+		float* dst = &output->r();
+		switch (num_channels)
+		{
+		case 1:
+			for (; i + 4 <= num_elems; i += 4, input += 8, dst += 16)
+			{
+				__m128i const v = _mm_loadl_epi64(reinterpret_cast<__m128i const *>(input));
+				__m128 r = HalfToFloat4(_mm_unpacklo_epi16(v, zero));
+				__m128 g = _mm_setzero_ps();
+				__m128 b = _mm_setzero_ps();
+				__m128 a = _mm_set1_ps(1);
+				_MM_TRANSPOSE4_PS(r, g, b, a);
+				_mm_storeu_ps(dst + 0, r);
+				_mm_storeu_ps(dst + 4, g);
+				_mm_storeu_ps(dst + 8, b);
+				_mm_storeu_ps(dst + 12, a);
+			}
+			break;
+
+		case 2:
+			{
+				__m128 const zero_one = _mm_set_ps(1, 0, 1, 0);
+				for (; i + 4 <= num_elems; i += 4, input += 16, dst += 16)
+				{
+					__m128i const v = _mm_loadu_si128(reinterpret_cast<__m128i const *>(input));
+					__m128 const rg01 = HalfToFloat4(_mm_unpacklo_epi16(v, zero));
+					__m128 const rg23 = HalfToFloat4(_mm_unpackhi_epi16(v, zero));
+					_mm_storeu_ps(dst + 0, _mm_movelh_ps(rg01, zero_one));
+					_mm_storeu_ps(dst + 4, _mm_movehl_ps(zero_one, rg01));
+					_mm_storeu_ps(dst + 8, _mm_movelh_ps(rg23, zero_one));
+					_mm_storeu_ps(dst + 12, _mm_movehl_ps(zero_one, rg23));
+				}
+			}
+			break;
+
+		case 4:
+			for (; i + 2 <= num_elems; i += 2, input += 16, dst += 8)
+			{
+				__m128i const v = _mm_loadu_si128(reinterpret_cast<__m128i const *>(input));
+				_mm_storeu_ps(dst + 0, HalfToFloat4(_mm_unpacklo_epi16(v, zero)));
+				_mm_storeu_ps(dst + 4, HalfToFloat4(_mm_unpackhi_epi16(v, zero)));
+			}
+			break;
+
+		default:
+			KFL_UNREACHABLE("Invalid channel count");
+		}
+#else
+		KFL_UNUSED(input);
+		KFL_UNUSED(num_elems);
+		KFL_UNUSED(num_channels);
+		KFL_UNUSED(output);
+#endif
+		return i;
+	}
+}
+
 namespace KlayGE
 {
 	void ConvertToABGR32F(ElementFormat fmt, void const * input, uint32_t num_elems, Color* output)
@@ -45,6 +297,38 @@ namespace KlayGE
 		uint8_t const * p = static_cast<uint8_t const *>(input);
 		uint32_t const elem_size = NumFormatBytes(fmt);
 
+		// Fast paths convert a multiple of a few elements, the generic loops below take the rest
+		uint32_t num_converted = 0;
+		switch (fmt)
+		{
+		case EF_ARGB8:
+		case EF_ABGR8:
+			num_converted = Unorm8x4ToABGR32F(p, num_elems, output, EF_ARGB8 == fmt);
+			break;
+
+		case EF_A2BGR10:
+			num_converted = A2BGR10ToABGR32F(p, num_elems, output);
+			break;
+
+		case EF_R16F:
+			num_converted = HalfToABGR32F(p, num_elems, 1, output);
+			break;
+
+		case EF_GR16F:
+			num_converted = HalfToABGR32F(p, num_elems, 2, output);
+			break;
+
+		case EF_ABGR16F:
+			num_converted = HalfToABGR32F(p, num_elems, 4, output);
+			break;
+
+		default:
+			break;
+		}
+		p += num_converted * elem_size;
+		output += num_converted;
+		num_elems -= num_converted;
+
 		switch (fmt)
 		{
 		case EF_A8:
@@ -723,22 +1007,22 @@ namespace KlayGE
 
 
 		case EF_ARGB8_SRGB:
-			for (uint32_t i = 0; i < num_elems; ++ i, p += elem_size, ++ output)
 			{
-				*output = Color(MathLib::srgb_to_linear(p[2] / 255.0f),
-					MathLib::srgb_to_linear(p[1] / 255.0f),
-					MathLib::srgb_to_linear(p[0] / 255.0f),
-					MathLib::srgb_to_linear(p[3] / 255.0f));
+				auto const & srgb_to_linear = SRGBToLinearTable();
+				for (uint32_t i = 0; i < num_elems; ++ i, p += elem_size, ++ output)
+				{
+					*output = Color(srgb_to_linear[p[2]], srgb_to_linear[p[1]], srgb_to_linear[p[0]], srgb_to_linear[p[3]]);
+				}
 			}
 			break;
 
 		case EF_ABGR8_SRGB:
-			for (uint32_t i = 0; i < num_elems; ++ i, p += elem_size, ++ output)
 			{
-				*output = Color(MathLib::srgb_to_linear(p[0] / 255.0f),
-					MathLib::srgb_to_linear(p[1] / 255.0f),
-					MathLib::srgb_to_linear(p[2] / 255.0f),
-					MathLib::srgb_to_linear(p[3] / 255.0f));
+				auto const & srgb_to_linear = SRGBToLinearTable();
+				for (uint32_t i = 0; i < num_elems; ++ i, p += elem_size, ++ output)
+				{
+					*output = Color(srgb_to_linear[p[0]], srgb_to_linear[p[1]], srgb_to_linear[p[2]], srgb_to_linear[p[3]]);
+				}
 			}
 			break;
 
@@ -752,6 +1036,25 @@ namespace KlayGE
 		uint8_t* p = static_cast<uint8_t*>(output);
 		uint32_t const elem_size = NumFormatBytes(fmt);
 
+		uint32_t num_converted = 0;
+		switch (fmt)
+		{
+		case EF_ARGB8:
+		case EF_ABGR8:
+			num_converted = ABGR32FToUnorm8x4(input, num_elems, p, EF_ARGB8 == fmt);
+			break;
+
+		case EF_A2BGR10:
+			num_converted = ABGR32FToA2BGR10(input, num_elems, p);
+			break;
+
+		default:
+			break;
+		}
+		input += num_converted;
+		p += num_converted * elem_size;
+		num_elems -= num_converted;
+
 		switch (fmt)
 		{
 		case EF_A8:
@@ -1553,4 +1856,88 @@ namespace KlayGE
 			KFL_UNREACHABLE("Not supported element format");
 		}
 	}
+
+	void ConvertFormat(ElementFormat dst_fmt, void* output, ElementFormat src_fmt, void const * input, uint32_t num_elems)
+	{
+		BOOST_ASSERT(!IsCompressedFormat(dst_fmt) && !IsCompressedFormat(src_fmt));
+
+		uint8_t const * src = static_cast<uint8_t const *>(input);
+		uint8_t* dst = static_cast<uint8_t*>(output);
+
+		if (dst_fmt == src_fmt)
+		{
+			std::memcpy(dst, src, num_elems * NumFormatBytes(src_fmt));
+			return;
+		}
+
+		// Direct paths give the same results as going through ABGR32F
+		if (((EF_ARGB8 == src_fmt) && (EF_ABGR8 == dst_fmt)) || ((EF_ABGR8 == src_fmt) && (EF_ARGB8 == dst_fmt))
+			|| ((EF_ARGB8_SRGB == src_fmt) && (EF_ABGR8_SRGB == dst_fmt)) || ((EF_ABGR8_SRGB == src_fmt) && (EF_ARGB8_SRGB == dst_fmt)))
+		{
+			uint32_t i = 0;
+#if defined(KLAYGE_SSE2_SUPPORT)
+			__m128i const ga_mask = _mm_set1_epi32(0xFF00FF00);
+			__m128i const c_mask = _mm_set1_epi32(0x000000FF);
+			for (; i + 4 <= num_elems; i += 4)
+			{
+				__m128i const v = _mm_loadu_si128(reinterpret_cast<__m128i const *>(src + i * 4));
+				__m128i const swapped = _mm_or_si128(_mm_and_si128(v, ga_mask),
+					_mm_or_si128(_mm_slli_epi32(_mm_and_si128(v, c_mask), 16), _mm_and_si128(_mm_srli_epi32(v, 16), c_mask)));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), swapped);
+			}
+#endif
+			for (; i < num_elems; ++ i)
+			{
+				uint8_t const * s = src + i * 4;
+				uint8_t* d = dst + i * 4;
+				uint8_t const tmp = s[0];
+				d[0] = s[2];
+				d[1] = s[1];
+				d[2] = tmp;
+				d[3] = s[3];
+			}
+		}
+		else if (((EF_R8 == src_fmt) || (EF_GR8 == src_fmt)) && (EF_ARGB8 == dst_fmt))
+		{
+			bool const has_g = (EF_GR8 == src_fmt);
+			uint32_t const src_elem_size = has_g ? 2 : 1;
+			for (uint32_t i = 0; i < num_elems; ++ i, src += src_elem_size, dst += 4)
+			{
+				dst[0] = 0;
+				dst[1] = has_g ? src[1] : 0;
+				dst[2] = src[0];
+				dst[3] = 0xFF;
+			}
+		}
+		else if (((EF_ARGB8_SRGB == src_fmt) && (EF_ARGB8 == dst_fmt)) || ((EF_ABGR8_SRGB == src_fmt) && (EF_ABGR8 == dst_fmt)))
+		{
+			static std::array<uint8_t, 256> const table = []
+				{
+					auto const & srgb_to_linear = SRGBToLinearTable();
+					std::array<uint8_t, 256> ret;
+					for (uint32_t i = 0; i < ret.size(); ++ i)
+					{
+						ret[i] = static_cast<uint8_t>(MathLib::clamp(static_cast<int>(srgb_to_linear[i] * 255.0f + 0.5f), 0, 255));
+					}
+					return ret;
+				}();
+			for (uint32_t i = 0; i < num_elems * 4; ++ i)
+			{
+				dst[i] = table[src[i]];
+			}
+		}
+		else
+		{
+			uint32_t const src_elem_size = NumFormatBytes(src_fmt);
+			uint32_t const dst_elem_size = NumFormatBytes(dst_fmt);
+
+			std::array<Color, 256> buff;
+			for (uint32_t i = 0; i < num_elems; i += static_cast<uint32_t>(buff.size()))
+			{
+				uint32_t const n = std::min(num_elems - i, static_cast<uint32_t>(buff.size()));
+				ConvertToABGR32F(src_fmt, src + i * src_elem_size, n, buff.data());
+				ConvertFromABGR32F(dst_fmt, buff.data(), n, dst + i * dst_elem_size);
+			}
+		}
+	}
 }
@@ -52,6 +52,7 @@
 #include <KlayGE/Window.hpp>
 
 #include <algorithm>
+#include <array>
 #include <vector>
 #include <cstring>
 #include <fstream>
@@ -94,28 +95,24 @@ namespace KlayGE
 
 			RenderEngine const & renderEngine = rf.RenderEngineInstance();
 			RenderDeviceCaps const & caps = renderEngine.DeviceCaps();
-			uint32_t size = std::min<uint32_t>(2048U, std::min<uint32_t>(caps.max_texture_width, caps.max_texture_height)) / kfont_char_size * kfont_char_size;
-			dist_texture_ = rf.MakeTexture2D(size, size, 1, 1, EF_R8, 1, 0, EAH_GPU_Read);
-			a_char_data_.resize(kfont_char_size * kfont_char_size);
-
-			char_free_list_.emplace_back(0, size * size / kfont_char_size / kfont_char_size);
+			page_size_ = std::min<uint32_t>(2048U, std::min<uint32_t>(caps.max_texture_width, caps.max_texture_height)) / kfont_char_size * kfont_char_size;
+			chars_per_row_ = page_size_ / kfont_char_size;
+			this->AddPage();
 
 			effect_ = SyncLoadRenderEffect("Font.fxml");
-			*(effect_->ParameterByName("distance_tex")) = dist_texture_;
+			distance_tex_ep_ = effect_->ParameterByName("distance_tex");
 			*(effect_->ParameterByName("distance_base_scale")) = float2(kfont_loader_->DistBase() / 32768.0f * 32 + 1, (kfont_loader_->DistScale() / 32768.0f + 1.0f) * 32);
 
 			half_width_height_ep_ = effect_->ParameterByName("half_width_height");
 			dpi_scale_ep_ = effect_->ParameterByName("dpi_scale");
 			mvp_ep_ = effect_->ParameterByName("mvp");
 
-			uint32_t const INDEX_PER_CHAR = restart_ ? 5 : 6;
 			uint32_t const INIT_NUM_CHAR = 1024;
 			tb_vb_ = MakeUniquePtr<TransientBuffer>(static_cast<uint32_t>(INIT_NUM_CHAR * 4 * sizeof(FontVert)), TransientBuffer::BF_Vertex);
-			tb_ib_ = MakeUniquePtr<TransientBuffer>(static_cast<uint32_t>(INIT_NUM_CHAR * INDEX_PER_CHAR * sizeof(uint16_t)), TransientBuffer::BF_Index);
+			this->EnsureQuadIndices(INIT_NUM_CHAR);
 
 			rls_[0]->BindVertexStream(tb_vb_->GetBuffer(), MakeSpan({VertexElement(VEU_Position, 0, EF_BGR32F),
 				VertexElement(VEU_Diffuse, 0, EF_ABGR8), VertexElement(VEU_TextureCoord, 0, EF_GR32F)}));
-			rls_[0]->BindIndexStream(tb_ib_->GetBuffer(), EF_R16UI);
 
 			pos_aabb_ = AABBox(float3(0, 0, 0), float3(0, 0, 0));
 			tc_aabb_ = AABBox(float3(0, 0, 0), float3(0, 0, 0));
@@ -146,57 +143,76 @@ namespace KlayGE
 			}
 
 			tb_vb_->EnsureDataReady();
-			tb_ib_->EnsureDataReady();
 
 			rls_[0]->SetVertexStream(0, tb_vb_->GetBuffer());
-			rls_[0]->BindIndexStream(tb_ib_->GetBuffer(), EF_R16UI);
 		}
 
 		void OnRenderEnd() override
 		{
 			pos_aabb_ = AABBox(float3(0, 0, 0), float3(0, 0, 0));
 
-			tb_vb_sub_allocs_.clear();
-			tb_ib_sub_allocs_.clear();
+			for (auto& vertices : page_vertices_)
+			{
+				vertices.clear();
+			}
 
 			tb_vb_->OnPresent();
-			tb_ib_->OnPresent();
+
+			// Drops the cached layouts and extents that were not used in this frame
+			if (layout_cache_.size() > MAX_NUM_CACHED_TEXTS)
+			{
+				for (auto iter = layout_cache_.begin(); iter != layout_cache_.end();)
+				{
+					iter = (iter->second.last_frame != frame_) ? layout_cache_.erase(iter) : std::next(iter);
+				}
+			}
+			if (extent_cache_.size() > MAX_NUM_CACHED_TEXTS)
+			{
+				for (auto iter = extent_cache_.begin(); iter != extent_cache_.end();)
+				{
+					iter = (iter->second.last_frame != frame_) ? extent_cache_.erase(iter) : std::next(iter);
+				}
+			}
+			++ frame_;
 		}
 
 		void Render() override
 		{
 			RenderEngine& re = Context::Instance().RenderFactoryInstance().RenderEngineInstance();
 
-			this->OnRenderBegin();
+			// One sub alloc and one draw call for each atlas page
+			tb_vb_sub_allocs_.resize(page_vertices_.size());
+			for (size_t i = 0; i < page_vertices_.size(); ++ i)
+			{
+				auto const & vertices = page_vertices_[i];
+				if (!vertices.empty())
+				{
+					BOOST_ASSERT(vertices.size() <= 0xFFFF);
 
-			BOOST_ASSERT(tb_vb_sub_allocs_.size() == tb_ib_sub_allocs_.size());
+					tb_vb_sub_allocs_[i] = tb_vb_->Alloc(static_cast<uint32_t>(vertices.size() * sizeof(vertices[0])), vertices.data());
+					this->EnsureQuadIndices(static_cast<uint32_t>(vertices.size() / 4));
+				}
+			}
 
-			for (size_t i = 0; i < tb_vb_sub_allocs_.size(); ++ i)
-			{
-				uint32_t vert_length = tb_vb_sub_allocs_[i].length_;
-				uint32_t const ind_offset = tb_ib_sub_allocs_[i].offset_;
-				uint32_t ind_length = tb_ib_sub_allocs_[i].length_;
+			this->OnRenderBegin();
 
-				while ((i + 1 < tb_vb_sub_allocs_.size())
-					&& (tb_vb_sub_allocs_[i].offset_ + tb_vb_sub_allocs_[i].length_ == tb_vb_sub_allocs_[i + 1].offset_)
-					&& (tb_ib_sub_allocs_[i].offset_ + tb_ib_sub_allocs_[i].length_ == tb_ib_sub_allocs_[i + 1].offset_))
+			uint32_t const index_per_char = restart_ ? 5 : 6;
+			for (size_t i = 0; i < page_vertices_.size(); ++ i)
+			{
+				uint32_t const num_vertices = static_cast<uint32_t>(page_vertices_[i].size());
+				if (num_vertices > 0)
 				{
-					vert_length += tb_vb_sub_allocs_[i + 1].length_;
-					ind_length += tb_ib_sub_allocs_[i + 1].length_;
-					++ i;
-				}
+					*distance_tex_ep_ = dist_textures_[i];
 
-				rls_[0]->NumVertices(vert_length / sizeof(FontVert));
-				rls_[0]->StartIndexLocation(ind_offset / sizeof(uint16_t));
-				rls_[0]->NumIndices(ind_length / sizeof(uint16_t));
+					rls_[0]->StartVertexLocation(tb_vb_sub_allocs_[i].offset_ / sizeof(FontVert));
+					rls_[0]->NumVertices(num_vertices);
+					rls_[0]->StartIndexLocation(0);
+					rls_[0]->NumIndices(num_vertices / 4 * index_per_char);
 
-				re.Render(*this->GetRenderEffect(), *this->GetRenderTechnique(), *rls_[0]);
-			}
+					re.Render(*this->GetRenderEffect(), *this->GetRenderTechnique(), *rls_[0]);
 
-			for (size_t i = 0; i < tb_vb_sub_allocs_.size(); ++ i)
-			{
-				tb_vb_->Dealloc(tb_vb_sub_allocs_[i]);
-				tb_ib_->Dealloc(tb_ib_sub_allocs_[i]);
+					tb_vb_->Dealloc(tb_vb_sub_allocs_[i]);
+				}
 			}
 
 			this->OnRenderEnd();
@@ -204,6 +220,15 @@ namespace KlayGE
 
 		Size_T<float> CalcSize(std::wstring_view text, float font_size)
 		{
+			size_t seed = HashValue(text);
+			HashCombine(seed, font_size);
+			auto& extent = extent_cache_[seed];
+			extent.last_frame = frame_;
+			if ((extent.font_size == font_size) && (extent.text == text))
+			{
+				return extent.size;
+			}
+
 			this->UpdateTexture(text);
 
 			KFont& kl = *kfont_loader_;
@@ -225,8 +250,11 @@ namespace KlayGE
 				}
 			}
 
-			return Size_T<float>(*std::max_element(lines.begin(), lines.end()),
+			extent.text = text;
+			extent.font_size = font_size;
+			extent.size = Size_T<float>(*std::max_element(lines.begin(), lines.end()),
 				font_size * lines.size());
+			return extent.size;
 		}
 
 		void AddText2D(float sx, float sy, float sz,
@@ -254,17 +282,179 @@ namespace KlayGE
 		}
 
 	private:
+#ifdef KLAYGE_HAS_STRUCT_PACK
+	#pragma pack(push, 1)
+#endif
+		struct FontVert
+		{
+			float3 pos;
+			uint32_t clr;
+			float2 tex;
+
+			FontVert()
+			{
+			}
+			FontVert(float3 const & p, uint32_t c, float2 const & t)
+				: pos(p), clr(c), tex(t)
+			{
+			}
+		};
+		static_assert(sizeof(FontVert) == 24);
+#ifdef KLAYGE_HAS_STRUCT_PACK
+	#pragma pack(pop)
+#endif
+
+		static uint32_t constexpr INVALID_SLOT = 0xFFFFFFFFU;
+		static uint32_t constexpr MAX_NUM_PAGES = 4;
+		static size_t constexpr MAX_NUM_CACHED_TEXTS = 1024;
+
+		struct CharInfo
+		{
+			Rect rc;
+			uint32_t slot;
+		};
+
+		// A glyph cell of the atlas pages, linked in the LRU list
+		struct CharSlot
+		{
+			wchar_t ch;
+			uint32_t prev;
+			uint32_t next;
+			uint64_t tick;
+			uint32_t generation;
+			bool linked;
+		};
+
+		// The prebuilt quads of a text. It's valid until one of its glyphs is evicted from the atlas.
+		struct TextLayout
+		{
+			std::wstring text;
+			std::array<float, 8> params;
+			uint32_t clr;
+			uint32_t align;
+
+			std::vector<std::vector<FontVert>> page_vertices;
+			std::vector<std::pair<uint32_t, uint32_t>> glyphs;
+			AABBox pos_aabb;
+			bool complete = false;
+			uint32_t last_frame;
+		};
+
+		struct TextExtent
+		{
+			std::wstring text;
+			float font_size = 0;
+			Size_T<float> size;
+			uint32_t last_frame;
+		};
+
 		void AddText(Rect const & rc, float sz,
 			float xScale, float yScale, Color const & clr, std::wstring_view text, float font_size, uint32_t align)
+		{
+			std::array<float, 8> const params = {rc.left(), rc.top(), rc.right(), rc.bottom(), sz, xScale, yScale, font_size};
+			TextLayout& layout = this->FindLayout(text, params, clr.ABGR(), align);
+			if (!this->IsLayoutValid(layout))
+			{
+				this->BeginLayout(layout);
+				this->LayoutText(layout, rc, sz, xScale, yScale, clr, text, font_size, align);
+				this->EndLayout(layout);
+			}
+			this->EmitLayout(layout);
+		}
+
+		void AddText(float sx, float sy, float sz,
+			float xScale, float yScale, Color const & clr, std::wstring_view text, float font_size)
+		{
+			// Align 0 never appears in rect layouts, so it marks the layouts that start from a point
+			std::array<float, 8> const params = {sx, sy, sz, xScale, yScale, font_size, 0, 0};
+			TextLayout& layout = this->FindLayout(text, params, clr.ABGR(), 0);
+			if (!this->IsLayoutValid(layout))
+			{
+				this->BeginLayout(layout);
+				this->LayoutText(layout, sx, sy, sz, xScale, yScale, clr, text, font_size);
+				this->EndLayout(layout);
+			}
+			this->EmitLayout(layout);
+		}
+
+		TextLayout& FindLayout(std::wstring_view text, std::array<float, 8> const & params, uint32_t clr, uint32_t align)
+		{
+			size_t seed = HashValue(text);
+			HashRange(seed, params.begin(), params.end());
+			HashCombine(seed, clr);
+			HashCombine(seed, align);
+
+			auto& layout = layout_cache_[seed];
+			if ((layout.params != params) || (layout.clr != clr) || (layout.align != align) || (layout.text != text))
+			{
+				layout.text = text;
+				layout.params = params;
+				layout.clr = clr;
+				layout.align = align;
+				layout.complete = false;
+			}
+			layout.last_frame = frame_;
+			return layout;
+		}
+
+		bool IsLayoutValid(TextLayout const & layout)
+		{
+			if (!layout.complete)
+			{
+				return false;
+			}
+			for (auto const & glyph : layout.glyphs)
+			{
+				if (char_slots_[glyph.first].generation != glyph.second)
+				{
+					return false;
+				}
+			}
+
+			// The glyphs are used again, same as UpdateTexture does for a new text
+			++ tick_;
+			for (auto const & glyph : layout.glyphs)
+			{
+				this->TouchSlot(glyph.first);
+			}
+			return true;
+		}
+
+		void BeginLayout(TextLayout& layout)
+		{
+			for (auto& vertices : layout.page_vertices)
+			{
+				vertices.clear();
+			}
+			layout.glyphs.clear();
+			layout.pos_aabb = AABBox(float3(0, 0, 0), float3(0, 0, 0));
+			layout.complete = true;
+		}
+
+		void EndLayout(TextLayout& layout)
+		{
+			std::sort(layout.glyphs.begin(), layout.glyphs.end());
+			layout.glyphs.erase(std::unique(layout.glyphs.begin(), layout.glyphs.end()), layout.glyphs.end());
+		}
+
+		void EmitLayout(TextLayout const & layout)
+		{
+			for (size_t i = 0; i < layout.page_vertices.size(); ++ i)
+			{
+				auto const & vertices = layout.page_vertices[i];
+				page_vertices_[i].insert(page_vertices_[i].end(), vertices.begin(), vertices.end());
+			}
+			pos_aabb_ |= layout.pos_aabb;
+		}
+
+		void LayoutText(TextLayout& layout, Rect const & rc, float sz,
+			float xScale, float yScale, Color const & clr, std::wstring_view text, float font_size, uint32_t align)
 		{
 			this->UpdateTexture(text);
 
 			KFont const & kl = *kfont_loader_;
 			auto const & cim = char_info_map_;
 
-			std::vector<FontVert> vertices;
-			std::vector<uint16_t> indices;
-
 			float const h = font_size * yScale;
 			float const rel_size = font_size / kl.CharSize();
 			float const rel_size_x = rel_size * xScale;
@@ -330,16 +520,11 @@ namespace KlayGE
 				}
 			}
 
-			uint32_t const index_per_char = restart_ ? 5 : 6;
-
 			uint32_t const clr32 = clr.ABGR();
 			for (size_t i = 0; i < sx.size(); ++ i)
 			{
-				size_t const maxSize = lines[i].second.length();
 				float x = sx[i], y = sy[i];
 
-				vertices.reserve(maxSize * 4);
-
 				for (auto const & ch : lines[i].second)
 				{
 					std::pair<int32_t, uint32_t> const & offset_adv = kl.CharIndexAdvance(ch);
@@ -353,24 +538,18 @@ namespace KlayGE
 						float height = ci.height * rel_size_y;
 
 						auto cmiter = cim.find(ch);
-						Rect const & texRect(cmiter->second.rc);
-
-						Rect pos_rc(x + left, y + top, x + left + width, y + top + height);
-						Rect intersect_rc = pos_rc & rc;
-						if ((intersect_rc.Width() > 0) && (intersect_rc.Height() > 0))
+						if (cmiter != cim.end())
+						{
+							Rect pos_rc(x + left, y + top, x + left + width, y + top + height);
+							Rect intersect_rc = pos_rc & rc;
+							if ((intersect_rc.Width() > 0) && (intersect_rc.Height() > 0))
+							{
+								this->AddQuad(layout, cmiter->second, pos_rc, sz, clr32);
+							}
+						}
+						else
 						{
-							vertices.push_back(FontVert(float3(pos_rc.left(), pos_rc.top(), sz),
-													clr32,
-													float2(texRect.left(), texRect.top())));
-							vertices.push_back(FontVert(float3(pos_rc.right(), pos_rc.top(), sz),
-													clr32,
-													float2(texRect.right(), texRect.top())));
-							vertices.push_back(FontVert(float3(pos_rc.right(), pos_rc.bottom(), sz),
-													clr32,
-													float2(texRect.right(), texRect.bottom())));
-							vertices.push_back(FontVert(float3(pos_rc.left(), pos_rc.bottom(), sz),
-													clr32,
-													float2(texRect.left(), texRect.bottom())));
+							layout.complete = false;
 						}
 					}
 
@@ -378,38 +557,11 @@ namespace KlayGE
 					y += (offset_adv.second >> 16) * rel_size_y;
 				}
 
-				tb_vb_sub_allocs_.push_back(tb_vb_->Alloc(static_cast<uint32_t>(vertices.size() * sizeof(vertices[0])), &vertices[0]));
-
-				uint16_t last_index = static_cast<uint16_t>(tb_vb_sub_allocs_.back().offset_ / sizeof(FontVert));
-				uint32_t const num_chars = static_cast<uint32_t>(vertices.size() / 4);
-				indices.reserve(num_chars * index_per_char);
-				for (uint32_t c = 0; c < num_chars; ++ c)
-				{
-					indices.push_back(last_index + 0);
-					indices.push_back(last_index + 1);
-					if (restart_)
-					{
-						indices.push_back(last_index + 3);
-						indices.push_back(last_index + 2);
-						indices.push_back(0xFFFF);
-					}
-					else
-					{
-						indices.push_back(last_index + 2);
-						indices.push_back(last_index + 2);
-						indices.push_back(last_index + 3);
-						indices.push_back(last_index + 0);
-					}
-					last_index += 4;
-				}
-				BOOST_ASSERT(last_index + 3 <= 0xFFFF);
-				tb_ib_sub_allocs_.push_back(tb_ib_->Alloc(static_cast<uint32_t>(indices.size() * sizeof(indices[0])), &indices[0]));
-
-				pos_aabb_ |= AABBox(float3(sx[i], sy[i], sz), float3(sx[i] + lines[i].first, sy[i] + h, sz + 0.1f));
+				layout.pos_aabb |= AABBox(float3(sx[i], sy[i], sz), float3(sx[i] + lines[i].first, sy[i] + h, sz + 0.1f));
 			}
 		}
 
-		void AddText(float sx, float sy, float sz,
+		void LayoutText(TextLayout& layout, float sx, float sy, float sz,
 			float xScale, float yScale, Color const & clr, std::wstring_view text, float font_size)
 		{
 			this->UpdateTexture(text);
@@ -417,22 +569,14 @@ namespace KlayGE
 			KFont const & kl = *kfont_loader_;
 			auto const & cim = char_info_map_;
 
-			std::vector<FontVert> vertices;
-			std::vector<uint16_t> indices;
-
 			uint32_t const clr32 = clr.ABGR();
 			float const h = font_size * yScale;
 			float const rel_size = font_size / kl.CharSize();
 			float const rel_size_x = rel_size * xScale;
 			float const rel_size_y = rel_size * yScale;
-			size_t const maxSize = text.length() - std::count(text.begin(), text.end(), L'\n');
 			float x = sx, y = sy;
 			float maxx = sx, maxy = sy;
 
-			uint32_t const index_per_char = restart_ ? 5 : 6;
-
-			vertices.reserve(maxSize * 4);
-
 			for (auto const & ch : text)
 			{
 				if (ch != L'\n')
@@ -450,21 +594,12 @@ namespace KlayGE
 						auto cmiter = cim.find(ch);
 						if (cmiter != cim.end())
 						{
-							Rect const & texRect(cmiter->second.rc);
 							Rect pos_rc(x + left, y + top, x + left + width, y + top + height);
-
-							vertices.push_back(FontVert(float3(pos_rc.left(), pos_rc.top(), sz),
-												clr32,
-												float2(texRect.left(), texRect.top())));
-							vertices.push_back(FontVert(float3(pos_rc.right(), pos_rc.top(), sz),
-												clr32,
-												float2(texRect.right(), texRect.top())));
-							vertices.push_back(FontVert(float3(pos_rc.right(), pos_rc.bottom(), sz),
-												clr32,
-												float2(texRect.right(), texRect.bottom())));
-							vertices.push_back(FontVert(float3(pos_rc.left(), pos_rc.bottom(), sz),
-												clr32,
-												float2(texRect.left(), texRect.bottom())));
+							this->AddQuad(layout, cmiter->second, pos_rc, sz, clr32);
+						}
+						else
+						{
+							layout.complete = false;
 						}
 					}
 
@@ -488,33 +623,7 @@ namespace KlayGE
 				}
 			}
 
-			tb_vb_sub_allocs_.push_back(tb_vb_->Alloc(static_cast<uint32_t>(vertices.size() * sizeof(vertices[0])), &vertices[0]));
-
-			uint16_t last_index = static_cast<uint16_t>(tb_vb_sub_allocs_.back().offset_ / sizeof(FontVert));
-			uint32_t const num_chars = static_cast<uint32_t>(vertices.size() / 4);
-			indices.reserve(num_chars * index_per_char);
-			for (uint32_t c = 0; c < num_chars; ++ c)
-			{
-				indices.push_back(last_index + 0);
-				indices.push_back(last_index + 1);
-				if (restart_)
-				{
-					indices.push_back(last_index + 3);
-					indices.push_back(last_index + 2);
-					indices.push_back(0xFFFF);
-				}
-				else
-				{
-					indices.push_back(last_index + 2);
-					indices.push_back(last_index + 2);
-					indices.push_back(last_index + 3);
-					indices.push_back(last_index + 0);
-				}
-				last_index += 4;
-			}
-			tb_ib_sub_allocs_.push_back(tb_ib_->Alloc(static_cast<uint32_t>(indices.size() * sizeof(indices[0])), &indices[0]));
-
-			pos_aabb_ |= AABBox(float3(sx, sy, sz), float3(maxx, maxy, sz + 0.1f));
+			layout.pos_aabb |= AABBox(float3(sx, sy, sz), float3(maxx, maxy, sz + 0.1f));
 		}
 
 		// ʹLRU㷨
@@ -523,16 +632,10 @@ namespace KlayGE
 		{
 			++ tick_;
 
-			uint32_t const tex_size = dist_texture_->Width(0);
-
 			KFont& kl = *kfont_loader_;
 			auto& cim = char_info_map_;
 
-			uint32_t const kfont_char_size = kl.CharSize();
-
-			uint32_t const num_chars_a_row = tex_size / kfont_char_size;
-			uint32_t const num_total_chars = num_chars_a_row * num_chars_a_row;
-
+			pending_glyphs_.clear();
 			for (auto const & ch : text)
 			{
 				int32_t offset = kl.CharIndex(ch);
@@ -541,162 +644,302 @@ namespace KlayGE
 					auto cmiter = cim.find(ch);
 					if (cmiter != cim.end())
 					{
-						// ҵ
-
-						cmiter->second.tick = tick_;
+						this->TouchSlot(cmiter->second.slot);
 					}
 					else
 					{
-						// ҲԵ
+						uint32_t const slot = this->AllocSlot();
+						uint32_t const page_slot = slot % this->CharsPerPage();
+						uint32_t const kfont_char_size = kl.CharSize();
 
 						KFont::font_info const & ci = kl.CharInfo(offset);
 
-						uint32_t width = ci.width;
-						uint32_t height = ci.height;
+						CharInfo char_info;
+						char_info.rc.left() = static_cast<float>(page_slot % chars_per_row_ * kfont_char_size) / page_size_;
+						char_info.rc.top() = static_cast<float>(page_slot / chars_per_row_ * kfont_char_size) / page_size_;
+						char_info.rc.right() = char_info.rc.left() + static_cast<float>(ci.width) / page_size_;
+						char_info.rc.bottom() = char_info.rc.top() + static_cast<float>(ci.height) / page_size_;
+						char_info.slot = slot;
+						cim.emplace(ch, char_info);
 
-						int2 char_pos;
-						CharInfo charInfo;
-						if (cim.size() < num_total_chars)
-						{
-							// пռ
+						char_slots_[slot].ch = ch;
+						this->TouchSlot(slot);
 
-							uint32_t const s = char_free_list_.front().first;
-						
-							char_pos.y() = s / num_chars_a_row;
-							char_pos.x() = s - char_pos.y() * num_chars_a_row;
+						pending_glyphs_.emplace_back(slot, offset);
+					}
+				}
+			}
 
-							char_pos.x() *= kfont_char_size;
-							char_pos.y() *= kfont_char_size;
+			if (!pending_glyphs_.empty())
+			{
+				this->UploadGlyphs();
+			}
+		}
 
-							charInfo.rc.left() = static_cast<float>(char_pos.x()) / tex_size;
-							charInfo.rc.top() = static_cast<float>(char_pos.y()) / tex_size;
+		// Decodes the missing glyphs in parallel, and uploads them in runs of adjacent slots
+		void UploadGlyphs()
+		{
+			KFont const & kl = *kfont_loader_;
+			uint32_t const kfont_char_size = kl.CharSize();
+			uint32_t const chars_per_page = this->CharsPerPage();
 
-							++ char_free_list_.front().first;
-							if (char_free_list_.front().first == char_free_list_.front().second)
-							{
-								char_free_list_.pop_front();
-							}
-						}
-						else
-						{
-							// ҵʹʱûʹõ
+			// A slot could be evicted and reused within one text. Only its last glyph is uploaded.
+			std::stable_sort(pending_glyphs_.begin(), pending_glyphs_.end(),
+				[](std::pair<uint32_t, int32_t> const & lhs, std::pair<uint32_t, int32_t> const & rhs)
+				{
+					return lhs.first < rhs.first;
+				});
+			auto const last_iter = std::unique(pending_glyphs_.rbegin(), pending_glyphs_.rend(),
+				[](std::pair<uint32_t, int32_t> const & lhs, std::pair<uint32_t, int32_t> const & rhs)
+				{
+					return lhs.first == rhs.first;
+				});
+			pending_glyphs_.erase(pending_glyphs_.begin(), last_iter.base());
 
-							uint64_t min_tick = cim.begin()->second.tick;
-							auto min_chiter = cim.begin();
-							for (auto chiter = cim.begin(); chiter != cim.end(); ++ chiter)
-							{
-								if (chiter->second.tick < min_tick)
-								{
-									min_tick = chiter->second.tick;
-									min_chiter = chiter;
-								}
-							}
+			struct GlyphRun
+			{
+				uint32_t first_slot;
+				uint32_t num_slots;
+				uint32_t data_offset;
+			};
+			std::vector<GlyphRun> runs;
+			std::vector<uint32_t> glyph_runs(pending_glyphs_.size());
+			for (size_t i = 0; i < pending_glyphs_.size(); ++ i)
+			{
+				uint32_t const slot = pending_glyphs_[i].first;
+				if (!runs.empty())
+				{
+					auto& run = runs.back();
+					uint32_t const next_slot = run.first_slot + run.num_slots;
+					if ((slot == next_slot) && (slot % chars_per_row_ != 0) && (slot % chars_per_page != 0))
+					{
+						++ run.num_slots;
+						glyph_runs[i] = static_cast<uint32_t>(runs.size() - 1);
+						continue;
+					}
+				}
 
-							char_pos.x() = static_cast<int32_t>(min_chiter->second.rc.left() * tex_size);
-							char_pos.y() = static_cast<int32_t>(min_chiter->second.rc.top() * tex_size);
-							charInfo.rc.left() = min_chiter->second.rc.left();
-							charInfo.rc.top() = min_chiter->second.rc.top();
+				uint32_t const data_offset = runs.empty() ? 0
+					: runs.back().data_offset + runs.back().num_slots * kfont_char_size * kfont_char_size;
+				runs.push_back({slot, 1, data_offset});
+				glyph_runs[i] = static_cast<uint32_t>(runs.size() - 1);
+			}
 
-							for (auto chiter = cim.begin(); chiter != cim.end(); ++ chiter)
-							{
-								if (chiter->second.tick == min_tick)
-								{
-									uint32_t const x = static_cast<int32_t>(chiter->second.rc.left() * tex_size);
-									uint32_t const y = static_cast<int32_t>(chiter->second.rc.top() * tex_size);
-									uint32_t const id = y * num_chars_a_row + x;
-									auto freeiter = char_free_list_.begin();
-									while ((freeiter != char_free_list_.end()) && (freeiter->second <= id))
-									{
-										++ freeiter;
-									}
-									char_free_list_.emplace(freeiter, id, id + 1);
-
-									cim.erase(chiter);
-									break;
-								}
-							}
-							for (auto freeiter = char_free_list_.begin(); freeiter != char_free_list_.end();)
-							{
-								auto nextiter = freeiter;
-								++ nextiter;
-
-								if (nextiter != char_free_list_.end())
-								{
-									if (freeiter->second == nextiter->first)
-									{
-										freeiter->second = nextiter->second;
-										char_free_list_.erase(nextiter);
-									}
-									else
-									{
-										++ freeiter;
-									}
-								}
-								else
-								{
-									break;
-								}
-							}
-						}
+			// Reading the compressed data could touch a shared stream, so only the decoding runs in parallel
+			lzma_offsets_.resize(pending_glyphs_.size() + 1);
+			lzma_offsets_[0] = 0;
+			for (size_t i = 0; i < pending_glyphs_.size(); ++ i)
+			{
+				uint32_t size;
+				kl.GetLZMADistanceData(nullptr, size, pending_glyphs_[i].second);
+				lzma_offsets_[i + 1] = lzma_offsets_[i] + size;
+			}
+			lzma_data_.resize(lzma_offsets_.back());
+			for (size_t i = 0; i < pending_glyphs_.size(); ++ i)
+			{
+				uint32_t size = lzma_offsets_[i + 1] - lzma_offsets_[i];
+				kl.GetLZMADistanceData(&lzma_data_[lzma_offsets_[i]], size, pending_glyphs_[i].second);
+			}
+
+			glyph_data_.resize(pending_glyphs_.size() * kfont_char_size * kfont_char_size);
+			Context::Instance().JobSystemInstance().ParallelFor(0, static_cast<uint32_t>(pending_glyphs_.size()), 1,
+				[this, &kl, &runs, &glyph_runs, kfont_char_size](uint32_t begin, uint32_t end)
+				{
+					for (uint32_t i = begin; i < end; ++ i)
+					{
+						GlyphRun const & run = runs[glyph_runs[i]];
+						uint32_t const pitch = run.num_slots * kfont_char_size;
+						uint8_t* dst = &glyph_data_[run.data_offset + (pending_glyphs_[i].first - run.first_slot) * kfont_char_size];
+						kl.DecodeLZMADistanceData(dst, pitch, &lzma_data_[lzma_offsets_[i]], lzma_offsets_[i + 1] - lzma_offsets_[i]);
+					}
+				});
 
-						charInfo.rc.right()		= charInfo.rc.left() + static_cast<float>(width) / tex_size;
-						charInfo.rc.bottom()	= charInfo.rc.top() + static_cast<float>(height) / tex_size;
-						charInfo.tick			= tick_;
+			for (auto const & run : runs)
+			{
+				uint32_t const page = run.first_slot / chars_per_page;
+				uint32_t const page_slot = run.first_slot % chars_per_page;
+				uint32_t const x = page_slot % chars_per_row_ * kfont_char_size;
+				uint32_t const y = page_slot / chars_per_row_ * kfont_char_size;
+				uint32_t const width = run.num_slots * kfont_char_size;
+				dist_textures_[page]->UpdateSubresource2D(0, 0, x, y, width, kfont_char_size, &glyph_data_[run.data_offset], width);
+			}
+		}
 
-						kl.GetDistanceData(&a_char_data_[0], kfont_char_size, offset);
-						dist_texture_->UpdateSubresource2D(0, 0, char_pos.x(), char_pos.y(), kfont_char_size, kfont_char_size,
-							&a_char_data_[0], kfont_char_size);
+		uint32_t CharsPerPage() const
+		{
+			return chars_per_row_ * chars_per_row_;
+		}
 
-						cim.emplace(ch, charInfo);
-					}
+		void AddPage()
+		{
+			RenderFactory& rf = Context::Instance().RenderFactoryInstance();
+			dist_textures_.push_back(rf.MakeTexture2D(page_size_, page_size_, 1, 1, EF_R8, 1, 0, EAH_GPU_Read));
+			page_vertices_.resize(dist_textures_.size());
+
+			CharSlot const empty_slot = {0, INVALID_SLOT, INVALID_SLOT, 0, 0, false};
+			char_slots_.resize(char_slots_.size() + this->CharsPerPage(), empty_slot);
+		}
+
+		// Returns a free slot. If the atlas is full, the least recently used glyph is evicted,
+		// unless it is used by the current text. In that case a new page is added.
+		uint32_t AllocSlot()
+		{
+			if (num_used_slots_ == char_slots_.size())
+			{
+				if (((lru_tail_ != INVALID_SLOT) && (char_slots_[lru_tail_].tick == tick_))
+					&& (dist_textures_.size() < MAX_NUM_PAGES))
+				{
+					this->AddPage();
 				}
 			}
+
+			if (num_used_slots_ < char_slots_.size())
+			{
+				uint32_t const slot = num_used_slots_;
+				++ num_used_slots_;
+				return slot;
+			}
+
+			uint32_t const slot = lru_tail_;
+			BOOST_ASSERT(slot != INVALID_SLOT);
+			char_info_map_.erase(char_slots_[slot].ch);
+			++ char_slots_[slot].generation;
+			this->UnlinkSlot(slot);
+			return slot;
 		}
 
-	private:
-		struct CharInfo
+		// Moves the slot to the head of the LRU list
+		void TouchSlot(uint32_t slot)
 		{
-			Rect rc;
-			uint64_t tick;
-		};
+			auto& char_slot = char_slots_[slot];
+			char_slot.tick = tick_;
+			if (lru_head_ != slot)
+			{
+				if (char_slot.linked)
+				{
+					this->UnlinkSlot(slot);
+				}
 
-#ifdef KLAYGE_HAS_STRUCT_PACK
-	#pragma pack(push, 1)
-#endif
-		struct FontVert
+				char_slot.prev = INVALID_SLOT;
+				char_slot.next = lru_head_;
+				if (lru_head_ != INVALID_SLOT)
+				{
+					char_slots_[lru_head_].prev = slot;
+				}
+				lru_head_ = slot;
+				if (lru_tail_ == INVALID_SLOT)
+				{
+					lru_tail_ = slot;
+				}
+				char_slot.linked = true;
+			}
+		}
+
+		void UnlinkSlot(uint32_t slot)
 		{
-			float3 pos;
-			uint32_t clr;
-			float2 tex;
+			auto& char_slot = char_slots_[slot];
+			BOOST_ASSERT(char_slot.linked);
+			if (char_slot.prev != INVALID_SLOT)
+			{
+				char_slots_[char_slot.prev].next = char_slot.next;
+			}
+			else
+			{
+				lru_head_ = char_slot.next;
+			}
+			if (char_slot.next != INVALID_SLOT)
+			{
+				char_slots_[char_slot.next].prev = char_slot.prev;
+			}
+			else
+			{
+				lru_tail_ = char_slot.prev;
+			}
+			char_slot.prev = INVALID_SLOT;
+			char_slot.next = INVALID_SLOT;
+			char_slot.linked = false;
+		}
 
-			FontVert()
+		void AddQuad(TextLayout& layout, CharInfo const & char_info, Rect const & pos_rc, float sz, uint32_t clr32)
+		{
+			uint32_t const page = char_info.slot / this->CharsPerPage();
+			if (layout.page_vertices.size() <= page)
 			{
+				layout.page_vertices.resize(page + 1);
 			}
-			FontVert(float3 const & p, uint32_t c, float2 const & t)
-				: pos(p), clr(c), tex(t)
+			layout.glyphs.emplace_back(char_info.slot, char_slots_[char_info.slot].generation);
+
+			Rect const & tex_rc = char_info.rc;
+			auto& vertices = layout.page_vertices[page];
+			vertices.emplace_back(float3(pos_rc.left(), pos_rc.top(), sz), clr32, float2(tex_rc.left(), tex_rc.top()));
+			vertices.emplace_back(float3(pos_rc.right(), pos_rc.top(), sz), clr32, float2(tex_rc.right(), tex_rc.top()));
+			vertices.emplace_back(float3(pos_rc.right(), pos_rc.bottom(), sz), clr32, float2(tex_rc.right(), tex_rc.bottom()));
+			vertices.emplace_back(float3(pos_rc.left(), pos_rc.bottom(), sz), clr32, float2(tex_rc.left(), tex_rc.bottom()));
+		}
+
+		// The indices of quads never change, so a static index buffer is shared by all draws
+		void EnsureQuadIndices(uint32_t num_quads)
+		{
+			if (num_quads > num_indexed_quads_)
 			{
+				num_indexed_quads_ = std::max(num_quads, num_indexed_quads_ * 2);
+
+				uint32_t const index_per_char = restart_ ? 5 : 6;
+				std::vector<uint16_t> indices(num_indexed_quads_ * index_per_char);
+				for (uint32_t i = 0; i < num_indexed_quads_; ++ i)
+				{
+					uint16_t const base = static_cast<uint16_t>(i * 4);
+					uint16_t* quad_indices = &indices[i * index_per_char];
+					quad_indices[0] = base + 0;
+					quad_indices[1] = base + 1;
+					if (restart_)
+					{
+						quad_indices[2] = base + 3;
+						quad_indices[3] = base + 2;
+						quad_indices[4] = 0xFFFF;
+					}
+					else
+					{
+						quad_indices[2] = base + 2;
+						quad_indices[3] = base + 2;
+						quad_indices[4] = base + 3;
+						quad_indices[5] = base + 0;
+					}
+				}
+
+				RenderFactory& rf = Context::Instance().RenderFactoryInstance();
+				GraphicsBufferPtr ib = rf.MakeIndexBuffer(BU_Static, EAH_GPU_Read | EAH_Immutable,
+					static_cast<uint32_t>(indices.size() * sizeof(indices[0])), indices.data());
+				rls_[0]->BindIndexStream(ib, EF_R16UI);
 			}
-		};
-		static_assert(sizeof(FontVert) == 24);
-#ifdef KLAYGE_HAS_STRUCT_PACK
-	#pragma pack(pop)
-#endif
+		}
 
+	private:
 		bool restart_;
 
 		std::unordered_map<wchar_t, CharInfo> char_info_map_;
-		std::list<std::pair<uint32_t, uint32_t>> char_free_list_;
+		std::vector<CharSlot> char_slots_;
+		uint32_t num_used_slots_ = 0;
+		uint32_t lru_head_ = INVALID_SLOT;
+		uint32_t lru_tail_ = INVALID_SLOT;
+
+		std::vector<std::pair<uint32_t, int32_t>> pending_glyphs_;
+		std::vector<uint32_t> lzma_offsets_;
+		std::vector<uint8_t> lzma_data_;
+		std::vector<uint8_t> glyph_data_;
 
 		bool three_dim_;
 
 		std::unique_ptr<TransientBuffer> tb_vb_;
-		std::unique_ptr<TransientBuffer> tb_ib_;
 		std::vector<SubAlloc> tb_vb_sub_allocs_;
-		std::vector<SubAlloc> tb_ib_sub_allocs_;
+		uint32_t num_indexed_quads_ = 0;
 
-		TexturePtr		dist_texture_;
-		std::vector<uint8_t> a_char_data_;
+		uint32_t page_size_;
+		uint32_t chars_per_row_;
+		std::vector<TexturePtr> dist_textures_;
+		std::vector<std::vector<FontVert>> page_vertices_;
 
+		RenderEffectParameter* distance_tex_ep_;
 		RenderEffectParameter* half_width_height_ep_;
 		RenderEffectParameter* dpi_scale_ep_;
 		RenderEffectParameter* mvp_ep_;
@@ -704,6 +947,10 @@ namespace KlayGE
 		std::shared_ptr<KFont> kfont_loader_;
 
 		uint64_t tick_;
+
+		std::unordered_map<size_t, TextLayout> layout_cache_;
+		std::unordered_map<size_t, TextExtent> extent_cache_;
+		uint32_t frame_ = 0;
 	};
 }
 
@@ -785,6 +1032,15 @@ namespace
 			return false;
 		}
 
+		uint64_t Hash() const override
+		{
+			size_t seed = 0;
+			HashCombine(seed, this->Type());
+			HashRange(seed, font_desc_.res_name.begin(), font_desc_.res_name.end());
+			HashCombine(seed, font_desc_.flag);
+			return seed;
+		}
+
 		void CopyDataFrom(ResLoadingDesc const & rhs) override
 		{
 			BOOST_ASSERT(this->Type() == rhs.Type());
@@ -872,9 +1128,8 @@ namespace KlayGE
 	{
 		if (!text.empty())
 		{
-			auto font_node = MakeSharedPtr<SceneNode>(MakeSharedPtr<RenderableComponent>(font_renderable_), fsn_attrib_);
 			font_renderable_->AddText2D(x, y, z, xScale, yScale, clr, text, font_size);
-			Context::Instance().SceneManagerInstance().OverlayRootNode().AddChild(font_node);
+			this->AttachOverlayNode();
 		}
 	}
 
@@ -886,9 +1141,8 @@ namespace KlayGE
 	{
 		if (!text.empty())
 		{
-			auto font_node = MakeSharedPtr<SceneNode>(MakeSharedPtr<RenderableComponent>(font_renderable_), fsn_attrib_);
 			font_renderable_->AddText2D(rc, z, xScale, yScale, clr, text, font_size, align);
-			Context::Instance().SceneManagerInstance().OverlayRootNode().AddChild(font_node);
+			this->AttachOverlayNode();
 		}
 	}
 
@@ -904,6 +1158,19 @@ namespace KlayGE
 		}
 	}
 
+	void Font::AttachOverlayNode()
+	{
+		// The renderable draws all texts of a frame at once, so one node is kept and attached once per frame
+		if (!overlay_node_)
+		{
+			overlay_node_ = MakeSharedPtr<SceneNode>(MakeSharedPtr<RenderableComponent>(font_renderable_), fsn_attrib_);
+		}
+		if (overlay_node_->Parent() == nullptr)
+		{
+			Context::Instance().SceneManagerInstance().OverlayRootNode().AddChild(overlay_node_);
+		}
+	}
+
 
 	FontPtr SyncLoadFont(std::string_view font_name, uint32_t flags)
 	{
@@ -38,6 +38,7 @@
 #include <KFL/Hash.hpp>
 #include <KlayGE/DeferredRenderingLayer.hpp>
 #include <KlayGE/SceneManager.hpp>
+#include <KlayGE/AnimationEvaluator.hpp>
 
 #include <algorithm>
 #include <fstream>
@@ -50,7 +51,122 @@ namespace
 {
 	using namespace KlayGE;
 
-	uint32_t const MODEL_BIN_VERSION = 19;
+	uint32_t const MODEL_BIN_VERSION = 20;
+	uint32_t const MODEL_BIN_LEGACY_VERSION = 19;
+	uint32_t const MODEL_BIN_CHUNK_ALIGNMENT = 16;
+
+	// Since version 20, model_bin has a chunk table after the header. Each chunk is compressed on its own and starts at an aligned
+	// offset. The first chunk describes the model, followed by one chunk per merged vertex stream and one for the indices.
+	struct ModelBinChunkDesc
+	{
+		uint32_t fourcc;
+		uint32_t reserved;
+		uint64_t offset;
+		uint64_t len;
+		uint64_t original_len;
+	};
+	static_assert(sizeof(ModelBinChunkDesc) == 32);
+
+	GraphicsBufferPtr CreateModelBuffer(uint64_t size)
+	{
+		auto buff = MakeSharedPtr<SoftwareGraphicsBuffer>(static_cast<uint32_t>(size), false);
+		buff->CreateHWResource(nullptr);
+		return buff;
+	}
+
+	GraphicsBufferPtr ReadModelBuffer(ResIdentifier& res, uint64_t size)
+	{
+		auto buff = CreateModelBuffer(size);
+		GraphicsBuffer::Mapper mapper(*buff, BA_Write_Only);
+		res.read(mapper.Pointer<void>(), static_cast<size_t>(size));
+		return buff;
+	}
+
+	ResIdentifierPtr DecodeModelChunks(ResIdentifierPtr const & res, std::vector<GraphicsBufferPtr>& merged_vbs,
+		GraphicsBufferPtr& merged_ib)
+	{
+		uint32_t num_chunks;
+		res->read(&num_chunks, sizeof(num_chunks));
+		num_chunks = LE2Native(num_chunks);
+		uint32_t reserved;
+		res->read(&reserved, sizeof(reserved));
+
+		std::vector<ModelBinChunkDesc> chunks(num_chunks);
+		res->read(chunks.data(), chunks.size() * sizeof(chunks[0]));
+		for (auto& chunk : chunks)
+		{
+			chunk.fourcc = LE2Native(chunk.fourcc);
+			chunk.offset = LE2Native(chunk.offset);
+			chunk.len = LE2Native(chunk.len);
+			chunk.original_len = LE2Native(chunk.original_len);
+		}
+		BOOST_ASSERT(!chunks.empty() && (chunks[0].fourcc == (MakeFourCC<'D', 'E', 'S', 'C'>::value)));
+
+		// One read for all the compressed chunks, the decoding doesn't touch the file any more. A memory-backed resource is
+		//  decoded in place.
+		uint64_t const payload_offset = static_cast<uint64_t>(res->tellg());
+		size_t const payload_size = static_cast<size_t>(chunks.back().offset + chunks.back().len - payload_offset);
+		std::vector<uint8_t> payload_block;
+		uint8_t const * payload;
+		auto const res_data = res->Data();
+		if (!res_data.empty())
+		{
+			BOOST_ASSERT(payload_offset + payload_size <= res_data.size());
+			payload = res_data.data() + payload_offset;
+		}
+		else
+		{
+			payload_block.resize(payload_size);
+			res->read(payload_block.data(), payload_block.size());
+			payload = payload_block.data();
+		}
+
+		// Vertex and index chunks are decoded straight into the buffers that end up in the meshes
+		std::vector<GraphicsBufferPtr> buffs(num_chunks);
+		std::vector<std::unique_ptr<GraphicsBuffer::Mapper>> mappers(num_chunks);
+		for (uint32_t i = 1; i < num_chunks; ++ i)
+		{
+			buffs[i] = CreateModelBuffer(chunks[i].original_len);
+			mappers[i] = MakeUniquePtr<GraphicsBuffer::Mapper>(*buffs[i], BA_Write_Only);
+
+			if (chunks[i].fourcc == MakeFourCC<'V', 'E', 'R', 'T'>::value)
+			{
+				merged_vbs.push_back(buffs[i]);
+			}
+			else
+			{
+				BOOST_ASSERT(chunks[i].fourcc == (MakeFourCC<'I', 'N', 'D', 'X'>::value));
+				merged_ib = buffs[i];
+			}
+		}
+
+		auto desc = MakeSharedPtr<std::stringstream>();
+		Context::Instance().JobSystemInstance().ParallelFor(0, num_chunks, 1,
+			[&chunks, payload, payload_offset, &mappers, &desc](uint32_t begin, uint32_t end)
+			{
+				LZMACodec lzma;
+				for (uint32_t i = begin; i < end; ++ i)
+				{
+					auto const & chunk = chunks[i];
+					if (chunk.original_len == 0)
+					{
+						continue;
+					}
+
+					auto const input = MakeSpan(&payload[static_cast<size_t>(chunk.offset - payload_offset)], static_cast<size_t>(chunk.len));
+					if (i == 0)
+					{
+						lzma.Decode(*desc, input, chunk.original_len);
+					}
+					else
+					{
+						lzma.Decode(mappers[i]->Pointer<void>(), input, chunk.original_len);
+					}
+				}
+			});
+
+		return MakeSharedPtr<ResIdentifier>(res->ResName(), res->Timestamp(), desc);
+	}
 
 	class RenderModelLoadingDesc : public ResLoadingDesc
 	{
@@ -64,8 +180,10 @@ namespace
 			std::function<RenderModelPtr(std::wstring_view, uint32_t)> CreateModelFactoryFunc;
 			std::function<StaticMeshPtr(std::wstring_view)> CreateMeshFactoryFunc;
 
-			RenderModelPtr sw_model;
+			// Shared with the descs cloned from this one, so only the sub thread stage of this one loads it
+			std::shared_ptr<RenderModelPtr> sw_model;
 
+			bool cloned = false;
 			std::shared_ptr<RenderModelPtr> model;
 		};
 
@@ -81,6 +199,7 @@ namespace
 			model_desc_.OnFinishLoading = OnFinishLoading;
 			model_desc_.CreateModelFactoryFunc = CreateModelFactoryFunc;
 			model_desc_.CreateMeshFactoryFunc = CreateMeshFactoryFunc;
+			model_desc_.sw_model = MakeSharedPtr<RenderModelPtr>();
 			model_desc_.model = MakeSharedPtr<RenderModelPtr>();
 
 			this->AddsSubPath();
@@ -114,7 +233,15 @@ namespace
 				return;
 			}
 
-			model_desc_.sw_model = LoadSoftwareModel(model_desc_.res_name);
+			if (model_desc_.cloned)
+			{
+				// Only SyncQuery runs the sub thread stage of a clone, while the desc it's cloned from could be loading too
+				model_desc_.sw_model = MakeSharedPtr<RenderModelPtr>(LoadSoftwareModel(model_desc_.res_name));
+			}
+			else
+			{
+				*model_desc_.sw_model = LoadSoftwareModel(model_desc_.res_name);
+			}
 
 			RenderFactory& rf = Context::Instance().RenderFactoryInstance();
 			RenderDeviceCaps const & caps = rf.RenderEngineInstance().DeviceCaps();
@@ -137,10 +264,28 @@ namespace
 
 		bool Match(ResLoadingDesc const & rhs) const override
 		{
-			KFL_UNUSED(rhs);
+			if (this->Type() == rhs.Type())
+			{
+				RenderModelLoadingDesc const & rmld = static_cast<RenderModelLoadingDesc const &>(rhs);
+				return (model_desc_.res_name == rmld.model_desc_.res_name)
+					&& (model_desc_.access_hint == rmld.model_desc_.access_hint)
+					&& (model_desc_.node_attrib == rmld.model_desc_.node_attrib)
+					&& SameFactory<RenderModelPtr(*)(std::wstring_view, uint32_t)>(model_desc_.CreateModelFactoryFunc,
+						rmld.model_desc_.CreateModelFactoryFunc)
+					&& SameFactory<StaticMeshPtr(*)(std::wstring_view)>(model_desc_.CreateMeshFactoryFunc,
+						rmld.model_desc_.CreateMeshFactoryFunc);
+			}
 			return false;
 		}
 
+		uint64_t Hash() const override
+		{
+			size_t seed = 0;
+			HashCombine(seed, this->Type());
+			HashRange(seed, model_desc_.res_name.begin(), model_desc_.res_name.end());
+			return seed;
+		}
+
 		void CopyDataFrom(ResLoadingDesc const & rhs) override
 		{
 			BOOST_ASSERT(this->Type() == rhs.Type());
@@ -148,14 +293,27 @@ namespace
 			RenderModelLoadingDesc const & rmld = static_cast<RenderModelLoadingDesc const &>(rhs);
 			model_desc_.res_name = rmld.model_desc_.res_name;
 			model_desc_.access_hint = rmld.model_desc_.access_hint;
+			model_desc_.node_attrib = rmld.model_desc_.node_attrib;
 			model_desc_.sw_model = rmld.model_desc_.sw_model;
-			model_desc_.model = rmld.model_desc_.model;
+			// Every query owns its model. It's filled from the one loaded by rhs in CloneResourceFrom, which runs first.
+			model_desc_.model = MakeSharedPtr<RenderModelPtr>(model_desc_.CreateModelFactoryFunc(L"Model", model_desc_.node_attrib));
+			model_desc_.cloned = true;
 		}
 
 		std::shared_ptr<void> CloneResourceFrom(std::shared_ptr<void> const & resource) override
 		{
 			auto rhs_model = std::static_pointer_cast<RenderModel>(resource);
-			auto model = model_desc_.CreateModelFactoryFunc(rhs_model->RootNode()->Name(), rhs_model->RootNode()->Attrib());
+
+			// Fill the model handed out by the query in place
+			RenderModelPtr& model = *model_desc_.model;
+			if (model && model->HWResourceReady())
+			{
+				return std::static_pointer_cast<void>(model);
+			}
+			if (!model)
+			{
+				model = model_desc_.CreateModelFactoryFunc(rhs_model->RootNode()->Name(), rhs_model->RootNode()->Attrib());
+			}
 			model->CloneDataFrom(*rhs_model, model_desc_.CreateMeshFactoryFunc);
 
 			model->BuildModelInfo();
@@ -177,11 +335,59 @@ namespace
 			return *model_desc_.model;
 		}
 
+		uint64_t ResidentSize() const override
+		{
+			RenderModelPtr const & model = *model_desc_.model;
+			if (!model)
+			{
+				return 0;
+			}
+
+			// Meshes share the merged buffers, count each buffer once
+			std::vector<GraphicsBuffer const *> buffers;
+			for (uint32_t mesh_index = 0; mesh_index < model->NumMeshes(); ++ mesh_index)
+			{
+				for (uint32_t lod = 0; lod < model->Mesh(mesh_index)->NumLods(); ++ lod)
+				{
+					auto const & rl = model->Mesh(mesh_index)->GetRenderLayout(lod);
+					for (uint32_t i = 0; i < rl.NumVertexStreams(); ++ i)
+					{
+						buffers.push_back(rl.GetVertexStream(i).get());
+					}
+					if (rl.UseIndices())
+					{
+						buffers.push_back(rl.GetIndexStream().get());
+					}
+				}
+			}
+			std::sort(buffers.begin(), buffers.end());
+			buffers.erase(std::unique(buffers.begin(), buffers.end()), buffers.end());
+
+			uint64_t size = 0;
+			for (auto const * buffer : buffers)
+			{
+				if (buffer != nullptr)
+				{
+					size += buffer->Size();
+				}
+			}
+			return size;
+		}
+
 	private:
+		// Factories can only be compared when both are plain functions, such as the default CreateXXXFactory
+		template <typename Func, typename StdFunction>
+		static bool SameFactory(StdFunction const & lhs, StdFunction const & rhs)
+		{
+			auto const * lhs_func = lhs.template target<Func>();
+			auto const * rhs_func = rhs.template target<Func>();
+			return (lhs_func != nullptr) && (rhs_func != nullptr) && (*lhs_func == *rhs_func);
+		}
+
 		void FillModel()
 		{
 			auto const & model = *model_desc_.model;
-			auto const & sw_model = *model_desc_.sw_model;
+			auto const & sw_model = **model_desc_.sw_model;
 
 			model->CloneDataFrom(sw_model, model_desc_.CreateMeshFactoryFunc);
 
@@ -228,9 +434,15 @@ namespace
 			RenderModelPtr const & model = *model_desc_.model;
 			if (!model || !model->HWResourceReady())
 			{
+				if (!model_desc_.sw_model || !*model_desc_.sw_model)
+				{
+					// Only when nothing has loaded the software model, such as a clone whose original model is already released
+					model_desc_.sw_model = MakeSharedPtr<RenderModelPtr>(LoadSoftwareModel(model_desc_.res_name));
+				}
+
 				this->FillModel();
 
-				auto const & sw_model = *model_desc_.sw_model;
+				auto const & sw_model = **model_desc_.sw_model;
 
 				auto const & caps = Context::Instance().RenderFactoryInstance().RenderEngineInstance().DeviceCaps();
 				auto const & rl = checked_pointer_cast<StaticMesh>(model->Mesh(0))->GetRenderLayout();
@@ -327,7 +539,8 @@ namespace
 					checked_pointer_cast<StaticMesh>(model->Mesh(i))->BuildMeshInfo(*model);
 				}
 
-				model_desc_.sw_model.reset();
+				// Clones are filled from the model from now on. The holder itself stays, they could be copying it.
+				model_desc_.sw_model->reset();
 
 				if (model_desc_.OnFinishLoading)
 				{
@@ -539,6 +752,7 @@ namespace KlayGE
 		: Renderable(name),
 			hw_res_ready_(false)
 	{
+		auto_instancing_ = true;
 	}
 	
 	void StaticMesh::BuildMeshInfo(RenderModel const & model)
@@ -723,75 +937,40 @@ namespace KlayGE
 
 	void SkinnedModel::BuildBones(float frame)
 	{
-		for (size_t i = 0; i < joints_.size(); ++ i)
+		if (!animation_evaluator_)
 		{
-			auto& joint = *joints_[i];
-			KeyFrameSet const & kf = (*key_frame_sets_)[i];
-
-			std::tuple<Quaternion, Quaternion, float> key_dq = kf.Frame(frame);
-
-			bool is_root = false;
-			auto* parent_node = joint.BoundSceneNode()->Parent();
-			if (parent_node)
+			std::vector<int32_t> parents(joints_.size(), -1);
+			for (size_t i = 0; i < joints_.size(); ++ i)
 			{
-				auto* parent_joint = parent_node->FirstComponentOfType<JointComponent>();
-				if (parent_joint == nullptr)
+				auto* parent_node = joints_[i]->BoundSceneNode()->Parent();
+				if (parent_node)
 				{
-					is_root = true;
+					auto* parent_joint = parent_node->FirstComponentOfType<JointComponent>();
+					if (parent_joint != nullptr)
+					{
+						auto const iter = std::find_if(joints_.begin(), joints_.begin() + i,
+							[parent_joint](JointComponentPtr const & joint) { return joint.get() == parent_joint; });
+						BOOST_ASSERT(iter != joints_.begin() + i);
+						if (iter != joints_.begin() + i)
+						{
+							parents[i] = static_cast<int32_t>(iter - joints_.begin());
+						}
+					}
 				}
 			}
 
-			if (is_root)
-			{
-				joint.BindParams(std::get<0>(key_dq), std::get<1>(key_dq), std::get<2>(key_dq));
-			}
-			else
-			{
-				auto const& parent = *parent_node->FirstComponentOfType<JointComponent>();
-
-				if (MathLib::dot(std::get<0>(key_dq), parent.BindReal()) < 0)
-				{
-					std::get<0>(key_dq) = -std::get<0>(key_dq);
-					std::get<1>(key_dq) = -std::get<1>(key_dq);
-				}
-
-				if ((MathLib::SignBit(std::get<2>(key_dq)) > 0) && (MathLib::SignBit(parent.BindScale()) > 0))
-				{
-					joint.BindParams(MathLib::mul_real(std::get<0>(key_dq), parent.BindReal()),
-						MathLib::mul_dual(
-							std::get<0>(key_dq), std::get<1>(key_dq) * parent.BindScale(), parent.BindReal(), parent.BindDual()),
-						std::get<2>(key_dq) * parent.BindScale());
-				}
-				else
-				{
-					float const key_scale = std::get<2>(key_dq);
-					float4x4 tmp_mat = MathLib::scaling(MathLib::abs(key_scale), MathLib::abs(key_scale), key_scale)
-						* MathLib::to_matrix(std::get<0>(key_dq))
-						* MathLib::translation(MathLib::udq_to_trans(std::get<0>(key_dq), std::get<1>(key_dq)))
-						* MathLib::scaling(MathLib::abs(parent.BindScale()), MathLib::abs(parent.BindScale()), parent.BindScale())
-						* MathLib::to_matrix(parent.BindReal())
-						* MathLib::translation(MathLib::udq_to_trans(parent.BindReal(), parent.BindDual()));
-
-					float flip = 1;
-					if (MathLib::dot(MathLib::cross(float3(tmp_mat(0, 0), tmp_mat(0, 1), tmp_mat(0, 2)),
-						float3(tmp_mat(1, 0), tmp_mat(1, 1), tmp_mat(1, 2))),
-						float3(tmp_mat(2, 0), tmp_mat(2, 1), tmp_mat(2, 2))) < 0)
-					{
-						tmp_mat(2, 0) = -tmp_mat(2, 0);
-						tmp_mat(2, 1) = -tmp_mat(2, 1);
-						tmp_mat(2, 2) = -tmp_mat(2, 2);
-
-						flip = -1;
-					}
+			animation_evaluator_ = MakeSharedPtr<AnimationEvaluator>();
+			animation_evaluator_->Bind(std::move(parents), key_frame_sets_);
+		}
 
-					float3 scale;
-					Quaternion rot;
-					float3 trans;
-					MathLib::decompose(scale, rot, trans, tmp_mat);
+		animation_evaluator_->Evaluate(frame);
 
-					joint.BindParams(rot, MathLib::quat_trans_to_udq(rot, trans), flip * scale.x());
-				}
-			}
+		auto const reals = animation_evaluator_->BindReals();
+		auto const duals = animation_evaluator_->BindDuals();
+		auto const scales = animation_evaluator_->BindScales();
+		for (size_t i = 0; i < joints_.size(); ++ i)
+		{
+			joints_[i]->BindParams(reals[i], duals[i], scales[i]);
 		}
 
 		this->UpdateBinds();
@@ -1095,7 +1274,8 @@ namespace KlayGE
 				ver = LE2Native(ver);
 				if ((fourcc != MakeFourCC<'K', 'L', 'M', ' '>::value) || (ver != MODEL_BIN_VERSION))
 				{
-					jit = true;
+					// A legacy runtime file without its source is still loadable
+					jit = (ver != MODEL_BIN_LEGACY_VERSION) || !ResLoader::Instance().Locate(model_name).empty();
 				}
 				else
 				{
@@ -1134,8 +1314,8 @@ namespace KlayGE
 		std::vector<RenderMaterialPtr> mtls;
 		std::vector<VertexElement> merged_ves;
 		char all_is_index_16_bit;
-		std::vector<std::vector<uint8_t>> merged_buff;
-		std::vector<uint8_t> merged_indices;
+		std::vector<GraphicsBufferPtr> merged_vbs;
+		GraphicsBufferPtr merged_ib;
 		std::vector<std::string> mesh_names;
 		std::vector<int32_t> mtl_ids;
 		std::vector<uint32_t> mesh_lods;
@@ -1163,20 +1343,28 @@ namespace KlayGE
 		uint32_t ver;
 		runtime_file->read(&ver, sizeof(ver));
 		ver = LE2Native(ver);
-		BOOST_ASSERT(MODEL_BIN_VERSION == ver);
+		BOOST_ASSERT((MODEL_BIN_VERSION == ver) || (MODEL_BIN_LEGACY_VERSION == ver));
 
-		std::shared_ptr<std::stringstream> ss = MakeSharedPtr<std::stringstream>();
+		ResIdentifierPtr decoded;
+		if (ver == MODEL_BIN_LEGACY_VERSION)
+		{
+			std::shared_ptr<std::stringstream> ss = MakeSharedPtr<std::stringstream>();
 
-		uint64_t original_len, len;
-		runtime_file->read(&original_len, sizeof(original_len));
-		original_len = LE2Native(original_len);
-		runtime_file->read(&len, sizeof(len));
-		len = LE2Native(len);
+			uint64_t original_len, len;
+			runtime_file->read(&original_len, sizeof(original_len));
+			original_len = LE2Native(original_len);
+			runtime_file->read(&len, sizeof(len));
+			len = LE2Native(len);
 
-		LZMACodec lzma;
-		lzma.Decode(*ss, runtime_file, len, original_len);
+			LZMACodec lzma;
+			lzma.Decode(*ss, runtime_file, len, original_len);
 
-		ResIdentifierPtr decoded = MakeSharedPtr<ResIdentifier>(runtime_file->ResName(), runtime_file->Timestamp(), ss);
+			decoded = MakeSharedPtr<ResIdentifier>(runtime_file->ResName(), runtime_file->Timestamp(), ss);
+		}
+		else
+		{
+			decoded = DecodeModelChunks(runtime_file, merged_vbs, merged_ib);
+		}
 
 		uint32_t num_mtls;
 		decoded->read(&num_mtls, sizeof(num_mtls));
@@ -1321,14 +1509,17 @@ namespace KlayGE
 
 		int const index_elem_size = all_is_index_16_bit ? 2 : 4;
 
-		merged_buff.resize(merged_ves.size());
-		for (size_t i = 0; i < merged_buff.size(); ++ i)
+		if (ver == MODEL_BIN_LEGACY_VERSION)
 		{
-			merged_buff[i].resize(all_num_vertices * merged_ves[i].element_size());
-			decoded->read(&merged_buff[i][0], merged_buff[i].size() * sizeof(merged_buff[i][0]));
+			merged_vbs.resize(merged_ves.size());
+			for (size_t i = 0; i < merged_vbs.size(); ++ i)
+			{
+				merged_vbs[i] = ReadModelBuffer(*decoded, all_num_vertices * merged_ves[i].element_size());
+			}
+			merged_ib = ReadModelBuffer(*decoded, all_num_indices * index_elem_size);
 		}
-		merged_indices.resize(all_num_indices * index_elem_size);
-		decoded->read(&merged_indices[0], merged_indices.size() * sizeof(merged_indices[0]));
+		BOOST_ASSERT(merged_vbs.size() == merged_ves.size());
+		BOOST_ASSERT(merged_ib && (merged_ib->Size() == all_num_indices * index_elem_size));
 
 		mesh_names.resize(num_meshes);
 		mtl_ids.resize(num_meshes);
@@ -1604,17 +1795,6 @@ namespace KlayGE
 			model->GetMaterial(mtl_index) = mtls[mtl_index];
 		}
 
-		std::vector<GraphicsBufferPtr> merged_vbs(merged_buff.size());
-		for (size_t i = 0; i < merged_buff.size(); ++ i)
-		{
-			auto vb = MakeSharedPtr<SoftwareGraphicsBuffer>(static_cast<uint32_t>(merged_buff[i].size()), false);
-			vb->CreateHWResource(merged_buff[i].data());
-
-			merged_vbs[i] = vb;
-		}
-		auto merged_ib = MakeSharedPtr<SoftwareGraphicsBuffer>(static_cast<uint32_t>(merged_indices.size()), false);
-		merged_ib->CreateHWResource(merged_indices.data());
-
 		uint32_t mesh_lod_index = 0;
 		std::vector<StaticMeshPtr> meshes(num_meshes);
 		for (uint32_t mesh_index = 0; mesh_index < num_meshes; ++ mesh_index)
@@ -1640,7 +1820,7 @@ namespace KlayGE
 			mesh->NumLods(lods);
 			for (uint32_t lod = 0; lod < lods; ++ lod, ++ mesh_lod_index)
 			{
-				for (uint32_t ve_index = 0; ve_index < merged_buff.size(); ++ ve_index)
+				for (uint32_t ve_index = 0; ve_index < merged_vbs.size(); ++ ve_index)
 				{
 					mesh->AddVertexStream(lod, merged_vbs[ve_index], merged_ves[ve_index]);
 				}
@@ -1779,9 +1959,7 @@ namespace
 		std::vector<AABBox> const & pos_bbs, std::vector<AABBox> const & tc_bbs,
 		std::vector<uint32_t> const & mesh_num_vertices, std::vector<uint32_t> const & mesh_base_vertices,
 		std::vector<uint32_t> const & mesh_num_indices, std::vector<uint32_t> const & mesh_start_indices,
-		std::vector<VertexElement> const & merged_ves,
-		std::vector<std::vector<uint8_t>> const & merged_vertices, std::vector<uint8_t> const & merged_indices,
-		char is_index_16_bit, std::ostream& os)
+		std::vector<VertexElement> const & merged_ves, char is_index_16_bit, std::ostream& os)
 	{
 		uint32_t num_merged_ves = Native2LE(static_cast<uint32_t>(merged_ves.size()));
 		os.write(reinterpret_cast<char*>(&num_merged_ves), sizeof(num_merged_ves));
@@ -1799,12 +1977,6 @@ namespace
 		os.write(reinterpret_cast<char*>(&num_indices), sizeof(num_indices));
 		os.write(&is_index_16_bit, sizeof(is_index_16_bit));
 
-		for (size_t i = 0; i < merged_vertices.size(); ++ i)
-		{
-			os.write(reinterpret_cast<char const *>(&merged_vertices[i][0]), merged_vertices[i].size() * sizeof(merged_vertices[i][0]));
-		}
-		os.write(reinterpret_cast<char const *>(&merged_indices[0]), merged_indices.size() * sizeof(merged_indices[0]));
-
 		uint32_t mesh_lod_index = 0;
 		for (uint32_t mesh_index = 0; mesh_index < mesh_names.size(); ++ mesh_index)
 		{
@@ -2098,7 +2270,7 @@ namespace
 		{
 			WriteMeshesChunk(mesh_names, mtl_ids, mesh_lods, pos_bbs, tc_bbs,
 				mesh_num_vertices, mesh_base_vertices, mesh_num_indices, mesh_base_indices,
-				merged_ves, merged_buffs, merged_indices, all_is_index_16_bit, ss);
+				merged_ves, all_is_index_16_bit, ss);
 		}
 
 		if (!nodes.empty())
@@ -2120,6 +2292,55 @@ namespace
 			WriteAnimationsChunk(*animations, ss);
 		}
 
+		std::string const desc_str = ss.str();
+
+		std::vector<uint32_t> chunk_fourccs;
+		std::vector<std::span<uint8_t const>> chunk_inputs;
+		chunk_fourccs.push_back(MakeFourCC<'D', 'E', 'S', 'C'>::value);
+		chunk_inputs.push_back(MakeSpan(reinterpret_cast<uint8_t const *>(desc_str.data()), desc_str.size()));
+		if (!mesh_names.empty())
+		{
+			for (auto const & buff : merged_buffs)
+			{
+				chunk_fourccs.push_back(MakeFourCC<'V', 'E', 'R', 'T'>::value);
+				chunk_inputs.push_back(MakeSpan(buff));
+			}
+			chunk_fourccs.push_back(MakeFourCC<'I', 'N', 'D', 'X'>::value);
+			chunk_inputs.push_back(MakeSpan(merged_indices));
+		}
+
+		uint32_t const num_chunks = static_cast<uint32_t>(chunk_inputs.size());
+		std::vector<std::vector<uint8_t>> chunk_outputs(num_chunks);
+		Context::Instance().JobSystemInstance().ParallelFor(0, num_chunks, 1,
+			[&chunk_inputs, &chunk_outputs](uint32_t begin, uint32_t end)
+			{
+				LZMACodec lzma;
+				for (uint32_t i = begin; i < end; ++ i)
+				{
+					if (!chunk_inputs[i].empty())
+					{
+						lzma.Encode(chunk_outputs[i], chunk_inputs[i]);
+					}
+				}
+			});
+
+		std::vector<ModelBinChunkDesc> chunks(num_chunks);
+		std::vector<uint64_t> chunk_offsets(num_chunks);
+		uint64_t offset = sizeof(uint32_t) * 4 + chunks.size() * sizeof(chunks[0]);
+		for (uint32_t i = 0; i < num_chunks; ++ i)
+		{
+			offset = (offset + MODEL_BIN_CHUNK_ALIGNMENT - 1) & ~static_cast<uint64_t>(MODEL_BIN_CHUNK_ALIGNMENT - 1);
+			chunk_offsets[i] = offset;
+
+			chunks[i].fourcc = Native2LE(chunk_fourccs[i]);
+			chunks[i].reserved = 0;
+			chunks[i].offset = Native2LE(offset);
+			chunks[i].len = Native2LE(static_cast<uint64_t>(chunk_outputs[i].size()));
+			chunks[i].original_len = Native2LE(static_cast<uint64_t>(chunk_inputs[i].size()));
+
+			offset += chunk_outputs[i].size();
+		}
+
 		std::ofstream ofs(jit_name.c_str(), std::ios_base::binary);
 		BOOST_ASSERT(ofs);
 		uint32_t fourcc = Native2LE(MakeFourCC<'K', 'L', 'M', ' '>::value);
@@ -2128,20 +2349,19 @@ namespace
 		uint32_t ver = Native2LE(MODEL_BIN_VERSION);
 		ofs.write(reinterpret_cast<char*>(&ver), sizeof(ver));
 
-		auto const & ss_str = ss.str();
-		uint64_t original_len = Native2LE(static_cast<uint64_t>(ss_str.size()));
-		ofs.write(reinterpret_cast<char*>(&original_len), sizeof(original_len));
-
-		std::ofstream::pos_type p = ofs.tellp();
-		uint64_t len = 0;
-		ofs.write(reinterpret_cast<char*>(&len), sizeof(len));
+		uint32_t num_chunks_le = Native2LE(num_chunks);
+		ofs.write(reinterpret_cast<char*>(&num_chunks_le), sizeof(num_chunks_le));
+		uint32_t reserved = 0;
+		ofs.write(reinterpret_cast<char*>(&reserved), sizeof(reserved));
+		ofs.write(reinterpret_cast<char*>(chunks.data()), chunks.size() * sizeof(chunks[0]));
 
-		LZMACodec lzma;
-		len = lzma.Encode(ofs, MakeSpan(reinterpret_cast<uint8_t const *>(ss_str.c_str()), ss_str.size()));
+		for (uint32_t i = 0; i < num_chunks; ++ i)
+		{
+			char const padding[MODEL_BIN_CHUNK_ALIGNMENT] = {};
+			ofs.write(padding, chunk_offsets[i] - static_cast<uint64_t>(ofs.tellp()));
 
-		ofs.seekp(p, std::ios_base::beg);
-		len = Native2LE(len);
-		ofs.write(reinterpret_cast<char*>(&len), sizeof(len));
+			ofs.write(reinterpret_cast<char const *>(chunk_outputs[i].data()), chunk_outputs[i].size());
+		}
 	}
 } // namespace
 
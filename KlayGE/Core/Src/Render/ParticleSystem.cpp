@@ -45,8 +45,11 @@
 #include <KFL/XMLDom.hpp>
 #include <KlayGE/DeferredRenderingLayer.hpp>
 #include <KFL/Hash.hpp>
+#include <KFL/RadixSort.hpp>
 
+#include <cstring>
 #include <fstream>
+#include <numeric>
 #include <string>
 
 #include <KlayGE/ParticleSystem.hpp>
@@ -56,6 +59,7 @@ namespace
 	using namespace KlayGE;
 
 	uint32_t const NUM_PARTICLES = 4096;
+	uint32_t const PARTICLE_GRAIN_SIZE = 4096;
 
 	class ParticleSystemLoadingDesc : public ResLoadingDesc
 	{
@@ -336,6 +340,14 @@ namespace
 			return false;
 		}
 
+		uint64_t Hash() const override
+		{
+			size_t seed = 0;
+			HashCombine(seed, this->Type());
+			HashRange(seed, ps_desc_.res_name.begin(), ps_desc_.res_name.end());
+			return seed;
+		}
+
 		void CopyDataFrom(ResLoadingDesc const & rhs) override
 		{
 			BOOST_ASSERT(this->Type() == rhs.Type());
@@ -409,6 +421,21 @@ namespace
 		float alpha;
 	};
 	static_assert(sizeof(ParticleInstance) == 32);
+	static_assert(sizeof(ParticleInstance) == 2 * sizeof(float4));
+
+	float EvalPolyline(std::vector<float2> const & polyline, float x)
+	{
+		for (auto iter = std::next(polyline.begin()); iter != polyline.end(); ++ iter)
+		{
+			if (iter->x() >= x)
+			{
+				float2 const & prev = *std::prev(iter);
+				float const s = (x - prev.x()) / (iter->x() - prev.x());
+				return MathLib::lerp(prev.y(), iter->y(), s);
+			}
+		}
+		return polyline.back().y();
+	}
 #ifdef KLAYGE_HAS_STRUCT_PACK
 #pragma pack(pop)
 #endif
@@ -534,6 +561,65 @@ namespace
 
 namespace KlayGE
 {
+	void ParticleArrays::Resize(uint32_t num)
+	{
+		pos_x.resize(num);
+		pos_y.resize(num);
+		pos_z.resize(num);
+		vel_x.resize(num);
+		vel_y.resize(num);
+		vel_z.resize(num);
+		life.resize(num);
+		spin.resize(num);
+		size.resize(num);
+		alpha.resize(num);
+		init_life.resize(num);
+	}
+
+	Particle ParticleArrays::Get(uint32_t index) const
+	{
+		Particle par;
+		par.pos = float3(pos_x[index], pos_y[index], pos_z[index]);
+		par.vel = float3(vel_x[index], vel_y[index], vel_z[index]);
+		par.life = life[index];
+		par.spin = spin[index];
+		par.size = size[index];
+		par.alpha = alpha[index];
+		par.init_life = init_life[index];
+		return par;
+	}
+
+	void ParticleArrays::Set(uint32_t index, Particle const & par)
+	{
+		pos_x[index] = par.pos.x();
+		pos_y[index] = par.pos.y();
+		pos_z[index] = par.pos.z();
+		vel_x[index] = par.vel.x();
+		vel_y[index] = par.vel.y();
+		vel_z[index] = par.vel.z();
+		life[index] = par.life;
+		spin[index] = par.spin;
+		size[index] = par.size;
+		alpha[index] = par.alpha;
+		init_life[index] = par.init_life;
+	}
+
+	void ParticleArrays::Move(uint32_t from, uint32_t to)
+	{
+		pos_x[to] = pos_x[from];
+		pos_y[to] = pos_y[from];
+		pos_z[to] = pos_z[from];
+		vel_x[to] = vel_x[from];
+		vel_y[to] = vel_y[from];
+		vel_z[to] = vel_z[from];
+		life[to] = life[from];
+		spin[to] = spin[from];
+		size[to] = size[from];
+		alpha[to] = alpha[from];
+		init_life[to] = init_life[from];
+	}
+
+
 	ParticleEmitter::ParticleEmitter(ParticleSystemPtr const& ps)
 			: ps_(ps),
 				model_mat_(float4x4::Identity()),
@@ -585,10 +671,11 @@ namespace KlayGE
 
 	ParticleSystem::ParticleSystem(uint32_t max_num_particles, bool sort_particles)
 		: root_node_(MakeSharedPtr<SceneNode>(L"ParticleSystemRootNode", SceneNode::SOA_Moveable | SceneNode::SOA_NotCastShadow)),
-			particles_(max_num_particles),
+			max_num_particles_(max_num_particles),
 			gravity_(0.5f), force_(0, 0, 0), media_density_(0.0f),
 			sort_particles_(sort_particles)
 	{
+		particles_.Resize(max_num_particles_);
 		this->ClearParticles();
 
 		RenderFactory& rf = Context::Instance().RenderFactoryInstance();
@@ -731,174 +818,202 @@ namespace KlayGE
 	uint32_t ParticleSystem::GetActiveParticleIndex(uint32_t i) const
 	{
 		std::lock_guard<std::mutex> lock(actived_particles_mutex_);
-		return actived_particles_[i].first;
+		return actived_particles_[i];
 	}
 
 	void ParticleSystem::ClearParticles()
 	{
-		for (auto& particle : particles_)
-		{
-			particle.life = 0;
-		}
-	}
-
-	void ParticleSystem::UpdateParticlesNoLock(float elapsed_time)
-	{
-		auto emitter_iter = emitters_.begin();
-		uint32_t new_particle = (*emitter_iter)->Update(elapsed_time);
-
-		auto& re = Context::Instance().RenderFactoryInstance().RenderEngineInstance();
-		auto const& camera = *re.DefaultFrameBuffer()->Viewport()->Camera();
-		float4x4 const& view_mat = camera.ViewMatrix();
-
-		actived_particles_.clear();
-
-		float3 min_bb(+1e10f, +1e10f, +1e10f);
-		float3 max_bb(-1e10f, -1e10f, -1e10f);
-
-		for (auto const & updater : updaters_)
-		{
-			updater->SnapParams();
-		}
-
-		for (uint32_t i = 0; i < particles_.size(); ++ i)
-		{
-			Particle& particle = particles_[i];
-
-			if (particle.life > 0)
-			{
-				for (auto const & updater : updaters_)
-				{
-					updater->Update(particle, elapsed_time);
-				}
-			}
-			else
-			{
-				if (new_particle > 0)
-				{
-					(*emitter_iter)->Emit(particle);
-					for (auto const & updater : updaters_)
-					{
-						updater->Update(particle, 0);
-					}
-					-- new_particle;
-				}
-				else
-				{
-					if (emitter_iter != emitters_.end())
-					{
-						++ emitter_iter;
-						if (emitter_iter != emitters_.end())
-						{
-							new_particle = (*emitter_iter)->Update(elapsed_time);
-						}
-					}
-				}
-			}
-
-			if (particle.life > 0)
-			{
-				float3 const & pos = particle.pos;
-
-				float depth_es;
-				if (sort_particles_)
-				{
-					float4 const pos4(pos.x(), pos.y(), pos.z(), 1);
-					float4 const z_row = view_mat.Col(2);
-					float4 const w_row = view_mat.Col(3);
-
-					depth_es = MathLib::dot(pos4, z_row) / MathLib::dot(pos4, w_row);
-				}
-				else
-				{
-					depth_es = 0;
-				}
-
-				actived_particles_.emplace_back(i, depth_es);
-
-				min_bb = MathLib::minimize(min_bb, pos);
-				max_bb = MathLib::maximize(min_bb, pos);
-			}
-		}
-
-		if (!actived_particles_.empty())
-		{
-			if (sort_particles_)
-			{
-				std::sort(actived_particles_.begin(), actived_particles_.end(),
-					[](std::pair<uint32_t, float> const & lhs, std::pair<uint32_t, float> const & rhs)
-					{
-						return lhs.second > rhs.second;
-					});
-			}
-
-			checked_cast<RenderParticles&>(*render_particles_).PosBound(AABBox(min_bb, max_bb));
-		}
-	}
-
-	void ParticleSystem::UpdateParticleBufferNoLock()
-	{
-		if (!actived_particles_.empty())
-		{
-			RenderLayout& rl = render_particles_->GetRenderLayout();
-
-			GraphicsBufferPtr instance_gb;
-			if (gs_support_)
-			{
-				instance_gb = rl.GetVertexStream(0);
-			}
-			else
-			{
-				instance_gb = rl.InstanceStream();
-			}
-
-			uint32_t const num_active_particles = static_cast<uint32_t>(actived_particles_.size());
-			uint32_t const new_instance_size = num_active_particles * sizeof(ParticleInstance);
-			if (!instance_gb || (instance_gb->Size() < new_instance_size))
-			{
-				RenderFactory& rf = Context::Instance().RenderFactoryInstance();
-				instance_gb = rf.MakeVertexBuffer(BU_Dynamic, EAH_GPU_Read | EAH_CPU_Write,
-					new_instance_size, nullptr);
-
-				if (gs_support_)
-				{
-					rl.SetVertexStream(0, instance_gb);
-				}
-				else
-				{
-					rl.InstanceStream(instance_gb);
-				}
-			}
-
-			if (gs_support_)
-			{
-				rl.NumVertices(num_active_particles);
-			}
-			else
-			{
-				for (uint32_t i = 0; i < rl.NumVertexStreams(); ++ i)
-				{
-					rl.VertexStreamFrequencyDivider(i, RenderLayout::ST_Geometry, num_active_particles);
-				}
-			}
-
-			{
-				GraphicsBuffer::Mapper mapper(*instance_gb, BA_Write_Only);
-				ParticleInstance* instance_data = mapper.Pointer<ParticleInstance>();
-				for (uint32_t i = 0; i < num_active_particles; ++ i, ++ instance_data)
-				{
-					Particle const & par = particles_[actived_particles_[i].first];
-					instance_data->pos = par.pos;
-					instance_data->life = par.life;
-					instance_data->spin = par.spin;
-					instance_data->size = par.size;
-					instance_data->life_factor = (par.init_life - par.life) / par.init_life;
-					instance_data->alpha = par.alpha;
-				}
-			}
-		}
+		num_particles_ = 0;
 	}
 
+	void ParticleSystem::UpdateParticlesNoLock(float elapsed_time)
+	{
+		auto& job_system = Context::Instance().JobSystemInstance();
+
+		for (auto const & updater : updaters_)
+		{
+			updater->SnapParams();
+		}
+
+		job_system.ParallelFor(0, num_particles_, PARTICLE_GRAIN_SIZE, [this, elapsed_time](uint32_t begin, uint32_t end)
+			{
+				for (auto const & updater : updaters_)
+				{
+					updater->Update(particles_, begin, end, elapsed_time);
+				}
+			});
+
+		// Keep the living particles packed at the front
+		uint32_t num_particles = 0;
+		for (uint32_t i = 0; i < num_particles_; ++ i)
+		{
+			if (particles_.life[i] > 0)
+			{
+				if (num_particles != i)
+				{
+					particles_.Move(i, num_particles);
+				}
+				++ num_particles;
+			}
+		}
+
+		uint32_t const first_new_particle = num_particles;
+		for (auto const & emitter : emitters_)
+		{
+			uint32_t const new_particles = std::min(emitter->Update(elapsed_time), max_num_particles_ - num_particles);
+			for (uint32_t i = 0; i < new_particles; ++ i, ++ num_particles)
+			{
+				Particle par;
+				emitter->Emit(par);
+				particles_.Set(num_particles, par);
+			}
+		}
+		for (auto const & updater : updaters_)
+		{
+			updater->Update(particles_, first_new_particle, num_particles, 0);
+		}
+		num_particles_ = num_particles;
+
+		actived_particles_.resize(num_particles);
+		particle_instances_.resize(num_particles * 2);
+		if (num_particles == 0)
+		{
+			return;
+		}
+
+		auto& re = Context::Instance().RenderFactoryInstance().RenderEngineInstance();
+		auto const& camera = *re.DefaultFrameBuffer()->Viewport()->Camera();
+		float4x4 const& view_mat = camera.ViewMatrix();
+		float4 const z_col = view_mat.Col(2);
+		float4 const w_col = view_mat.Col(3);
+
+		if (sort_particles_)
+		{
+			sort_keys_.resize(num_particles);
+		}
+		uint32_t const num_ranges = (num_particles + PARTICLE_GRAIN_SIZE - 1) / PARTICLE_GRAIN_SIZE;
+		range_min_bbs_.resize(num_ranges);
+		range_max_bbs_.resize(num_ranges);
+		job_system.ParallelFor(0, num_ranges, 1, [this, num_particles, &z_col, &w_col](uint32_t range_begin, uint32_t range_end)
+			{
+				for (uint32_t range = range_begin; range < range_end; ++ range)
+				{
+					uint32_t const begin = range * PARTICLE_GRAIN_SIZE;
+					uint32_t const end = std::min(begin + PARTICLE_GRAIN_SIZE, num_particles);
+
+					float3 min_bb(+1e10f, +1e10f, +1e10f);
+					float3 max_bb(-1e10f, -1e10f, -1e10f);
+					for (uint32_t i = begin; i < end; ++ i)
+					{
+						float3 const pos(particles_.pos_x[i], particles_.pos_y[i], particles_.pos_z[i]);
+						min_bb = MathLib::minimize(min_bb, pos);
+						max_bb = MathLib::maximize(max_bb, pos);
+
+						actived_particles_[i] = i;
+						if (sort_particles_)
+						{
+							float const depth_es = (pos.x() * z_col.x() + pos.y() * z_col.y() + pos.z() * z_col.z() + z_col.w())
+								/ (pos.x() * w_col.x() + pos.y() * w_col.y() + pos.z() * w_col.z() + w_col.w());
+
+							// Back to front
+							sort_keys_[i] = ~FloatToSortableKey(depth_es);
+						}
+					}
+					range_min_bbs_[range] = min_bb;
+					range_max_bbs_[range] = max_bb;
+				}
+			});
+
+		if (sort_particles_)
+		{
+			sort_tmp_keys_.resize(num_particles);
+			sort_tmp_indices_.resize(num_particles);
+			RadixSort(sort_keys_.data(), actived_particles_.data(), num_particles, sort_tmp_keys_.data(), sort_tmp_indices_.data());
+		}
+
+		// Fill the instance data in drawing order, so the vertex buffer only needs one copy
+		ParticleInstance* instances = reinterpret_cast<ParticleInstance*>(particle_instances_.data());
+		job_system.ParallelFor(0, num_particles, PARTICLE_GRAIN_SIZE, [this, instances](uint32_t begin, uint32_t end)
+			{
+				for (uint32_t i = begin; i < end; ++ i)
+				{
+					uint32_t const index = actived_particles_[i];
+					float const life = particles_.life[index];
+					float const init_life = particles_.init_life[index];
+
+					ParticleInstance& instance = instances[i];
+					instance.pos = float3(particles_.pos_x[index], particles_.pos_y[index], particles_.pos_z[index]);
+					instance.life = life;
+					instance.spin = particles_.spin[index];
+					instance.size = particles_.size[index];
+					instance.life_factor = (init_life - life) / init_life;
+					instance.alpha = particles_.alpha[index];
+				}
+			});
+
+		float3 min_bb = range_min_bbs_[0];
+		float3 max_bb = range_max_bbs_[0];
+		for (uint32_t i = 1; i < num_ranges; ++ i)
+		{
+			min_bb = MathLib::minimize(min_bb, range_min_bbs_[i]);
+			max_bb = MathLib::maximize(max_bb, range_max_bbs_[i]);
+		}
+		checked_cast<RenderParticles&>(*render_particles_).PosBound(AABBox(min_bb, max_bb));
+	}
+
+	void ParticleSystem::UpdateParticleBufferNoLock()
+	{
+		if (!actived_particles_.empty())
+		{
+			RenderLayout& rl = render_particles_->GetRenderLayout();
+
+			GraphicsBufferPtr instance_gb;
+			if (gs_support_)
+			{
+				instance_gb = rl.GetVertexStream(0);
+			}
+			else
+			{
+				instance_gb = rl.InstanceStream();
+			}
+
+			uint32_t const num_active_particles = static_cast<uint32_t>(actived_particles_.size());
+			uint32_t const new_instance_size = num_active_particles * sizeof(ParticleInstance);
+			if (!instance_gb || (instance_gb->Size() < new_instance_size))
+			{
+				RenderFactory& rf = Context::Instance().RenderFactoryInstance();
+				instance_gb = rf.MakeVertexBuffer(BU_Dynamic, EAH_GPU_Read | EAH_CPU_Write,
+					new_instance_size, nullptr);
+
+				if (gs_support_)
+				{
+					rl.SetVertexStream(0, instance_gb);
+				}
+				else
+				{
+					rl.InstanceStream(instance_gb);
+				}
+			}
+
+			if (gs_support_)
+			{
+				rl.NumVertices(num_active_particles);
+			}
+			else
+			{
+				for (uint32_t i = 0; i < rl.NumVertexStreams(); ++ i)
+				{
+					rl.VertexStreamFrequencyDivider(i, RenderLayout::ST_Geometry, num_active_particles);
+				}
+			}
+
+			{
+				GraphicsBuffer::Mapper mapper(*instance_gb, BA_Write_Only);
+				std::memcpy(mapper.Pointer<void>(), particle_instances_.data(), new_instance_size);
+			}
+		}
+	}
+
 	void ParticleSystem::ParticleAlphaFromTex(std::string const & tex_name)
 	{
 		particle_alpha_from_tex_name_ = tex_name;
@@ -1146,61 +1261,45 @@ namespace KlayGE
 		return ret;
 	}
 
-	void PolylineParticleUpdater::Update(Particle& par, float elapse_time)
-	{
-		BOOST_ASSERT(!this_frame_size_over_life_.empty());
-		BOOST_ASSERT(!this_frame_mass_over_life_.empty());
-		BOOST_ASSERT(!this_frame_opacity_over_life_.empty());
-
-		float pos = (par.init_life - par.life) / par.init_life;
-
-		float cur_size = this_frame_size_over_life_.back().y();
-		for (auto iter = std::next(this_frame_size_over_life_.begin()); iter != this_frame_size_over_life_.end(); ++ iter)
-		{
-			if (iter->x() >= pos)
-			{
-				float2 const & prev = *std::prev(iter);
-				float const s = (pos - prev.x()) / (iter->x() - prev.x());
-				cur_size = MathLib::lerp(prev.y(), iter->y(), s);
-				break;
-			}
-		}
-
-		float cur_mass = this_frame_mass_over_life_.back().y();
-		for (auto iter = std::next(this_frame_mass_over_life_.begin()); iter != this_frame_mass_over_life_.end(); ++ iter)
-		{
-			if (iter->x() >= pos)
-			{
-				float2 const & prev = *std::prev(iter);
-				float const s = (pos - prev.x()) / (iter->x() - prev.x());
-				cur_mass = MathLib::lerp(prev.y(), iter->y(), s);
-				break;
-			}
-		}
-
-		float cur_alpha = this_frame_opacity_over_life_.back().y();
-		for (auto iter = std::next(this_frame_opacity_over_life_.begin()); iter != this_frame_opacity_over_life_.end(); ++ iter)
-		{
-			if (iter->x() >= pos)
-			{
-				float2 const & prev = *std::prev(iter);
-				float const s = (pos - prev.x()) / (iter->x() - prev.x());
-				cur_alpha = MathLib::lerp(prev.y(), iter->y(), s);
-				break;
-			}
-		}
-
-		ParticleSystemPtr ps = ps_.lock();
-		float buoyancy = 4.0f / 3 * PI * MathLib::cube(cur_size) * ps->MediaDensity() * ps->Gravity();
-		float3 accel = (ps->Force() + float3(0, buoyancy, 0)) / cur_mass - float3(0, ps->Gravity(), 0);
-		par.vel += accel * elapse_time;
-		par.pos += par.vel * elapse_time;
-		par.life -= elapse_time;
-		par.spin += 0.001f;
-		par.size = cur_size;
-		par.alpha = cur_alpha;
-	}
-
+	void PolylineParticleUpdater::Update(ParticleArrays& particles, uint32_t begin, uint32_t end, float elapse_time)
+	{
+		BOOST_ASSERT(!this_frame_size_over_life_.empty());
+		BOOST_ASSERT(!this_frame_mass_over_life_.empty());
+		BOOST_ASSERT(!this_frame_opacity_over_life_.empty());
+
+		ParticleSystemPtr ps = ps_.lock();
+		float const gravity = ps->Gravity();
+		float const buoyancy_factor = 4.0f / 3 * PI * ps->MediaDensity() * gravity;
+		float3 const force = ps->Force();
+
+		for (uint32_t i = begin; i < end; ++ i)
+		{
+			float const init_life = particles.init_life[i];
+			float const life = particles.life[i];
+			float const pos = (init_life - life) / init_life;
+
+			float const cur_size = EvalPolyline(this_frame_size_over_life_, pos);
+			float const cur_mass = EvalPolyline(this_frame_mass_over_life_, pos);
+			float const cur_alpha = EvalPolyline(this_frame_opacity_over_life_, pos);
+
+			float const buoyancy = buoyancy_factor * MathLib::cube(cur_size);
+			float const inv_mass = 1 / cur_mass;
+			float const vel_x = particles.vel_x[i] + force.x() * inv_mass * elapse_time;
+			float const vel_y = particles.vel_y[i] + ((force.y() + buoyancy) * inv_mass - gravity) * elapse_time;
+			float const vel_z = particles.vel_z[i] + force.z() * inv_mass * elapse_time;
+			particles.vel_x[i] = vel_x;
+			particles.vel_y[i] = vel_y;
+			particles.vel_z[i] = vel_z;
+			particles.pos_x[i] += vel_x * elapse_time;
+			particles.pos_y[i] += vel_y * elapse_time;
+			particles.pos_z[i] += vel_z * elapse_time;
+			particles.life[i] = life - elapse_time;
+			particles.spin[i] += 0.001f;
+			particles.size[i] = cur_size;
+			particles.alpha[i] = cur_alpha;
+		}
+	}
+
 	void PolylineParticleUpdater::SnapParams()
 	{
 		std::lock_guard<std::mutex> lock(update_mutex_);
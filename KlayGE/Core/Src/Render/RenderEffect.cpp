@@ -62,6 +62,7 @@
 #include <KFL/Hash.hpp>
 #include <KFL/CXX17/filesystem.hpp>
 
+#include <algorithm>
 #include <fstream>
 #include <iterator>
 #include <string>
@@ -80,6 +81,17 @@ namespace
 
 	uint32_t const KFX_VERSION = 0x0150;
 
+	uint32_t FindInLookupIndex(std::vector<std::pair<size_t, uint32_t>> const& index, size_t hash) noexcept
+	{
+		auto iter = std::lower_bound(
+			index.begin(), index.end(), hash, [](std::pair<size_t, uint32_t> const& lhs, size_t rhs) { return lhs.first < rhs; });
+		if ((iter != index.end()) && (iter->first == hash))
+		{
+			return iter->second;
+		}
+		return static_cast<uint32_t>(-1);
+	}
+
 #if KLAYGE_IS_DEV_PLATFORM
 	std::unique_ptr<RenderVariable> LoadVariable(
 		RenderEffect const& effect, XMLNode const& node, RenderEffectDataType type, uint32_t array_size);
@@ -4240,6 +4252,17 @@ namespace KlayGE
 			return false;
 		}
 
+		uint64_t Hash() const override
+		{
+			size_t seed = 0;
+			HashCombine(seed, this->Type());
+			for (auto const & name : effect_desc_.res_name)
+			{
+				HashRange(seed, name.begin(), name.end());
+			}
+			return seed;
+		}
+
 		void CopyDataFrom(ResLoadingDesc const & rhs) override
 		{
 			BOOST_ASSERT(this->Type() == rhs.Type());
@@ -4462,6 +4485,10 @@ namespace KlayGE
 
 		immutable_->res_name = (first_fxml_directory / (connected_name + ".fxml")).string();
 		immutable_->res_name_hash = HashValue(immutable_->res_name);
+
+		immutable_->param_name_index.clear();
+		immutable_->param_semantic_index.clear();
+		immutable_->tech_name_index.clear();
 #if KLAYGE_IS_DEV_PLATFORM
 		for (auto const& name : names)
 		{
@@ -4542,6 +4569,26 @@ namespace KlayGE
 			}
 #endif
 		}
+
+		this->BuildLookupIndices();
+	}
+
+	void RenderEffect::BuildLookupIndices()
+	{
+		auto build = [](std::vector<std::pair<size_t, uint32_t>>& index, uint32_t count, auto const& hash_of) {
+			index.resize(count);
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				index[i] = std::make_pair(hash_of(i), i);
+			}
+			// Stable, so duplicated hashes still resolve to the first one like the linear search does
+			std::stable_sort(index.begin(), index.end(), [](auto const& lhs, auto const& rhs) { return lhs.first < rhs.first; });
+		};
+
+		uint32_t const num_params = this->NumParameters();
+		build(immutable_->param_name_index, num_params, [this](uint32_t i) { return params_[i].NameHash(); });
+		build(immutable_->param_semantic_index, num_params, [this](uint32_t i) { return params_[i].SemanticHash(); });
+		build(immutable_->tech_name_index, this->NumTechniques(), [this](uint32_t i) { return immutable_->techniques[i].NameHash(); });
 	}
 
 #if KLAYGE_IS_DEV_PLATFORM
@@ -4637,54 +4684,83 @@ namespace KlayGE
 
 	RenderEffectParameter* RenderEffect::ParameterBySemantic(std::string_view semantic) noexcept
 	{
-		size_t const semantic_hash = HashValue(std::move(semantic));
-		for (auto& param : params_)
-		{
-			if (semantic_hash == param.SemanticHash())
-			{
-				return &param;
-			}
-		}
-		return nullptr;
+		return this->ParameterBySemantic(HashValue(std::move(semantic)));
 	}
 
 	RenderEffectParameter const* RenderEffect::ParameterBySemantic(std::string_view semantic) const noexcept
 	{
-		size_t const semantic_hash = HashValue(std::move(semantic));
-		for (auto const& param : params_)
-		{
-			if (semantic_hash == param.SemanticHash())
-			{
-				return &param;
-			}
-		}
-		return nullptr;
+		return this->ParameterBySemantic(HashValue(std::move(semantic)));
+	}
+
+	RenderEffectParameter* RenderEffect::ParameterBySemantic(size_t semantic_hash) noexcept
+	{
+		uint32_t const index = this->ParameterIndexBySemantic(semantic_hash);
+		return (index != static_cast<uint32_t>(-1)) ? &params_[index] : nullptr;
+	}
+
+	RenderEffectParameter const* RenderEffect::ParameterBySemantic(size_t semantic_hash) const noexcept
+	{
+		uint32_t const index = this->ParameterIndexBySemantic(semantic_hash);
+		return (index != static_cast<uint32_t>(-1)) ? &params_[index] : nullptr;
 	}
 
 	RenderEffectParameter* RenderEffect::ParameterByName(std::string_view name) noexcept
 	{
-		size_t const name_hash = HashValue(std::move(name));
-		for (auto& param : params_)
+		return this->ParameterByName(HashValue(std::move(name)));
+	}
+
+	RenderEffectParameter const* RenderEffect::ParameterByName(std::string_view name) const noexcept
+	{
+		return this->ParameterByName(HashValue(std::move(name)));
+	}
+
+	RenderEffectParameter* RenderEffect::ParameterByName(size_t name_hash) noexcept
+	{
+		uint32_t const index = this->ParameterIndexByName(name_hash);
+		return (index != static_cast<uint32_t>(-1)) ? &params_[index] : nullptr;
+	}
+
+	RenderEffectParameter const* RenderEffect::ParameterByName(size_t name_hash) const noexcept
+	{
+		uint32_t const index = this->ParameterIndexByName(name_hash);
+		return (index != static_cast<uint32_t>(-1)) ? &params_[index] : nullptr;
+	}
+
+	uint32_t RenderEffect::ParameterIndexByName(size_t name_hash) const noexcept
+	{
+		auto const& index = immutable_->param_name_index;
+		if (index.size() == params_.size())
 		{
-			if (name_hash == param.NameHash())
+			return FindInLookupIndex(index, name_hash);
+		}
+
+		// The index isn't built while the effect is still loading
+		for (uint32_t i = 0; i < params_.size(); ++i)
+		{
+			if (name_hash == params_[i].NameHash())
 			{
-				return &param;
+				return i;
 			}
 		}
-		return nullptr;
+		return static_cast<uint32_t>(-1);
 	}
 
-	RenderEffectParameter const* RenderEffect::ParameterByName(std::string_view name) const noexcept
+	uint32_t RenderEffect::ParameterIndexBySemantic(size_t semantic_hash) const noexcept
 	{
-		size_t const name_hash = HashValue(std::move(name));
-		for (auto const& param : params_)
+		auto const& index = immutable_->param_semantic_index;
+		if (index.size() == params_.size())
 		{
-			if (name_hash == param.NameHash())
+			return FindInLookupIndex(index, semantic_hash);
+		}
+
+		for (uint32_t i = 0; i < params_.size(); ++i)
+		{
+			if (semantic_hash == params_[i].SemanticHash())
 			{
-				return &param;
+				return i;
 			}
 		}
-		return nullptr;
+		return static_cast<uint32_t>(-1);
 	}
 
 	RenderEffectParameter* RenderEffect::ParameterByIndex(uint32_t n) noexcept
@@ -4772,8 +4848,21 @@ namespace KlayGE
 
 	RenderTechnique* RenderEffect::TechniqueByName(std::string_view name) const noexcept
 	{
-		size_t const name_hash = HashValue(std::move(name));
-		for (auto& tech : immutable_->techniques)
+		return this->TechniqueByName(HashValue(std::move(name)));
+	}
+
+	RenderTechnique* RenderEffect::TechniqueByName(size_t name_hash) const noexcept
+	{
+		auto& techniques = immutable_->techniques;
+		auto const& index = immutable_->tech_name_index;
+		if (index.size() == techniques.size())
+		{
+			uint32_t const tech_index = FindInLookupIndex(index, name_hash);
+			return (tech_index != static_cast<uint32_t>(-1)) ? &techniques[tech_index] : nullptr;
+		}
+
+		// Techniques can inherit from earlier ones while the effect is still loading
+		for (auto& tech : techniques)
 		{
 			if (name_hash == tech.NameHash())
 			{
@@ -141,30 +141,53 @@ namespace KlayGE
 
 				auto const& viewport = *re.CurFrameBuffer()->Viewport();
 				uint32_t const num_cameras = viewport.NumCameras();
-				visible_in_cameras_ = 0;
-				for (uint32_t i = 0; i < num_cameras; ++i)
+
+				float4x4 cascade_crop_mat = float4x4::Identity();
+				bool need_cascade_crop_mat = false;
+				if (drl)
 				{
-					if ((curr_node_ == nullptr) || (curr_node_->VisibleMark(i) != BoundOverlap::No))
+					int32_t const cas_index = drl->CurrCascadeIndex();
+					if (cas_index >= 0)
 					{
-						Camera const& camera = *viewport.Camera(i);
+						cascade_crop_mat = drl->GetCascadedShadowLayer().CascadeCropMatrix(cas_index);
+						need_cascade_crop_mat = true;
+					}
+				}
 
-						float4x4 cascade_crop_mat = float4x4::Identity();
-						bool need_cascade_crop_mat = false;
-						if (drl)
+				visible_in_cameras_ = 0;
+				if (num_batch_nodes_ > 0)
+				{
+					// One slot for each visible pair of instance and camera
+					for (uint32_t n = 0; n < num_batch_nodes_; ++n)
+					{
+						SceneNode const& node = *batch_nodes_[n];
+						for (uint32_t i = 0; i < num_cameras; ++i)
 						{
-							int32_t const cas_index = drl->CurrCascadeIndex();
-							if (cas_index >= 0)
+							if (node.VisibleMark(i) != BoundOverlap::No)
 							{
-								cascade_crop_mat = drl->GetCascadedShadowLayer().CascadeCropMatrix(cas_index);
-								need_cascade_crop_mat = true;
+								viewport.Camera(i)->Active(*camera_cbuffer_, visible_in_cameras_, node.TransformToWorld(),
+									node.InverseTransformToWorld(), node.PrevTransformToWorld(), true, cascade_crop_mat, need_cascade_crop_mat);
+								pccb.CameraIndices(*camera_cbuffer_, visible_in_cameras_) = i;
+
+								++visible_in_cameras_;
 							}
 						}
+					}
+				}
+				else
+				{
+					for (uint32_t i = 0; i < num_cameras; ++i)
+					{
+						if ((curr_node_ == nullptr) || (curr_node_->VisibleMark(i) != BoundOverlap::No))
+						{
+							Camera const& camera = *viewport.Camera(i);
 
-						camera.Active(*camera_cbuffer_, visible_in_cameras_, model_mat_, inv_model_mat_, prev_model_mat_, model_mat_dirty_,
-							cascade_crop_mat, need_cascade_crop_mat);
-						pccb.CameraIndices(*camera_cbuffer_, visible_in_cameras_) = i;
+							camera.Active(*camera_cbuffer_, visible_in_cameras_, model_mat_, inv_model_mat_, prev_model_mat_, model_mat_dirty_,
+								cascade_crop_mat, need_cascade_crop_mat);
+							pccb.CameraIndices(*camera_cbuffer_, visible_in_cameras_) = i;
 
-						++visible_in_cameras_;
+							++visible_in_cameras_;
+						}
 					}
 				}
 
@@ -262,6 +285,8 @@ namespace KlayGE
 	{
 		this->UpdateInstanceStream();
 
+		num_draws_saved_ = 0;
+
 		RenderEngine& re = Context::Instance().RenderFactoryInstance().RenderEngineInstance();
 
 		int32_t lod;
@@ -290,12 +315,22 @@ namespace KlayGE
 		}
 		else
 		{
+			RenderTechnique const * auto_instancing_tech = nullptr;
+			if (auto_instancing_ && (instances_.size() > 1) && (re.NumCameraInstances() == 0))
+			{
+				auto_instancing_tech = this->AutoInstancingTech();
+			}
+
 			if (instances_.empty())
 			{
 				this->OnRenderBegin();
 				re.Render(effect, tech, layout);
 				this->OnRenderEnd();
 			}
+			else if (auto_instancing_tech != nullptr)
+			{
+				this->RenderAutoInstances(effect, *auto_instancing_tech, layout);
+			}
 			else
 			{
 				for (auto const * node : instances_)
@@ -321,6 +356,61 @@ namespace KlayGE
 		}
 	}
 
+	void Renderable::RenderAutoInstances(RenderEffect const & effect, RenderTechnique const & tech, RenderLayout const & layout)
+	{
+		RenderEngine& re = Context::Instance().RenderFactoryInstance().RenderEngineInstance();
+		uint32_t const num_cameras = re.CurFrameBuffer()->Viewport()->NumCameras();
+		uint32_t const max_num_slots = RenderEngine::PredefinedCameraCBuffer::max_num_cameras;
+
+		uint32_t num_draws = 0;
+		size_t begin = 0;
+		while (begin < instances_.size())
+		{
+			uint32_t num_slots = 0;
+			size_t end = begin;
+			for (; end < instances_.size(); ++ end)
+			{
+				uint32_t num_visible = 0;
+				for (uint32_t i = 0; i < num_cameras; ++ i)
+				{
+					if (instances_[end]->VisibleMark(i) != BoundOverlap::No)
+					{
+						++ num_visible;
+					}
+				}
+				if (num_slots + num_visible > max_num_slots)
+				{
+					break;
+				}
+				num_slots += num_visible;
+			}
+			BOOST_ASSERT(end > begin);
+
+			this->BindSceneNode(instances_[begin]);
+			batch_nodes_ = &instances_[begin];
+			num_batch_nodes_ = static_cast<uint32_t>(end - begin);
+
+			this->OnRenderBegin();
+			if (visible_in_cameras_ > 0)
+			{
+				re.NumCameraInstances(visible_in_cameras_);
+				re.Render(effect, tech, layout);
+				re.NumCameraInstances(0);
+				++ num_draws;
+			}
+			this->OnRenderEnd();
+
+			begin = end;
+		}
+
+		batch_nodes_ = nullptr;
+		num_batch_nodes_ = 0;
+		// The slots now hold the transforms of the last batch
+		model_mat_dirty_ = true;
+
+		num_draws_saved_ = static_cast<uint32_t>(instances_.size()) - num_draws;
+	}
+
 	void Renderable::AddInstance(SceneNode const * node)
 	{
 		instances_.push_back(node);
@@ -592,6 +682,80 @@ namespace KlayGE
 		select_mode_tech_ = effect_->TechniqueByName("SelectModeTech");
 	}
 
+	RenderTechnique* Renderable::AutoInstancingTech() const
+	{
+		if (select_mode_on_)
+		{
+			return nullptr;
+		}
+
+		// The multi-view techniques of the deferred effects take all the transforms from the camera slots
+		PassType multi_view_type;
+		switch (type_)
+		{
+		case PT_OpaqueGBuffer:
+		case PT_OpaqueGBufferMultiView:
+			multi_view_type = PT_OpaqueGBufferMultiView;
+			break;
+
+		case PT_TransparencyBackGBuffer:
+		case PT_TransparencyBackGBufferMultiView:
+			multi_view_type = PT_TransparencyBackGBufferMultiView;
+			break;
+
+		case PT_TransparencyFrontGBuffer:
+		case PT_TransparencyFrontGBufferMultiView:
+			multi_view_type = PT_TransparencyFrontGBufferMultiView;
+			break;
+
+		case PT_GenShadowMap:
+		case PT_GenShadowMapMultiView:
+			multi_view_type = PT_GenShadowMapMultiView;
+			break;
+
+		case PT_GenCascadedShadowMap:
+		case PT_GenCascadedShadowMapMultiView:
+			multi_view_type = PT_GenCascadedShadowMapMultiView;
+			break;
+
+		case PT_GenReflectiveShadowMap:
+		case PT_GenReflectiveShadowMapMultiView:
+			multi_view_type = PT_GenReflectiveShadowMapMultiView;
+			break;
+
+		case PT_OpaqueSpecialShading:
+		case PT_OpaqueSpecialShadingMultiView:
+			multi_view_type = PT_OpaqueSpecialShadingMultiView;
+			break;
+
+		case PT_TransparencyBackSpecialShading:
+		case PT_TransparencyBackSpecialShadingMultiView:
+			multi_view_type = PT_TransparencyBackSpecialShadingMultiView;
+			break;
+
+		case PT_TransparencyFrontSpecialShading:
+		case PT_TransparencyFrontSpecialShadingMultiView:
+			multi_view_type = PT_TransparencyFrontSpecialShadingMultiView;
+			break;
+
+		default:
+			return nullptr;
+		}
+
+		// Renderables with their own techniques may bind per-node states
+		if (technique_ != this->PassTech(type_))
+		{
+			return nullptr;
+		}
+
+		RenderTechnique* tech = this->PassTech(multi_view_type);
+		if ((tech != nullptr) && tech->Validate())
+		{
+			return tech;
+		}
+		return nullptr;
+	}
+
 	RenderTechnique* Renderable::PassTech(PassType type) const
 	{
 		switch (type)
@@ -0,0 +1,415 @@
+/**
+ * @file SoftwareMipmapper.cpp
+ * @author Minmin Gong
+ *
+ * @section DESCRIPTION
+ *
+ * This source file is part of KlayGE
+ * For the latest info, see http://www.klayge.org
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * You may alternatively use this source under the terms of
+ * the KlayGE Proprietary License (KPL). You can obtained such a license
+ * from http://www.klayge.org/licensing/.
+ */
+
+#include <KlayGE/KlayGE.hpp>
+
+#include <KFL/Color.hpp>
+#include <KFL/ErrorHandling.hpp>
+#include <KFL/Math.hpp>
+#include <KFL/Thread.hpp>
+#include <KlayGE/Context.hpp>
+#include <KlayGE/ElementFormat.hpp>
+#include <KlayGE/Texture.hpp>
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#if defined(KLAYGE_SSE2_SUPPORT)
+	#include <emmintrin.h>
+#endif
+
+#include <KlayGE/SoftwareMipmapper.hpp>
+
+namespace
+{
+	using namespace KlayGE;
+
+	static_assert(sizeof(Color) == sizeof(float) * 4);
+
+	float constexpr WINDOWED_SINC_RADIUS = 3;
+	float constexpr KAISER_ALPHA = 4;
+
+	float Sinc(float x)
+	{
+		if (std::abs(x) < 1e-6f)
+		{
+			return 1;
+		}
+		else
+		{
+			float const px = x * PI;
+			return std::sin(px) / px;
+		}
+	}
+
+	// Modified Bessel function of the first kind, order 0
+	float BesselI0(float x)
+	{
+		float const half_x = x * 0.5f;
+		float sum = 1;
+		float term = 1;
+		for (uint32_t k = 1; k < 32; ++ k)
+		{
+			float const t = half_x / k;
+			term *= t * t;
+			sum += term;
+			if (term < sum * 1e-8f)
+			{
+				break;
+			}
+		}
+		return sum;
+	}
+
+	float FilterRadius(MipmapFilter filter)
+	{
+		switch (filter)
+		{
+		case MipmapFilter::Box:
+			return 0.5f;
+
+		case MipmapFilter::Kaiser:
+		case MipmapFilter::Lanczos:
+			return WINDOWED_SINC_RADIUS;
+
+		default:
+			KFL_UNREACHABLE("Invalid mipmap filter");
+		}
+	}
+
+	float FilterKernel(MipmapFilter filter, float x)
+	{
+		switch (filter)
+		{
+		case MipmapFilter::Box:
+			return ((x >= -0.5f) && (x < 0.5f)) ? 1.0f : 0.0f;
+
+		case MipmapFilter::Kaiser:
+			if (std::abs(x) < WINDOWED_SINC_RADIUS)
+			{
+				float const r = x / WINDOWED_SINC_RADIUS;
+				return Sinc(x) * BesselI0(KAISER_ALPHA * std::sqrt(1 - r * r)) / BesselI0(KAISER_ALPHA);
+			}
+			return 0;
+
+		case MipmapFilter::Lanczos:
+			if (std::abs(x) < WINDOWED_SINC_RADIUS)
+			{
+				return Sinc(x) * Sinc(x / WINDOWED_SINC_RADIUS);
+			}
+			return 0;
+
+		default:
+			KFL_UNREACHABLE("Invalid mipmap filter");
+		}
+	}
+
+	// Every destination texel along one axis reads a fixed number of (clamped) source texels with normalized weights
+	struct FilterWeights
+	{
+		uint32_t taps;
+		std::vector<uint32_t> indices;
+		std::vector<float> weights;
+	};
+
+	FilterWeights ComputeFilterWeights(MipmapFilter filter, uint32_t src_size, uint32_t dst_size)
+	{
+		float const scale = static_cast<float>(src_size) / dst_size;
+		float const filter_scale = std::max(scale, 1.0f);
+		float const support = FilterRadius(filter) * filter_scale;
+
+		FilterWeights ret;
+		ret.taps = static_cast<uint32_t>(std::ceil(support * 2)) + 1;
+		ret.indices.resize(dst_size * ret.taps);
+		ret.weights.resize(dst_size * ret.taps);
+		for (uint32_t dst = 0; dst < dst_size; ++ dst)
+		{
+			float const center = (dst + 0.5f) * scale;
+			int const first = static_cast<int>(std::floor(center - support));
+
+			uint32_t* indices = &ret.indices[dst * ret.taps];
+			float* weights = &ret.weights[dst * ret.taps];
+			float sum = 0;
+			for (uint32_t k = 0; k < ret.taps; ++ k)
+			{
+				int const src = first + static_cast<int>(k);
+				indices[k] = static_cast<uint32_t>(MathLib::clamp(src, 0, static_cast<int>(src_size) - 1));
+				weights[k] = FilterKernel(filter, (src + 0.5f - center) / filter_scale);
+				sum += weights[k];
+			}
+
+			if (std::abs(sum) > 1e-6f)
+			{
+				float const inv_sum = 1 / sum;
+				for (uint32_t k = 0; k < ret.taps; ++ k)
+				{
+					weights[k] *= inv_sum;
+				}
+			}
+			else
+			{
+				std::fill(weights, weights + ret.taps, 0.0f);
+				indices[0] = std::min(static_cast<uint32_t>(center), src_size - 1);
+				weights[0] = 1;
+			}
+		}
+
+		return ret;
+	}
+
+	// out[x] = sum(weights[k] * src[rows[k]][x])
+	void FilterColumns(Color const* src, uint32_t width, uint32_t const* rows, float const* weights, uint32_t taps, Color* out)
+	{
+#if defined(KLAYGE_SSE2_SUPPORT)
+		for (uint32_t x = 0; x < width; ++ x)
+		{
+			__m128 sum = _mm_setzero_ps();
+			for (uint32_t k = 0; k < taps; ++ k)
+			{
+				__m128 const s = _mm_loadu_ps(&src[rows[k] * width + x].r());
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[k]), s));
+			}
+			_mm_storeu_ps(&out[x].r(), sum);
+		}
+#else
+		for (uint32_t x = 0; x < width; ++ x)
+		{
+			Color sum(0, 0, 0, 0);
+			for (uint32_t k = 0; k < taps; ++ k)
+			{
+				sum += src[rows[k] * width + x] * weights[k];
+			}
+			out[x] = sum;
+		}
+#endif
+	}
+
+	// out[x] = sum(weights[x][k] * row[indices[x][k]])
+	void FilterRow(Color const* row, FilterWeights const& weights, uint32_t dst_width, Color* out)
+	{
+		uint32_t const taps = weights.taps;
+		for (uint32_t x = 0; x < dst_width; ++ x)
+		{
+			uint32_t const* indices = &weights.indices[x * taps];
+			float const* w = &weights.weights[x * taps];
+
+#if defined(KLAYGE_SSE2_SUPPORT)
+			__m128 sum = _mm_setzero_ps();
+			for (uint32_t k = 0; k < taps; ++ k)
+			{
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(w[k]), _mm_loadu_ps(&row[indices[k]].r())));
+			}
+			_mm_storeu_ps(&out[x].r(), sum);
+#else
+			Color sum(0, 0, 0, 0);
+			for (uint32_t k = 0; k < taps; ++ k)
+			{
+				sum += row[indices[k]] * w[k];
+			}
+			out[x] = sum;
+#endif
+		}
+	}
+
+	void ResampleLevel(MipmapFilter filter, std::vector<Color> const& src, uint32_t src_width, uint32_t src_height,
+		std::vector<Color>& dst, uint32_t dst_width, uint32_t dst_height)
+	{
+		auto const x_weights = ComputeFilterWeights(filter, src_width, dst_width);
+		auto const y_weights = ComputeFilterWeights(filter, src_height, dst_height);
+
+		dst.resize(dst_width * dst_height);
+		Context::Instance().JobSystemInstance().ParallelFor(0, dst_height, 0, [&](uint32_t begin, uint32_t end) {
+			std::vector<Color> row(src_width);
+			for (uint32_t y = begin; y < end; ++ y)
+			{
+				FilterColumns(src.data(), src_width, &y_weights.indices[y * y_weights.taps], &y_weights.weights[y * y_weights.taps],
+					y_weights.taps, row.data());
+				FilterRow(row.data(), x_weights, dst_width, &dst[y * dst_width]);
+			}
+		});
+	}
+
+	float AlphaCoverage(std::vector<Color> const& texels, float alpha_ref, float alpha_scale)
+	{
+		uint32_t count = 0;
+		for (auto const& texel : texels)
+		{
+			if (texel.a() * alpha_scale > alpha_ref)
+			{
+				++ count;
+			}
+		}
+		return static_cast<float>(count) / texels.size();
+	}
+
+	// Coverage grows monotonically with the scale, so a bisection finds the scale that reproduces the target
+	float FindAlphaScale(std::vector<Color> const& texels, float alpha_ref, float target_coverage)
+	{
+		float low = 0;
+		float high = 8;
+		for (uint32_t i = 0; i < 16; ++ i)
+		{
+			float const mid = (low + high) * 0.5f;
+			if (AlphaCoverage(texels, alpha_ref, mid) < target_coverage)
+			{
+				low = mid;
+			}
+			else
+			{
+				high = mid;
+			}
+		}
+		return (low + high) * 0.5f;
+	}
+
+	template <typename Func>
+	void MapLevel(Texture& texture, uint32_t array_index, uint32_t face, uint32_t level, TextureMapAccess tma, Func const& func)
+	{
+		uint32_t const width = texture.Width(level);
+		uint32_t const height = texture.Height(level);
+		switch (texture.Type())
+		{
+		case Texture::TT_1D:
+			{
+				Texture::Mapper mapper(texture, array_index, level, tma, 0, width);
+				func(mapper.Pointer<uint8_t>(), 0U);
+			}
+			break;
+
+		case Texture::TT_2D:
+			{
+				Texture::Mapper mapper(texture, array_index, level, tma, 0, 0, width, height);
+				func(mapper.Pointer<uint8_t>(), mapper.RowPitch());
+			}
+			break;
+
+		case Texture::TT_Cube:
+			{
+				Texture::Mapper mapper(
+					texture, array_index, static_cast<Texture::CubeFaces>(face), level, tma, 0, 0, width, height);
+				func(mapper.Pointer<uint8_t>(), mapper.RowPitch());
+			}
+			break;
+
+		default:
+			KFL_UNREACHABLE("Unsupported texture type");
+		}
+	}
+
+	void ReadLevel(Texture& texture, uint32_t array_index, uint32_t face, uint32_t level, std::vector<Color>& texels)
+	{
+		uint32_t const width = texture.Width(level);
+		uint32_t const height = texture.Height(level);
+		ElementFormat const fmt = texture.Format();
+
+		texels.resize(width * height);
+		MapLevel(texture, array_index, face, level, TMA_Read_Only, [&](uint8_t const* data, uint32_t row_pitch) {
+			for (uint32_t y = 0; y < height; ++ y)
+			{
+				ConvertToABGR32F(fmt, data + y * row_pitch, width, &texels[y * width]);
+			}
+		});
+	}
+
+	void WriteLevel(Texture& texture, uint32_t array_index, uint32_t face, uint32_t level, std::vector<Color> const& texels)
+	{
+		uint32_t const width = texture.Width(level);
+		uint32_t const height = texture.Height(level);
+		ElementFormat const fmt = texture.Format();
+
+		MapLevel(texture, array_index, face, level, TMA_Write_Only, [&](uint8_t* data, uint32_t row_pitch) {
+			for (uint32_t y = 0; y < height; ++ y)
+			{
+				ConvertFromABGR32F(fmt, &texels[y * width], width, data + y * row_pitch);
+			}
+		});
+	}
+}
+
+namespace KlayGE
+{
+	SoftwareMipmapper::SoftwareMipmapper(MipmapFilter filter)
+		: filter_(filter)
+	{
+	}
+
+	void SoftwareMipmapper::BuildSubLevels(Texture& texture) const
+	{
+		BOOST_ASSERT(!IsCompressedFormat(texture.Format()));
+		BOOST_ASSERT(texture.Type() != Texture::TT_3D);
+
+		uint32_t const num_faces = (texture.Type() == Texture::TT_Cube) ? 6 : 1;
+		uint32_t const num_slices = texture.ArraySize() * num_faces;
+		uint32_t const num_mipmaps = texture.NumMipMaps();
+
+		auto build_slice = [this, &texture, num_mipmaps](uint32_t array_index, uint32_t face) {
+			std::vector<Color> src;
+			std::vector<Color> dst;
+			std::vector<Color> scaled;
+			ReadLevel(texture, array_index, face, 0, src);
+
+			float const coverage = preserve_alpha_coverage_ ? AlphaCoverage(src, alpha_ref_, 1) : 0;
+
+			for (uint32_t level = 1; level < num_mipmaps; ++ level)
+			{
+				// Each level is filtered from the unscaled previous level, so alpha scaling doesn't accumulate down the chain
+				ResampleLevel(filter_, src, texture.Width(level - 1), texture.Height(level - 1), dst, texture.Width(level),
+					texture.Height(level));
+
+				if (preserve_alpha_coverage_)
+				{
+					float const alpha_scale = FindAlphaScale(dst, alpha_ref_, coverage);
+					scaled = dst;
+					for (auto& texel : scaled)
+					{
+						texel.a() = std::min(texel.a() * alpha_scale, 1.0f);
+					}
+					WriteLevel(texture, array_index, face, level, scaled);
+				}
+				else
+				{
+					WriteLevel(texture, array_index, face, level, dst);
+				}
+
+				src.swap(dst);
+			}
+		};
+
+		Context::Instance().JobSystemInstance().ParallelFor(0, num_slices, 1, [num_faces, &build_slice](uint32_t begin, uint32_t end) {
+			for (uint32_t slice = begin; slice < end; ++ slice)
+			{
+				build_slice(slice / num_faces, slice % num_faces);
+			}
+		});
+	}
+} // namespace KlayGE
@@ -29,6 +29,7 @@
 */
 
 #include <KlayGE/KlayGE.hpp>
+#include <KFL/Thread.hpp>
 #include <KlayGE/Context.hpp>
 #include <KlayGE/RenderFactory.hpp>
 #include <KlayGE/Texture.hpp>
@@ -293,35 +294,50 @@ namespace KlayGE
 
 		uint8_t const * src = static_cast<uint8_t const *>(input);
 
-		std::vector<uint8_t> uncompressed(block_width * block_height * elem_size);
-		for (uint32_t y_base = 0; y_base < height; y_base += block_height)
-		{
-			uint8_t* dst = static_cast<uint8_t*>(output) + (y_base / block_height) * out_row_pitch;
-
-			for (uint32_t x_base = 0; x_base < width; x_base += block_width)
+		uint32_t const num_block_rows = (height + block_height - 1) / block_height;
+		Context::Instance().JobSystemInstance().ParallelFor(0, num_block_rows, 0,
+			[this, width, height, output, out_row_pitch, src, in_row_pitch, method,
+				elem_size, block_width, block_height, block_bytes](uint32_t begin, uint32_t end)
 			{
-				for (uint32_t y = 0; y < block_height; ++ y)
+				auto job_codec = this->MakeJobCodec();
+				TexCompression& codec = job_codec ? *job_codec : *this;
+
+				std::vector<uint8_t> uncompressed(block_width * block_height * elem_size);
+				for (uint32_t block_y = begin; block_y < end; ++ block_y)
 				{
-					for (uint32_t x = 0; x < block_width; ++ x)
+					uint32_t const y_base = block_y * block_height;
+					uint8_t* dst = static_cast<uint8_t*>(output) + block_y * out_row_pitch;
+
+					for (uint32_t x_base = 0; x_base < width; x_base += block_width)
 					{
-						if ((x_base + x < width) && (y_base + y < height))
+						for (uint32_t y = 0; y < block_height; ++ y)
 						{
-							memcpy(&uncompressed[(y * block_width + x) * elem_size],
-								&src[(y_base + y) * in_row_pitch + (x_base + x) * elem_size],
-								elem_size);
-						}
-						else
-						{
-							memset(&uncompressed[(y * block_width + x) * elem_size],
-								0, elem_size);
+							for (uint32_t x = 0; x < block_width; ++ x)
+							{
+								if ((x_base + x < width) && (y_base + y < height))
+								{
+									memcpy(&uncompressed[(y * block_width + x) * elem_size],
+										&src[(y_base + y) * in_row_pitch + (x_base + x) * elem_size],
+										elem_size);
+								}
+								else
+								{
+									memset(&uncompressed[(y * block_width + x) * elem_size],
+										0, elem_size);
+								}
+							}
 						}
+
+						codec.EncodeBlock(dst, &uncompressed[0], method);
+						dst += block_bytes;
 					}
 				}
+			});
+	}
 
-				this->EncodeBlock(dst, &uncompressed[0], method);
-				dst += block_bytes;
-			}
-		}
+	std::unique_ptr<TexCompression> TexCompression::MakeJobCodec() const
+	{
+		return std::unique_ptr<TexCompression>();
 	}
 
 	void TexCompression::DecodeMem(uint32_t width, uint32_t height,
@@ -43,6 +43,10 @@
 #include <vector>
 #include <boost/assert.hpp>
 
+#if defined(KLAYGE_SSE2_SUPPORT)
+	#include <emmintrin.h>
+#endif
+
 #include <KlayGE/TexCompressionBC.hpp>
 #include "../Base/TableGen/Tables.hpp"
 
@@ -843,6 +847,118 @@ namespace
 		std::uniform_int_distribution<int> random_dis(0, RAND_MAX);
 		return random_dis(gen);
 	}
+
+	// Min and max of 16 bytes
+	void MinMax16(uint8_t const * values, int& min_value, int& max_value)
+	{
+#if defined(KLAYGE_SSE2_SUPPORT)
+		__m128i const v = _mm_loadu_si128(reinterpret_cast<__m128i const *>(values));
+		__m128i v_min = _mm_min_epu8(v, _mm_srli_si128(v, 8));
+		__m128i v_max = _mm_max_epu8(v, _mm_srli_si128(v, 8));
+		v_min = _mm_min_epu8(v_min, _mm_srli_si128(v_min, 4));
+		v_max = _mm_max_epu8(v_max, _mm_srli_si128(v_max, 4));
+		v_min = _mm_min_epu8(v_min, _mm_srli_si128(v_min, 2));
+		v_max = _mm_max_epu8(v_max, _mm_srli_si128(v_max, 2));
+		v_min = _mm_min_epu8(v_min, _mm_srli_si128(v_min, 1));
+		v_max = _mm_max_epu8(v_max, _mm_srli_si128(v_max, 1));
+		min_value = _mm_cvtsi128_si32(v_min) & 0xFF;
+		max_value = _mm_cvtsi128_si32(v_max) & 0xFF;
+#else
+		min_value = max_value = values[0];
+		for (int i = 1; i < 16; ++ i)
+		{
+			min_value = std::min<int>(min_value, values[i]);
+			max_value = std::max<int>(max_value, values[i]);
+		}
+#endif
+	}
+
+	// Per channel min, max, and rounded mean of 16 pixels
+	void ChannelStats16(ARGBColor32 const * argb, int mu[4], int min_values[4], int max_values[4])
+	{
+#if defined(KLAYGE_SSE2_SUPPORT)
+		__m128i const * p = reinterpret_cast<__m128i const *>(argb);
+		__m128i const v0 = _mm_loadu_si128(p + 0);
+		__m128i const v1 = _mm_loadu_si128(p + 1);
+		__m128i const v2 = _mm_loadu_si128(p + 2);
+		__m128i const v3 = _mm_loadu_si128(p + 3);
+
+		__m128i v_min = _mm_min_epu8(_mm_min_epu8(v0, v1), _mm_min_epu8(v2, v3));
+		__m128i v_max = _mm_max_epu8(_mm_max_epu8(v0, v1), _mm_max_epu8(v2, v3));
+		v_min = _mm_min_epu8(v_min, _mm_srli_si128(v_min, 8));
+		v_max = _mm_max_epu8(v_max, _mm_srli_si128(v_max, 8));
+		v_min = _mm_min_epu8(v_min, _mm_srli_si128(v_min, 4));
+		v_max = _mm_max_epu8(v_max, _mm_srli_si128(v_max, 4));
+
+		// 16-bit sums can't overflow, 16 * 255 < 65536
+		__m128i const zero = _mm_setzero_si128();
+		__m128i sum = _mm_add_epi16(_mm_add_epi16(_mm_unpacklo_epi8(v0, zero), _mm_unpackhi_epi8(v0, zero)),
+			_mm_add_epi16(_mm_unpacklo_epi8(v1, zero), _mm_unpackhi_epi8(v1, zero)));
+		sum = _mm_add_epi16(sum, _mm_add_epi16(_mm_unpacklo_epi8(v2, zero), _mm_unpackhi_epi8(v2, zero)));
+		sum = _mm_add_epi16(sum, _mm_add_epi16(_mm_unpacklo_epi8(v3, zero), _mm_unpackhi_epi8(v3, zero)));
+		sum = _mm_add_epi16(sum, _mm_srli_si128(sum, 8));
+
+		uint32_t const min32 = static_cast<uint32_t>(_mm_cvtsi128_si32(v_min));
+		uint32_t const max32 = static_cast<uint32_t>(_mm_cvtsi128_si32(v_max));
+		uint32_t const sum_lo = static_cast<uint32_t>(_mm_cvtsi128_si32(sum));
+		uint32_t const sum_hi = static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_srli_si128(sum, 4)));
+		int const sums[] = { static_cast<int>(sum_lo & 0xFFFF), static_cast<int>(sum_lo >> 16),
+			static_cast<int>(sum_hi & 0xFFFF), static_cast<int>(sum_hi >> 16) };
+		for (int ch = 0; ch < 4; ++ ch)
+		{
+			mu[ch] = (sums[ch] + 8) >> 4;
+			min_values[ch] = (min32 >> (ch * 8)) & 0xFF;
+			max_values[ch] = (max32 >> (ch * 8)) & 0xFF;
+		}
+#else
+		for (int ch = 0; ch < 4; ++ ch)
+		{
+			int muv, minv, maxv;
+
+			muv = minv = maxv = argb[0][ch];
+			for (int i = 1; i < 16; ++ i)
+			{
+				muv += argb[i][ch];
+				minv = std::min<int>(minv, argb[i][ch]);
+				maxv = std::max<int>(maxv, argb[i][ch]);
+			}
+
+			mu[ch] = (muv + 8) >> 4;
+			min_values[ch] = minv;
+			max_values[ch] = maxv;
+		}
+#endif
+	}
+
+	// Luminance of 16 pixels, the same as dot(Color(argb), (0.2126, 0.7152, 0.0722, 0))
+	void Luminance16(ARGBColor32 const * argb, float* lums)
+	{
+		float const LUM_R = 0.2126f;
+		float const LUM_G = 0.7152f;
+		float const LUM_B = 0.0722f;
+
+#if defined(KLAYGE_SSE2_SUPPORT)
+		__m128 const rcp = _mm_set1_ps(1 / 255.0f);
+		__m128 const wr = _mm_set1_ps(LUM_R);
+		__m128 const wg = _mm_set1_ps(LUM_G);
+		__m128 const wb = _mm_set1_ps(LUM_B);
+		__m128i const mask = _mm_set1_epi32(0xFF);
+		for (int i = 0; i < 16; i += 4)
+		{
+			__m128i const v = _mm_loadu_si128(reinterpret_cast<__m128i const *>(&argb[i]));
+			__m128 const r = _mm_mul_ps(rcp, _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(v, 16), mask)));
+			__m128 const g = _mm_mul_ps(rcp, _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(v, 8), mask)));
+			__m128 const b = _mm_mul_ps(rcp, _mm_cvtepi32_ps(_mm_and_si128(v, mask)));
+			_mm_storeu_ps(&lums[i], _mm_add_ps(_mm_add_ps(_mm_mul_ps(r, wr), _mm_mul_ps(g, wg)), _mm_mul_ps(b, wb)));
+		}
+#else
+		Color const LUM_WEIGHT(LUM_R, LUM_G, LUM_B, 0);
+		for (int i = 0; i < 16; ++ i)
+		{
+			lums[i] = MathLib::dot(Color(argb[i].ARGB()), LUM_WEIGHT);
+		}
+#endif
+	}
 }
 
 namespace KlayGE
@@ -1029,14 +1145,15 @@ namespace KlayGE
 	{
 		if (method != TCM_Quality)
 		{
-			Color const LUM_WEIGHT(0.2126f, 0.7152f, 0.0722f, 0);
+			float lums[16];
+			Luminance16(argb, lums);
 
 			max_clr = min_clr = argb[0];
-			float min_lum = MathLib::dot(Color(min_clr.ARGB()), LUM_WEIGHT);
+			float min_lum = lums[0];
 			float max_lum = min_lum;
 			for (size_t i = 1; i < 16; ++ i)
 			{
-				float lum = MathLib::dot(Color(argb[i].ARGB()), LUM_WEIGHT);
+				float const lum = lums[i];
 				if (lum < min_lum)
 				{
 					min_lum = lum;
@@ -1054,24 +1171,8 @@ namespace KlayGE
 			static int const ITER_POWER = 4;
 
 			// determine color distribution
-			int mu[3], min[3], max[3];
-
-			for (int ch = 0; ch < 3; ++ ch)
-			{
-				int muv, minv, maxv;
-
-				muv = minv = maxv = argb[0][ch];
-				for (int i = 1; i < 16; ++ i)
-				{
-					muv += argb[i][ch];
-					minv = std::min<int>(minv, argb[i][ch]);
-					maxv = std::max<int>(maxv, argb[i][ch]);
-				}
-
-				mu[ch] = (muv + 8) >> 4;
-				min[ch] = minv;
-				max[ch] = maxv;
-			}
+			int mu[4], min[4], max[4];
+			ChannelStats16(argb, mu, min, max);
 
 			// determine covariance matrix
 			int cov[6];
@@ -1451,13 +1552,7 @@ namespace KlayGE
 
 		// find min/max color
 		int min, max;
-		min = max = r[0];
-
-		for (int i = 1; i < 16; ++ i)
-		{
-			min = std::min<int>(min, r[i]);
-			max = std::max<int>(max, r[i]);
-		}
+		MinMax16(r, min, max);
 
 		// encode them
 		bc4.alpha_0 = static_cast<uint8_t>(max);
@@ -2137,6 +2232,12 @@ namespace KlayGE
 		compression_format_ = EF_BC7;
 	}
 
+	std::unique_ptr<TexCompression> TexCompressionBC7::MakeJobCodec() const
+	{
+		// The mode search keeps its states in members
+		return MakeUniquePtr<TexCompressionBC7>();
+	}
+
 	void TexCompressionBC7::EncodeBlock(void* output, void const * input, TexCompressionMethod method)
 	{
 		BOOST_ASSERT(output);
@@ -3646,69 +3747,23 @@ namespace KlayGE
 
 	void BC4ToBC1G(BC1Block& bc1, BC4Block const & bc4)
 	{
+		// BC4 index to BC1 index, for alpha_0 >= alpha_1 and alpha_0 < alpha_1
+		static uint8_t const index_map[2][8] =
+		{
+			{ 0, 1, 0, 2, 2, 1, 2, 1 },
+			{ 0, 1, 2, 2, 3, 3, 0, 1 }
+		};
+
 		bc1.clr_0 = (bc4.alpha_0 >> 2) << 5;
 		bc1.clr_1 = (bc4.alpha_1 >> 2) << 5;
-		bool swap_clr = false;
-		if (bc4.alpha_0 < bc4.alpha_1)
-		{
-			swap_clr = true;
-		}
+		uint8_t const * mapping = index_map[bc4.alpha_0 < bc4.alpha_1];
 		for (int i = 0; i < 2; ++ i)
 		{
 			uint32_t alpha32 = (bc4.bitmap[i * 3 + 2] << 16) | (bc4.bitmap[i * 3 + 1] << 8) | (bc4.bitmap[i * 3 + 0] << 0);
 			uint16_t mask = 0;
-			for (int j = 0; j < 8; ++ j)
+			for (int j = 0; j < 8; ++ j, alpha32 >>= 3)
 			{
-				uint16_t bit = (alpha32 >> (j * 3)) & 0x7;
-				if (swap_clr)
-				{
-					switch (bit)
-					{
-					case 0:
-					case 6:
-						bit = 0;
-						break;
-
-					case 1:
-					case 7:
-						bit = 1;
-						break;
-
-					case 2:
-					case 3:
-						bit = 2;
-						break;
-
-					case 4:
-					case 5:
-						bit = 3;
-						break;
-					}
-				}
-				else
-				{
-					switch (bit)
-					{
-					case 0:
-					case 2:
-						bit = 0;
-						break;
-
-					case 1:
-					case 5:
-					case 7:
-						bit = 1;
-						break;
-
-					case 3:
-					case 4:
-					case 6:
-						bit = 2;
-						break;
-					}
-				}
-
-				mask |= bit << (j * 2);
+				mask |= mapping[alpha32 & 0x7] << (j * 2);
 			}
 
 			bc1.bitmap[i] = mask;
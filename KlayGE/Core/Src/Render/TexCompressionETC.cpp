@@ -39,6 +39,10 @@
 #include <vector>
 #include <boost/assert.hpp>
 
+#if defined(KLAYGE_SSE2_SUPPORT)
+	#include <emmintrin.h>
+#endif
+
 #include <KlayGE/TexCompressionETC.hpp>
 #include "../Base/TableGen/Tables.hpp"
 
@@ -501,6 +505,91 @@ namespace
 
 		return cur_ind;
 	}
+
+	// Picks the nearest of 4 block colors for each pixel of an 8 pixel subblock. Returns the total squared RGB error.
+	uint32_t SelectSubblockColors(ARGBColor32 const * pixels, ARGBColor32 const * block_colors, uint8_t* selectors)
+	{
+#if defined(KLAYGE_SSE2_SUPPORT)
+		__m128i const mask = _mm_set1_epi32(0xFF);
+		__m128i const zero = _mm_setzero_si128();
+		__m128i const v0 = _mm_loadu_si128(reinterpret_cast<__m128i const *>(pixels));
+		__m128i const v1 = _mm_loadu_si128(reinterpret_cast<__m128i const *>(pixels + 4));
+		__m128i const r = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(v0, 16), mask), _mm_and_si128(_mm_srli_epi32(v1, 16), mask));
+		__m128i const g = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(v0, 8), mask), _mm_and_si128(_mm_srli_epi32(v1, 8), mask));
+		__m128i const b = _mm_packs_epi32(_mm_and_si128(v0, mask), _mm_and_si128(v1, mask));
+
+		__m128i best_err[2];
+		__m128i best_sel[2];
+		for (int s = 0; s < 4; ++ s)
+		{
+			__m128i const dr = _mm_sub_epi16(r, _mm_set1_epi16(block_colors[s].r()));
+			__m128i const dg = _mm_sub_epi16(g, _mm_set1_epi16(block_colors[s].g()));
+			__m128i const db = _mm_sub_epi16(b, _mm_set1_epi16(block_colors[s].b()));
+
+			// dr^2 + dg^2 + db^2 in 32-bit, 4 pixels per half
+			__m128i const rg_lo = _mm_unpacklo_epi16(dr, dg);
+			__m128i const rg_hi = _mm_unpackhi_epi16(dr, dg);
+			__m128i const b_lo = _mm_unpacklo_epi16(db, zero);
+			__m128i const b_hi = _mm_unpackhi_epi16(db, zero);
+			__m128i const err[] =
+			{
+				_mm_add_epi32(_mm_madd_epi16(rg_lo, rg_lo), _mm_madd_epi16(b_lo, b_lo)),
+				_mm_add_epi32(_mm_madd_epi16(rg_hi, rg_hi), _mm_madd_epi16(b_hi, b_hi))
+			};
+
+			if (0 == s)
+			{
+				for (int i = 0; i < 2; ++ i)
+				{
+					best_err[i] = err[i];
+					best_sel[i] = zero;
+				}
+			}
+			else
+			{
+				__m128i const sel = _mm_set1_epi32(s);
+				for (int i = 0; i < 2; ++ i)
+				{
+					__m128i const less = _mm_cmplt_epi32(err[i], best_err[i]);
+					best_err[i] = _mm_or_si128(_mm_and_si128(less, err[i]), _mm_andnot_si128(less, best_err[i]));
+					best_sel[i] = _mm_or_si128(_mm_and_si128(less, sel), _mm_andnot_si128(less, best_sel[i]));
+				}
+			}
+		}
+
+		__m128i const sel8 = _mm_packus_epi16(_mm_packs_epi32(best_sel[0], best_sel[1]), zero);
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(selectors), sel8);
+
+		__m128i sum = _mm_add_epi32(best_err[0], best_err[1]);
+		sum = _mm_add_epi32(sum, _mm_srli_si128(sum, 8));
+		sum = _mm_add_epi32(sum, _mm_srli_si128(sum, 4));
+		return static_cast<uint32_t>(_mm_cvtsi128_si32(sum));
+#else
+		uint32_t total_err = 0;
+		for (uint32_t c = 0; c < 8; ++ c)
+		{
+			ARGBColor32 const src_pixel = pixels[c];
+
+			uint32_t best_selector_index = 0;
+			uint32_t best_err = std::numeric_limits<uint32_t>::max();
+			for (uint32_t s = 0; s < 4; ++ s)
+			{
+				uint32_t const trial_err = MathLib::sqr(src_pixel.r() - block_colors[s].r())
+					+ MathLib::sqr(src_pixel.g() - block_colors[s].g())
+					+ MathLib::sqr(src_pixel.b() - block_colors[s].b());
+				if (trial_err < best_err)
+				{
+					best_err = trial_err;
+					best_selector_index = s;
+				}
+			}
+
+			selectors[c] = static_cast<uint8_t>(best_selector_index);
+			total_err += best_err;
+		}
+		return total_err;
+#endif
+	}
 }
 
 namespace KlayGE
@@ -650,6 +739,12 @@ namespace KlayGE
 		sorted_luma_indices_ = nullptr;
 	}
 
+	std::unique_ptr<TexCompression> TexCompressionETC1::MakeJobCodec() const
+	{
+		// The solver keeps its states in members
+		return MakeUniquePtr<TexCompressionETC1>();
+	}
+
 	void TexCompressionETC1::EncodeBlock(void* output, void const * input, TexCompressionMethod method)
 	{
 		BOOST_ASSERT(output);
@@ -1588,8 +1683,6 @@ namespace KlayGE
 
 		ARGBColor32 const base_color = coords.ScaledColor();
 
-		uint32_t const N = 8;
-
 		trial_solution.error_ = std::numeric_limits<uint64_t>::max();
 
 		for (uint32_t inten_table = 0; inten_table < 8; ++ inten_table)
@@ -1601,54 +1694,7 @@ namespace KlayGE
 				block_colors[s] = From4Ints(0, base_color.r() + yd, base_color.g() + yd, base_color.b() + yd);
 			}
 
-			uint64_t total_err = 0;
-
-			ARGBColor32 const * src_pixels = params_->src_pixels_;
-			for (uint32_t c = 0; c < N; ++ c)
-			{
-				ARGBColor32 src_pixel = *src_pixels;
-				++ src_pixels;
-
-				uint32_t best_selector_index = 0;
-				uint32_t best_err = MathLib::sqr(src_pixel.r() - block_colors[0].r())
-					+ MathLib::sqr(src_pixel.g() - block_colors[0].g())
-					+ MathLib::sqr(src_pixel.b() - block_colors[0].b());
-
-				uint32_t trial_err = MathLib::sqr(src_pixel.r() - block_colors[1].r())
-					+ MathLib::sqr(src_pixel.g() - block_colors[1].g())
-					+ MathLib::sqr(src_pixel.b() - block_colors[1].b());
-				if (trial_err < best_err)
-				{
-					best_err = trial_err;
-					best_selector_index = 1;
-				}
-
-				trial_err = MathLib::sqr(src_pixel.r() - block_colors[2].r())
-					+ MathLib::sqr(src_pixel.g() - block_colors[2].g())
-					+ MathLib::sqr(src_pixel.b() - block_colors[2].b());
-				if (trial_err < best_err)
-				{
-					best_err = trial_err;
-					best_selector_index = 2;
-				}
-
-				trial_err = MathLib::sqr(src_pixel.r() - block_colors[3].r())
-					+ MathLib::sqr(src_pixel.g() - block_colors[3].g())
-					+ MathLib::sqr(src_pixel.b() - block_colors[3].b());
-				if (trial_err < best_err)
-				{
-					best_err = trial_err;
-					best_selector_index = 3;
-				}
-
-				temp_selectors_[c] = static_cast<uint8_t>(best_selector_index);
-
-				total_err += best_err;
-				if (total_err >= trial_solution.error_)
-				{
-					break;
-				}
-			}
+			uint64_t const total_err = SelectSubblockColors(params_->src_pixels_, block_colors, temp_selectors_);
 
 			if (total_err < trial_solution.error_)
 			{
@@ -1822,13 +1868,18 @@ namespace KlayGE
 		etc1_codec_ = MakeUniquePtr<TexCompressionETC1>();
 	}
 
+	std::unique_ptr<TexCompression> TexCompressionETC2RGB8::MakeJobCodec() const
+	{
+		return MakeUniquePtr<TexCompressionETC2RGB8>();
+	}
+
 	void TexCompressionETC2RGB8::EncodeBlock(void* output, void const * input, TexCompressionMethod method)
 	{
-		KFL_UNUSED(output);
-		KFL_UNUSED(input);
-		KFL_UNUSED(method);
+		BOOST_ASSERT(output);
+		BOOST_ASSERT(input);
 
-		// TODO
+		// ETC1 blocks are valid ETC2 blocks, the differential colors never overflow. T, H and planar modes are not searched yet.
+		etc1_codec_->EncodeETC1BlockInternal(static_cast<ETC2Block*>(output)->etc1, static_cast<ARGBColor32 const *>(input), method);
 	}
 
 	void TexCompressionETC2RGB8::DecodeBlock(void* output, void const * input)
@@ -2043,6 +2094,11 @@ namespace KlayGE
 		etc2_rgb8_codec_ = MakeUniquePtr<TexCompressionETC2RGB8>();
 	}
 
+	std::unique_ptr<TexCompression> TexCompressionETC2RGB8A1::MakeJobCodec() const
+	{
+		return MakeUniquePtr<TexCompressionETC2RGB8A1>();
+	}
+
 	void TexCompressionETC2RGB8A1::EncodeBlock(void* output, void const * input, TexCompressionMethod method)
 	{
 		KFL_UNUSED(output);
@@ -35,6 +35,7 @@
 #include <KlayGE/RenderEngine.hpp>
 #include <KlayGE/RenderView.hpp>
 #include <KlayGE/ResLoader.hpp>
+#include <KlayGE/SoftwareMipmapper.hpp>
 #include <KFL/Util.hpp>
 #include <KlayGE/TexCompressionBC.hpp>
 #include <KlayGE/TexCompressionETC.hpp>
@@ -1311,6 +1312,15 @@ namespace
 			return false;
 		}
 
+		uint64_t Hash() const override
+		{
+			size_t seed = 0;
+			HashCombine(seed, this->Type());
+			HashRange(seed, tex_desc_.res_name.begin(), tex_desc_.res_name.end());
+			HashCombine(seed, tex_desc_.access_hint);
+			return seed;
+		}
+
 		void CopyDataFrom(ResLoadingDesc const & rhs) override
 		{
 			BOOST_ASSERT(this->Type() == rhs.Type());
@@ -1332,6 +1342,42 @@ namespace
 			return *tex_desc_.tex;
 		}
 
+		uint64_t ResidentSize() const override
+		{
+			TexturePtr const & tex = *tex_desc_.tex;
+			if (!tex)
+			{
+				return 0;
+			}
+
+			ElementFormat const format = tex->Format();
+			uint64_t size = 0;
+			for (uint32_t level = 0; level < tex->NumMipMaps(); ++ level)
+			{
+				uint32_t const width = tex->Width(level);
+				uint32_t const height = tex->Height(level);
+				uint32_t const depth = tex->Depth(level);
+				if (IsCompressedFormat(format))
+				{
+					uint32_t const block_width = BlockWidth(format);
+					uint32_t const block_height = BlockHeight(format);
+					size += static_cast<uint64_t>((width + block_width - 1) / block_width)
+						* ((height + block_height - 1) / block_height) * depth * BlockBytes(format);
+				}
+				else
+				{
+					size += static_cast<uint64_t>(width) * height * depth * NumFormatBytes(format);
+				}
+			}
+
+			uint32_t array_size = tex->ArraySize();
+			if (Texture::TT_Cube == tex->Type())
+			{
+				array_size *= 6;
+			}
+			return size * array_size;
+		}
+
 	private:
 		void LoadDDS()
 		{
@@ -2134,6 +2180,7 @@ namespace KlayGE
 		ElementFormat format;
 		std::vector<ElementInitData> init_data;
 		std::vector<uint8_t> data_block;
+		size_t data_size = 0;
 
 		uint32_t row_pitch, slice_pitch;
 		ReadDdsFileHeader(tex_res, type, width, height, depth, num_mipmaps, array_size, format,
@@ -2174,14 +2221,11 @@ namespace KlayGE
 							image_size = (padding ? ((the_width + 3) & ~3) : the_width) * fmt_size;
 						}
 
-						base[index] = data_block.size();
-						data_block.resize(base[index] + image_size);
+						base[index] = data_size;
+						data_size += image_size;
 						init_data[index].row_pitch = image_size;
 						init_data[index].slice_pitch = image_size;
 
-						tex_res->read(&data_block[base[index]], static_cast<std::streamsize>(image_size));
-						BOOST_ASSERT(tex_res->gcount() == static_cast<int>(image_size));
-
 						the_width = std::max<uint32_t>(the_width / 2, 1);
 					}
 				}
@@ -2204,23 +2248,17 @@ namespace KlayGE
 							uint32_t const block_size = NumFormatBytes(format) * 4;
 							uint32_t image_size = ((the_width + 3) / 4) * ((the_height + 3) / 4) * block_size;
 
-							base[index] = data_block.size();
-							data_block.resize(base[index] + image_size);
+							base[index] = data_size;
+							data_size += image_size;
 							init_data[index].row_pitch = (the_width + 3) / 4 * block_size;
 							init_data[index].slice_pitch = image_size;
-
-							tex_res->read(&data_block[base[index]], static_cast<std::streamsize>(image_size));
-							BOOST_ASSERT(tex_res->gcount() == static_cast<int>(image_size));
 						}
 						else
 						{
 							init_data[index].row_pitch = (padding ? ((the_width + 3) & ~3) : the_width) * fmt_size;
 							init_data[index].slice_pitch = init_data[index].row_pitch * the_height;
-							base[index] = data_block.size();
-							data_block.resize(base[index] + init_data[index].slice_pitch);
-
-							tex_res->read(&data_block[base[index]], static_cast<std::streamsize>(init_data[index].slice_pitch));
-							BOOST_ASSERT(tex_res->gcount() == static_cast<int>(init_data[index].slice_pitch));
+							base[index] = data_size;
+							data_size += init_data[index].slice_pitch;
 						}
 
 						the_width = std::max<uint32_t>(the_width / 2, 1);
@@ -2247,23 +2285,17 @@ namespace KlayGE
 							uint32_t const block_size = NumFormatBytes(format) * 4;
 							uint32_t image_size = ((the_width + 3) / 4) * ((the_height + 3) / 4) * the_depth * block_size;
 
-							base[index] = data_block.size();
-							data_block.resize(base[index] + image_size);
+							base[index] = data_size;
+							data_size += image_size;
 							init_data[index].row_pitch = (the_width + 3) / 4 * block_size;
 							init_data[index].slice_pitch = ((the_width + 3) / 4) * ((the_height + 3) / 4) * block_size;
-
-							tex_res->read(&data_block[base[index]], static_cast<std::streamsize>(image_size));
-							BOOST_ASSERT(tex_res->gcount() == static_cast<int>(image_size));
 						}
 						else
 						{
 							init_data[index].row_pitch = (padding ? ((the_width + 3) & ~3) : the_width) * fmt_size;
 							init_data[index].slice_pitch = init_data[index].row_pitch * the_height;
-							base[index] = data_block.size();
-							data_block.resize(base[index] + init_data[index].slice_pitch * the_depth);
-
-							tex_res->read(&data_block[base[index]], static_cast<std::streamsize>(init_data[index].slice_pitch * the_depth));
-							BOOST_ASSERT(tex_res->gcount() == static_cast<int>(init_data[index].slice_pitch * the_depth));
+							base[index] = data_size;
+							data_size += init_data[index].slice_pitch * the_depth;
 						}
 
 						the_width = std::max<uint32_t>(the_width / 2, 1);
@@ -2292,23 +2324,17 @@ namespace KlayGE
 								uint32_t const block_size = NumFormatBytes(format) * 4;
 								uint32_t image_size = ((the_width + 3) / 4) * ((the_height + 3) / 4) * block_size;
 
-								base[index] = data_block.size();
-								data_block.resize(base[index] + image_size);
+								base[index] = data_size;
+								data_size += image_size;
 								init_data[index].row_pitch = (the_width + 3) / 4 * block_size;
 								init_data[index].slice_pitch = image_size;
-
-								tex_res->read(&data_block[base[index]], static_cast<std::streamsize>(image_size));
-								BOOST_ASSERT(tex_res->gcount() == static_cast<int>(image_size));
 							}
 							else
 							{
 								init_data[index].row_pitch = (padding ? ((the_width + 3) & ~3) : the_width) * fmt_size;
 								init_data[index].slice_pitch = init_data[index].row_pitch * the_width;
-								base[index] = data_block.size();
-								data_block.resize(base[index] + init_data[index].slice_pitch);
-
-								tex_res->read(&data_block[base[index]], static_cast<std::streamsize>(init_data[index].slice_pitch));
-								BOOST_ASSERT(tex_res->gcount() == static_cast<int>(init_data[index].slice_pitch));
+								base[index] = data_size;
+								data_size += init_data[index].slice_pitch;
 							}
 
 							the_width = std::max<uint32_t>(the_width / 2, 1);
@@ -2320,9 +2346,27 @@ namespace KlayGE
 			break;
 		}
 
+		// All the subresources are stored back to back after the header
+		uint8_t const * data;
+		auto const res_data = tex_res->Data();
+		if (!res_data.empty())
+		{
+			// SoftwareTexture copies the init data, so it can point straight into the mapped file
+			size_t const data_offset = static_cast<size_t>(tex_res->tellg());
+			BOOST_ASSERT(data_offset + data_size <= res_data.size());
+			data = res_data.data() + data_offset;
+		}
+		else
+		{
+			data_block.resize(data_size);
+			tex_res->read(data_block.data(), data_size);
+			BOOST_ASSERT(tex_res->gcount() == static_cast<int64_t>(data_size));
+			data = data_block.data();
+		}
+
 		for (size_t i = 0; i < base.size(); ++ i)
 		{
-			init_data[i].data = &data_block[base[i]];
+			init_data[i].data = data + base[i];
 		}
 
 		auto ret = MakeSharedPtr<SoftwareTexture>(type, width, height, depth,
@@ -3678,6 +3722,17 @@ namespace KlayGE
 				}
 			}
 		}
+		else if ((src_width == dst_width) && (src_height == dst_height) && (src_depth == dst_depth))
+		{
+			for (uint32_t z = 0; z < dst_depth; ++ z)
+			{
+				for (uint32_t y = 0; y < dst_height; ++ y)
+				{
+					ConvertFormat(dst_cpu_format, dst_ptr + z * dst_cpu_slice_pitch + y * dst_cpu_row_pitch,
+						src_cpu_format, src_ptr + z * src_cpu_slice_pitch + y * src_cpu_row_pitch, dst_width);
+				}
+			}
+		}
 		else
 		{
 			std::vector<Color> src_32f(src_width * src_height * src_depth);
@@ -4441,4 +4496,17 @@ namespace KlayGE
 			dst_ptr += init_data.row_pitch;
 		}
 	}
+
+	bool SoftwareTexture::HwBuildMipSubLevels(TextureFilter filter)
+	{
+		// Point filtering and volume textures stay on the generic resize path
+		if ((filter != TextureFilter::Linear) || (type_ == TT_3D) || IsCompressedFormat(format_))
+		{
+			return false;
+		}
+
+		SoftwareMipmapper mipmapper(MipmapFilter::Box);
+		mipmapper.BuildSubLevels(*this);
+		return true;
+	}
 }
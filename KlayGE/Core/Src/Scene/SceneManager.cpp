@@ -53,9 +53,11 @@
 #include <KlayGE/FrameBuffer.hpp>
 #include <KlayGE/DeferredRenderingLayer.hpp>
 #include <KFL/Hash.hpp>
+#include <KFL/RadixSort.hpp>
 
 #include <map>
 #include <algorithm>
+#include <numeric>
 
 #include <KlayGE/SceneManager.hpp>
 
@@ -75,6 +77,8 @@ namespace KlayGE
 	{
 		scene_root_.FillVisibleMark(BoundOverlap::Partial);
 		overlay_root_.FillVisibleMark(BoundOverlap::Partial);
+
+		pos_bounds_ws_ = MakeSharedPtr<PosBoundWSStore>();
 	}
 
 	// 
@@ -110,61 +114,138 @@ namespace KlayGE
 		update_elapse_ = elapse;
 	}
 
+	void SceneManager::ParallelCulling(bool parallel)
+	{
+		parallel_culling_ = parallel;
+	}
+
+	bool SceneManager::ParallelCulling() const
+	{
+		return parallel_culling_;
+	}
+
 	// ü
 	/////////////////////////////////////////////////////////////////////////////////
 	void SceneManager::ClipScene()
 	{
 		auto& re = Context::Instance().RenderFactoryInstance().RenderEngineInstance();
 		auto const& viewport = *re.CurFrameBuffer()->Viewport();
+
+		uint32_t constexpr MIN_PARALLEL_NODES = 4096;
+		uint32_t constexpr GRAIN_SIZE = 1024;
+
+		// Frustum tests of all the bounds in one streaming pass per camera. ClipNode() only looks the results up.
+		pos_bound_overlaps_.resize(viewport.NumCameras());
+		for (uint32_t i = 0; i < viewport.NumCameras(); ++ i)
+		{
+			auto& overlaps = pos_bound_overlaps_[i];
+			if (!pos_bounds_ws_ || viewport.Camera(i)->OmniDirectionalMode())
+			{
+				overlaps.clear();
+			}
+			else
+			{
+				overlaps.resize(pos_bounds_ws_->Size());
+				pos_bounds_ws_->Intersect(*camera_frustums_[i], overlaps.data());
+			}
+		}
+
+		if (parallel_culling_ && (all_scene_nodes_.size() >= MIN_PARALLEL_NODES))
+		{
+			for (auto& level : culling_levels_)
+			{
+				level.clear();
+			}
+			for (auto* sn : all_scene_nodes_)
+			{
+				size_t depth = 0;
+				for (auto const * parent = sn->Parent(); parent != nullptr; parent = parent->Parent())
+				{
+					++ depth;
+				}
+				if (depth >= culling_levels_.size())
+				{
+					culling_levels_.resize(depth + 1);
+				}
+				culling_levels_[depth].push_back(sn);
+			}
+
+			auto& js = Context::Instance().JobSystemInstance();
+			for (auto const & level : culling_levels_)
+			{
+				js.ParallelFor(0, static_cast<uint32_t>(level.size()), GRAIN_SIZE,
+					[this, &level, &viewport](uint32_t begin, uint32_t end)
+					{
+						for (uint32_t i = begin; i < end; ++ i)
+						{
+							this->ClipNode(*level[i], viewport);
+						}
+					});
+			}
+		}
+		else
+		{
+			for (auto* sn : all_scene_nodes_)
+			{
+				this->ClipNode(*sn, viewport);
+			}
+		}
+	}
+
+	void SceneManager::ClipNode(SceneNode& node, Viewport const & viewport)
+	{
 		uint32_t const num_cameras = viewport.NumCameras();
 
-		for (auto* sn : all_scene_nodes_)
+		node.FillVisibleMark(BoundOverlap::No);
+		if (node.Visible())
 		{
-			auto& node = *sn;
-			node.FillVisibleMark(BoundOverlap::No);
-			if (node.Visible())
+			if (node.Updated())
 			{
-				if (node.Updated())
+				uint32_t const attr = node.Attrib();
+
+				for (uint32_t i = 0; i < num_cameras; ++i)
 				{
-					uint32_t const attr = node.Attrib();
+					float4x4 const& view_proj = camera_view_projs_[i];
 
-					for (uint32_t i = 0; i < num_cameras; ++i)
+					auto visible = this->VisibleTestFromParent(node, i);
+					if (BoundOverlap::Partial == visible)
 					{
-						auto const& camera = *viewport.Camera(i);
-						float4x4 const& view_proj = camera_view_projs_[i];
+						if (attr & SceneNode::SOA_Cullable)
+						{
+							visible = (small_obj_threshold_ <= 0) ||
+											  ((MathLib::ortho_area(camera_forward_vecs_[i], node.PosBoundWS()) > small_obj_threshold_) &&
+												  (MathLib::perspective_area(camera_eye_poses_[i], view_proj, node.PosBoundWS()) >
+													  small_obj_threshold_))
+										  ? BoundOverlap::Yes
+										  : BoundOverlap::No;
+						}
+						else
+						{
+							visible = BoundOverlap::Yes;
+						}
 
-						auto visible = this->VisibleTestFromParent(node, i);
-						if (BoundOverlap::Partial == visible)
+						if (!viewport.Camera(i)->OmniDirectionalMode() && (attr & SceneNode::SOA_Cullable) && (BoundOverlap::Yes == visible))
 						{
-							if (attr & SceneNode::SOA_Cullable)
+							uint32_t const bound_index = pos_bounds_ws_ ? node.PosBoundWSIndex(*pos_bounds_ws_) : ~0U;
+							if (bound_index < pos_bound_overlaps_[i].size())
 							{
-								visible = (small_obj_threshold_ <= 0) ||
-												  ((MathLib::ortho_area(camera.ForwardVec(), node.PosBoundWS()) > small_obj_threshold_) &&
-													  (MathLib::perspective_area(camera.EyePos(), view_proj, node.PosBoundWS()) >
-														  small_obj_threshold_))
-											  ? BoundOverlap::Yes
-											  : BoundOverlap::No;
+								visible = pos_bound_overlaps_[i][bound_index];
 							}
 							else
-							{
-								visible = BoundOverlap::Yes;
-							}
-
-							if (!camera.OmniDirectionalMode() && (attr & SceneNode::SOA_Cullable) && (BoundOverlap::Yes == visible))
 							{
 								visible = camera_frustums_[i]->Intersect(node.PosBoundWS());
 							}
 						}
-
-						node.VisibleMark(i, visible);
 					}
+
+					node.VisibleMark(i, visible);
 				}
-				else
+			}
+			else
+			{
+				for (uint32_t i = 0; i < num_cameras; ++i)
 				{
-					for (uint32_t i = 0; i < num_cameras; ++i)
-					{
-						node.VisibleMark(i, BoundOverlap::Yes);
-					}
+					node.VisibleMark(i, BoundOverlap::Yes);
 				}
 			}
 		}
@@ -252,22 +333,8 @@ namespace KlayGE
 
 			if (add)
 			{
-				RenderTechnique const * obj_tech = obj->GetRenderTechnique();
-				BOOST_ASSERT(obj_tech);
-				bool found = false;
-				for (auto& items : render_queue_)
-				{
-					if (items.first == obj_tech)
-					{
-						items.second.push_back(obj);
-						found = true;
-						break;
-					}
-				}
-				if (!found)
-				{
-					render_queue_.emplace_back(obj_tech, std::vector<Renderable*>(1, obj));
-				}
+				BOOST_ASSERT(obj->GetRenderTechnique());
+				render_queue_.push_back(obj);
 			}
 		}
 	}
@@ -405,7 +472,7 @@ namespace KlayGE
 
 				return true;
 			});
-			scene_root_.UpdatePosBoundSubtree();
+			scene_root_.UpdatePosBoundSubtree(pos_bounds_ws_);
 
 			overlay_root_.ClearChildren();
 		}
@@ -470,19 +537,7 @@ namespace KlayGE
 		}
 		if (!(urt & App3DFramework::URV_Overlay))
 		{
-			scene_root_.Traverse([num_cameras](SceneNode& node)
-				{
-					uint32_t const attr = node.Attrib();
-					if ((node.Parent() == nullptr)
-						|| (node.Visible() && (!(attr & SceneNode::SOA_Cullable) || (attr & SceneNode::SOA_Moveable))))
-					{
-						for (uint32_t i = 0; i < num_cameras; ++i)
-						{
-							node.VisibleMark(i, BoundOverlap::Partial);
-						}
-					}
-					return node.Visible();
-				});
+			this->MarkUncullableNodes(num_cameras);
 		}
 		if (urt & App3DFramework::URV_NeedFlush)
 		{
@@ -512,11 +567,7 @@ namespace KlayGE
 			auto vmiter = visible_marks_map_.find(seed);
 			if (vmiter == visible_marks_map_.end())
 			{
-				camera_view_projs_.resize(viewport.NumCameras());
-				for (uint32_t i = 0; i < viewport.NumCameras(); ++i)
-				{
-					camera_view_projs_[i] = viewport.Camera(i)->ViewProjMatrix();
-				}
+				this->SnapshotCameras(viewport);
 				auto drl = Context::Instance().DeferredRenderingLayerInstance();
 				if (drl)
 				{
@@ -612,64 +663,14 @@ namespace KlayGE
 			}
 		}
 
-		std::sort(render_queue_.begin(), render_queue_.end(),
-			[](std::pair<RenderTechnique const *, std::vector<Renderable*>> const & lhs,
-				std::pair<RenderTechnique const *, std::vector<Renderable*>> const & rhs)
-			{
-				BOOST_ASSERT(lhs.first);
-				BOOST_ASSERT(rhs.first);
-
-				return lhs.first->Weight() < rhs.first->Weight();
-			});
+		this->SortRenderQueue(viewport);
 
-		float4 view_mat_z;
-		if (viewport.NumCameras() == 1)
+		for (auto* renderable : render_queue_)
 		{
-			view_mat_z = viewport.Camera(0)->ViewMatrix().Col(2);
-		}
-		for (auto& items : render_queue_)
-		{
-			if ((viewport.NumCameras() == 1) && !items.first->Transparent() && !items.first->HasDiscard() && (items.second.size() > 1))
-			{
-				std::vector<std::pair<float, uint32_t>> min_depths(items.second.size());
-				for (size_t j = 0; j < min_depths.size(); ++ j)
-				{
-					Renderable const * renderable = items.second[j];
-					AABBox const & box = renderable->PosBound();
-					uint32_t const num = renderable->NumInstances();
-					float md = 1e10f;
-					for (uint32_t i = 0; i < num; ++ i)
-					{
-						float4x4 const & mat = renderable->GetInstance(i)->TransformToWorld();
-						float4 const zvec(MathLib::dot(mat.Row(0), view_mat_z),
-							MathLib::dot(mat.Row(1), view_mat_z), MathLib::dot(mat.Row(2), view_mat_z),
-							MathLib::dot(mat.Row(3), view_mat_z));
-						for (int k = 0; k < 8; ++ k)
-						{
-							float3 const v = box.Corner(k);
-							md = std::min(md, v.x() * zvec.x() + v.y() * zvec.y() + v.z() * zvec.z() + zvec.w());
-						}
-					}
-
-					min_depths[j] = std::make_pair(md, static_cast<uint32_t>(j));
-				}
-
-				std::sort(min_depths.begin(), min_depths.end());
-
-				std::vector<Renderable*> sorted_items(min_depths.size());
-				for (size_t j = 0; j < min_depths.size(); ++ j)
-				{
-					sorted_items[j] = items.second[min_depths[j].second];
-				}
-				items.second.swap(sorted_items);
-			}
-
-			for (auto const & item : items.second)
-			{
-				item->Render();
-			}
-			num_renderables_rendered_ += static_cast<uint32_t>(items.second.size());
+			renderable->Render();
+			num_frame_draw_calls_saved_ += renderable->NumDrawsSaved();
 		}
+		num_renderables_rendered_ += static_cast<uint32_t>(render_queue_.size());
 		render_queue_.resize(0);
 
 		num_primitives_rendered_ += re.NumPrimitivesJustRendered();
@@ -714,11 +715,190 @@ namespace KlayGE
 		return num_draw_calls_;
 	}
 
+	uint32_t SceneManager::NumDrawCallsSaved() const
+	{
+		return num_draw_calls_saved_;
+	}
+
 	uint32_t SceneManager::NumDispatchCalls() const
 	{
 		return num_dispatch_calls_;
 	}
 
+	void SceneManager::CullScene()
+	{
+		std::lock_guard<std::mutex> lock(update_mutex_);
+
+		RenderEngine& re = Context::Instance().RenderFactoryInstance().RenderEngineInstance();
+		auto const& viewport = *re.CurFrameBuffer()->Viewport();
+		uint32_t const num_cameras = viewport.NumCameras();
+
+		scene_root_.Traverse([](SceneNode& node)
+			{
+				node.UpdateTransforms();
+				return true;
+			});
+		scene_root_.UpdatePosBoundSubtree(pos_bounds_ws_);
+
+		all_scene_nodes_.clear();
+		scene_root_.Traverse([this](SceneNode& node)
+			{
+				all_scene_nodes_.push_back(&node);
+				node.FillVisibleMark(BoundOverlap::No);
+				return true;
+			});
+		this->MarkUncullableNodes(num_cameras);
+
+		camera_frustums_.resize(num_cameras);
+		for (uint32_t i = 0; i < num_cameras; ++i)
+		{
+			camera_frustums_[i] = &viewport.Camera(i)->ViewFrustum();
+		}
+		this->SnapshotCameras(viewport);
+
+		this->ClipScene();
+
+		all_scene_nodes_.clear();
+	}
+
+	void SceneManager::MarkUncullableNodes(uint32_t num_cameras)
+	{
+		scene_root_.Traverse([num_cameras](SceneNode& node)
+			{
+				uint32_t const attr = node.Attrib();
+				if ((node.Parent() == nullptr)
+					|| (node.Visible() && (!(attr & SceneNode::SOA_Cullable) || (attr & SceneNode::SOA_Moveable))))
+				{
+					for (uint32_t i = 0; i < num_cameras; ++i)
+					{
+						node.VisibleMark(i, BoundOverlap::Partial);
+					}
+				}
+				return node.Visible();
+			});
+	}
+
+	void SceneManager::SnapshotCameras(Viewport const & viewport)
+	{
+		camera_view_projs_.resize(viewport.NumCameras());
+		camera_eye_poses_.resize(viewport.NumCameras());
+		camera_forward_vecs_.resize(viewport.NumCameras());
+		for (uint32_t i = 0; i < viewport.NumCameras(); ++i)
+		{
+			auto const& camera = *viewport.Camera(i);
+			camera_view_projs_[i] = camera.ViewProjMatrix();
+			camera_eye_poses_[i] = camera.EyePos();
+			camera_forward_vecs_[i] = camera.ForwardVec();
+		}
+	}
+
+	void SceneManager::SortRenderQueue(Viewport const & viewport)
+	{
+		uint32_t const num_renderables = static_cast<uint32_t>(render_queue_.size());
+		if (num_renderables == 0)
+		{
+			return;
+		}
+
+		// Dense ids of techniques, materials and layouts, in the order of their first appearance
+		queue_techs_.clear();
+		queue_tech_ids_.clear();
+		queue_mtl_ids_.clear();
+		queue_layout_ids_.clear();
+		queue_tech_indices_.resize(num_renderables);
+		queue_state_ids_.resize(num_renderables);
+		for (uint32_t i = 0; i < num_renderables; ++ i)
+		{
+			Renderable const & renderable = *render_queue_[i];
+
+			RenderTechnique const * tech = renderable.GetRenderTechnique();
+			auto const tech_iter = queue_tech_ids_.try_emplace(tech, static_cast<uint32_t>(queue_techs_.size())).first;
+			if (tech_iter->second == queue_techs_.size())
+			{
+				queue_techs_.push_back(tech);
+			}
+			queue_tech_indices_[i] = tech_iter->second;
+
+			uint32_t const mtl_id = queue_mtl_ids_.try_emplace(renderable.Material().get(),
+				static_cast<uint32_t>(queue_mtl_ids_.size())).first->second;
+			uint32_t const layout_id = queue_layout_ids_.try_emplace(&renderable.GetRenderLayout(),
+				static_cast<uint32_t>(queue_layout_ids_.size())).first->second;
+			queue_state_ids_[i] = ((mtl_id & 0xFFF) << 12) | (layout_id & 0xFFF);
+		}
+
+		// Techniques are drawn in the order of their weights
+		uint32_t const num_techs = static_cast<uint32_t>(queue_techs_.size());
+		queue_tech_ranks_.resize(num_techs);
+		std::iota(queue_tech_ranks_.begin(), queue_tech_ranks_.end(), 0U);
+		std::stable_sort(queue_tech_ranks_.begin(), queue_tech_ranks_.end(), [this](uint32_t lhs, uint32_t rhs)
+			{
+				return queue_techs_[lhs]->Weight() < queue_techs_[rhs]->Weight();
+			});
+		queue_tech_orders_.resize(num_techs);
+		for (uint32_t i = 0; i < num_techs; ++ i)
+		{
+			queue_tech_orders_[queue_tech_ranks_[i]] = i;
+		}
+
+		// 64-bit key: technique rank (16 bits) | quantized depth (24 bits) | material (12 bits) | layout (12 bits).
+		// Opaque objects without discard are drawn front to back when there is only one camera. Transparent ones only get
+		//  the technique rank, so the stable sort keeps them in the order they were added, as blending needs.
+		bool const depth_sort = (viewport.NumCameras() == 1);
+		float4 const view_mat_z = depth_sort ? viewport.Camera(0)->ViewMatrix().Col(2) : float4(0, 0, 0, 0);
+		queue_keys_.resize(num_renderables);
+		Context::Instance().JobSystemInstance().ParallelFor(0, num_renderables, 256,
+			[this, depth_sort, &view_mat_z](uint32_t begin, uint32_t end)
+			{
+				for (uint32_t i = begin; i < end; ++ i)
+				{
+					Renderable const & renderable = *render_queue_[i];
+					uint32_t const tech_index = queue_tech_indices_[i];
+					RenderTechnique const & tech = *queue_techs_[tech_index];
+
+					uint64_t key = static_cast<uint64_t>(queue_tech_orders_[tech_index]) << 48;
+					if (!tech.Transparent())
+					{
+						key |= queue_state_ids_[i];
+					}
+					if (depth_sort && !tech.Transparent() && !tech.HasDiscard())
+					{
+						// The nearest corner of the transformed box, from its center and extent
+						AABBox const & box = renderable.PosBound();
+						float3 const center = box.Center();
+						float3 const half_size = box.HalfSize();
+						float md = 1e10f;
+						for (uint32_t j = 0; j < renderable.NumInstances(); ++ j)
+						{
+							float4x4 const & mat = renderable.GetInstance(j)->TransformToWorld();
+							float4 const zvec(MathLib::dot(mat.Row(0), view_mat_z),
+								MathLib::dot(mat.Row(1), view_mat_z), MathLib::dot(mat.Row(2), view_mat_z),
+								MathLib::dot(mat.Row(3), view_mat_z));
+							float const center_depth = center.x() * zvec.x() + center.y() * zvec.y() + center.z() * zvec.z() + zvec.w();
+							float const extent = half_size.x() * std::abs(zvec.x()) + half_size.y() * std::abs(zvec.y())
+								+ half_size.z() * std::abs(zvec.z());
+							md = std::min(md, center_depth - extent);
+						}
+
+						key |= static_cast<uint64_t>(FloatToSortableKey(md) >> 8) << 24;
+					}
+					queue_keys_[i] = key;
+				}
+			});
+
+		queue_indices_.resize(num_renderables);
+		std::iota(queue_indices_.begin(), queue_indices_.end(), 0U);
+		queue_tmp_keys_.resize(num_renderables);
+		queue_tmp_indices_.resize(num_renderables);
+		RadixSort(queue_keys_.data(), queue_indices_.data(), num_renderables, queue_tmp_keys_.data(), queue_tmp_indices_.data());
+
+		sorted_render_queue_.resize(num_renderables);
+		for (uint32_t i = 0; i < num_renderables; ++ i)
+		{
+			sorted_render_queue_[i] = render_queue_[queue_indices_[i]];
+		}
+		render_queue_.swap(sorted_render_queue_);
+	}
+
 	void SceneManager::FlushScene()
 	{
 		RenderEngine& re = Context::Instance().RenderFactoryInstance().RenderEngineInstance();
@@ -758,6 +938,8 @@ namespace KlayGE
 		re.ConvertToDisplay();
 
 		num_draw_calls_ = re.NumDrawsJustCalled();
+		num_draw_calls_saved_ = num_frame_draw_calls_saved_;
+		num_frame_draw_calls_saved_ = 0;
 		num_dispatch_calls_ = re.NumDispatchesJustCalled();
 	}
 
@@ -811,13 +993,10 @@ namespace KlayGE
 				{
 					if (small_obj_threshold_ > 0)
 					{
-						auto& re = Context::Instance().RenderFactoryInstance().RenderEngineInstance();
-						auto const& viewport = *re.CurFrameBuffer()->Viewport();
-						auto const& camera = *viewport.Camera(camera_index);
 						float4x4 const& view_proj = camera_view_projs_[camera_index];
 
-						visible = ((MathLib::ortho_area(camera.ForwardVec(), node.PosBoundWS()) > small_obj_threshold_)
-							&& (MathLib::perspective_area(camera.EyePos(), view_proj, node.PosBoundWS()) > small_obj_threshold_))
+						visible = ((MathLib::ortho_area(camera_forward_vecs_[camera_index], node.PosBoundWS()) > small_obj_threshold_)
+							&& (MathLib::perspective_area(camera_eye_poses_[camera_index], view_proj, node.PosBoundWS()) > small_obj_threshold_))
 							? parent_bo : BoundOverlap::No;
 					}
 					else
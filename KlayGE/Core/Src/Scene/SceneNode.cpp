@@ -32,6 +32,7 @@
 #include <KlayGE/SceneManager.hpp>
 #include <KlayGE/Context.hpp>
 #include <KFL/Math.hpp>
+#include <KFL/SIMDMath.hpp>
 
 #include <string_view>
 
@@ -41,6 +42,56 @@
 
 namespace KlayGE
 {
+	uint32_t PosBoundWSStore::Allocate()
+	{
+		{
+			std::lock_guard<std::mutex> lock(free_slots_mutex_);
+			if (!free_slots_.empty())
+			{
+				uint32_t const index = free_slots_.back();
+				free_slots_.pop_back();
+				return index;
+			}
+		}
+
+		uint32_t const index = this->Size();
+		for (auto& coord : coords_)
+		{
+			coord.resize(index + 4, 0);
+		}
+		{
+			std::lock_guard<std::mutex> lock(free_slots_mutex_);
+			for (uint32_t i = 3; i > 0; -- i)
+			{
+				free_slots_.push_back(index + i);
+			}
+		}
+		return index;
+	}
+
+	void PosBoundWSStore::Free(uint32_t index)
+	{
+		std::lock_guard<std::mutex> lock(free_slots_mutex_);
+		free_slots_.push_back(index);
+	}
+
+	void PosBoundWSStore::Update(uint32_t index, AABBox const & aabb)
+	{
+		coords_[0][index] = aabb.Min().x();
+		coords_[1][index] = aabb.Min().y();
+		coords_[2][index] = aabb.Min().z();
+		coords_[3][index] = aabb.Max().x();
+		coords_[4][index] = aabb.Max().y();
+		coords_[5][index] = aabb.Max().z();
+	}
+
+	void PosBoundWSStore::Intersect(Frustum const & frustum, BoundOverlap* results) const
+	{
+		SIMDMathLib::IntersectAABBsFrustum(coords_[0].data(), coords_[1].data(), coords_[2].data(),
+			coords_[3].data(), coords_[4].data(), coords_[5].data(), this->Size(), frustum, results);
+	}
+
+
 	SceneNode::SceneNode(uint32_t attrib)
 		: attrib_(attrib)
 	{
@@ -73,6 +124,11 @@ namespace KlayGE
 
 	SceneNode::~SceneNode()
 	{
+		if (auto store = pos_bound_store_weak_.lock())
+		{
+			store->Free(pos_bound_index_);
+		}
+
 		for (auto& component : components_)
 		{
 			component->BindSceneNode(nullptr);
@@ -660,10 +716,28 @@ namespace KlayGE
 	}
 
 	void SceneNode::UpdatePosBoundSubtree()
+	{
+		this->UpdatePosBoundSubtree(PosBoundWSStorePtr());
+	}
+
+	void SceneNode::UpdatePosBoundSubtree(PosBoundWSStorePtr const & store)
 	{
 		for (auto const & child : children_)
 		{
-			child->UpdatePosBoundSubtree();
+			child->UpdatePosBoundSubtree(store);
+		}
+
+		if (store && pos_aabb_ws_ && (pos_bound_store_ != store.get()))
+		{
+			if (auto old_store = pos_bound_store_weak_.lock())
+			{
+				old_store->Free(pos_bound_index_);
+			}
+
+			pos_bound_store_ = store.get();
+			pos_bound_store_weak_ = store;
+			pos_bound_index_ = store->Allocate();
+			pos_bound_store_dirty_ = true;
 		}
 
 		if (pos_aabb_dirty_)
@@ -696,10 +770,19 @@ namespace KlayGE
 				}
 
 				*pos_aabb_ws_ = MathLib::transform_aabb(*pos_aabb_os_, xform_to_world_);
+				pos_bound_store_dirty_ = (pos_bound_store_ != nullptr);
 			}
 
 			pos_aabb_dirty_ = false;
 		}
+
+		// Without a store, the call may come from a loading thread while the scene manager resizes the store, so the write waits
+		//  for its next pass
+		if (store && pos_bound_store_dirty_ && (pos_bound_store_ == store.get()))
+		{
+			store->Update(pos_bound_index_, *pos_aabb_ws_);
+			pos_bound_store_dirty_ = false;
+		}
 	}
 
 	void SceneNode::EmitSceneChanged()
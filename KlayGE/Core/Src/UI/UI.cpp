@@ -31,7 +31,7 @@
 #include <KlayGE/SceneNode.hpp>
 #include <KFL/XMLDom.hpp>
 #include <KlayGE/Font.hpp>
-#include <KlayGE/TransientBuffer.hpp>
+#include <KlayGE/GraphicsBuffer.hpp>
 #include <KFL/Hash.hpp>
 #include <KlayGE/App3D.hpp>
 #include <KlayGE/Window.hpp>
@@ -47,6 +47,9 @@ namespace
 {
 	std::mutex singleton_mutex;
 
+	// 16-bit indices reach 0x10000 vertices, and 0xFFFF is the restart index. Larger batches are split into several draws.
+	uint32_t const MAX_UI_QUADS_PER_DRAW = 0xFFFF / 4;
+
 	bool ReadBool(KlayGE::XMLNode const& node, std::string const & name, bool default_val)
 	{
 		bool ret = default_val;
@@ -95,14 +98,9 @@ namespace KlayGE
 				rls_[0]->TopologyType(RenderLayout::TT_TriangleList);
 			}
 
-			uint32_t const INDEX_PER_QUAD = restart_ ? 5 : 6;
 			uint32_t const INIT_NUM_QUAD = 1024;
-			tb_vb_ = MakeUniquePtr<TransientBuffer>(static_cast<uint32_t>(INIT_NUM_QUAD * 4 * sizeof(UIManager::VertexFormat)), TransientBuffer::BF_Vertex);
-			tb_ib_ = MakeUniquePtr<TransientBuffer>(static_cast<uint32_t>(INIT_NUM_QUAD * INDEX_PER_QUAD * sizeof(uint16_t)), TransientBuffer::BF_Index);
-
-			rls_[0]->BindVertexStream(tb_vb_->GetBuffer(), MakeSpan({VertexElement(VEU_Position, 0, EF_BGR32F),
-				VertexElement(VEU_Diffuse, 0, EF_ABGR32F), VertexElement(VEU_TextureCoord, 0, EF_GR32F)}));
-			rls_[0]->BindIndexStream(tb_ib_->GetBuffer(), EF_R16UI);
+			vertices_.reserve(INIT_NUM_QUAD * 4);
+			uploaded_vertices_.reserve(INIT_NUM_QUAD * 4);
 
 			effect_ = effect;
 			if (texture)
@@ -121,7 +119,7 @@ namespace KlayGE
 
 		bool Empty() const
 		{
-			return tb_ib_sub_allocs_.empty();
+			return vertices_.empty();
 		}
 
 		void OnRenderBegin()
@@ -137,20 +135,18 @@ namespace KlayGE
 			*half_width_height_ep_ = float2(half_width, half_height);
 			*dpi_scale_ep_ = Context::Instance().AppInstance().MainWnd()->DPIScale();
 
-			tb_vb_->EnsureDataReady();
-			tb_ib_->EnsureDataReady();
-
-			rls_[0]->SetVertexStream(0, tb_vb_->GetBuffer());
-			rls_[0]->BindIndexStream(tb_ib_->GetBuffer(), EF_R16UI);
+			// The quads are retained in the vertex buffer. Only upload them when they differ from the last frame.
+			if ((vertices_.size() != uploaded_vertices_.size())
+				|| (std::memcmp(vertices_.data(), uploaded_vertices_.data(), vertices_.size() * sizeof(vertices_[0])) != 0))
+			{
+				this->UpdateBuffers();
+			}
 		}
-		
+
 		void OnRenderEnd()
 		{
-			tb_vb_->OnPresent();
-			tb_ib_->OnPresent();
-
-			tb_vb_sub_allocs_.clear();
-			tb_ib_sub_allocs_.clear();
+			uploaded_vertices_.swap(vertices_);
+			vertices_.clear();
 		}
 
 		void Render()
@@ -159,64 +155,84 @@ namespace KlayGE
 
 			this->OnRenderBegin();
 
-			BOOST_ASSERT(tb_vb_sub_allocs_.size() == tb_ib_sub_allocs_.size());
-
-			for (size_t i = 0; i < tb_vb_sub_allocs_.size(); ++ i)
+			// All quads of a texture are drawn in one call, unless they are more than the 16-bit indices can reach
+			uint32_t const num_quads = static_cast<uint32_t>(vertices_.size() / 4);
+			for (uint32_t first_quad = 0; first_quad < num_quads; first_quad += MAX_UI_QUADS_PER_DRAW)
 			{
-				uint32_t vert_length = tb_vb_sub_allocs_[i].length_;
-				uint32_t const ind_offset = tb_ib_sub_allocs_[i].offset_;
-				uint32_t ind_length = tb_ib_sub_allocs_[i].length_;
-
-				while ((i + 1 < tb_vb_sub_allocs_.size())
-					&& (tb_vb_sub_allocs_[i].offset_ + tb_vb_sub_allocs_[i].length_ == tb_vb_sub_allocs_[i + 1].offset_)
-					&& (tb_ib_sub_allocs_[i].offset_ + tb_ib_sub_allocs_[i].length_ == tb_ib_sub_allocs_[i + 1].offset_))
-				{
-					vert_length += tb_vb_sub_allocs_[i + 1].length_;
-					ind_length += tb_ib_sub_allocs_[i + 1].length_;
-					++ i;
-				}
-
-				rls_[0]->NumVertices(vert_length / sizeof(UIManager::VertexFormat));
-				rls_[0]->StartIndexLocation(ind_offset / sizeof(uint16_t));
-				rls_[0]->NumIndices(ind_length / sizeof(uint16_t));
+				uint32_t const num_draw_quads = std::min(num_quads - first_quad, MAX_UI_QUADS_PER_DRAW);
+				rls_[0]->StartVertexLocation(first_quad * 4);
+				rls_[0]->NumVertices(num_draw_quads * 4);
+				rls_[0]->StartIndexLocation(0);
+				rls_[0]->NumIndices(num_draw_quads * (restart_ ? 5 : 6));
 
 				re.Render(*this->GetRenderEffect(), *this->GetRenderTechnique(), *rls_[0]);
 			}
 
-			for (size_t i = 0; i < tb_vb_sub_allocs_.size(); ++ i)
-			{
-				tb_vb_->Dealloc(tb_vb_sub_allocs_[i]);
-				tb_ib_->Dealloc(tb_ib_sub_allocs_[i]);
-			}
-
 			this->OnRenderEnd();
 		}
 
-		void AddQuad(std::vector<UIManager::VertexFormat> const & vertices)
+		void AddQuad(UIManager::VertexFormat const * vertices)
 		{
-			tb_vb_sub_allocs_.push_back(tb_vb_->Alloc(static_cast<uint32_t>(vertices.size() * sizeof(vertices[0])), &vertices[0]));
-			
-			uint16_t const last_index = static_cast<uint16_t>(tb_vb_sub_allocs_.back().offset_ / sizeof(UIManager::VertexFormat));
-			std::vector<uint16_t> indices;
-			indices.resize(restart_ ? 5 : 6);
-			indices[0] = last_index + 0;
-			indices[1] = last_index + 1;
-			if (restart_)
+			vertices_.insert(vertices_.end(), vertices, vertices + 4);
+		}
+
+	private:
+		void UpdateBuffers()
+		{
+			RenderFactory& rf = Context::Instance().RenderFactoryInstance();
+
+			uint32_t const num_quads = static_cast<uint32_t>(vertices_.size() / 4);
+			if (num_quads > quad_capacity_)
 			{
-				indices[2] = last_index + 3;
-				indices[3] = last_index + 2;
-				indices[4] = 0xFFFF;
+				uint32_t const old_index_capacity = std::min(quad_capacity_, MAX_UI_QUADS_PER_DRAW);
+				quad_capacity_ = std::max(num_quads, std::max(quad_capacity_ * 2, 1024U));
+
+				vb_ = rf.MakeVertexBuffer(BU_Dynamic, EAH_CPU_Write | EAH_GPU_Read,
+					static_cast<uint32_t>(quad_capacity_ * 4 * sizeof(UIManager::VertexFormat)), nullptr);
+				rls_[0]->BindVertexStream(vb_, MakeSpan({VertexElement(VEU_Position, 0, EF_BGR32F),
+					VertexElement(VEU_Diffuse, 0, EF_ABGR32F), VertexElement(VEU_TextureCoord, 0, EF_GR32F)}));
+
+				// The indices of quads never change. Every draw starts from its own base vertex, so they only cover one draw.
+				uint32_t const index_capacity = std::min(quad_capacity_, MAX_UI_QUADS_PER_DRAW);
+				if (index_capacity > old_index_capacity)
+				{
+					this->UpdateIndices(index_capacity);
+				}
 			}
-			else
+
+			GraphicsBuffer::Mapper mapper(*vb_, BA_Write_Only);
+			std::memcpy(mapper.Pointer<UIManager::VertexFormat>(), vertices_.data(), vertices_.size() * sizeof(vertices_[0]));
+		}
+
+		void UpdateIndices(uint32_t num_quads)
+		{
+			RenderFactory& rf = Context::Instance().RenderFactoryInstance();
+
+			uint32_t const index_per_quad = restart_ ? 5 : 6;
+			std::vector<uint16_t> indices(num_quads * index_per_quad);
+			for (uint32_t i = 0; i < num_quads; ++ i)
 			{
-				indices[2] = last_index + 2;
-				indices[3] = last_index + 2;
-				indices[4] = last_index + 3;
-				indices[5] = last_index + 0;
+				uint16_t const base = static_cast<uint16_t>(i * 4);
+				uint16_t* quad_indices = &indices[i * index_per_quad];
+				quad_indices[0] = base + 0;
+				quad_indices[1] = base + 1;
+				if (restart_)
+				{
+					quad_indices[2] = base + 3;
+					quad_indices[3] = base + 2;
+					quad_indices[4] = 0xFFFF;
+				}
+				else
+				{
+					quad_indices[2] = base + 2;
+					quad_indices[3] = base + 2;
+					quad_indices[4] = base + 3;
+					quad_indices[5] = base + 0;
+				}
 			}
-			BOOST_ASSERT(last_index + 3 <= 0xFFFF);
-
-			tb_ib_sub_allocs_.push_back(tb_ib_->Alloc(static_cast<uint32_t>(indices.size() * sizeof(indices[0])), &indices[0]));
+			GraphicsBufferPtr ib = rf.MakeIndexBuffer(BU_Static, EAH_GPU_Read | EAH_Immutable,
+				static_cast<uint32_t>(indices.size() * sizeof(indices[0])), indices.data());
+			rls_[0]->BindIndexStream(ib, EF_R16UI);
 		}
 
 	private:
@@ -228,10 +244,11 @@ namespace KlayGE
 
 		TexturePtr texture_;
 
-		std::unique_ptr<TransientBuffer> tb_vb_;
-		std::unique_ptr<TransientBuffer> tb_ib_;
-		std::vector<SubAlloc> tb_vb_sub_allocs_;
-		std::vector<SubAlloc> tb_ib_sub_allocs_;
+		GraphicsBufferPtr vb_;
+		uint32_t quad_capacity_ = 0;
+
+		std::vector<UIManager::VertexFormat> vertices_;
+		std::vector<UIManager::VertexFormat> uploaded_vertices_;
 	};
 
 
@@ -892,12 +909,12 @@ namespace KlayGE
 			dialog->Render();
 		}
 
+		auto& overlay_root = Context::Instance().SceneManagerInstance().OverlayRootNode();
 		for (auto const & rect : rects_)
 		{
-			if (!checked_pointer_cast<UIRectRenderable>(rect.second)->Empty())
+			if (!rect.second.first->Empty())
 			{
-				auto ui_rect_obj = MakeSharedPtr<SceneNode>(MakeSharedPtr<RenderableComponent>(rect.second), SceneNode::SOA_Overlay);
-				Context::Instance().SceneManagerInstance().OverlayRootNode().AddChild(ui_rect_obj);
+				overlay_root.AddChild(rect.second.second);
 			}
 		}
 		for (auto const & str : strings_)
@@ -926,56 +943,41 @@ namespace KlayGE
 			texcoord = Rect(0, 0, 0, 0);
 		}
 
-		std::shared_ptr<UIRectRenderable> renderable;
-		if (rects_.find(texture) == rects_.end())
-		{
-			renderable = MakeSharedPtr<UIRectRenderable>(texture, effect_);
-			rects_[texture] = renderable;
-		}
-		else
+		VertexFormat const vertices[] =
 		{
-			renderable = checked_pointer_cast<UIRectRenderable>(rects_[texture]);
-		}
-		BOOST_ASSERT(renderable);
-
-		std::vector<VertexFormat> vertices(4);
-		vertices[0] = VertexFormat(pos + float3(0, 0, 0),
-			clrs[0], float2(texcoord.left(), texcoord.top()));
-		vertices[1] = VertexFormat(pos + float3(width, 0, 0),
-			clrs[1], float2(texcoord.right(), texcoord.top()));
-		vertices[2] = VertexFormat(pos + float3(width, height, 0),
-			clrs[2], float2(texcoord.right(), texcoord.bottom()));
-		vertices[3] = VertexFormat(pos + float3(0, height, 0),
-			clrs[3], float2(texcoord.left(), texcoord.bottom()));
+			VertexFormat(pos + float3(0, 0, 0), clrs[0], float2(texcoord.left(), texcoord.top())),
+			VertexFormat(pos + float3(width, 0, 0), clrs[1], float2(texcoord.right(), texcoord.top())),
+			VertexFormat(pos + float3(width, height, 0), clrs[2], float2(texcoord.right(), texcoord.bottom())),
+			VertexFormat(pos + float3(0, height, 0), clrs[3], float2(texcoord.left(), texcoord.bottom()))
+		};
 
-		renderable->AddQuad(vertices);
+		this->RectRenderable(texture).AddQuad(vertices);
 	}
 
 	void UIManager::DrawQuad(float3 const & offset, VertexFormat const * vertices, TexturePtr const & texture)
 	{
-		std::shared_ptr<UIRectRenderable> renderable;
-		if (rects_.find(texture) == rects_.end())
-		{
-			renderable = MakeSharedPtr<UIRectRenderable>(texture, effect_);
-			rects_[texture] = renderable;
-		}
-		else
+		VertexFormat const verts[] =
 		{
-			renderable = checked_pointer_cast<UIRectRenderable>(rects_[texture]);
-		}
-		BOOST_ASSERT(renderable);
+			VertexFormat(offset + vertices[0].pos, vertices[0].clr, vertices[0].tex),
+			VertexFormat(offset + vertices[1].pos, vertices[1].clr, vertices[1].tex),
+			VertexFormat(offset + vertices[2].pos, vertices[2].clr, vertices[2].tex),
+			VertexFormat(offset + vertices[3].pos, vertices[3].clr, vertices[3].tex)
+		};
 
-		std::vector<VertexFormat> verts(4);
-		verts[0] = VertexFormat(offset + vertices[0].pos,
-			vertices[0].clr, vertices[0].tex);
-		verts[1] = VertexFormat(offset + vertices[1].pos,
-			vertices[1].clr, vertices[1].tex);
-		verts[2] = VertexFormat(offset + vertices[2].pos,
-			vertices[2].clr, vertices[2].tex);
-		verts[3] = VertexFormat(offset + vertices[3].pos,
-			vertices[3].clr, vertices[3].tex);
+		this->RectRenderable(texture).AddQuad(verts);
+	}
 
-		renderable->AddQuad(verts);
+	UIRectRenderable& UIManager::RectRenderable(TexturePtr const & texture)
+	{
+		auto iter = rects_.find(texture);
+		if (iter == rects_.end())
+		{
+			// The scene node is kept with the renderable and re-attached to the overlay root every frame
+			auto renderable = MakeSharedPtr<UIRectRenderable>(texture, effect_);
+			auto node = MakeSharedPtr<SceneNode>(MakeSharedPtr<RenderableComponent>(renderable), SceneNode::SOA_Overlay);
+			iter = rects_.emplace(texture, std::make_pair(std::move(renderable), std::move(node))).first;
+		}
+		return *iter->second.first;
 	}
 
 	void UIManager::DrawString(std::wstring const & strText, uint32_t font_index,
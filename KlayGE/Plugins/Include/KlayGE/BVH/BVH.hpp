@@ -0,0 +1,153 @@
+/**
+ * @file BVH.hpp
+ * @author Minmin Gong
+ *
+ * @section DESCRIPTION
+ *
+ * This source file is part of KlayGE
+ * For the latest info, see http://www.klayge.org
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * You may alternatively use this source under the terms of
+ * the KlayGE Proprietary License (KPL). You can obtained such a license
+ * from http://www.klayge.org/licensing/.
+ */
+
+#ifndef KLAYGE_PLUGINS_BVH_HPP
+#define KLAYGE_PLUGINS_BVH_HPP
+
+#pragma once
+
+#include <KlayGE/PreDeclare.hpp>
+#include <KlayGE/SceneNode.hpp>
+#include <KlayGE/SceneManager.hpp>
+#include <KFL/AABBox.hpp>
+
+#include <unordered_map>
+#include <vector>
+
+namespace KlayGE
+{
+	struct BVHStatistics
+	{
+		uint32_t num_builds = 0;
+		double last_build_time = 0;
+		double total_build_time = 0;
+		uint32_t num_refits = 0;
+		uint32_t num_inserts = 0;
+		uint32_t num_removes = 0;
+
+		// SAH cost of the tree, relative to the one right after the last build
+		float cost_ratio = 1;
+
+		uint32_t num_tree_nodes = 0;
+		uint32_t num_objs = 0;
+	};
+
+	// Scene manager on a bounding volume hierarchy of the cullable scene nodes. The tree is built with the surface area
+	// heuristic and refitted every frame when moveable nodes are in it. Added nodes are inserted where they increase the
+	// SAH cost the least, and removed nodes are unlinked. It's only rebuilt when all that degrades it too much.
+	class BVH final : public SceneManager
+	{
+	public:
+		BVH();
+
+		// Rebuild the tree once its SAH cost grows to this times the cost right after the build. 1.5 by default.
+		void RebuildThreshold(float ratio);
+		float RebuildThreshold() const;
+
+		void ClipScene() override;
+
+		BoundOverlap AABBVisible(AABBox const & aabb) const override;
+		BoundOverlap OBBVisible(OBBox const & obb) const override;
+		BoundOverlap SphereVisible(Sphere const & sphere) const override;
+		BoundOverlap FrustumVisible(Frustum const & frustum) const override;
+
+		// Queries on the bounds of the cullable nodes, as of the last ClipScene
+		// Nodes whose bounds are hit by the ray, the nearest first
+		void RayQuery(float3 const & orig, float3 const & dir, std::vector<SceneNode*>& nodes) const;
+		// Nodes whose bounds overlap the aabb
+		void AABBQuery(AABBox const & aabb, std::vector<SceneNode*>& nodes) const;
+
+		BVHStatistics Statistics() const;
+		void ResetStatistics();
+
+		void ClearObject() override;
+
+		void OnSceneChanged() override;
+
+	private:
+		void DoSuspend() override;
+		void DoResume() override;
+
+		void BuildTree();
+		void SyncTree();
+		void RefitTree();
+		void RefitNode(uint32_t index);
+		void RefitAncestors(uint32_t index);
+		float TreeCost() const;
+
+		void InsertObj(SceneNode* node);
+		void RemoveObj(uint32_t obj_index);
+
+		void NodeVisible(uint32_t index);
+		void MarkNodeObjs(uint32_t index, bool force);
+
+		// Whether the aabb is inside a tree node out of all the frustums
+		bool InInvisibleNode(AABBox const & aabb) const;
+
+	private:
+		// Children of an inner node are stored next to each other, always after their parent
+		struct bvh_node_t
+		{
+			AABBox bb;
+			uint32_t parent;
+			// Inner node: index of the first child. Leaf: index of the first object in objs_.
+			uint32_t first;
+			// 0 for inner nodes
+			uint32_t num_objs;
+			BoundOverlap visible;
+			bool dirty;
+		};
+
+		std::vector<bvh_node_t> nodes_;
+		std::vector<SceneNode*> objs_;
+		std::vector<uint32_t> obj_leaves_;
+		std::vector<uint32_t> moveable_objs_;
+		std::vector<uint32_t> obj_visit_stamps_;
+		uint32_t visit_stamp_;
+
+		// Free slots in objs_ and unlinked nodes are left behind by removals, until the next build
+		std::vector<uint32_t> free_objs_;
+		uint32_t num_dead_nodes_;
+		std::unordered_map<SceneNode const *, uint32_t> obj_indices_;
+		std::vector<uint32_t> obj_sync_stamps_;
+		uint32_t sync_stamp_;
+
+		// Sum of the SAH cost terms of all the nodes, not normalized
+		float curr_cost_;
+		float build_cost_;
+		float rebuild_threshold_;
+		bool rebuild_tree_;
+		bool sync_tree_;
+
+		BVHStatistics stats_;
+	};
+}
+
+#endif		// KLAYGE_PLUGINS_BVH_HPP
@@ -29,10 +29,25 @@
 #include <KlayGE/SceneManager.hpp>
 #include <KFL/AABBox.hpp>
 
+#include <unordered_map>
 #include <vector>
 
 namespace KlayGE
 {
+	struct OCTreeStatistics
+	{
+		uint32_t num_rebuilds = 0;
+		double last_rebuild_time = 0;
+		double total_rebuild_time = 0;
+
+		uint32_t num_inserts = 0;
+		uint32_t num_removes = 0;
+		uint32_t num_moves = 0;
+
+		uint32_t num_cells = 0;
+		uint32_t num_objs = 0;
+	};
+
 	class OCTree final : public SceneManager
 	{
 	public:
@@ -41,6 +56,12 @@ namespace KlayGE
 		void MaxTreeDepth(uint32_t max_tree_depth);
 		uint32_t MaxTreeDepth() const;
 
+		// Rebuild the whole tree on the next ClipScene, instead of updating it incrementally
+		void RebuildTree();
+
+		OCTreeStatistics Statistics() const;
+		void ResetStatistics();
+
 		void ClipScene() override;
 
 		BoundOverlap AABBVisible(AABBox const & aabb) const override;
@@ -56,7 +77,20 @@ namespace KlayGE
 		void DoSuspend() override;
 		void DoResume() override;
 
-		void DivideNode(size_t index, uint32_t curr_depth);
+		void BuildTree();
+		void SyncTree();
+		void UpdateMovedObjs();
+
+		bool InsertObj(SceneNode* node);
+		void RemoveObj(int obj_index);
+		void LinkObj(int obj_index, int cell_index);
+		void UnlinkObj(int obj_index);
+
+		int AllocateChildren(int cell_index);
+		void FreeChildren(int cell_index);
+
+		static bool IsTreeObj(SceneNode const & node);
+
 		void NodeVisible(size_t index);
 		void MarkNodeObjs(size_t index, bool force);
 
@@ -70,20 +104,46 @@ namespace KlayGE
 		OCTree& operator=(OCTree const & rhs);
 
 	private:
+		// A loose octree. The bb of a cell is twice the size of the cell itself, so an object only lives in one cell, and
+		// moving it a little doesn't touch the tree at all.
 		struct octree_node_t
 		{
 			AABBox bb;
+			float3 center;
+			float half_size;
+			uint32_t depth;
+
+			int parent_index;
 			int first_child_index;
 			BoundOverlap visible;
 
-			std::vector<SceneNode*> node_ptrs;
+			int first_obj_index;
+			uint32_t num_subtree_objs;
 		};
 
+		struct octree_obj_t
+		{
+			SceneNode* node;
+			int cell_index;
+			int prev_index;
+			int next_index;
+			uint32_t sync_stamp;
+		};
+
+		// Cells and objects are stored in flat pools. Children of a cell are 8 consecutive cells.
 		std::vector<octree_node_t> octree_;
+		std::vector<int> free_children_;
+		std::vector<octree_obj_t> objs_;
+		std::vector<int> free_objs_;
+		std::unordered_map<SceneNode const *, int> obj_indices_;
+		uint32_t sync_stamp_;
 
 		uint32_t max_tree_depth_;
 
 		bool rebuild_tree_;
+		bool sync_tree_;
+
+		OCTreeStatistics stats_;
 
 #ifdef KLAYGE_DRAW_NODES
 		RenderablePtr node_renderable_;
@@ -32,8 +32,9 @@
 
 #include <KFL/CXX17/filesystem.hpp>
 #include <KFL/CXX20/span.hpp>
-#include <KFL/CpuInfo.hpp>
 #include <KFL/ErrorHandling.hpp>
+#include <KFL/Thread.hpp>
+#include <KlayGE/Context.hpp>
 #include <KlayGE/ResLoader.hpp>
 #include <KlayGE/TexCompression.hpp>
 #include <KlayGE/TexCompressionBC.hpp>
@@ -778,18 +779,16 @@ namespace KlayGE
 
 		std::vector<uint8_t> new_tex_data(slice_pitch);
 
-		CpuInfo cpu;
-		uint32_t const num_threads = cpu.NumHWThreads();
-		ThreadPool tp(1, num_threads);
-		std::vector<std::future<void>> joiners(num_threads);
+		auto& js = Context::Instance().JobSystemInstance();
+		uint32_t const num_regions = js.NumWorkers() + 1;
 
-		uint32_t const tex_region_height = ((tex_height + num_threads - 1) / num_threads + block_height - 1) & ~(block_height - 1);
-		std::vector<TexturePtr> new_tex_regions(num_threads);
-		for (uint32_t i = 0; i < num_threads; ++ i)
-		{
-			joiners[i] = tp.QueueThread(
-				[block_height, tex_width, tex_height, tex_region_height, i, format, row_pitch,
-					&new_tex_data, &new_tex_regions, this]
+		uint32_t const tex_region_height = ((tex_height + num_regions - 1) / num_regions + block_height - 1) & ~(block_height - 1);
+		std::vector<TexturePtr> new_tex_regions(num_regions);
+		js.ParallelFor(0, num_regions, 1,
+			[block_height, tex_width, tex_height, tex_region_height, format, row_pitch, &new_tex_data, &new_tex_regions, this](
+				uint32_t begin, uint32_t end)
+			{
+				for (uint32_t i = begin; i < end; ++ i)
 				{
 					uint32_t const this_tex_region_height = MathLib::clamp(static_cast<int>(tex_height - i * tex_region_height),
 						0, static_cast<int>(tex_region_height));
@@ -808,8 +807,8 @@ namespace KlayGE
 						uncompressed_tex_->CopyToSubTexture2D(*new_tex_regions[i], 0, 0, 0, 0, tex_width, this_tex_region_height,
 							0, 0, 0, i * tex_region_height, tex_width, this_tex_region_height, TextureFilter::Point);
 					}
-				});
-		}
+				}
+			});
 
 		TexturePtr new_tex = MakeSharedPtr<SoftwareTexture>(Texture::TT_2D, uncompressed_tex_->Width(0), uncompressed_tex_->Height(0),
 			1, 1, 1, format, false);
@@ -818,11 +817,6 @@ namespace KlayGE
 		init_data.row_pitch = row_pitch;
 		init_data.slice_pitch = slice_pitch;
 
-		for (uint32_t i = 0; i < num_threads; ++ i)
-		{
-			joiners[i].wait();
-		}
-
 		new_tex->CreateHWResource(MakeSpan<1>(init_data), nullptr);
 
 		if (IsCompressedFormat(format))
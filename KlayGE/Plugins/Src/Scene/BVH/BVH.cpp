@@ -0,0 +1,1027 @@
+/**
+ * @file BVH.cpp
+ * @author Minmin Gong
+ *
+ * @section DESCRIPTION
+ *
+ * This source file is part of KlayGE
+ * For the latest info, see http://www.klayge.org
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * You may alternatively use this source under the terms of
+ * the KlayGE Proprietary License (KPL). You can obtained such a license
+ * from http://www.klayge.org/licensing/.
+ */
+
+#include <KlayGE/KlayGE.hpp>
+#include <KFL/Math.hpp>
+#include <KFL/Timer.hpp>
+#include <KlayGE/Camera.hpp>
+#include <KlayGE/Context.hpp>
+#include <KlayGE/FrameBuffer.hpp>
+#include <KlayGE/RenderEngine.hpp>
+#include <KlayGE/RenderFactory.hpp>
+#include <KlayGE/SceneNode.hpp>
+#include <KlayGE/Viewport.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <limits>
+#include <utility>
+#include <boost/assert.hpp>
+
+#include <KlayGE/BVH/BVH.hpp>
+
+namespace
+{
+	using namespace KlayGE;
+
+	uint32_t constexpr NUM_BINS = 16;
+	uint32_t constexpr MAX_LEAF_OBJS = 8;
+	// Cost of visiting an inner node, relative to testing one object
+	float constexpr TRAVERSAL_COST = 1.0f;
+
+	struct build_obj_t
+	{
+		SceneNode* node;
+		AABBox bb;
+		float3 center;
+	};
+
+	AABBox EmptyAABBox()
+	{
+		// Inverted, so the first |= takes the other box. The constructor asserts on that, so set the corners directly.
+		float constexpr flt_max = std::numeric_limits<float>::max();
+		AABBox aabb;
+		aabb.Min() = float3(flt_max, flt_max, flt_max);
+		aabb.Max() = float3(-flt_max, -flt_max, -flt_max);
+		return aabb;
+	}
+
+	float SurfaceArea(AABBox const & aabb)
+	{
+		float3 const size = aabb.Max() - aabb.Min();
+		return 2 * (size.x() * size.y() + size.y() * size.z() + size.z() * size.x());
+	}
+
+	bool Contains(AABBox const & outer, AABBox const & inner)
+	{
+		return outer.VecInBound(inner.Min()) && outer.VecInBound(inner.Max());
+	}
+
+	// A zero component would make the slab test compute 0 * inf = NaN for origins on a slab plane, and miss the box. A huge
+	//  finite reciprocal keeps the sign and the result everywhere else.
+	float SafeReciprocal(float v)
+	{
+		float constexpr MAX_RECIPROCAL = 1e30f;
+		return (std::abs(v) > 1 / MAX_RECIPROCAL) ? 1 / v : std::copysign(MAX_RECIPROCAL, v);
+	}
+
+	// Distance along the ray to where it enters the aabb, negative if the ray misses it. inv_dir must be finite.
+	float RayEnterDistance(float3 const & orig, float3 const & inv_dir, AABBox const & aabb)
+	{
+		float t_min = 0;
+		float t_max = std::numeric_limits<float>::max();
+		for (uint32_t i = 0; i < 3; ++ i)
+		{
+			float t0 = (aabb.Min()[i] - orig[i]) * inv_dir[i];
+			float t1 = (aabb.Max()[i] - orig[i]) * inv_dir[i];
+			if (t0 > t1)
+			{
+				std::swap(t0, t1);
+			}
+			t_min = std::max(t_min, t0);
+			t_max = std::min(t_max, t1);
+		}
+		return (t_min <= t_max) ? t_min : -1.0f;
+	}
+}
+
+namespace KlayGE
+{
+	BVH::BVH()
+		: visit_stamp_(0), num_dead_nodes_(0), sync_stamp_(0), curr_cost_(0), build_cost_(1), rebuild_threshold_(1.5f),
+			rebuild_tree_(false), sync_tree_(false)
+	{
+		// Objects are tested in the BVH leaves, and the omni directional path doesn't do frustum tests
+		pos_bounds_ws_.reset();
+	}
+
+	void BVH::RebuildThreshold(float ratio)
+	{
+		rebuild_threshold_ = ratio;
+	}
+
+	float BVH::RebuildThreshold() const
+	{
+		return rebuild_threshold_;
+	}
+
+	BVHStatistics BVH::Statistics() const
+	{
+		BVHStatistics stats = stats_;
+		stats.cost_ratio = nodes_.empty() ? 1 : this->TreeCost() / build_cost_;
+		stats.num_tree_nodes = static_cast<uint32_t>(nodes_.size() - num_dead_nodes_);
+		stats.num_objs = static_cast<uint32_t>(obj_indices_.size());
+		return stats;
+	}
+
+	void BVH::ResetStatistics()
+	{
+		stats_ = BVHStatistics();
+	}
+
+	void BVH::ClipScene()
+	{
+		if (nodes_.empty())
+		{
+			rebuild_tree_ |= sync_tree_;
+		}
+		else if (!rebuild_tree_)
+		{
+			bool const sync_tree = sync_tree_;
+			if (sync_tree)
+			{
+				this->SyncTree();
+			}
+			if (!moveable_objs_.empty())
+			{
+				this->RefitTree();
+			}
+
+			if (sync_tree || !moveable_objs_.empty())
+			{
+				// Unlinked nodes stay in nodes_ until the next build, don't let them pile up
+				rebuild_tree_ = (this->TreeCost() > build_cost_ * rebuild_threshold_) || (num_dead_nodes_ * 2 > nodes_.size());
+			}
+		}
+		if (rebuild_tree_)
+		{
+			this->BuildTree();
+		}
+
+		if (!nodes_.empty())
+		{
+			this->NodeVisible(0);
+		}
+
+		auto& re = Context::Instance().RenderFactoryInstance().RenderEngineInstance();
+		auto const& viewport = *re.CurFrameBuffer()->Viewport();
+		uint32_t const num_cameras = viewport.NumCameras();
+
+		bool omni_directional = false;
+		for (uint32_t i = 0; i < num_cameras; ++i)
+		{
+			omni_directional |= viewport.Camera(i)->OmniDirectionalMode();
+		}
+
+		if (omni_directional)
+		{
+			// The tree doesn't help when everything around is in the frustums
+			SceneManager::ClipScene();
+		}
+		else
+		{
+			++ visit_stamp_;
+			if (!nodes_.empty())
+			{
+				this->MarkNodeObjs(0, false);
+			}
+
+			// Moveable nodes are marked partial before culling. Those not reached by the traversal are out of all the frustums.
+			for (uint32_t const obj_index : moveable_objs_)
+			{
+				if (obj_visit_stamps_[obj_index] != visit_stamp_)
+				{
+					objs_[obj_index]->FillVisibleMark(BoundOverlap::No);
+				}
+			}
+		}
+	}
+
+	void BVH::ClearObject()
+	{
+		SceneManager::ClearObject();
+
+		nodes_.clear();
+		objs_.clear();
+		obj_leaves_.clear();
+		moveable_objs_.clear();
+		obj_visit_stamps_.clear();
+		free_objs_.clear();
+		num_dead_nodes_ = 0;
+		obj_indices_.clear();
+		obj_sync_stamps_.clear();
+		rebuild_tree_ = true;
+	}
+
+	void BVH::OnSceneChanged()
+	{
+		// Added or removed nodes are picked up incrementally, the tree is not rebuilt
+		sync_tree_ = true;
+	}
+
+	void BVH::DoSuspend()
+	{
+	}
+
+	void BVH::DoResume()
+	{
+	}
+
+	void BVH::BuildTree()
+	{
+		Timer timer;
+
+		nodes_.clear();
+		objs_.clear();
+		obj_leaves_.clear();
+		moveable_objs_.clear();
+		free_objs_.clear();
+		num_dead_nodes_ = 0;
+		obj_indices_.clear();
+
+		++ sync_stamp_;
+		sync_tree_ = false;
+		std::vector<build_obj_t> build_objs;
+		for (auto* sn : all_scene_nodes_)
+		{
+			if (sn->Attrib() & SceneNode::SOA_Cullable)
+			{
+				if (sn->Updated())
+				{
+					AABBox const & aabb = sn->PosBoundWS();
+					build_objs.push_back({sn, aabb, aabb.Center()});
+				}
+				else
+				{
+					// Not ready yet, insert it in the next frame
+					sync_tree_ = true;
+				}
+			}
+		}
+
+		if (!build_objs.empty())
+		{
+			uint32_t const num_objs = static_cast<uint32_t>(build_objs.size());
+			nodes_.reserve(num_objs * 2);
+			nodes_.push_back({EmptyAABBox(), 0, 0, num_objs, BoundOverlap::No, false});
+
+			std::vector<uint32_t> stack(1, 0);
+			while (!stack.empty())
+			{
+				uint32_t const index = stack.back();
+				stack.pop_back();
+
+				uint32_t const first = nodes_[index].first;
+				uint32_t const last = first + nodes_[index].num_objs;
+
+				AABBox bb = EmptyAABBox();
+				AABBox center_bb = EmptyAABBox();
+				for (uint32_t i = first; i < last; ++ i)
+				{
+					bb |= build_objs[i].bb;
+					center_bb |= AABBox(build_objs[i].center, build_objs[i].center);
+				}
+				nodes_[index].bb = bb;
+
+				if (last - first <= 1)
+				{
+					continue;
+				}
+
+				// Binned SAH along the longest axis of the object centers
+				float3 const center_size = center_bb.Max() - center_bb.Min();
+				uint32_t axis = 0;
+				if (center_size.y() > center_size[axis])
+				{
+					axis = 1;
+				}
+				if (center_size.z() > center_size[axis])
+				{
+					axis = 2;
+				}
+
+				float const center_min = center_bb.Min()[axis];
+				float const scale = (center_size[axis] > 0) ? NUM_BINS / center_size[axis] : 0.0f;
+				auto bin_index = [axis, center_min, scale](float3 const & center)
+				{
+					return std::min(NUM_BINS - 1, static_cast<uint32_t>((center[axis] - center_min) * scale));
+				};
+
+				int split_bin = -1;
+				float best_cost = std::numeric_limits<float>::max();
+				if (scale > 0)
+				{
+					uint32_t bin_counts[NUM_BINS] = {};
+					AABBox bin_bbs[NUM_BINS];
+					std::fill(std::begin(bin_bbs), std::end(bin_bbs), EmptyAABBox());
+					for (uint32_t i = first; i < last; ++ i)
+					{
+						uint32_t const bin = bin_index(build_objs[i].center);
+						++ bin_counts[bin];
+						bin_bbs[bin] |= build_objs[i].bb;
+					}
+
+					float right_areas[NUM_BINS];
+					uint32_t right_counts[NUM_BINS];
+					AABBox right_bb = EmptyAABBox();
+					uint32_t right_count = 0;
+					for (uint32_t i = NUM_BINS - 1; i > 0; -- i)
+					{
+						right_bb |= bin_bbs[i];
+						right_count += bin_counts[i];
+						right_areas[i] = (right_count > 0) ? SurfaceArea(right_bb) : 0;
+						right_counts[i] = right_count;
+					}
+
+					AABBox left_bb = EmptyAABBox();
+					uint32_t left_count = 0;
+					for (uint32_t i = 0; i < NUM_BINS - 1; ++ i)
+					{
+						left_bb |= bin_bbs[i];
+						left_count += bin_counts[i];
+						if ((left_count > 0) && (right_counts[i + 1] > 0))
+						{
+							float const cost = SurfaceArea(left_bb) * left_count + right_areas[i + 1] * right_counts[i + 1];
+							if (cost < best_cost)
+							{
+								best_cost = cost;
+								split_bin = static_cast<int>(i);
+							}
+						}
+					}
+				}
+
+				float const area = SurfaceArea(bb);
+				uint32_t mid;
+				if ((split_bin >= 0) && ((TRAVERSAL_COST * area + best_cost < (last - first) * area) || (last - first > MAX_LEAF_OBJS)))
+				{
+					auto const iter = std::partition(build_objs.begin() + first, build_objs.begin() + last,
+						[&bin_index, split_bin](build_obj_t const & obj)
+						{
+							return bin_index(obj.center) <= static_cast<uint32_t>(split_bin);
+						});
+					mid = static_cast<uint32_t>(iter - build_objs.begin());
+				}
+				else if (last - first > MAX_LEAF_OBJS)
+				{
+					// All the centers are at the same place, just cut the objects in half
+					mid = (first + last) / 2;
+				}
+				else
+				{
+					continue;
+				}
+
+				uint32_t const first_child = static_cast<uint32_t>(nodes_.size());
+				nodes_[index].first = first_child;
+				nodes_[index].num_objs = 0;
+				nodes_.push_back({EmptyAABBox(), index, first, mid - first, BoundOverlap::No, false});
+				nodes_.push_back({EmptyAABBox(), index, mid, last - mid, BoundOverlap::No, false});
+				stack.push_back(first_child);
+				stack.push_back(first_child + 1);
+			}
+
+			objs_.resize(num_objs);
+			obj_leaves_.resize(num_objs);
+			obj_indices_.reserve(num_objs);
+			for (uint32_t i = 0; i < num_objs; ++ i)
+			{
+				objs_[i] = build_objs[i].node;
+				obj_indices_.emplace(objs_[i], i);
+				if (objs_[i]->Attrib() & SceneNode::SOA_Moveable)
+				{
+					moveable_objs_.push_back(i);
+				}
+			}
+			for (uint32_t i = 0; i < nodes_.size(); ++ i)
+			{
+				for (uint32_t j = 0; j < nodes_[i].num_objs; ++ j)
+				{
+					obj_leaves_[nodes_[i].first + j] = i;
+				}
+			}
+		}
+		obj_visit_stamps_.assign(objs_.size(), visit_stamp_);
+		obj_sync_stamps_.assign(objs_.size(), sync_stamp_);
+
+		curr_cost_ = 0;
+		for (auto const & node : nodes_)
+		{
+			curr_cost_ += SurfaceArea(node.bb) * ((node.num_objs > 0) ? node.num_objs : TRAVERSAL_COST);
+		}
+		build_cost_ = this->TreeCost();
+
+		rebuild_tree_ = false;
+
+		++ stats_.num_builds;
+		stats_.last_build_time = timer.elapsed();
+		stats_.total_build_time += stats_.last_build_time;
+	}
+
+	void BVH::RefitTree()
+	{
+		// Only the leaves holding moveable nodes and their ancestors are refitted
+		for (uint32_t const obj_index : moveable_objs_)
+		{
+			for (uint32_t i = obj_leaves_[obj_index]; !nodes_[i].dirty; i = nodes_[i].parent)
+			{
+				nodes_[i].dirty = true;
+				if (0 == i)
+				{
+					break;
+				}
+			}
+		}
+
+		// Children always come after their parent
+		for (size_t i = nodes_.size(); i > 0; -- i)
+		{
+			if (nodes_[i - 1].dirty)
+			{
+				this->RefitNode(static_cast<uint32_t>(i - 1));
+				nodes_[i - 1].dirty = false;
+			}
+		}
+
+		++ stats_.num_refits;
+	}
+
+	void BVH::RefitNode(uint32_t index)
+	{
+		auto& node = nodes_[index];
+		float const weight = (node.num_objs > 0) ? node.num_objs : TRAVERSAL_COST;
+		curr_cost_ -= SurfaceArea(node.bb) * weight;
+
+		if (node.num_objs > 0)
+		{
+			node.bb = objs_[node.first]->PosBoundWS();
+			for (uint32_t j = 1; j < node.num_objs; ++ j)
+			{
+				node.bb |= objs_[node.first + j]->PosBoundWS();
+			}
+		}
+		else
+		{
+			node.bb = nodes_[node.first].bb;
+			node.bb |= nodes_[node.first + 1].bb;
+		}
+
+		curr_cost_ += SurfaceArea(node.bb) * weight;
+	}
+
+	void BVH::RefitAncestors(uint32_t index)
+	{
+		for (;;)
+		{
+			this->RefitNode(index);
+			if (0 == index)
+			{
+				break;
+			}
+			index = nodes_[index].parent;
+		}
+	}
+
+	void BVH::SyncTree()
+	{
+		++ sync_stamp_;
+		sync_tree_ = false;
+		for (auto* sn : all_scene_nodes_)
+		{
+			if (sn->Attrib() & SceneNode::SOA_Cullable)
+			{
+				auto iter = obj_indices_.find(sn);
+				if (iter != obj_indices_.end())
+				{
+					obj_sync_stamps_[iter->second] = sync_stamp_;
+				}
+				else if (sn->Updated())
+				{
+					this->InsertObj(sn);
+					++ stats_.num_inserts;
+				}
+				else
+				{
+					// Not ready yet, try again in the next frame
+					sync_tree_ = true;
+				}
+			}
+		}
+
+		// Removing an object moves another one of its leaf into its slot, so the stale ones are collected first
+		std::vector<SceneNode const *> removed_objs;
+		for (uint32_t i = 0; i < objs_.size(); ++ i)
+		{
+			if ((objs_[i] != nullptr) && (obj_sync_stamps_[i] != sync_stamp_))
+			{
+				removed_objs.push_back(objs_[i]);
+			}
+		}
+		for (auto const * sn : removed_objs)
+		{
+			this->RemoveObj(obj_indices_[sn]);
+			++ stats_.num_removes;
+		}
+
+		moveable_objs_.clear();
+		for (uint32_t i = 0; i < objs_.size(); ++ i)
+		{
+			if ((objs_[i] != nullptr) && (objs_[i]->Attrib() & SceneNode::SOA_Moveable))
+			{
+				moveable_objs_.push_back(i);
+			}
+		}
+	}
+
+	void BVH::InsertObj(SceneNode* node)
+	{
+		BOOST_ASSERT(!nodes_.empty());
+
+		AABBox const & aabb = node->PosBoundWS();
+		float const obj_area = SurfaceArea(aabb);
+
+		uint32_t obj_index;
+		if (free_objs_.empty())
+		{
+			obj_index = static_cast<uint32_t>(objs_.size());
+			objs_.push_back(node);
+			obj_leaves_.push_back(0);
+			obj_visit_stamps_.push_back(visit_stamp_);
+			obj_sync_stamps_.push_back(sync_stamp_);
+		}
+		else
+		{
+			obj_index = free_objs_.back();
+			free_objs_.pop_back();
+			objs_[obj_index] = node;
+			obj_visit_stamps_[obj_index] = visit_stamp_;
+			obj_sync_stamps_[obj_index] = sync_stamp_;
+		}
+		obj_indices_.emplace(node, obj_index);
+
+		// Branch and bound for the leaf where the object increases the SAH cost the least. The leaf becomes an inner node
+		//  over itself and a new leaf of the object, and all its ancestors grow to hold the object.
+		auto merged_area = [this, &aabb](uint32_t index)
+		{
+			AABBox bb = nodes_[index].bb;
+			bb |= aabb;
+			return SurfaceArea(bb);
+		};
+
+		uint32_t best_leaf = 0;
+		float best_cost = std::numeric_limits<float>::max();
+		// Node index, cost added to its ancestors
+		std::vector<std::pair<uint32_t, float>> stack(1, std::make_pair(0U, 0.0f));
+		while (!stack.empty())
+		{
+			auto const [index, ancestors_cost] = stack.back();
+			stack.pop_back();
+
+			auto const & bvh_node = nodes_[index];
+			float const area = merged_area(index);
+			if (bvh_node.num_objs > 0)
+			{
+				float const cost = ancestors_cost + TRAVERSAL_COST * area + obj_area;
+				if (cost < best_cost)
+				{
+					best_cost = cost;
+					best_leaf = index;
+				}
+			}
+			else
+			{
+				float const children_cost = ancestors_cost + TRAVERSAL_COST * (area - SurfaceArea(bvh_node.bb));
+				// Any leaf below costs at least that much more
+				if (children_cost + (TRAVERSAL_COST + 1) * obj_area < best_cost)
+				{
+					uint32_t const first_child = bvh_node.first;
+					float const first_growth = merged_area(first_child) - SurfaceArea(nodes_[first_child].bb);
+					float const second_growth = merged_area(first_child + 1) - SurfaceArea(nodes_[first_child + 1].bb);
+
+					// The child that grows less is visited first
+					if (first_growth < second_growth)
+					{
+						stack.emplace_back(first_child + 1, children_cost);
+						stack.emplace_back(first_child, children_cost);
+					}
+					else
+					{
+						stack.emplace_back(first_child, children_cost);
+						stack.emplace_back(first_child + 1, children_cost);
+					}
+				}
+			}
+		}
+
+		// The objects of the leaf move to its first child unchanged
+		bvh_node_t const leaf = nodes_[best_leaf];
+		uint32_t const first_child = static_cast<uint32_t>(nodes_.size());
+		nodes_.push_back({leaf.bb, best_leaf, leaf.first, leaf.num_objs, BoundOverlap::No, false});
+		nodes_.push_back({aabb, best_leaf, obj_index, 1, BoundOverlap::No, false});
+		for (uint32_t i = 0; i < leaf.num_objs; ++ i)
+		{
+			obj_leaves_[leaf.first + i] = first_child;
+		}
+		obj_leaves_[obj_index] = first_child + 1;
+		curr_cost_ += obj_area;
+
+		nodes_[best_leaf].first = first_child;
+		nodes_[best_leaf].num_objs = 0;
+		curr_cost_ += TRAVERSAL_COST * SurfaceArea(leaf.bb);
+		this->RefitAncestors(best_leaf);
+	}
+
+	void BVH::RemoveObj(uint32_t obj_index)
+	{
+		BOOST_ASSERT(objs_[obj_index] != nullptr);
+
+		obj_indices_.erase(objs_[obj_index]);
+
+		uint32_t const leaf = obj_leaves_[obj_index];
+		auto& leaf_node = nodes_[leaf];
+		uint32_t free_index;
+		if (leaf_node.num_objs > 1)
+		{
+			// Keep the objects of the leaf contiguous
+			free_index = leaf_node.first + leaf_node.num_objs - 1;
+			if (obj_index != free_index)
+			{
+				objs_[obj_index] = objs_[free_index];
+				obj_visit_stamps_[obj_index] = obj_visit_stamps_[free_index];
+				obj_sync_stamps_[obj_index] = obj_sync_stamps_[free_index];
+				obj_indices_[objs_[obj_index]] = obj_index;
+			}
+
+			curr_cost_ -= SurfaceArea(leaf_node.bb);
+			-- leaf_node.num_objs;
+			this->RefitAncestors(leaf);
+		}
+		else
+		{
+			free_index = obj_index;
+
+			if (0 == leaf)
+			{
+				nodes_.clear();
+				num_dead_nodes_ = 0;
+				curr_cost_ = 0;
+			}
+			else
+			{
+				// The sibling takes the place of the parent, the leaf and the sibling node are left unlinked
+				uint32_t const parent = leaf_node.parent;
+				auto& parent_node = nodes_[parent];
+				auto const & sibling_node = nodes_[(parent_node.first == leaf) ? leaf + 1 : leaf - 1];
+				curr_cost_ -= SurfaceArea(leaf_node.bb) + TRAVERSAL_COST * SurfaceArea(parent_node.bb);
+
+				parent_node.bb = sibling_node.bb;
+				parent_node.first = sibling_node.first;
+				parent_node.num_objs = sibling_node.num_objs;
+				if (parent_node.num_objs > 0)
+				{
+					for (uint32_t i = 0; i < parent_node.num_objs; ++ i)
+					{
+						obj_leaves_[parent_node.first + i] = parent;
+					}
+				}
+				else
+				{
+					nodes_[parent_node.first].parent = parent;
+					nodes_[parent_node.first + 1].parent = parent;
+				}
+				num_dead_nodes_ += 2;
+
+				if (parent != 0)
+				{
+					this->RefitAncestors(parent_node.parent);
+				}
+			}
+		}
+
+		objs_[free_index] = nullptr;
+		free_objs_.push_back(free_index);
+	}
+
+	float BVH::TreeCost() const
+	{
+		float const root_area = nodes_.empty() ? 0 : SurfaceArea(nodes_[0].bb);
+		return (root_area > 0) ? curr_cost_ / root_area : 1.0f;
+	}
+
+	void BVH::NodeVisible(uint32_t index)
+	{
+		BOOST_ASSERT(index < nodes_.size());
+
+		auto& re = Context::Instance().RenderFactoryInstance().RenderEngineInstance();
+		auto const& viewport = *re.CurFrameBuffer()->Viewport();
+		uint32_t const num_cameras = viewport.NumCameras();
+
+		auto& bvh_node = nodes_[index];
+		bool large_enough;
+		if (small_obj_threshold_ <= 0)
+		{
+			large_enough = true;
+		}
+		else
+		{
+			large_enough = false;
+			for (uint32_t i = 0; i < num_cameras; ++i)
+			{
+				float4x4 const& view_proj = camera_view_projs_[i];
+				if (((MathLib::ortho_area(camera_forward_vecs_[i], bvh_node.bb) > small_obj_threshold_)
+					&& (MathLib::perspective_area(camera_eye_poses_[i], view_proj, bvh_node.bb) > small_obj_threshold_)))
+				{
+					large_enough = true;
+					break;
+				}
+			}
+		}
+
+		if (large_enough)
+		{
+			bvh_node.visible = SceneManager::AABBVisible(bvh_node.bb);
+			if ((BoundOverlap::Partial == bvh_node.visible) && (0 == bvh_node.num_objs))
+			{
+				this->NodeVisible(bvh_node.first);
+				this->NodeVisible(bvh_node.first + 1);
+			}
+		}
+		else
+		{
+			bvh_node.visible = BoundOverlap::No;
+		}
+	}
+
+	void BVH::MarkNodeObjs(uint32_t index, bool force)
+	{
+		BOOST_ASSERT(index < nodes_.size());
+
+		auto& re = Context::Instance().RenderFactoryInstance().RenderEngineInstance();
+		auto const& viewport = *re.CurFrameBuffer()->Viewport();
+		uint32_t const num_cameras = viewport.NumCameras();
+
+		auto const & bvh_node = nodes_[index];
+		if ((bvh_node.visible != BoundOverlap::No) || force)
+		{
+			if (0 == bvh_node.num_objs)
+			{
+				bool const force_children = (BoundOverlap::Yes == bvh_node.visible) || force;
+				this->MarkNodeObjs(bvh_node.first, force_children);
+				this->MarkNodeObjs(bvh_node.first + 1, force_children);
+				return;
+			}
+
+			for (uint32_t obj_index = bvh_node.first; obj_index < bvh_node.first + bvh_node.num_objs; ++ obj_index)
+			{
+				obj_visit_stamps_[obj_index] = visit_stamp_;
+
+				auto* node = objs_[obj_index];
+				if (node->Attrib() & SceneNode::SOA_Moveable)
+				{
+					if (node->Visible())
+					{
+						for (uint32_t i = 0; i < num_cameras; ++i)
+						{
+							if (node->VisibleMark(i) == BoundOverlap::Partial)
+							{
+								node->VisibleMark(i, camera_frustums_[i]->Intersect(node->PosBoundWS()));
+							}
+						}
+					}
+				}
+				else if (node->Visible())
+				{
+					if (node->Updated())
+					{
+						for (uint32_t i = 0; i < num_cameras; ++i)
+						{
+							if (node->VisibleMark(i) == BoundOverlap::No)
+							{
+								auto visible = this->VisibleTestFromParent(*node, i);
+								if (BoundOverlap::Partial == visible)
+								{
+									if (node->Parent())
+									{
+										visible = camera_frustums_[i]->Intersect(node->PosBoundWS());
+									}
+									else
+									{
+										visible = BoundOverlap::No;
+									}
+								}
+
+								node->VisibleMark(i, visible);
+							}
+						}
+					}
+					else
+					{
+						for (uint32_t i = 0; i < num_cameras; ++i)
+						{
+							node->VisibleMark(i, BoundOverlap::Yes);
+						}
+					}
+
+					for (uint32_t i = 0; i < num_cameras; ++i)
+					{
+						if (node->VisibleMark(i) != BoundOverlap::No)
+						{
+							auto* override_node = node->Parent();
+							while ((override_node != nullptr) && (override_node->VisibleMark(i) == BoundOverlap::No))
+							{
+								override_node->VisibleMark(i, BoundOverlap::Partial);
+								override_node = override_node->Parent();
+							}
+						}
+					}
+				}
+				else
+				{
+					node->FillVisibleMark(BoundOverlap::No);
+				}
+			}
+		}
+	}
+
+	bool BVH::InInvisibleNode(AABBox const & aabb) const
+	{
+		if (nodes_.empty() || !Contains(nodes_[0].bb, aabb))
+		{
+			return false;
+		}
+
+		// Unlike octree cells, tree nodes don't cover the space between them. Only a node containing the whole bound can
+		// tell it's out of the frustums.
+		uint32_t index = 0;
+		for (;;)
+		{
+			auto const & bvh_node = nodes_[index];
+			if (bvh_node.visible != BoundOverlap::Partial)
+			{
+				return BoundOverlap::No == bvh_node.visible;
+			}
+			if (bvh_node.num_objs > 0)
+			{
+				return false;
+			}
+
+			if (Contains(nodes_[bvh_node.first].bb, aabb))
+			{
+				index = bvh_node.first;
+			}
+			else if (Contains(nodes_[bvh_node.first + 1].bb, aabb))
+			{
+				index = bvh_node.first + 1;
+			}
+			else
+			{
+				return false;
+			}
+		}
+	}
+
+	BoundOverlap BVH::AABBVisible(AABBox const & aabb) const
+	{
+		if (this->InInvisibleNode(aabb))
+		{
+			return BoundOverlap::No;
+		}
+		return SceneManager::AABBVisible(aabb);
+	}
+
+	BoundOverlap BVH::OBBVisible(OBBox const & obb) const
+	{
+		if (this->InInvisibleNode(MathLib::convert_to_aabbox(obb)))
+		{
+			return BoundOverlap::No;
+		}
+		return SceneManager::OBBVisible(obb);
+	}
+
+	BoundOverlap BVH::SphereVisible(Sphere const & sphere) const
+	{
+		float3 const extent(sphere.Radius(), sphere.Radius(), sphere.Radius());
+		if (this->InInvisibleNode(AABBox(sphere.Center() - extent, sphere.Center() + extent)))
+		{
+			return BoundOverlap::No;
+		}
+		return SceneManager::SphereVisible(sphere);
+	}
+
+	BoundOverlap BVH::FrustumVisible(Frustum const & frustum) const
+	{
+		float3 corners[8];
+		for (uint32_t i = 0; i < 8; ++ i)
+		{
+			corners[i] = frustum.Corner(i);
+		}
+		if (this->InInvisibleNode(MathLib::compute_aabbox(std::begin(corners), std::end(corners))))
+		{
+			return BoundOverlap::No;
+		}
+		return SceneManager::FrustumVisible(frustum);
+	}
+
+	void BVH::RayQuery(float3 const & orig, float3 const & dir, std::vector<SceneNode*>& nodes) const
+	{
+		nodes.clear();
+		if (nodes_.empty())
+		{
+			return;
+		}
+
+		float3 const inv_dir(SafeReciprocal(dir.x()), SafeReciprocal(dir.y()), SafeReciprocal(dir.z()));
+
+		std::vector<std::pair<float, SceneNode*>> hits;
+		std::vector<uint32_t> stack(1, 0);
+		while (!stack.empty())
+		{
+			auto const & bvh_node = nodes_[stack.back()];
+			stack.pop_back();
+
+			if (RayEnterDistance(orig, inv_dir, bvh_node.bb) >= 0)
+			{
+				if (bvh_node.num_objs > 0)
+				{
+					for (uint32_t i = bvh_node.first; i < bvh_node.first + bvh_node.num_objs; ++ i)
+					{
+						float const t = RayEnterDistance(orig, inv_dir, objs_[i]->PosBoundWS());
+						if (t >= 0)
+						{
+							hits.emplace_back(t, objs_[i]);
+						}
+					}
+				}
+				else
+				{
+					stack.push_back(bvh_node.first);
+					stack.push_back(bvh_node.first + 1);
+				}
+			}
+		}
+
+		std::sort(hits.begin(), hits.end(),
+			[](std::pair<float, SceneNode*> const & lhs, std::pair<float, SceneNode*> const & rhs)
+			{
+				return lhs.first < rhs.first;
+			});
+		nodes.reserve(hits.size());
+		for (auto const & hit : hits)
+		{
+			nodes.push_back(hit.second);
+		}
+	}
+
+	void BVH::AABBQuery(AABBox const & aabb, std::vector<SceneNode*>& nodes) const
+	{
+		nodes.clear();
+		if (nodes_.empty())
+		{
+			return;
+		}
+
+		std::vector<uint32_t> stack(1, 0);
+		while (!stack.empty())
+		{
+			auto const & bvh_node = nodes_[stack.back()];
+			stack.pop_back();
+
+			if (MathLib::intersect_aabb_aabb(bvh_node.bb, aabb))
+			{
+				if (bvh_node.num_objs > 0)
+				{
+					for (uint32_t i = bvh_node.first; i < bvh_node.first + bvh_node.num_objs; ++ i)
+					{
+						if (MathLib::intersect_aabb_aabb(objs_[i]->PosBoundWS(), aabb))
+						{
+							nodes.push_back(objs_[i]);
+						}
+					}
+				}
+				else
+				{
+					stack.push_back(bvh_node.first);
+					stack.push_back(bvh_node.first + 1);
+				}
+			}
+		}
+	}
+}
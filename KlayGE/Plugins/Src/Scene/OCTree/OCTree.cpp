@@ -28,6 +28,7 @@
 #include <KFL/Vector.hpp>
 #include <KFL/Matrix.hpp>
 #include <KFL/Plane.hpp>
+#include <KFL/Timer.hpp>
 #include <KlayGE/SceneNode.hpp>
 #include <KlayGE/Camera.hpp>
 #include <KlayGE/App3D.hpp>
@@ -99,13 +100,20 @@ namespace
 namespace KlayGE
 {
 	OCTree::OCTree()
-		: max_tree_depth_(4), rebuild_tree_(false)
+		: sync_stamp_(0), max_tree_depth_(4), rebuild_tree_(false), sync_tree_(false)
 	{
+		// Objects are tested in the octree cells
+		pos_bounds_ws_.reset();
 	}
 
 	void OCTree::MaxTreeDepth(uint32_t max_tree_depth)
 	{
-		max_tree_depth_ = std::min<uint32_t>(max_tree_depth, 16UL);
+		max_tree_depth = std::min<uint32_t>(max_tree_depth, 16UL);
+		if (max_tree_depth_ != max_tree_depth)
+		{
+			max_tree_depth_ = max_tree_depth;
+			rebuild_tree_ = true;
+		}
 	}
 
 	uint32_t OCTree::MaxTreeDepth() const
@@ -113,33 +121,44 @@ namespace KlayGE
 		return max_tree_depth_;
 	}
 
+	void OCTree::RebuildTree()
+	{
+		rebuild_tree_ = true;
+	}
+
+	OCTreeStatistics OCTree::Statistics() const
+	{
+		OCTreeStatistics stats = stats_;
+		stats.num_cells = static_cast<uint32_t>(octree_.size() - free_children_.size() * 8);
+		stats.num_objs = static_cast<uint32_t>(obj_indices_.size());
+		return stats;
+	}
+
+	void OCTree::ResetStatistics()
+	{
+		stats_ = OCTreeStatistics();
+	}
+
 	void OCTree::ClipScene()
 	{
-		if (rebuild_tree_)
+		if (octree_.empty())
 		{
-			octree_.resize(1);
-			AABBox bb_root(float3(0, 0, 0), float3(0, 0, 0));
-			octree_[0].first_child_index = -1;
-			octree_[0].visible = BoundOverlap::No;
-			for (auto* sn : all_scene_nodes_)
+			rebuild_tree_ |= sync_tree_;
+		}
+		else if (!rebuild_tree_)
+		{
+			if (sync_tree_)
 			{
-				auto const & node = *sn;
-				uint32_t const attr = node.Attrib();
-				if (node.Updated() && (attr & SceneNode::SOA_Cullable) && !(attr & SceneNode::SOA_Moveable))
-				{
-					bb_root |= node.PosBoundWS();
-					octree_[0].node_ptrs.push_back(sn);
-				}
+				this->SyncTree();
+			}
+			if (!rebuild_tree_)
+			{
+				this->UpdateMovedObjs();
 			}
-			float3 const & center = bb_root.Center();
-			float3 const & extent = bb_root.HalfSize();
-			float longest_dim = std::max(std::max(extent.x(), extent.y()), extent.z());
-			float3 new_extent(longest_dim, longest_dim, longest_dim);
-			octree_[0].bb = AABBox(center - new_extent, center + new_extent);
-
-			this->DivideNode(0, 1);
-
-			rebuild_tree_ = false;
+		}
+		if (rebuild_tree_)
+		{
+			this->BuildTree();
 		}
 
 #ifdef KLAYGE_DRAW_NODES
@@ -259,12 +278,17 @@ namespace KlayGE
 		SceneManager::ClearObject();
 
 		octree_.clear();
+		free_children_.clear();
+		objs_.clear();
+		free_objs_.clear();
+		obj_indices_.clear();
 		rebuild_tree_ = true;
 	}
 
 	void OCTree::OnSceneChanged()
 	{
-		rebuild_tree_ = true;
+		// Added or removed nodes are picked up incrementally, the tree is not rebuilt
+		sync_tree_ = true;
 	}
 
 	void OCTree::DoSuspend()
@@ -277,57 +301,309 @@ namespace KlayGE
 		// TODO
 	}
 
-	void OCTree::DivideNode(size_t index, uint32_t curr_depth)
+	bool OCTree::IsTreeObj(SceneNode const & node)
 	{
-		if (octree_[index].node_ptrs.size() > 1)
+		uint32_t const attr = node.Attrib();
+		return (attr & SceneNode::SOA_Cullable) && !(attr & SceneNode::SOA_Moveable);
+	}
+
+	void OCTree::BuildTree()
+	{
+		Timer timer;
+
+		octree_.clear();
+		free_children_.clear();
+		objs_.clear();
+		free_objs_.clear();
+		obj_indices_.clear();
+
+		AABBox bb_root(float3(0, 0, 0), float3(0, 0, 0));
+		for (auto* sn : all_scene_nodes_)
 		{
-			size_t const this_size = octree_.size();
-			AABBox const parent_bb = octree_[index].bb;
-			float3 const parent_center = parent_bb.Center();
-			octree_[index].first_child_index = static_cast<int>(this_size);
-			octree_[index].visible = BoundOverlap::No;
+			auto const & node = *sn;
+			if (node.Updated() && IsTreeObj(node))
+			{
+				bb_root |= node.PosBoundWS();
+			}
+		}
+		float3 const & extent = bb_root.HalfSize();
+		float const longest_dim = std::max(std::max(extent.x(), extent.y()), extent.z());
+
+		octree_.resize(1);
+		octree_node_t& root = octree_[0];
+		root.center = bb_root.Center();
+		root.half_size = longest_dim;
+		root.bb = AABBox(root.center - float3(longest_dim * 2, longest_dim * 2, longest_dim * 2),
+			root.center + float3(longest_dim * 2, longest_dim * 2, longest_dim * 2));
+		root.depth = 0;
+		root.parent_index = -1;
+		root.first_child_index = -1;
+		root.visible = BoundOverlap::No;
+		root.first_obj_index = -1;
+		root.num_subtree_objs = 0;
+
+		++ sync_stamp_;
+		sync_tree_ = false;
+		for (auto* sn : all_scene_nodes_)
+		{
+			if (IsTreeObj(*sn))
+			{
+				if (sn->Updated())
+				{
+					bool const inserted = this->InsertObj(sn);
+					BOOST_ASSERT(inserted);
+					KFL_UNUSED(inserted);
+				}
+				else
+				{
+					sync_tree_ = true;
+				}
+			}
+		}
 
-			octree_.resize(this_size + 8);
-			for (auto* node : octree_[index].node_ptrs)
+		rebuild_tree_ = false;
+
+		++ stats_.num_rebuilds;
+		stats_.last_rebuild_time = timer.elapsed();
+		stats_.total_rebuild_time += stats_.last_rebuild_time;
+	}
+
+	void OCTree::SyncTree()
+	{
+		++ sync_stamp_;
+		sync_tree_ = false;
+		for (auto* sn : all_scene_nodes_)
+		{
+			if (IsTreeObj(*sn))
 			{
-				AABBox const & aabb = node->PosBoundWS();
-				int mark[6];
-				mark[0] = aabb.Min().x() >= parent_center.x() ? 1 : 0;
-				mark[1] = aabb.Min().y() >= parent_center.y() ? 2 : 0;
-				mark[2] = aabb.Min().z() >= parent_center.z() ? 4 : 0;
-				mark[3] = aabb.Max().x() >= parent_center.x() ? 1 : 0;
-				mark[4] = aabb.Max().y() >= parent_center.y() ? 2 : 0;
-				mark[5] = aabb.Max().z() >= parent_center.z() ? 4 : 0;
-				for (int j = 0; j < 8; ++ j)
+				auto iter = obj_indices_.find(sn);
+				if (iter != obj_indices_.end())
+				{
+					objs_[iter->second].sync_stamp = sync_stamp_;
+				}
+				else if (sn->Updated())
 				{
-					if (j == ((j & 1) ? mark[3] : mark[0])
-						+ ((j & 2) ? mark[4] : mark[1])
-						+ ((j & 4) ? mark[5] : mark[2]))
+					if (!this->InsertObj(sn))
 					{
-						octree_[this_size + j].node_ptrs.push_back(node);
+						// Out of the root, the tree has to grow
+						rebuild_tree_ = true;
+						return;
 					}
+					++ stats_.num_inserts;
+				}
+				else
+				{
+					// Not ready yet, try again in the next frame
+					sync_tree_ = true;
 				}
 			}
+		}
 
-			for (size_t j = 0; j < 8; ++ j)
+		for (size_t i = 0; i < objs_.size(); ++ i)
+		{
+			if ((objs_[i].node != nullptr) && (objs_[i].sync_stamp != sync_stamp_))
 			{
-				octree_node_t& new_node = octree_[this_size + j];
-				new_node.first_child_index = -1;
-				new_node.bb = AABBox(float3((j & 1) ? parent_center.x() : parent_bb.Min().x(),
-						(j & 2) ? parent_center.y() : parent_bb.Min().y(),
-						(j & 4) ? parent_center.z() : parent_bb.Min().z()),
-					float3((j & 1) ? parent_bb.Max().x() : parent_center.x(),
-						(j & 2) ? parent_bb.Max().y() : parent_center.y(),
-						(j & 4) ? parent_bb.Max().z() : parent_center.z()));
+				this->RemoveObj(static_cast<int>(i));
+				++ stats_.num_removes;
+			}
+		}
+	}
 
-				if (curr_depth < max_tree_depth_)
+	void OCTree::UpdateMovedObjs()
+	{
+		for (size_t i = 0; i < objs_.size(); ++ i)
+		{
+			SceneNode* node = objs_[i].node;
+			if ((node != nullptr) && node->Updated())
+			{
+				AABBox const & aabb = node->PosBoundWS();
+				AABBox const & cell_bb = octree_[objs_[i].cell_index].bb;
+				if (!cell_bb.VecInBound(aabb.Min()) || !cell_bb.VecInBound(aabb.Max()))
 				{
-					this->DivideNode(this_size + j, curr_depth + 1);
+					this->RemoveObj(static_cast<int>(i));
+					if (!this->InsertObj(node))
+					{
+						rebuild_tree_ = true;
+						return;
+					}
+					++ stats_.num_moves;
 				}
 			}
+		}
+	}
+
+	bool OCTree::InsertObj(SceneNode* node)
+	{
+		AABBox const & aabb = node->PosBoundWS();
+		if (!octree_[0].bb.VecInBound(aabb.Min()) || !octree_[0].bb.VecInBound(aabb.Max()))
+		{
+			return false;
+		}
+
+		int obj_index;
+		if (free_objs_.empty())
+		{
+			obj_index = static_cast<int>(objs_.size());
+			objs_.emplace_back();
+		}
+		else
+		{
+			obj_index = free_objs_.back();
+			free_objs_.pop_back();
+		}
+		objs_[obj_index].node = node;
+		objs_[obj_index].sync_stamp = sync_stamp_;
+		obj_indices_[node] = obj_index;
+
+		// Go down to the deepest cell whose loose bb still holds the object
+		float3 const obj_center = aabb.Center();
+		int cell_index = 0;
+		while (octree_[cell_index].depth < max_tree_depth_)
+		{
+			octree_node_t const & cell = octree_[cell_index];
+			float const child_half_size = cell.half_size / 2;
+			int const j = (obj_center.x() >= cell.center.x() ? 1 : 0)
+				+ (obj_center.y() >= cell.center.y() ? 2 : 0)
+				+ (obj_center.z() >= cell.center.z() ? 4 : 0);
+			float3 const child_center = cell.center + float3((j & 1) ? child_half_size : -child_half_size,
+				(j & 2) ? child_half_size : -child_half_size, (j & 4) ? child_half_size : -child_half_size);
+			float3 const child_extent(child_half_size * 2, child_half_size * 2, child_half_size * 2);
+			AABBox const child_bb(child_center - child_extent, child_center + child_extent);
+			if (!child_bb.VecInBound(aabb.Min()) || !child_bb.VecInBound(aabb.Max()))
+			{
+				break;
+			}
+
+			int first_child_index = cell.first_child_index;
+			if (-1 == first_child_index)
+			{
+				first_child_index = this->AllocateChildren(cell_index);
+			}
+			cell_index = first_child_index + j;
+		}
+
+		this->LinkObj(obj_index, cell_index);
+
+		return true;
+	}
+
+	void OCTree::RemoveObj(int obj_index)
+	{
+		this->UnlinkObj(obj_index);
+
+		auto& obj = objs_[obj_index];
+		obj_indices_.erase(obj.node);
+		obj.node = nullptr;
+		free_objs_.push_back(obj_index);
+	}
+
+	void OCTree::LinkObj(int obj_index, int cell_index)
+	{
+		auto& obj = objs_[obj_index];
+		auto& cell = octree_[cell_index];
+
+		obj.cell_index = cell_index;
+		obj.prev_index = -1;
+		obj.next_index = cell.first_obj_index;
+		if (cell.first_obj_index != -1)
+		{
+			objs_[cell.first_obj_index].prev_index = obj_index;
+		}
+		cell.first_obj_index = obj_index;
+
+		for (int i = cell_index; i != -1; i = octree_[i].parent_index)
+		{
+			++ octree_[i].num_subtree_objs;
+		}
+	}
+
+	void OCTree::UnlinkObj(int obj_index)
+	{
+		auto& obj = objs_[obj_index];
+
+		if (obj.prev_index != -1)
+		{
+			objs_[obj.prev_index].next_index = obj.next_index;
+		}
+		else
+		{
+			octree_[obj.cell_index].first_obj_index = obj.next_index;
+		}
+		if (obj.next_index != -1)
+		{
+			objs_[obj.next_index].prev_index = obj.prev_index;
+		}
+
+		// Collapse the largest subtree that becomes empty
+		int empty_cell_index = -1;
+		for (int i = obj.cell_index; i != -1; i = octree_[i].parent_index)
+		{
+			BOOST_ASSERT(octree_[i].num_subtree_objs > 0);
+			-- octree_[i].num_subtree_objs;
+			if (0 == octree_[i].num_subtree_objs)
+			{
+				empty_cell_index = i;
+			}
+		}
+		if (empty_cell_index != -1)
+		{
+			this->FreeChildren(empty_cell_index);
+		}
 
-			octree_[index].node_ptrs.clear();
-			octree_[index].node_ptrs.shrink_to_fit();
+		obj.cell_index = -1;
+		obj.prev_index = -1;
+		obj.next_index = -1;
+	}
+
+	int OCTree::AllocateChildren(int cell_index)
+	{
+		int first_child_index;
+		if (free_children_.empty())
+		{
+			first_child_index = static_cast<int>(octree_.size());
+			octree_.resize(octree_.size() + 8);
+		}
+		else
+		{
+			first_child_index = free_children_.back();
+			free_children_.pop_back();
+		}
+
+		octree_node_t& parent = octree_[cell_index];
+		float const child_half_size = parent.half_size / 2;
+		float3 const child_extent(child_half_size * 2, child_half_size * 2, child_half_size * 2);
+		for (int j = 0; j < 8; ++ j)
+		{
+			octree_node_t& child = octree_[first_child_index + j];
+			child.center = parent.center + float3((j & 1) ? child_half_size : -child_half_size,
+				(j & 2) ? child_half_size : -child_half_size, (j & 4) ? child_half_size : -child_half_size);
+			child.half_size = child_half_size;
+			child.bb = AABBox(child.center - child_extent, child.center + child_extent);
+			child.depth = parent.depth + 1;
+			child.parent_index = cell_index;
+			child.first_child_index = -1;
+			child.visible = BoundOverlap::No;
+			child.first_obj_index = -1;
+			child.num_subtree_objs = 0;
+		}
+		parent.first_child_index = first_child_index;
+
+		return first_child_index;
+	}
+
+	void OCTree::FreeChildren(int cell_index)
+	{
+		int const first_child_index = octree_[cell_index].first_child_index;
+		if (first_child_index != -1)
+		{
+			for (int j = 0; j < 8; ++ j)
+			{
+				BOOST_ASSERT(-1 == octree_[first_child_index + j].first_obj_index);
+				this->FreeChildren(first_child_index + j);
+			}
+
+			free_children_.push_back(first_child_index);
+			octree_[cell_index].first_child_index = -1;
 		}
 	}
 
@@ -400,8 +676,9 @@ namespace KlayGE
 		auto const & octree_node = octree_[index];
 		if ((octree_node.visible != BoundOverlap::No) || force)
 		{
-			for (auto* node : octree_node.node_ptrs)
+			for (int obj_index = octree_node.first_obj_index; obj_index != -1; obj_index = objs_[obj_index].next_index)
 			{
+				auto* node = objs_[obj_index].node;
 				if (node->Visible())
 				{
 					if (node->Updated())
@@ -580,25 +857,13 @@ namespace KlayGE
 
 				if (node.first_child_index != -1)
 				{
-					float3 const center = node.bb.Center();
-					int mark[6];
-					mark[0] = aabb.Min().x() >= center.x() ? 1 : 0;
-					mark[1] = aabb.Min().y() >= center.y() ? 2 : 0;
-					mark[2] = aabb.Min().z() >= center.z() ? 4 : 0;
-					mark[3] = aabb.Max().x() >= center.x() ? 1 : 0;
-					mark[4] = aabb.Max().y() >= center.y() ? 2 : 0;
-					mark[5] = aabb.Max().z() >= center.z() ? 4 : 0;
-					for (int j = 0; j < 8; ++ j)
+					// Loose bbs of the children overlap each other, so all of them have to be checked
+					for (int i = 0; i < 8; ++ i)
 					{
-						if (j == ((j & 1) ? mark[3] : mark[0])
-							+ ((j & 2) ? mark[4] : mark[1])
-							+ ((j & 4) ? mark[5] : mark[2]))
+						BoundOverlap const bo = this->BoundVisible(node.first_child_index + i, aabb);
+						if (bo != BoundOverlap::No)
 						{
-							BoundOverlap const bo = this->BoundVisible(node.first_child_index + j, aabb);
-							if (bo != BoundOverlap::No)
-							{
-								return bo;
-							}
+							return bo;
 						}
 					}
 
@@ -589,7 +589,8 @@ void DeferredRenderingApp::DoUpdateOverlay()
 	font_->RenderText(0, 72, Color(1, 1, 1, 1), stream.str(), 16);
 
 	stream.str(L"");
-	stream << scene_mgr.NumDrawCalls() << " Draws/frame "
+	stream << scene_mgr.NumDrawCalls() << " Draws/frame ("
+		<< scene_mgr.NumDrawCallsSaved() << " saved by instancing) "
 		<< scene_mgr.NumDispatchCalls() << " Dispatches/frame";
 	font_->RenderText(0, 90, Color(1, 1, 1, 1), stream.str(), 16);
 
@@ -0,0 +1,223 @@
+/**
+ * @file AnimationEvaluatorTest.cpp
+ * @author Minmin Gong
+ *
+ * @section DESCRIPTION
+ *
+ * This source file is part of KlayGE
+ * For the latest info, see http://www.klayge.org
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * You may alternatively use this source under the terms of
+ * the KlayGE Proprietary License (KPL). You can obtained such a license
+ * from http://www.klayge.org/licensing/.
+ */
+
+#include <KlayGE/KlayGE.hpp>
+#include <KFL/Math.hpp>
+#include <KFL/Timer.hpp>
+#include <KlayGE/AnimationEvaluator.hpp>
+#include <KlayGE/Mesh.hpp>
+
+#include <iostream>
+#include <random>
+#include <tuple>
+#include <vector>
+
+#include "KlayGETests.hpp"
+
+using namespace std;
+using namespace KlayGE;
+
+namespace
+{
+	// Random skeleton with parents before children. Every 7th track has a single key, and mirrored_joint has a negative scale.
+	std::shared_ptr<std::vector<KeyFrameSet>> GenerateKeyFrameSets(std::vector<int32_t>& parents, uint32_t num_joints,
+		uint32_t mirrored_joint, bool binary_tree)
+	{
+		std::ranlux24_base gen;
+		std::uniform_real_distribution<float> dis(-1, 1);
+
+		parents.resize(num_joints);
+		auto kfs = MakeSharedPtr<std::vector<KeyFrameSet>>(num_joints);
+		for (uint32_t i = 0; i < num_joints; ++ i)
+		{
+			if (i == 0)
+			{
+				parents[i] = -1;
+			}
+			else
+			{
+				parents[i] = binary_tree ? static_cast<int32_t>((i - 1) / 2) : static_cast<int32_t>(gen() % i);
+			}
+
+			auto& kf = (*kfs)[i];
+			uint32_t const num_keys = (i % 7 == 3) ? 1 : 2 + gen() % 10;
+			uint32_t frame = 0;
+			for (uint32_t k = 0; k < num_keys; ++ k)
+			{
+				kf.frame_id.push_back(frame);
+				frame += 1 + gen() % 8;
+
+				Quaternion const real = MathLib::normalize(Quaternion(dis(gen), dis(gen), dis(gen), dis(gen)));
+				float3 const trans(dis(gen) * 10, dis(gen) * 10, dis(gen) * 10);
+				kf.bind_real.push_back(real);
+				kf.bind_dual.push_back(MathLib::quat_trans_to_udq(real, trans));
+				kf.bind_scale.push_back((i == mirrored_joint) ? -1.0f : 1 + dis(gen) * 0.5f);
+			}
+		}
+
+		return kfs;
+	}
+
+	// The per joint evaluation SkinnedModel::BuildBones used to do
+	void ReferenceEvaluate(std::vector<int32_t> const & parents, std::vector<KeyFrameSet> const & kfs, float frame,
+		std::vector<Quaternion>& reals, std::vector<Quaternion>& duals, std::vector<float>& scales)
+	{
+		reals.resize(parents.size());
+		duals.resize(parents.size());
+		scales.resize(parents.size());
+		for (size_t i = 0; i < parents.size(); ++ i)
+		{
+			auto key_dq = kfs[i].Frame(frame);
+			if (parents[i] < 0)
+			{
+				std::tie(reals[i], duals[i], scales[i]) = key_dq;
+				continue;
+			}
+
+			Quaternion const parent_real = reals[parents[i]];
+			Quaternion const parent_dual = duals[parents[i]];
+			float const parent_scale = scales[parents[i]];
+
+			if (MathLib::dot(std::get<0>(key_dq), parent_real) < 0)
+			{
+				std::get<0>(key_dq) = -std::get<0>(key_dq);
+				std::get<1>(key_dq) = -std::get<1>(key_dq);
+			}
+
+			if ((MathLib::SignBit(std::get<2>(key_dq)) > 0) && (MathLib::SignBit(parent_scale) > 0))
+			{
+				reals[i] = MathLib::mul_real(std::get<0>(key_dq), parent_real);
+				duals[i] = MathLib::mul_dual(std::get<0>(key_dq), std::get<1>(key_dq) * parent_scale, parent_real, parent_dual);
+				scales[i] = std::get<2>(key_dq) * parent_scale;
+			}
+			else
+			{
+				float const key_scale = std::get<2>(key_dq);
+				float4x4 tmp_mat = MathLib::scaling(MathLib::abs(key_scale), MathLib::abs(key_scale), key_scale)
+					* MathLib::to_matrix(std::get<0>(key_dq))
+					* MathLib::translation(MathLib::udq_to_trans(std::get<0>(key_dq), std::get<1>(key_dq)))
+					* MathLib::scaling(MathLib::abs(parent_scale), MathLib::abs(parent_scale), parent_scale)
+					* MathLib::to_matrix(parent_real)
+					* MathLib::translation(MathLib::udq_to_trans(parent_real, parent_dual));
+
+				float flip = 1;
+				if (MathLib::dot(MathLib::cross(float3(tmp_mat(0, 0), tmp_mat(0, 1), tmp_mat(0, 2)),
+					float3(tmp_mat(1, 0), tmp_mat(1, 1), tmp_mat(1, 2))),
+					float3(tmp_mat(2, 0), tmp_mat(2, 1), tmp_mat(2, 2))) < 0)
+				{
+					tmp_mat(2, 0) = -tmp_mat(2, 0);
+					tmp_mat(2, 1) = -tmp_mat(2, 1);
+					tmp_mat(2, 2) = -tmp_mat(2, 2);
+
+					flip = -1;
+				}
+
+				float3 scale;
+				Quaternion rot;
+				float3 trans;
+				MathLib::decompose(scale, rot, trans, tmp_mat);
+
+				reals[i] = rot;
+				duals[i] = MathLib::quat_trans_to_udq(rot, trans);
+				scales[i] = flip * scale.x();
+			}
+		}
+	}
+}
+
+TEST(AnimationEvaluatorTest, Evaluate)
+{
+	uint32_t const num_joints = 67;
+
+	std::vector<int32_t> parents;
+	auto kfs = GenerateKeyFrameSets(parents, num_joints, 40, false);
+
+	AnimationEvaluator evaluator;
+	evaluator.Bind(parents, kfs);
+	EXPECT_EQ(evaluator.NumJoints(), num_joints);
+
+	std::vector<Quaternion> reals;
+	std::vector<Quaternion> duals;
+	std::vector<float> scales;
+	// Steps forward, backward, and across the loop point to move the cursors every way
+	for (float frame : {0.0f, 0.37f, 5.5f, 5.75f, 3.2f, 120.3f, 0.1f, 300.0f, 17.9f, 18.0f, 17.0f})
+	{
+		evaluator.Evaluate(frame);
+		ReferenceEvaluate(parents, *kfs, frame, reals, duals, scales);
+
+		for (uint32_t i = 0; i < num_joints; ++ i)
+		{
+			// Mirrored joints go through a matrix decomposition in both paths, so the chained results can pick opposite hemispheres
+			float const sign = (MathLib::dot(reals[i], evaluator.BindReals()[i]) < 0) ? -1.0f : 1.0f;
+			for (uint32_t c = 0; c < 4; ++ c)
+			{
+				EXPECT_NEAR(evaluator.BindReals()[i][c], sign * reals[i][c], 1e-4f);
+				EXPECT_NEAR(evaluator.BindDuals()[i][c], sign * duals[i][c], 1e-3f);
+			}
+			EXPECT_NEAR(evaluator.BindScales()[i], scales[i], 1e-4f);
+		}
+	}
+}
+
+TEST(AnimationEvaluatorTest, EvaluateBenchmark)
+{
+	uint32_t const num_joints = 256;
+	uint32_t const num_iterations = 2000;
+	float const frame_step = 0.25f;
+
+	std::vector<int32_t> parents;
+	auto kfs = GenerateKeyFrameSets(parents, num_joints, num_joints, true);
+
+	AnimationEvaluator evaluator;
+	evaluator.Bind(parents, kfs);
+
+	Timer timer;
+	for (uint32_t i = 0; i < num_iterations; ++ i)
+	{
+		evaluator.Evaluate(i * frame_step);
+	}
+	double const evaluator_time = timer.elapsed();
+
+	std::vector<Quaternion> reals;
+	std::vector<Quaternion> duals;
+	std::vector<float> scales;
+	timer.restart();
+	for (uint32_t i = 0; i < num_iterations; ++ i)
+	{
+		ReferenceEvaluate(parents, *kfs, i * frame_step, reals, duals, scales);
+	}
+	double const reference_time = timer.elapsed();
+
+	double const num_evaluated = static_cast<double>(num_joints) * num_iterations;
+	std::cout << "AnimationEvaluator: " << num_evaluated / evaluator_time / 1e6 << " M joints/s, per joint evaluation: "
+		<< num_evaluated / reference_time / 1e6 << " M joints/s" << std::endl;
+
+	EXPECT_EQ(evaluator.NumJoints(), num_joints);
+}
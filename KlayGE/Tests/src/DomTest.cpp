@@ -0,0 +1,177 @@
+/**
+ * @file DomTest.cpp
+ * @author Minmin Gong
+ *
+ * @section DESCRIPTION
+ *
+ * This source file is part of KFL, a subproject of KlayGE
+ * For the latest info, see http://www.klayge.org
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * You may alternatively use this source under the terms of
+ * the KlayGE Proprietary License (KPL). You can obtained such a license
+ * from http://www.klayge.org/licensing/.
+ */
+
+#include <KlayGE/KlayGE.hpp>
+#include <KFL/JsonDom.hpp>
+#include <KFL/ResIdentifier.hpp>
+#include <KFL/Timer.hpp>
+#include <KFL/XMLDom.hpp>
+#include <KlayGE/ResLoader.hpp>
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "KlayGETests.hpp"
+
+using namespace std;
+using namespace KlayGE;
+
+namespace
+{
+	ResIdentifierPtr MakeStringRes(std::string const & str)
+	{
+		auto data = MakeSharedPtr<std::string>(str);
+		return MakeSharedPtr<ResIdentifier>("DomTest", 0,
+			std::span<uint8_t const>(reinterpret_cast<uint8_t const *>(data->data()), data->size()), data);
+	}
+
+	uint32_t CountNodes(XMLNode const & node)
+	{
+		uint32_t ret = 1;
+		for (auto* child = node.FirstNode(); child; child = child->NextSibling())
+		{
+			ret += CountNodes(*child);
+		}
+		return ret;
+	}
+}
+
+TEST(DomTest, LoadXml)
+{
+	auto res = MakeStringRes("<?xml version=\"1.0\"?>"
+		"<effect version=\"3\"><parameter type=\"float\" name=\"scale\" value=\"2.5\">text</parameter>"
+		"<parameter type=\"int\" name=\"count\"/><shader><![CDATA[float4 f() { return 0; }]]></shader></effect>");
+	auto doc = LoadXml(*res);
+	res.reset();
+
+	XMLNode* root = doc->RootNode();
+	ASSERT_TRUE(root != nullptr);
+	EXPECT_EQ(root->Name(), "effect");
+	EXPECT_EQ(root->AttribInt("version", 0), 3);
+
+	XMLNode* param = root->FirstNode("parameter");
+	ASSERT_TRUE(param != nullptr);
+	EXPECT_EQ(param->AttribString("name", ""), "scale");
+	EXPECT_EQ(param->AttribFloat("value", 0), 2.5f);
+	EXPECT_EQ(param->ValueString(), "text");
+	EXPECT_EQ(param->NextSibling("parameter")->AttribString("name", ""), "count");
+	EXPECT_EQ(root->FirstNode("shader")->FirstNode()->ValueString(), "float4 f() { return 0; }");
+
+	// Loaded nodes stay editable
+	param->Value(42);
+	param->Attrib("name")->Value(std::string_view("renamed"));
+	param->AppendAttrib(doc->AllocAttribUInt("size", 4));
+	EXPECT_EQ(param->ValueInt(), 42);
+	EXPECT_EQ(param->AttribString("name", ""), "renamed");
+	EXPECT_EQ(param->AttribUInt("size", 0), 4U);
+
+	root->AppendNode(doc->CloneNode(*param));
+	root->RemoveNode(*param);
+	EXPECT_EQ(root->FirstNode("parameter")->AttribString("name", ""), "count");
+	EXPECT_EQ(root->LastNode("parameter")->AttribString("name", ""), "renamed");
+
+	std::ostringstream oss;
+	SaveXml(*doc, oss);
+	auto saved_doc = LoadXml(*MakeStringRes(oss.str()));
+	EXPECT_EQ(CountNodes(*saved_doc->RootNode()), CountNodes(*root));
+	EXPECT_EQ(saved_doc->RootNode()->LastNode("parameter")->AttribUInt("size", 0), 4U);
+}
+
+TEST(DomTest, LoadJson)
+{
+	auto res = MakeStringRes("{\"name\": \"es\\\"cape\", \"count\": 3, \"scale\": 0.5, \"flags\": [true, false, null],"
+		"\"nested\": {\"text\": \"value\"}}");
+	auto doc = LoadJson(*res);
+	res.reset();
+
+	JsonValue* root = doc->RootValue();
+	ASSERT_TRUE(root != nullptr);
+	EXPECT_EQ(root->Member("name")->ValueString(), "es\"cape");
+	EXPECT_EQ(root->Member("count")->ValueInt(), 3);
+	EXPECT_EQ(root->Member("scale")->ValueFloat(), 0.5f);
+	EXPECT_EQ(root->Member("flags")->ValueArray().size(), 3U);
+	EXPECT_EQ(root->Member("flags")->ValueArray()[2]->Type(), JsonValueType::Null);
+	EXPECT_EQ(root->Member("nested")->Member("text")->ValueString(), "value");
+
+	// Loaded values stay editable
+	root->Member("nested")->Member("text")->Value(std::string_view("changed"));
+	root->AppendValue("extra", doc->AllocValueString("added"));
+	auto cloned = root->Member("nested")->Clone();
+	EXPECT_EQ(cloned->Member("text")->ValueString(), "changed");
+	EXPECT_EQ(root->Member("extra")->ValueString(), "added");
+
+	std::ostringstream oss;
+	SaveJson(*doc, oss);
+	auto saved_doc = LoadJson(*MakeStringRes(oss.str()));
+	EXPECT_EQ(saved_doc->RootValue()->Member("name")->ValueString(), "es\"cape");
+	EXPECT_EQ(saved_doc->RootValue()->Member("nested")->Member("text")->ValueString(), "changed");
+}
+
+TEST(DomTest, EffectXmlLoadingBenchmark)
+{
+	std::string_view const effect_names[] = {"ClusteredDeferredRendering.fxml", "DeferredRendering.fxml", "GBuffer.fxml",
+		"InfTerrain.fxml", "LightIndexedDeferredRendering.fxml"};
+
+	std::vector<std::string> sources;
+	for (auto const & name : effect_names)
+	{
+		auto res = ResLoader::Instance().Open(name);
+		ASSERT_TRUE(res);
+
+		res->seekg(0, std::ios_base::end);
+		std::string source(static_cast<size_t>(res->tellg()), '\0');
+		res->seekg(0, std::ios_base::beg);
+		res->read(&source[0], source.size());
+		sources.push_back(std::move(source));
+	}
+
+	uint32_t const num_iterations = 100;
+
+	Timer timer;
+	size_t num_bytes = 0;
+	uint32_t num_nodes = 0;
+	for (uint32_t i = 0; i < num_iterations; ++ i)
+	{
+		for (auto const & source : sources)
+		{
+			auto doc = LoadXml(*MakeStringRes(source));
+			num_nodes += CountNodes(*doc->RootNode());
+			num_bytes += source.size();
+		}
+	}
+	double const elapsed = timer.elapsed();
+
+	EXPECT_GT(num_nodes, 0U);
+
+	std::cout << std::size(effect_names) << " effects loaded " << num_iterations << " times in " << elapsed * 1000 << " ms ("
+		<< num_bytes / elapsed / 1024 / 1024 << " MB/s, " << num_nodes / num_iterations << " nodes per pass)" << std::endl;
+}
@@ -0,0 +1,168 @@
+/**
+ * @file ElementFormatTest.cpp
+ * @author Minmin Gong
+ *
+ * @section DESCRIPTION
+ *
+ * This source file is part of KlayGE
+ * For the latest info, see http://www.klayge.org
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * You may alternatively use this source under the terms of
+ * the KlayGE Proprietary License (KPL). You can obtained such a license
+ * from http://www.klayge.org/licensing/.
+ */
+
+#include <KlayGE/KlayGE.hpp>
+#include <KFL/Half.hpp>
+#include <KFL/Timer.hpp>
+#include <KlayGE/ElementFormat.hpp>
+
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "KlayGETests.hpp"
+
+using namespace std;
+using namespace KlayGE;
+
+namespace
+{
+	std::vector<uint8_t> RandomTexels(ElementFormat fmt, uint32_t num_elems)
+	{
+		std::mt19937 gen;
+		std::uniform_int_distribution<uint32_t> dis(0, 255);
+
+		std::vector<uint8_t> ret(num_elems * NumFormatBytes(fmt));
+		for (auto& b : ret)
+		{
+			b = static_cast<uint8_t>(dis(gen));
+		}
+		if ((EF_R16F == fmt) || (EF_GR16F == fmt) || (EF_ABGR16F == fmt))
+		{
+			// Keeps the halfs finite
+			for (size_t i = 1; i < ret.size(); i += 2)
+			{
+				ret[i] &= 0xBB;
+			}
+		}
+		return ret;
+	}
+
+	// Converts the texels one by one, which always goes through the generic code
+	std::vector<uint8_t> ConvertPerElement(ElementFormat dst_fmt, ElementFormat src_fmt, std::vector<uint8_t> const & src)
+	{
+		uint32_t const src_elem_size = NumFormatBytes(src_fmt);
+		uint32_t const dst_elem_size = NumFormatBytes(dst_fmt);
+		uint32_t const num_elems = static_cast<uint32_t>(src.size() / src_elem_size);
+
+		std::vector<uint8_t> ret(num_elems * dst_elem_size);
+		for (uint32_t i = 0; i < num_elems; ++ i)
+		{
+			Color clr;
+			ConvertToABGR32F(src_fmt, &src[i * src_elem_size], 1, &clr);
+			ConvertFromABGR32F(dst_fmt, &clr, 1, &ret[i * dst_elem_size]);
+		}
+		return ret;
+	}
+
+	ElementFormat const conversion_pairs[][2] =
+	{
+		{ EF_ARGB8, EF_ABGR8 },
+		{ EF_ABGR8, EF_ARGB8 },
+		{ EF_ARGB8, EF_ABGR32F },
+		{ EF_ABGR32F, EF_ARGB8 },
+		{ EF_ARGB8_SRGB, EF_ARGB8 },
+		{ EF_ARGB8_SRGB, EF_ABGR32F },
+		{ EF_R8, EF_ARGB8 },
+		{ EF_GR8, EF_ARGB8 },
+		{ EF_A2BGR10, EF_ABGR32F },
+		{ EF_ABGR32F, EF_A2BGR10 },
+		{ EF_R16F, EF_ABGR32F },
+		{ EF_GR16F, EF_ABGR32F },
+		{ EF_ABGR16F, EF_ABGR32F },
+		{ EF_ABGR16F, EF_ARGB8 },
+		{ EF_R16F, EF_R8 }
+	};
+}
+
+TEST(ElementFormatTest, HalfSpecialValues)
+{
+	EXPECT_EQ(static_cast<float>(half(0.0f)), 0.0f);
+	EXPECT_EQ(static_cast<float>(half(1.0f)), 1.0f);
+	EXPECT_EQ(static_cast<float>(half(-2.5f)), -2.5f);
+	EXPECT_EQ(static_cast<float>(half::pos_inf()), std::numeric_limits<float>::infinity());
+	EXPECT_EQ(static_cast<float>(half::neg_inf()), -std::numeric_limits<float>::infinity());
+}
+
+TEST(ElementFormatTest, BulkConversionMatchesPerElement)
+{
+	uint32_t const num_elems = 1027;
+	for (auto const & pair : conversion_pairs)
+	{
+		ElementFormat const src_fmt = pair[0];
+		ElementFormat const dst_fmt = pair[1];
+		if (EF_ABGR32F == src_fmt)
+		{
+			continue;
+		}
+
+		std::vector<uint8_t> const src = RandomTexels(src_fmt, num_elems);
+
+		std::vector<Color> bulk_32f(num_elems);
+		ConvertToABGR32F(src_fmt, src.data(), num_elems, bulk_32f.data());
+		std::vector<uint8_t> const ref_32f = ConvertPerElement(EF_ABGR32F, src_fmt, src);
+		EXPECT_EQ(std::memcmp(bulk_32f.data(), ref_32f.data(), ref_32f.size()), 0);
+
+		std::vector<uint8_t> direct(num_elems * NumFormatBytes(dst_fmt));
+		ConvertFormat(dst_fmt, direct.data(), src_fmt, src.data(), num_elems);
+		EXPECT_TRUE(direct == ConvertPerElement(dst_fmt, src_fmt, src));
+	}
+}
+
+TEST(ElementFormatTest, ConversionThroughput)
+{
+	uint32_t const num_elems = 1024 * 1024;
+	for (auto const & pair : conversion_pairs)
+	{
+		ElementFormat const src_fmt = pair[0];
+		ElementFormat const dst_fmt = pair[1];
+
+		std::vector<uint8_t> src;
+		if (EF_ABGR32F == src_fmt)
+		{
+			std::vector<uint8_t> const texels = RandomTexels(EF_ARGB8, num_elems);
+			src.resize(num_elems * sizeof(Color));
+			ConvertToABGR32F(EF_ARGB8, texels.data(), num_elems, reinterpret_cast<Color*>(src.data()));
+		}
+		else
+		{
+			src = RandomTexels(src_fmt, num_elems);
+		}
+		std::vector<uint8_t> dst(num_elems * NumFormatBytes(dst_fmt));
+
+		Timer timer;
+		ConvertFormat(dst_fmt, dst.data(), src_fmt, src.data(), num_elems);
+		double const elapsed = timer.elapsed();
+
+		std::cout << "Converting " << src_fmt << " to " << dst_fmt << ": " << num_elems / elapsed / 1e6 << " M texels/s" << std::endl;
+	}
+}
@@ -1,5 +1,6 @@
 #include <KlayGE/KlayGE.hpp>
 #include <KFL/ErrorHandling.hpp>
+#include <KFL/Timer.hpp>
 #include <KlayGE/TexCompressionBC.hpp>
 #include <KlayGE/TexCompressionETC.hpp>
 #include <KlayGE/Texture.hpp>
@@ -15,15 +16,8 @@
 using namespace std;
 using namespace KlayGE;
 
-void TestEncodeDecodeTex(std::string_view input_name, std::string_view tc_name,
-		ElementFormat bc_fmt, float threshold)
+std::unique_ptr<TexCompression> CreateTexCodec(ElementFormat bc_fmt)
 {
-	ResLoader::Instance().AddPath("../../Tests/media/EncodeDecodeTex");
-
-	std::vector<uint8_t> input_argb;
-	std::vector<uint8_t> bc_blocks;
-	uint32_t width, height;
-
 	std::unique_ptr<TexCompression> codec;
 	switch (bc_fmt)
 	{
@@ -55,10 +49,28 @@ void TestEncodeDecodeTex(std::string_view input_name, std::string_view tc_name,
 		codec = MakeUniquePtr<TexCompressionETC1>();
 		break;
 
+	case EF_ETC2_BGR8:
+		codec = MakeUniquePtr<TexCompressionETC2RGB8>();
+		break;
+
 	default:
 		KFL_UNREACHABLE("Unsupported compression format");
 	}
 
+	return codec;
+}
+
+void TestEncodeDecodeTex(std::string_view input_name, std::string_view tc_name,
+		ElementFormat bc_fmt, float threshold)
+{
+	ResLoader::Instance().AddPath("../../Tests/media/EncodeDecodeTex");
+
+	std::vector<uint8_t> input_argb;
+	std::vector<uint8_t> bc_blocks;
+	uint32_t width, height;
+
+	std::unique_ptr<TexCompression> codec = CreateTexCodec(bc_fmt);
+
 	ElementFormat const decoded_fmt = DecodedFormat(bc_fmt);
 	uint32_t const pixel_size = NumFormatBytes(decoded_fmt);
 
@@ -229,6 +241,118 @@ void TestEncodeDecodeTex(std::string_view input_name, std::string_view tc_name,
 	EXPECT_LT(mse, threshold);
 }
 
+void TestEncodeThroughput(std::string_view input_name, ElementFormat bc_fmt, TexCompressionMethod method, float threshold)
+{
+	ResLoader::Instance().AddPath("../../Tests/media/EncodeDecodeTex");
+
+	std::unique_ptr<TexCompression> codec = CreateTexCodec(bc_fmt);
+
+	TexturePtr in_tex = LoadSoftwareTexture(input_name);
+	uint32_t const width = in_tex->Width(0);
+	uint32_t const height = in_tex->Height(0);
+	auto const & init_data = checked_cast<SoftwareTexture&>(*in_tex).SubresourceData();
+
+	BOOST_ASSERT(NumFormatBytes(in_tex->Format()) == 4);
+	uint32_t const pixel_size = NumFormatBytes(DecodedFormat(bc_fmt));
+
+	// Formats with fewer channels take R, then G, of the ARGB8 source
+	void const * input = init_data[0].data;
+	uint32_t input_row_pitch = init_data[0].row_pitch;
+	uint32_t input_slice_pitch = init_data[0].slice_pitch;
+	std::vector<uint8_t> packed_input;
+	if (pixel_size != 4)
+	{
+		BOOST_ASSERT(pixel_size <= 2);
+
+		packed_input.resize(width * height * pixel_size);
+		for (uint32_t y = 0; y < height; ++ y)
+		{
+			uint8_t const * src = static_cast<uint8_t const *>(init_data[0].data) + y * init_data[0].row_pitch;
+			for (uint32_t x = 0; x < width; ++ x)
+			{
+				for (uint32_t c = 0; c < pixel_size; ++ c)
+				{
+					packed_input[(y * width + x) * pixel_size + c] = src[x * 4 + 2 - c];
+				}
+			}
+		}
+		input = packed_input.data();
+		input_row_pitch = width * pixel_size;
+		input_slice_pitch = input_row_pitch * height;
+	}
+
+	uint32_t const block_width = BlockWidth(bc_fmt);
+	uint32_t const block_height = BlockHeight(bc_fmt);
+	uint32_t const block_bytes = BlockBytes(bc_fmt);
+	uint32_t const bc_row_pitch = (width + block_width - 1) / block_width * block_bytes;
+	std::vector<uint8_t> bc_blocks((height + block_height - 1) / block_height * bc_row_pitch);
+
+	Timer timer;
+	codec->EncodeMem(width, height, &bc_blocks[0], bc_row_pitch, static_cast<uint32_t>(bc_blocks.size()),
+		input, input_row_pitch, input_slice_pitch, method);
+	double const encode_time = timer.elapsed();
+
+	std::vector<uint8_t> restored_argb(width * height * pixel_size);
+	codec->DecodeMem(width, height, &restored_argb[0], width * pixel_size, static_cast<uint32_t>(restored_argb.size()),
+		&bc_blocks[0], bc_row_pitch, static_cast<uint32_t>(bc_blocks.size()));
+
+	float mse = 0;
+	uint8_t const * src = static_cast<uint8_t const *>(input);
+	for (uint32_t y = 0; y < height; ++ y)
+	{
+		for (uint32_t x = 0; x < width * pixel_size; ++ x)
+		{
+			float const diff = static_cast<float>(src[y * input_row_pitch + x]) - restored_argb[y * width * pixel_size + x];
+			mse += diff * diff;
+		}
+	}
+	mse = sqrt(mse / (width * height) / pixel_size);
+	EXPECT_LT(mse, threshold);
+
+	std::cout << "Encoding " << width << "x" << height << " to format " << bc_fmt << ": "
+		<< width * height / encode_time / 1e6 << " MP/s, PSNR " << 20 * log10(255 / mse) << " dB" << std::endl;
+}
+
+TEST(EncodeDecodeTexTest, EncodeThroughputBC1)
+{
+	TestEncodeThroughput("Lenna.dds", EF_BC1, TCM_Balanced, 4.6f);
+}
+
+TEST(EncodeDecodeTexTest, EncodeThroughputBC3)
+{
+	TestEncodeThroughput("leaf_v3_green_tex.dds", EF_BC3, TCM_Balanced, 8.9f);
+}
+
+TEST(EncodeDecodeTexTest, EncodeThroughputBC4)
+{
+	TestEncodeThroughput("Lenna.dds", EF_BC4, TCM_Balanced, 4.0f);
+}
+
+TEST(EncodeDecodeTexTest, EncodeThroughputBC5)
+{
+	TestEncodeThroughput("Lenna.dds", EF_BC5, TCM_Balanced, 4.0f);
+}
+
+TEST(EncodeDecodeTexTest, EncodeThroughputBC7)
+{
+	TestEncodeThroughput("Lenna.dds", EF_BC7, TCM_Balanced, 1.8f);
+}
+
+TEST(EncodeDecodeTexTest, EncodeThroughputETC1)
+{
+	TestEncodeThroughput("Lenna.dds", EF_ETC1, TCM_Balanced, 4.8f);
+}
+
+TEST(EncodeDecodeTexTest, EncodeThroughputETC1Speed)
+{
+	TestEncodeThroughput("Lenna.dds", EF_ETC1, TCM_Speed, 6.0f);
+}
+
+TEST(EncodeDecodeTexTest, EncodeThroughputETC2RGB8)
+{
+	TestEncodeThroughput("Lenna.dds", EF_ETC2_BGR8, TCM_Balanced, 4.8f);
+}
+
 TEST(EncodeDecodeTexTest, DecodeBC1)
 {
 	TestEncodeDecodeTex("Lenna.dds", "Lenna_bc1.dds", EF_BC1, 4.7f);
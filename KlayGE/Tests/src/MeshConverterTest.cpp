@@ -29,7 +29,11 @@
  */
 
 #include <KlayGE/KlayGE.hpp>
+#include <KFL/Timer.hpp>
 #include <KlayGE/Context.hpp>
+#include <KlayGE/GraphicsBuffer.hpp>
+#include <KlayGE/RenderMaterial.hpp>
+#include <KlayGE/SceneNode.hpp>
 #include <KlayGE/RenderFactory.hpp>
 #include <KlayGE/ResLoader.hpp>
 #include <KlayGE/Texture.hpp>
@@ -37,6 +41,13 @@
 #include <KlayGE/Mesh.hpp>
 #include <KlayGE/DevHelper/MeshConverter.hpp>
 #include <KlayGE/DevHelper/MeshMetadata.hpp>
+#include <KlayGE/LZMACodec.hpp>
+#include <KFL/ResIdentifier.hpp>
+
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
 
 #include "KlayGETests.hpp"
 
@@ -819,3 +830,243 @@ TEST_F(MeshConverterTest, StaticMeshML)
 {
 	RunTest("tree2a.lod.meshml", "", "tree2a.lod.meshml");
 }
+
+namespace
+{
+	struct GridData
+	{
+		uint32_t grid_size;
+		std::vector<float3> positions;
+		std::vector<uint32_t> normals;
+		std::vector<float2> texcoords;
+		std::vector<uint32_t> indices;
+	};
+
+	GridData GenerateGrid(uint32_t grid_size)
+	{
+		GridData grid;
+		grid.grid_size = grid_size;
+
+		uint32_t const num_vertices = grid_size * grid_size;
+		grid.positions.resize(num_vertices);
+		grid.normals.resize(num_vertices);
+		grid.texcoords.resize(num_vertices);
+		for (uint32_t y = 0; y < grid_size; ++ y)
+		{
+			for (uint32_t x = 0; x < grid_size; ++ x)
+			{
+				uint32_t const index = y * grid_size + x;
+				grid.positions[index] = float3(static_cast<float>(x), std::sin(x * 0.1f) * std::cos(y * 0.1f), static_cast<float>(y));
+				grid.normals[index] = 0x7F7FFF7F;
+				grid.texcoords[index] = float2(static_cast<float>(x) / grid_size, static_cast<float>(y) / grid_size);
+			}
+		}
+		grid.indices.reserve((grid_size - 1) * (grid_size - 1) * 6);
+		for (uint32_t y = 0; y < grid_size - 1; ++ y)
+		{
+			for (uint32_t x = 0; x < grid_size - 1; ++ x)
+			{
+				uint32_t const index = y * grid_size + x;
+				grid.indices.insert(grid.indices.end(),
+					{index, index + grid_size, index + 1, index + 1, index + grid_size, index + grid_size + 1});
+			}
+		}
+
+		return grid;
+	}
+
+	void SaveGridModel(GridData const & grid, std::string const & model_name)
+	{
+		auto make_buffer = [](void const * data, size_t size)
+		{
+			auto buff = MakeSharedPtr<SoftwareGraphicsBuffer>(static_cast<uint32_t>(size), false);
+			buff->CreateHWResource(data);
+			return buff;
+		};
+
+		auto mesh = MakeSharedPtr<StaticMesh>(L"Grid");
+		mesh->MaterialID(0);
+		mesh->NumLods(1);
+		mesh->AddVertexStream(0, make_buffer(grid.positions.data(), grid.positions.size() * sizeof(grid.positions[0])),
+			VertexElement(VEU_Position, 0, EF_BGR32F));
+		mesh->AddVertexStream(0, make_buffer(grid.normals.data(), grid.normals.size() * sizeof(grid.normals[0])),
+			VertexElement(VEU_Normal, 0, EF_ABGR8));
+		mesh->AddVertexStream(0, make_buffer(grid.texcoords.data(), grid.texcoords.size() * sizeof(grid.texcoords[0])),
+			VertexElement(VEU_TextureCoord, 0, EF_GR32F));
+		mesh->AddIndexStream(0, make_buffer(grid.indices.data(), grid.indices.size() * sizeof(grid.indices[0])), EF_R32UI);
+		mesh->NumVertices(0, static_cast<uint32_t>(grid.positions.size()));
+		mesh->NumIndices(0, static_cast<uint32_t>(grid.indices.size()));
+		mesh->StartVertexLocation(0, 0);
+		mesh->StartIndexLocation(0, 0);
+		mesh->PosBound(AABBox(float3(0, -1, 0), float3(static_cast<float>(grid.grid_size), 1, static_cast<float>(grid.grid_size))));
+		mesh->TexcoordBound(AABBox(float3(0, 0, 0), float3(1, 1, 0)));
+
+		auto root = MakeSharedPtr<SceneNode>(L"Grid", SceneNode::SOA_Cullable);
+		root->AddComponent(MakeSharedPtr<RenderableComponent>(mesh));
+
+		RenderModel model(root);
+		model.NumMaterials(1);
+		model.GetMaterial(0) = MakeSharedPtr<RenderMaterial>();
+		model.AssignMeshes(&mesh, &mesh + 1);
+
+		SaveModel(model, model_name);
+	}
+
+	void CheckGridModel(GridData const & grid, RenderModel const & model)
+	{
+		EXPECT_EQ(model.NumMeshes(), 1U);
+
+		auto const& rl = checked_cast<StaticMesh&>(*model.Mesh(0)).GetRenderLayout();
+		EXPECT_EQ(rl.NumVertexStreams(), 3U);
+		EXPECT_EQ(rl.IndexStreamFormat(), EF_R32UI);
+		{
+			GraphicsBuffer::Mapper mapper(*rl.GetVertexStream(0), BA_Read_Only);
+			EXPECT_EQ(std::memcmp(mapper.Pointer<void>(), grid.positions.data(), grid.positions.size() * sizeof(grid.positions[0])), 0);
+		}
+		{
+			GraphicsBuffer::Mapper mapper(*rl.GetIndexStream(), BA_Read_Only);
+			EXPECT_EQ(std::memcmp(mapper.Pointer<void>(), grid.indices.data(), grid.indices.size() * sizeof(grid.indices[0])), 0);
+		}
+	}
+
+	// Rewrites a v20 model_bin in the v19 layout: one LZMA stream of the description, with the merged vertex and index
+	//  data inlined after the mesh counts.
+	void ConvertToLegacyModelBin(std::string const & model_name, std::string const & legacy_name)
+	{
+		std::vector<uint8_t> file_data(static_cast<size_t>(FILESYSTEM_NS::file_size(model_name)));
+		{
+			std::ifstream ifs(model_name.c_str(), std::ios_base::binary);
+			ifs.read(reinterpret_cast<char*>(file_data.data()), static_cast<std::streamsize>(file_data.size()));
+		}
+
+		auto read_le = [&file_data](auto& value, size_t offset)
+		{
+			std::memcpy(&value, &file_data[offset], sizeof(value));
+			value = LE2Native(value);
+		};
+
+		uint32_t num_chunks;
+		read_le(num_chunks, sizeof(uint32_t) * 2);
+		std::vector<std::vector<uint8_t>> chunks(num_chunks);
+		LZMACodec lzma;
+		for (uint32_t i = 0; i < num_chunks; ++ i)
+		{
+			size_t const desc_offset = sizeof(uint32_t) * 4 + i * 32;
+			uint64_t offset;
+			read_le(offset, desc_offset + 8);
+			uint64_t len;
+			read_le(len, desc_offset + 16);
+			uint64_t original_len;
+			read_le(original_len, desc_offset + 24);
+			lzma.Decode(chunks[i], MakeSpan(&file_data[static_cast<size_t>(offset)], static_cast<size_t>(len)), original_len);
+		}
+
+		// Walks the description up to the end of the mesh counts, where v19 has the buffers
+		auto const & desc = chunks[0];
+		ResIdentifier desc_res(model_name, 0, MakeSpan(desc), nullptr);
+		uint32_t counts[6];
+		desc_res.read(counts, sizeof(counts));
+		for (uint32_t i = 0; i < LE2Native(counts[0]); ++ i)
+		{
+			ReadShortString(desc_res);
+			desc_res.seekg(sizeof(float) * 9 + sizeof(uint8_t) * 4, std::ios_base::cur);
+			std::string tex_names[RenderMaterial::TS_NumTextureSlots];
+			for (auto& tex_name : tex_names)
+			{
+				tex_name = ReadShortString(desc_res);
+			}
+			int64_t extra = 0;
+			extra += tex_names[RenderMaterial::TS_Normal].empty() ? 0 : sizeof(float);
+			extra += tex_names[RenderMaterial::TS_Height].empty() ? 0 : sizeof(float) * 2;
+			extra += tex_names[RenderMaterial::TS_Occlusion].empty() ? 0 : sizeof(float);
+			desc_res.seekg(extra, std::ios_base::cur);
+			uint8_t detail_mode;
+			desc_res.read(&detail_mode, sizeof(detail_mode));
+			if ((detail_mode == static_cast<uint8_t>(RenderMaterial::SurfaceDetailMode::FlatTessellation))
+				|| (detail_mode == static_cast<uint8_t>(RenderMaterial::SurfaceDetailMode::SmoothTessellation)))
+			{
+				desc_res.seekg(sizeof(float) * 4, std::ios_base::cur);
+			}
+		}
+		uint32_t num_merged_ves;
+		desc_res.read(&num_merged_ves, sizeof(num_merged_ves));
+		desc_res.seekg(LE2Native(num_merged_ves) * sizeof(VertexElement) + sizeof(uint32_t) * 2 + sizeof(char), std::ios_base::cur);
+		size_t const split = static_cast<size_t>(desc_res.tellg());
+
+		std::vector<uint8_t> legacy(desc.begin(), desc.begin() + split);
+		for (uint32_t i = 1; i < num_chunks; ++ i)
+		{
+			legacy.insert(legacy.end(), chunks[i].begin(), chunks[i].end());
+		}
+		legacy.insert(legacy.end(), desc.begin() + split, desc.end());
+
+		std::vector<uint8_t> encoded;
+		lzma.Encode(encoded, MakeSpan(legacy));
+
+		std::ofstream ofs(legacy_name.c_str(), std::ios_base::binary);
+		uint32_t const fourcc = Native2LE(MakeFourCC<'K', 'L', 'M', ' '>::value);
+		ofs.write(reinterpret_cast<char const *>(&fourcc), sizeof(fourcc));
+		uint32_t const ver = Native2LE(19U);
+		ofs.write(reinterpret_cast<char const *>(&ver), sizeof(ver));
+		uint64_t const original_len = Native2LE(static_cast<uint64_t>(legacy.size()));
+		ofs.write(reinterpret_cast<char const *>(&original_len), sizeof(original_len));
+		uint64_t const len = Native2LE(static_cast<uint64_t>(encoded.size()));
+		ofs.write(reinterpret_cast<char const *>(&len), sizeof(len));
+		ofs.write(reinterpret_cast<char const *>(encoded.data()), static_cast<std::streamsize>(encoded.size()));
+	}
+}
+
+TEST_F(MeshConverterTest, ModelBinLegacyLoad)
+{
+	GridData const grid = GenerateGrid(64);
+
+	std::string const model_name = "MeshConverterTestLegacyGrid.model_bin";
+	std::string const legacy_name = "MeshConverterTestLegacyGridV19.model_bin";
+	SaveGridModel(grid, model_name);
+	ConvertToLegacyModelBin(model_name, legacy_name);
+
+	auto loaded_model = LoadSoftwareModel(legacy_name);
+	ASSERT_TRUE(loaded_model);
+	CheckGridModel(grid, *loaded_model);
+
+	loaded_model.reset();
+	FILESYSTEM_NS::remove(model_name);
+	FILESYSTEM_NS::remove(legacy_name);
+}
+
+TEST_F(MeshConverterTest, ModelBinLoadBenchmark)
+{
+	uint32_t const GRID_SIZE = 1024;
+	uint32_t const NUM_ITERATIONS = 5;
+
+	GridData const grid = GenerateGrid(GRID_SIZE);
+
+	std::string const model_name = "MeshConverterTestGrid.model_bin";
+
+	Timer timer;
+	SaveGridModel(grid, model_name);
+	double const save_time = timer.elapsed();
+
+	RenderModelPtr loaded_model;
+	timer.restart();
+	for (uint32_t i = 0; i < NUM_ITERATIONS; ++ i)
+	{
+		loaded_model = LoadSoftwareModel(model_name);
+	}
+	double const load_time = timer.elapsed() / NUM_ITERATIONS;
+
+	ASSERT_TRUE(loaded_model);
+	CheckGridModel(grid, *loaded_model);
+
+	uint64_t const file_size = FILESYSTEM_NS::file_size(model_name);
+	uint64_t const decoded_size = grid.positions.size() * sizeof(grid.positions[0]) + grid.normals.size() * sizeof(grid.normals[0])
+		+ grid.texcoords.size() * sizeof(grid.texcoords[0]) + grid.indices.size() * sizeof(grid.indices[0]);
+	std::cout << "model_bin with " << grid.positions.size() << " vertices: save " << save_time * 1000 << " ms, load "
+		<< load_time * 1000 << " ms" << std::endl;
+	// Not measured. The loader only holds the compressed payload on top of the final buffers, so this is its lower bound.
+	std::cout << "Estimated peak loading memory: " << (file_size + decoded_size) / 1024 << " KB (" << file_size / 1024
+		<< " KB compressed, " << decoded_size / 1024 << " KB decoded)" << std::endl;
+
+	loaded_model.reset();
+	FILESYSTEM_NS::remove(model_name);
+}
@@ -30,18 +30,66 @@
 
 #include <KlayGE/KlayGE.hpp>
 
+#include <KFL/Timer.hpp>
 #include <KlayGE/Mipmapper.hpp>
 #include <KlayGE/RenderFactory.hpp>
 #include <KlayGE/ResLoader.hpp>
+#include <KlayGE/SoftwareMipmapper.hpp>
 #include <KlayGE/Texture.hpp>
 #include <KlayGE/DevHelper/TexConverter.hpp>
 #include <KlayGE/DevHelper/TexMetadata.hpp>
 
+#include <iostream>
+#include <random>
+#include <vector>
+
 #include "KlayGETests.hpp"
 
 using namespace std;
 using namespace KlayGE;
 
+namespace
+{
+	TexturePtr CreateRandomSoftwareTexture(Texture::TextureType type, uint32_t size, uint32_t array_size, ElementFormat format)
+	{
+		auto tex = MakeSharedPtr<SoftwareTexture>(type, size, (type == Texture::TT_1D) ? 1 : size, 1, 0, array_size, format, false);
+		tex->CreateHWResource({}, nullptr);
+
+		uint32_t const num_faces = (type == Texture::TT_Cube) ? 6 : 1;
+		auto const& subres_data = tex->SubresourceData();
+
+		std::ranlux24_base gen;
+		std::uniform_int_distribution<uint32_t> dis(0, 255);
+		for (uint32_t i = 0; i < array_size * num_faces; ++ i)
+		{
+			auto const& init_data = subres_data[i * tex->NumMipMaps()];
+			uint8_t* p = static_cast<uint8_t*>(const_cast<void*>(init_data.data));
+			for (uint32_t j = 0; j < init_data.slice_pitch; ++ j)
+			{
+				p[j] = static_cast<uint8_t>(dis(gen));
+			}
+		}
+
+		return tex;
+	}
+
+	std::vector<Color> ReadSoftwareLevel(Texture& tex, uint32_t subres)
+	{
+		auto const& init_data = checked_cast<SoftwareTexture&>(tex).SubresourceData()[subres];
+		uint32_t const level = subres % tex.NumMipMaps();
+		uint32_t const width = tex.Width(level);
+		uint32_t const height = tex.Height(level);
+
+		std::vector<Color> ret(width * height);
+		for (uint32_t y = 0; y < height; ++ y)
+		{
+			ConvertToABGR32F(tex.Format(), static_cast<uint8_t const*>(init_data.data) + y * init_data.row_pitch, width,
+				&ret[y * width]);
+		}
+		return ret;
+	}
+}
+
 class MipmapperTest : public testing::Test
 {
 public:
@@ -208,3 +256,121 @@ TEST_F(MipmapperTest, MipmapPoTSRGB2DLinear)
 
 	TestMipmapPoT2D(input_metadata, TextureFilter::Linear, sanity_metadata, 4.0f / 255);
 }
+
+TEST_F(MipmapperTest, SoftwareMipmapBox2DArray)
+{
+	uint32_t const size = 256;
+	uint32_t const array_size = 4;
+
+	auto tex = CreateRandomSoftwareTexture(Texture::TT_2D, size, array_size, EF_ARGB8);
+	SoftwareMipmapper mipmapper(MipmapFilter::Box);
+	mipmapper.BuildSubLevels(*tex);
+
+	uint32_t const num_mipmaps = tex->NumMipMaps();
+	for (uint32_t index = 0; index < array_size; ++ index)
+	{
+		for (uint32_t level = 1; level < num_mipmaps; ++ level)
+		{
+			auto const src = ReadSoftwareLevel(*tex, index * num_mipmaps + level - 1);
+			auto const dst = ReadSoftwareLevel(*tex, index * num_mipmaps + level);
+
+			uint32_t const src_width = tex->Width(level - 1);
+			uint32_t const dst_width = tex->Width(level);
+			for (uint32_t y = 0; y < tex->Height(level); ++ y)
+			{
+				for (uint32_t x = 0; x < dst_width; ++ x)
+				{
+					Color const avg = (src[(y * 2 + 0) * src_width + x * 2 + 0] + src[(y * 2 + 0) * src_width + x * 2 + 1]
+						+ src[(y * 2 + 1) * src_width + x * 2 + 0] + src[(y * 2 + 1) * src_width + x * 2 + 1]) * 0.25f;
+					for (uint32_t c = 0; c < 4; ++ c)
+					{
+						EXPECT_NEAR(avg[c], dst[y * dst_width + x][c], 1.0f / 255);
+					}
+				}
+			}
+		}
+	}
+}
+
+TEST_F(MipmapperTest, SoftwareMipmapSRGBCube)
+{
+	uint32_t const size = 64;
+
+	auto tex = MakeSharedPtr<SoftwareTexture>(Texture::TT_Cube, size, size, 1, 0, 1, EF_ARGB8_SRGB, false);
+	tex->CreateHWResource({}, nullptr);
+	for (uint32_t face = 0; face < 6; ++ face)
+	{
+		auto const& init_data = tex->SubresourceData()[face * tex->NumMipMaps()];
+		for (uint32_t y = 0; y < size; ++ y)
+		{
+			uint32_t* p = reinterpret_cast<uint32_t*>(static_cast<uint8_t*>(const_cast<void*>(init_data.data)) + y * init_data.row_pitch);
+			for (uint32_t x = 0; x < size; ++ x)
+			{
+				p[x] = ((x + y) & 1) ? 0xFFFFFFFFU : 0xFF000000U;
+			}
+		}
+	}
+
+	SoftwareMipmapper mipmapper(MipmapFilter::Box);
+	mipmapper.BuildSubLevels(*tex);
+
+	// A black and white checkerboard has to average to 0.5 in linear space, not in sRGB space
+	for (uint32_t face = 0; face < 6; ++ face)
+	{
+		for (uint32_t level = 1; level < tex->NumMipMaps(); ++ level)
+		{
+			for (auto const& texel : ReadSoftwareLevel(*tex, face * tex->NumMipMaps() + level))
+			{
+				EXPECT_NEAR(texel.r(), 0.5f, 0.01f);
+				EXPECT_NEAR(texel.a(), 1.0f, 1.0f / 255);
+			}
+		}
+	}
+}
+
+TEST_F(MipmapperTest, SoftwareMipmapAlphaCoverage)
+{
+	uint32_t const size = 256;
+	float const alpha_ref = 0.5f;
+
+	auto tex = CreateRandomSoftwareTexture(Texture::TT_2D, size, 1, EF_ABGR8);
+	SoftwareMipmapper mipmapper(MipmapFilter::Kaiser);
+	mipmapper.PreserveAlphaCoverage(true, alpha_ref);
+	mipmapper.BuildSubLevels(*tex);
+
+	auto coverage = [alpha_ref](std::vector<Color> const& texels) {
+		uint32_t count = 0;
+		for (auto const& texel : texels)
+		{
+			if (texel.a() > alpha_ref)
+			{
+				++ count;
+			}
+		}
+		return static_cast<float>(count) / texels.size();
+	};
+
+	float const base_coverage = coverage(ReadSoftwareLevel(*tex, 0));
+	for (uint32_t level = 1; tex->Width(level) >= 16; ++ level)
+	{
+		EXPECT_NEAR(coverage(ReadSoftwareLevel(*tex, level)), base_coverage, 0.05f);
+	}
+}
+
+TEST_F(MipmapperTest, SoftwareMipmapperPerformance)
+{
+	uint32_t const size = 512;
+
+	for (auto filter : {MipmapFilter::Box, MipmapFilter::Kaiser, MipmapFilter::Lanczos})
+	{
+		auto tex = CreateRandomSoftwareTexture(Texture::TT_Cube, size, 1, EF_ARGB8_SRGB);
+		SoftwareMipmapper mipmapper(filter);
+
+		Timer timer;
+		mipmapper.BuildSubLevels(*tex);
+		double const elapsed = timer.elapsed();
+
+		std::cout << "Building mipmaps of a " << size << "x" << size << " cube map with filter " << static_cast<int>(filter) << ": "
+			<< size * size * 6 / elapsed / 1e6 << " M source texels/s" << std::endl;
+	}
+}
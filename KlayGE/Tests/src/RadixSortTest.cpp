@@ -0,0 +1,97 @@
+/**
+ * @file RadixSortTest.cpp
+ * @author Minmin Gong
+ *
+ * @section DESCRIPTION
+ *
+ * This source file is part of KFL, a subproject of KlayGE
+ * For the latest info, see http://www.klayge.org
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * You may alternatively use this source under the terms of
+ * the KlayGE Proprietary License (KPL). You can obtained such a license
+ * from http://www.klayge.org/licensing/.
+ */
+
+#include <KlayGE/KlayGE.hpp>
+#include <KFL/RadixSort.hpp>
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "KlayGETests.hpp"
+
+using namespace std;
+using namespace KlayGE;
+
+TEST(RadixSortTest, SortUInt32)
+{
+	std::mt19937 gen;
+	std::uniform_int_distribution<uint32_t> dis(0, 1000);
+
+	uint32_t const num = 10000;
+	std::vector<uint32_t> keys(num);
+	std::vector<uint32_t> values(num);
+	for (uint32_t i = 0; i < num; ++ i)
+	{
+		keys[i] = dis(gen);
+		values[i] = i;
+	}
+
+	std::vector<uint32_t> sorted_values(values);
+	std::stable_sort(sorted_values.begin(), sorted_values.end(),
+		[&keys](uint32_t lhs, uint32_t rhs)
+		{
+			return keys[lhs] < keys[rhs];
+		});
+
+	std::vector<uint32_t> tmp_keys(num);
+	std::vector<uint32_t> tmp_values(num);
+	RadixSort(keys.data(), values.data(), num, tmp_keys.data(), tmp_values.data());
+
+	EXPECT_TRUE(std::is_sorted(keys.begin(), keys.end()));
+	EXPECT_TRUE(values == sorted_values);
+}
+
+TEST(RadixSortTest, SortFloat)
+{
+	std::mt19937 gen;
+	std::uniform_real_distribution<float> dis(-100.0f, 100.0f);
+
+	uint32_t const num = 10000;
+	std::vector<float> depths(num);
+	std::vector<uint32_t> keys(num);
+	std::vector<uint32_t> values(num);
+	for (uint32_t i = 0; i < num; ++ i)
+	{
+		depths[i] = dis(gen);
+		keys[i] = FloatToSortableKey(depths[i]);
+		values[i] = i;
+	}
+
+	std::vector<uint32_t> tmp_keys(num);
+	std::vector<uint32_t> tmp_values(num);
+	RadixSort(keys.data(), values.data(), num, tmp_keys.data(), tmp_values.data());
+
+	for (uint32_t i = 1; i < num; ++ i)
+	{
+		EXPECT_LE(depths[values[i - 1]], depths[values[i]]);
+	}
+}
@@ -1,10 +1,12 @@
 #include <KlayGE/KlayGE.hpp>
+#include <KFL/AlignedAllocator.hpp>
 #include <KFL/Math.hpp>
 #include <KFL/SIMDMath.hpp>
 
 #include "KlayGETests.hpp"
 
 #include <vector>
+#include <random>
 #include <string>
 #include <iostream>
 
@@ -31,3 +33,50 @@ TEST(SIMDMathTest, NormalizeVector4)
 	v = SIMDMathLib::NormalizeVector4(v);
 	EXPECT_LT(MathLib::abs(SIMDMathLib::GetX(SIMDMathLib::LengthVector4(v)) - 1.0f), 1e-3f);
 }
+
+TEST(SIMDMathTest, IntersectAABBsFrustum)
+{
+	float4x4 const view = MathLib::look_at_lh(float3(0, 0, 0), float3(1, 0.3f, 0.5f));
+	float4x4 const proj = MathLib::perspective_fov_lh(PI / 3, 1.3f, 0.1f, 300.0f);
+	float4x4 const view_proj = view * proj;
+	Frustum frustum;
+	frustum.ClipMatrix(view_proj, MathLib::inverse(view_proj));
+
+	uint32_t const num = 1024;
+	std::mt19937 gen(0);
+	std::uniform_real_distribution<float> center_dis(-200, 200);
+	std::uniform_real_distribution<float> extent_dis(0.1f, 30);
+
+	std::vector<AABBox> aabbs(num);
+	std::vector<float, aligned_allocator<float, 16>> coords[6];
+	for (auto& coord : coords)
+	{
+		coord.resize(num);
+	}
+	for (uint32_t i = 0; i < num; ++ i)
+	{
+		float3 const center(center_dis(gen), center_dis(gen), center_dis(gen));
+		float3 const extent(extent_dis(gen), extent_dis(gen), extent_dis(gen));
+		aabbs[i] = AABBox(center - extent, center + extent);
+		for (uint32_t j = 0; j < 3; ++ j)
+		{
+			coords[j][i] = aabbs[i].Min()[j];
+			coords[j + 3][i] = aabbs[i].Max()[j];
+		}
+	}
+
+	std::vector<BoundOverlap> results(num);
+	SIMDMathLib::IntersectAABBsFrustum(coords[0].data(), coords[1].data(), coords[2].data(),
+		coords[3].data(), coords[4].data(), coords[5].data(), num, frustum, results.data());
+
+	uint32_t num_partial = 0;
+	for (uint32_t i = 0; i < num; ++ i)
+	{
+		EXPECT_EQ(results[i], frustum.Intersect(aabbs[i]));
+		if (results[i] == BoundOverlap::Partial)
+		{
+			++ num_partial;
+		}
+	}
+	EXPECT_GT(num_partial, 0U);
+}
@@ -0,0 +1,347 @@
+/**
+ * @file SceneCullingTest.cpp
+ * @author Minmin Gong
+ *
+ * @section DESCRIPTION
+ *
+ * This source file is part of KlayGE
+ * For the latest info, see http://www.klayge.org
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * You may alternatively use this source under the terms of
+ * the KlayGE Proprietary License (KPL). You can obtained such a license
+ * from http://www.klayge.org/licensing/.
+ */
+
+
+#include <KlayGE/KlayGE.hpp>
+#include <KFL/Math.hpp>
+#include <KFL/Timer.hpp>
+#include <KlayGE/Camera.hpp>
+#include <KlayGE/Context.hpp>
+#include <KlayGE/FrameBuffer.hpp>
+#include <KlayGE/RenderEngine.hpp>
+#include <KlayGE/RenderFactory.hpp>
+#include <KlayGE/RenderableHelper.hpp>
+#include <KlayGE/SceneManager.hpp>
+#include <KlayGE/SceneNode.hpp>
+#include <KlayGE/Viewport.hpp>
+
+#include <deque>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "KlayGETests.hpp"
+
+using namespace KlayGE;
+
+namespace
+{
+	class CullingTestSceneManager : public SceneManager
+	{
+	public:
+		void OnSceneChanged() override
+		{
+		}
+
+		// Does what Flush() does before culling
+		void PrepareClip(Viewport const & viewport)
+		{
+			scene_root_.UpdatePosBoundSubtree(pos_bounds_ws_);
+
+			all_scene_nodes_.clear();
+			scene_root_.Traverse([this](SceneNode& node)
+				{
+					all_scene_nodes_.push_back(&node);
+					return true;
+				});
+
+			uint32_t const num_cameras = viewport.NumCameras();
+			camera_frustums_.resize(num_cameras);
+			camera_view_projs_.resize(num_cameras);
+			camera_eye_poses_.resize(num_cameras);
+			camera_forward_vecs_.resize(num_cameras);
+			for (uint32_t i = 0; i < num_cameras; ++ i)
+			{
+				auto const & camera = *viewport.Camera(i);
+				camera_frustums_[i] = &camera.ViewFrustum();
+				camera_view_projs_[i] = camera.ViewProjMatrix();
+				camera_eye_poses_[i] = camera.EyePos();
+				camera_forward_vecs_[i] = camera.ForwardVec();
+			}
+		}
+
+		std::vector<SceneNode*> const & AllSceneNodes() const
+		{
+			return all_scene_nodes_;
+		}
+
+	protected:
+		void DoSuspend() override
+		{
+		}
+		void DoResume() override
+		{
+		}
+	};
+}
+
+TEST(SceneCullingTest, ParallelClipSceneBenchmark)
+{
+	uint32_t const NUM_GROUPS = 1000;
+	uint32_t const NUM_NODES_PER_GROUP = 100;
+	uint32_t const NUM_ITERATIONS = 10;
+
+	CullingTestSceneManager scene_mgr;
+	scene_mgr.SmallObjectThreshold(0.0001f);
+
+	// All the nodes share one renderable, only their bounds matter here
+	auto box = MakeSharedPtr<RenderableTriBox>(
+		MathLib::convert_to_obbox(AABBox(float3(-0.5f, -0.5f, -0.5f), float3(0.5f, 0.5f, 0.5f))), Color(1, 1, 1, 1));
+
+	std::mt19937 gen(0);
+	std::uniform_real_distribution<float> group_dis(-400.0f, 400.0f);
+	std::uniform_real_distribution<float> node_dis(-20.0f, 20.0f);
+	for (uint32_t i = 0; i < NUM_GROUPS; ++ i)
+	{
+		auto group = MakeSharedPtr<SceneNode>(L"Group", SceneNode::SOA_Cullable);
+		float3 const group_pos(group_dis(gen), group_dis(gen) / 8, group_dis(gen));
+		group->TransformToParent(MathLib::translation(group_pos));
+		for (uint32_t j = 0; j < NUM_NODES_PER_GROUP; ++ j)
+		{
+			auto node = MakeSharedPtr<SceneNode>(MakeSharedPtr<RenderableComponent>(box), SceneNode::SOA_Cullable);
+			float3 const pos(node_dis(gen), node_dis(gen), node_dis(gen));
+			node->TransformToParent(MathLib::translation(pos));
+			group->AddChild(node);
+		}
+		scene_mgr.SceneRootNode().AddChild(group);
+	}
+
+	scene_mgr.SceneRootNode().Traverse([](SceneNode& node)
+		{
+			node.UpdateTransforms();
+			node.MainThreadUpdate(0, 0);
+			return true;
+		});
+	scene_mgr.SceneRootNode().UpdatePosBoundSubtree();
+
+	// 6 cameras, like a cube shadow map
+	float3 const look_ats[] = {float3(1, 0, 0), float3(-1, 0, 0), float3(0, 1, 0), float3(0, -1, 0), float3(0, 0, 1), float3(0, 0, -1)};
+	float3 const ups[] = {float3(0, 1, 0), float3(0, 1, 0), float3(0, 0, -1), float3(0, 0, 1), float3(0, 1, 0), float3(0, 1, 0)};
+	std::vector<SceneNodePtr> camera_nodes;
+
+	auto& re = Context::Instance().RenderFactoryInstance().RenderEngineInstance();
+	auto& viewport = *re.CurFrameBuffer()->Viewport();
+	CameraPtr const old_camera = viewport.Camera();
+	viewport.NumCameras(static_cast<uint32_t>(std::size(look_ats)));
+	for (uint32_t i = 0; i < std::size(look_ats); ++ i)
+	{
+		auto camera = MakeSharedPtr<Camera>();
+		camera->ProjParams(PI / 2, 1, 0.1f, 500.0f);
+
+		auto camera_node = MakeSharedPtr<SceneNode>(L"Camera", SceneNode::SOA_Moveable);
+		camera_node->AddComponent(camera);
+		camera_node->TransformToParent(MathLib::inverse(MathLib::look_at_lh(float3(0, 0, 0), look_ats[i], ups[i])));
+		camera_nodes.push_back(camera_node);
+
+		viewport.Camera(i, camera);
+	}
+
+	scene_mgr.PrepareClip(viewport);
+	auto const & nodes = scene_mgr.AllSceneNodes();
+	uint32_t const num_cameras = viewport.NumCameras();
+
+	Timer timer;
+
+	scene_mgr.ParallelCulling(false);
+	timer.restart();
+	for (uint32_t i = 0; i < NUM_ITERATIONS; ++ i)
+	{
+		scene_mgr.ClipScene();
+	}
+	double const serial_time = timer.elapsed() / NUM_ITERATIONS;
+
+	std::vector<BoundOverlap> serial_marks;
+	serial_marks.reserve(nodes.size() * num_cameras);
+	uint32_t num_visible = 0;
+	for (auto const * node : nodes)
+	{
+		for (uint32_t i = 0; i < num_cameras; ++ i)
+		{
+			serial_marks.push_back(node->VisibleMark(i));
+			if (node->VisibleMark(i) != BoundOverlap::No)
+			{
+				++ num_visible;
+			}
+		}
+	}
+
+	scene_mgr.ParallelCulling(true);
+	timer.restart();
+	for (uint32_t i = 0; i < NUM_ITERATIONS; ++ i)
+	{
+		scene_mgr.ClipScene();
+	}
+	double const parallel_time = timer.elapsed() / NUM_ITERATIONS;
+
+	size_t index = 0;
+	bool match = true;
+	for (auto const * node : nodes)
+	{
+		for (uint32_t i = 0; i < num_cameras; ++ i, ++ index)
+		{
+			match &= (node->VisibleMark(i) == serial_marks[index]);
+		}
+	}
+	EXPECT_TRUE(match);
+	EXPECT_GT(num_visible, 0U);
+
+	std::cout << nodes.size() << " nodes, " << num_cameras << " cameras, " << num_visible << " visible marks" << std::endl;
+	std::cout << "Serial ClipScene: " << serial_time * 1000 << " ms" << std::endl;
+	std::cout << "Parallel ClipScene: " << parallel_time * 1000 << " ms with "
+		 << Context::Instance().JobSystemInstance().NumWorkers() << " workers" << std::endl;
+
+	viewport.NumCameras(1);
+	viewport.Camera(old_camera);
+}
+
+TEST(SceneCullingTest, SceneManagerBenchmark)
+{
+	uint32_t const NUM_NODES = 50000;
+	uint32_t const NUM_FRAMES = 20;
+
+	struct Scenario
+	{
+		char const * name;
+		float moveable_ratio;
+		// Nodes removed and added per frame
+		float respawn_ratio;
+	};
+	Scenario const scenarios[] = {
+		{"Static", 0.0f, 0.0f}, {"Mostly static", 0.05f, 0.0f}, {"Dynamic", 1.0f, 0.0f}, {"Spawn/despawn", 0.0f, 0.01f}};
+	char const * sm_names[] = {"OCTree", "BVH"};
+
+	auto& context = Context::Instance();
+	auto& re = context.RenderFactoryInstance().RenderEngineInstance();
+	auto& viewport = *re.CurFrameBuffer()->Viewport();
+	CameraPtr const old_camera = viewport.Camera();
+
+	auto camera = MakeSharedPtr<Camera>();
+	camera->ProjParams(PI / 4, 1, 0.1f, 500.0f);
+	auto camera_node = MakeSharedPtr<SceneNode>(L"Camera", SceneNode::SOA_Moveable);
+	camera_node->AddComponent(camera);
+	camera_node->TransformToParent(MathLib::inverse(MathLib::look_at_lh(float3(0, 0, -450), float3(0, 0, 0), float3(0, 1, 0))));
+	viewport.Camera(camera);
+
+	auto box = MakeSharedPtr<RenderableTriBox>(
+		MathLib::convert_to_obbox(AABBox(float3(-0.5f, -0.5f, -0.5f), float3(0.5f, 0.5f, 0.5f))), Color(1, 1, 1, 1));
+
+	for (auto const & scenario : scenarios)
+	{
+		uint32_t num_visibles[std::size(sm_names)];
+		double times[std::size(sm_names)];
+		for (size_t s = 0; s < std::size(sm_names); ++ s)
+		{
+			context.LoadSceneManager(sm_names[s]);
+			auto& scene_mgr = context.SceneManagerInstance();
+			scene_mgr.SmallObjectThreshold(0);
+
+			std::mt19937 gen(0);
+			std::uniform_real_distribution<float> pos_dis(-400.0f, 400.0f);
+			std::uniform_real_distribution<float> ratio_dis(0.0f, 1.0f);
+			std::uniform_real_distribution<float> vel_dis(-2.0f, 2.0f);
+			std::vector<SceneNode*> moveable_nodes;
+			std::vector<float3> velocities;
+			std::deque<SceneNodePtr> static_nodes;
+			for (uint32_t i = 0; i < NUM_NODES; ++ i)
+			{
+				bool const moveable = ratio_dis(gen) < scenario.moveable_ratio;
+				auto node = MakeSharedPtr<SceneNode>(MakeSharedPtr<RenderableComponent>(box),
+					SceneNode::SOA_Cullable | (moveable ? SceneNode::SOA_Moveable : 0));
+				node->TransformToParent(MathLib::translation(pos_dis(gen), pos_dis(gen), pos_dis(gen)));
+				if (moveable)
+				{
+					moveable_nodes.push_back(node.get());
+					velocities.emplace_back(vel_dis(gen), vel_dis(gen), vel_dis(gen));
+				}
+				else
+				{
+					static_nodes.push_back(node);
+				}
+				scene_mgr.SceneRootNode().AddChild(node);
+			}
+			scene_mgr.SceneRootNode().Traverse([](SceneNode& node)
+				{
+					node.MainThreadUpdate(0, 0);
+					return true;
+				});
+
+			// The first frame builds the tree
+			scene_mgr.CullScene();
+
+			Timer timer;
+			times[s] = 0;
+			num_visibles[s] = 0;
+			for (uint32_t f = 0; f < NUM_FRAMES; ++ f)
+			{
+				for (size_t i = 0; i < moveable_nodes.size(); ++ i)
+				{
+					moveable_nodes[i]->TransformToParent(moveable_nodes[i]->TransformToParent() * MathLib::translation(velocities[i]));
+				}
+
+				// The oldest static nodes are replaced by new ones elsewhere
+				uint32_t const num_respawns = static_cast<uint32_t>(NUM_NODES * scenario.respawn_ratio);
+				for (uint32_t i = 0; i < num_respawns; ++ i)
+				{
+					scene_mgr.SceneRootNode().RemoveChild(static_nodes.front());
+					static_nodes.pop_front();
+
+					auto node = MakeSharedPtr<SceneNode>(MakeSharedPtr<RenderableComponent>(box), SceneNode::SOA_Cullable);
+					node->TransformToParent(MathLib::translation(pos_dis(gen), pos_dis(gen), pos_dis(gen)));
+					scene_mgr.SceneRootNode().AddChild(node);
+					node->MainThreadUpdate(0, 0);
+					static_nodes.push_back(node);
+				}
+
+				timer.restart();
+				scene_mgr.CullScene();
+				times[s] += timer.elapsed();
+			}
+			for (auto const & child : scene_mgr.SceneRootNode().Children())
+			{
+				if (child->VisibleMark(0) != BoundOverlap::No)
+				{
+					++ num_visibles[s];
+				}
+			}
+		}
+
+		EXPECT_EQ(num_visibles[0], num_visibles[1]);
+
+		std::cout << scenario.name << ", " << NUM_NODES << " nodes, " << num_visibles[0] << " visible:";
+		for (size_t s = 0; s < std::size(sm_names); ++ s)
+		{
+			std::cout << ' ' << sm_names[s] << ' ' << times[s] / NUM_FRAMES * 1000 << " ms";
+		}
+		std::cout << std::endl;
+	}
+
+	context.LoadSceneManager(context.Config().scene_manager_name);
+	viewport.Camera(old_camera);
+}
@@ -0,0 +1,172 @@
+/**
+ * @file ThreadTest.cpp
+ * @author Minmin Gong
+ *
+ * @section DESCRIPTION
+ *
+ * This source file is part of KFL, a subproject of KlayGE
+ * For the latest info, see http://www.klayge.org
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * You may alternatively use this source under the terms of
+ * the KlayGE Proprietary License (KPL). You can obtained such a license
+ * from http://www.klayge.org/licensing/.
+ */
+
+#include <KlayGE/KlayGE.hpp>
+#include <KFL/Thread.hpp>
+#include <KFL/Timer.hpp>
+
+#include <atomic>
+#include <iostream>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "KlayGETests.hpp"
+
+using namespace std;
+using namespace KlayGE;
+
+TEST(ThreadTest, JobSystemParallelFor)
+{
+	JobSystem js(4);
+
+	std::vector<uint32_t> values(100000, 0);
+	js.ParallelFor(0, static_cast<uint32_t>(values.size()), 0, [&values](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; ++ i)
+		{
+			values[i] = i;
+		}
+	});
+
+	for (uint32_t i = 0; i < values.size(); ++ i)
+	{
+		EXPECT_EQ(values[i], i);
+	}
+}
+
+TEST(ThreadTest, JobSystemParallelForException)
+{
+	JobSystem js(4);
+
+	uint32_t const num_values = 64 * 1024;
+	uint32_t const grain_size = 1024;
+	// The first range runs on the caller, the last one is scheduled
+	for (uint32_t throw_index : {0U, num_values - 1})
+	{
+		std::vector<std::atomic<uint32_t>> visits(num_values);
+		bool caught = false;
+		try
+		{
+			js.ParallelFor(0, num_values, grain_size, [&visits, throw_index](uint32_t begin, uint32_t end) {
+				for (uint32_t i = begin; i < end; ++ i)
+				{
+					visits[i].fetch_add(1, std::memory_order_relaxed);
+				}
+				if ((throw_index >= begin) && (throw_index < end))
+				{
+					throw std::runtime_error("ParallelFor range failed");
+				}
+			});
+		}
+		catch (std::runtime_error const & ex)
+		{
+			caught = (std::string(ex.what()) == "ParallelFor range failed");
+		}
+
+		EXPECT_TRUE(caught);
+		// Every range still ran exactly once before the exception reached the caller
+		for (uint32_t i = 0; i < num_values; ++ i)
+		{
+			EXPECT_EQ(visits[i].load(), 1U);
+		}
+	}
+
+	// The job system is still usable afterwards
+	std::atomic<uint32_t> sum(0);
+	js.ParallelFor(0, num_values, grain_size, [&sum](uint32_t begin, uint32_t end) { sum += end - begin; });
+	EXPECT_EQ(sum.load(), num_values);
+}
+
+TEST(ThreadTest, JobSystemContinuation)
+{
+	JobSystem js(4);
+
+	std::atomic<uint32_t> num_finished(0);
+	uint32_t num_finished_in_continuation = 0;
+
+	JobSystem::Counter jobs_counter;
+	JobSystem::Counter continuation_counter;
+	for (uint32_t i = 0; i < 1000; ++ i)
+	{
+		js.Schedule(
+			[&js, &num_finished] {
+				// Nested parallel loops must not deadlock
+				js.ParallelFor(0, 64, 8, [](uint32_t begin, uint32_t end) { KFL_UNUSED(begin); KFL_UNUSED(end); });
+				++ num_finished;
+			},
+			&jobs_counter);
+	}
+	js.Continue(jobs_counter, [&num_finished, &num_finished_in_continuation] { num_finished_in_continuation = num_finished; },
+		&continuation_counter);
+	js.Wait(continuation_counter);
+
+	EXPECT_TRUE(jobs_counter.Done());
+	EXPECT_EQ(num_finished_in_continuation, 1000U);
+}
+
+TEST(ThreadTest, JobSystemVsThreadPoolBenchmark)
+{
+	uint32_t const num_jobs = 20000;
+	std::atomic<uint32_t> sum(0);
+
+	Timer timer;
+	{
+		ThreadPool tp(1, 16);
+		std::vector<std::future<void>> joiners(num_jobs);
+		for (uint32_t i = 0; i < num_jobs; ++ i)
+		{
+			joiners[i] = tp.QueueThread([&sum, i] { sum += i; });
+		}
+		for (auto& joiner : joiners)
+		{
+			joiner.wait();
+		}
+	}
+	double const thread_pool_time = timer.elapsed();
+
+	sum = 0;
+	timer.restart();
+	{
+		JobSystem js;
+		JobSystem::Counter counter;
+		for (uint32_t i = 0; i < num_jobs; ++ i)
+		{
+			js.Schedule([&sum, i] { sum += i; }, &counter);
+		}
+		js.Wait(counter);
+	}
+	double const job_system_time = timer.elapsed();
+
+	EXPECT_EQ(sum, num_jobs * (num_jobs - 1) / 2);
+
+	std::cout << num_jobs << " jobs: ThreadPool " << thread_pool_time * 1000 << " ms, JobSystem " << job_system_time * 1000 << " ms"
+			  << std::endl;
+}
@@ -101,6 +101,8 @@ namespace KlayGE
 		font_info const & CharInfo(int32_t index) const;
 		void GetDistanceData(uint8_t* p, uint32_t pitch, int32_t index) const;
 		void GetLZMADistanceData(uint8_t* p, uint32_t& size, int32_t index) const;
+		// Decodes the data from GetLZMADistanceData. Thread-safe, so glyphs can be decoded in parallel.
+		void DecodeLZMADistanceData(uint8_t* p, uint32_t pitch, uint8_t const * lzma_data, uint32_t size) const;
 
 		void CharSize(uint32_t size);
 		void DistBase(int16_t base);
@@ -345,20 +345,25 @@ namespace KlayGE
 
 	void KFont::GetDistanceData(uint8_t* p, uint32_t pitch, int32_t index) const
 	{
-		size_t const decoded_size = char_size_ * char_size_;
-		auto decoded = MakeUniquePtr<uint8_t[]>(decoded_size);
-
 		uint32_t size;
 		this->GetLZMADistanceData(nullptr, size, index);
 
 		auto in_data = MakeUniquePtr<uint8_t[]>(size);
 		this->GetLZMADistanceData(&in_data[0], size, index);
 
+		this->DecodeLZMADistanceData(p, pitch, &in_data[0], size);
+	}
+
+	void KFont::DecodeLZMADistanceData(uint8_t* p, uint32_t pitch, uint8_t const * lzma_data, uint32_t size) const
+	{
+		size_t const decoded_size = char_size_ * char_size_;
+		auto decoded = MakeUniquePtr<uint8_t[]>(decoded_size);
+
 		SizeT s_out_len = decoded_size;
 
 		SizeT s_src_len = static_cast<SizeT>(size - LZMA_PROPS_SIZE);
-		LZMALoader::Instance().LzmaUncompress(static_cast<Byte*>(&decoded[0]), &s_out_len, &in_data[LZMA_PROPS_SIZE], &s_src_len,
-			&in_data[0], LZMA_PROPS_SIZE);
+		LZMALoader::Instance().LzmaUncompress(static_cast<Byte*>(&decoded[0]), &s_out_len, &lzma_data[LZMA_PROPS_SIZE], &s_src_len,
+			lzma_data, LZMA_PROPS_SIZE);
 
 		uint8_t const * char_data = &decoded[0];
 		for (uint32_t y = 0; y < char_size_; ++ y)